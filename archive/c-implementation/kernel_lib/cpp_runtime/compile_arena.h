@@ -0,0 +1,124 @@
+/**
+ * C++ Runtime - Compile-Session Arena
+ *
+ * While a session is active, operator new bump-allocates from one region
+ * reserved up front instead of calling malloc, and operator delete on
+ * region memory is a no-op. compile_arena_end() drops the whole region in
+ * one shot, so the thousands of short-lived LLVM objects created by one
+ * recompilation never touch (or fragment) the global heap.
+ *
+ * Ended regions stay reserved and are reused by the next session of a
+ * fitting size, so a delete that arrives after its session ended is still
+ * recognized as region memory and stays a no-op. At most
+ * COMPILE_ARENA_MAX_REGIONS regions exist at once.
+ *
+ * Objects that must outlive the session (JIT'd code metadata, caches) are
+ * allocated inside an escape scope, which routes operator new back to malloc.
+ *
+ * Requests that do not fit in the region also fall back to malloc, so a
+ * session never fails an allocation the heap could have satisfied.
+ */
+
+#ifndef COMPILE_ARENA_H
+#define COMPILE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMPILE_ARENA_DEFAULT_SIZE (4 * 1024 * 1024)  // 4 MB per session
+#define COMPILE_ARENA_ALIGN 16
+#define COMPILE_ARENA_MAX_REGIONS 4                    // Live + retired regions
+
+typedef struct compile_arena {
+    uint8_t* base;                  // Region start (from the region table)
+    size_t capacity;                // Region size
+    size_t used;                    // Bump offset
+    size_t peak_used;               // High-water mark within this session
+    size_t num_allocs;              // Allocations served from the region
+    size_t num_fallbacks;           // Allocations that overflowed to malloc
+    int escape_depth;               // >0: operator new goes to malloc
+    struct compile_arena* prev;     // Enclosing session (nested compiles)
+} compile_arena_t;
+
+/**
+ * Start a compile session: reserve 'capacity' bytes (reusing an ended
+ * region when one is large enough) and route operator new to it. Sessions
+ * nest; the innermost one receives allocations.
+ *
+ * Returns: 0 on success, -1 if the region could not be reserved or all
+ * COMPILE_ARENA_MAX_REGIONS regions are in use
+ */
+int compile_arena_begin(compile_arena_t* arena, size_t capacity);
+
+/**
+ * End a compile session and retire its region in one shot.
+ * Every object allocated in the region (outside escape scopes) dies here;
+ * the region itself is kept for the next session.
+ */
+void compile_arena_end(compile_arena_t* arena);
+
+/**
+ * Route allocations to malloc until the matching compile_arena_escape_end()
+ */
+void compile_arena_escape_begin(void);
+void compile_arena_escape_end(void);
+
+/**
+ * Innermost active session, or NULL
+ */
+compile_arena_t* compile_arena_current(void);
+
+/**
+ * Allocation entry points used by operator new/delete
+ */
+void* compile_arena_alloc(size_t size);
+void compile_arena_free(void* ptr);
+
+#ifdef __cplusplus
+}
+
+/**
+ * RAII compile session
+ *
+ *   {
+ *       CompileArenaScope session;
+ *       ... build IR, run passes, emit code ...
+ *   }   // everything allocated above is dropped here
+ */
+class CompileArenaScope {
+public:
+    explicit CompileArenaScope(size_t capacity = COMPILE_ARENA_DEFAULT_SIZE) {
+        active_ = compile_arena_begin(&arena_, capacity) == 0;
+    }
+    ~CompileArenaScope() {
+        if (active_) compile_arena_end(&arena_);
+    }
+    bool active() const { return active_; }
+    const compile_arena_t& stats() const { return arena_; }
+
+    CompileArenaScope(const CompileArenaScope&) = delete;
+    CompileArenaScope& operator=(const CompileArenaScope&) = delete;
+
+private:
+    compile_arena_t arena_;
+    bool active_;
+};
+
+/**
+ * RAII escape hatch for allocations that must outlive the session
+ */
+class CompileArenaEscape {
+public:
+    CompileArenaEscape() { compile_arena_escape_begin(); }
+    ~CompileArenaEscape() { compile_arena_escape_end(); }
+
+    CompileArenaEscape(const CompileArenaEscape&) = delete;
+    CompileArenaEscape& operator=(const CompileArenaEscape&) = delete;
+};
+#endif
+
+#endif // COMPILE_ARENA_H
@@ -3,9 +3,13 @@
  *
  * Bare-metal implementation using kernel_lib malloc/free.
  * Required for any C++ code that uses heap allocation.
+ *
+ * During a compile session (compile_arena.h) operator new bump-allocates
+ * from the session region instead.
  */
 
 #include <stddef.h>
+#include "compile_arena.h"
 
 // Forward declarations from kernel_lib/memory/malloc.h
 extern "C" {
@@ -14,16 +18,149 @@ extern "C" {
     void free(void* ptr);
 }
 
+// ============================================================================
+// Compile-session arena
+// ============================================================================
+
+static compile_arena_t* g_current_arena = nullptr;
+
+// Every region ever handed out. Regions are never returned to the heap:
+// objects created in a session may still be deleted after it ends, and
+// compile_arena_free() must keep recognizing their addresses. Ended
+// regions are reused by later sessions instead.
+static struct {
+    uint8_t* base;
+    size_t capacity;
+    bool in_use;
+} g_regions[COMPILE_ARENA_MAX_REGIONS];
+
+static uint8_t* region_acquire(size_t capacity) {
+    int slot = -1;
+    for (int i = 0; i < COMPILE_ARENA_MAX_REGIONS; i++) {
+        if (!g_regions[i].base) {
+            if (slot < 0) slot = i;
+        } else if (!g_regions[i].in_use && g_regions[i].capacity >= capacity) {
+            g_regions[i].in_use = true;
+            return g_regions[i].base;
+        }
+    }
+    if (slot < 0) return nullptr;
+
+    uint8_t* base = (uint8_t*)malloc(capacity);
+    if (!base) return nullptr;
+    g_regions[slot].base = base;
+    g_regions[slot].capacity = capacity;
+    g_regions[slot].in_use = true;
+    return base;
+}
+
+static void region_release(uint8_t* base) {
+    for (int i = 0; i < COMPILE_ARENA_MAX_REGIONS; i++) {
+        if (g_regions[i].base == base) {
+            g_regions[i].in_use = false;
+            return;
+        }
+    }
+}
+
+extern "C" int compile_arena_begin(compile_arena_t* arena, size_t capacity) {
+    if (!arena || capacity == 0) return -1;
+
+    capacity = (capacity + COMPILE_ARENA_ALIGN - 1) & ~(size_t)(COMPILE_ARENA_ALIGN - 1);
+    arena->base = region_acquire(capacity);
+    if (!arena->base) return -1;
+
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->peak_used = 0;
+    arena->num_allocs = 0;
+    arena->num_fallbacks = 0;
+    arena->escape_depth = 0;
+    arena->prev = g_current_arena;
+    g_current_arena = arena;
+    return 0;
+}
+
+extern "C" void compile_arena_end(compile_arena_t* arena) {
+    if (!arena || !arena->base) return;
+
+    // Unlink (normally the innermost session)
+    compile_arena_t** link = &g_current_arena;
+    while (*link && *link != arena) {
+        link = &(*link)->prev;
+    }
+    if (*link) {
+        *link = arena->prev;
+    }
+
+    region_release(arena->base);
+    arena->base = nullptr;
+    arena->used = 0;
+    arena->prev = nullptr;
+}
+
+extern "C" void compile_arena_escape_begin(void) {
+    if (g_current_arena) g_current_arena->escape_depth++;
+}
+
+extern "C" void compile_arena_escape_end(void) {
+    if (g_current_arena && g_current_arena->escape_depth > 0) {
+        g_current_arena->escape_depth--;
+    }
+}
+
+extern "C" compile_arena_t* compile_arena_current(void) {
+    return g_current_arena;
+}
+
+extern "C" void* compile_arena_alloc(size_t size) {
+    compile_arena_t* arena = g_current_arena;
+    if (!arena || arena->escape_depth > 0) {
+        return malloc(size);
+    }
+
+    if (size == 0) size = 1;
+    size_t aligned = (size + COMPILE_ARENA_ALIGN - 1) & ~(size_t)(COMPILE_ARENA_ALIGN - 1);
+    if (aligned > arena->capacity - arena->used) {
+        // Region exhausted: heap object, freed normally by operator delete
+        arena->num_fallbacks++;
+        return malloc(size);
+    }
+
+    void* ptr = arena->base + arena->used;
+    arena->used += aligned;
+    arena->num_allocs++;
+    if (arena->used > arena->peak_used) {
+        arena->peak_used = arena->used;
+    }
+    return ptr;
+}
+
+extern "C" void compile_arena_free(void* ptr) {
+    if (!ptr) return;
+
+    // Region memory is never freed individually, even after its session
+    // has ended (the object may outlive the session by mistake or by design)
+    for (int i = 0; i < COMPILE_ARENA_MAX_REGIONS; i++) {
+        uint8_t* base = g_regions[i].base;
+        if (base && (uint8_t*)ptr >= base && (uint8_t*)ptr < base + g_regions[i].capacity) {
+            return;
+        }
+    }
+
+    free(ptr);
+}
+
 // ============================================================================
 // operator new
 // ============================================================================
 
 void* operator new(size_t size) {
-    return malloc(size);
+    return compile_arena_alloc(size);
 }
 
 void* operator new[](size_t size) {
-    return malloc(size);
+    return compile_arena_alloc(size);
 }
 
 // Placement new (no-op, just returns the pointer)
@@ -40,20 +177,20 @@ void* operator new[](size_t, void* ptr) {
 // ============================================================================
 
 void operator delete(void* ptr) noexcept {
-    free(ptr);
+    compile_arena_free(ptr);
 }
 
 void operator delete[](void* ptr) noexcept {
-    free(ptr);
+    compile_arena_free(ptr);
 }
 
 // Sized delete (C++14)
 void operator delete(void* ptr, size_t) noexcept {
-    free(ptr);
+    compile_arena_free(ptr);
 }
 
 void operator delete[](void* ptr, size_t) noexcept {
-    free(ptr);
+    compile_arena_free(ptr);
 }
 
 // Placement delete (no-op)
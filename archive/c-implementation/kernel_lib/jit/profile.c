@@ -11,64 +11,143 @@ void jit_profile_init(jit_profile_t* prof) {
     prof->num_functions = 0;
     for (int i = 0; i < JIT_MAX_FUNCTIONS; i++) {
         prof->functions[i].name[0] = '\0';
+        prof->functions[i].name_hash = 0;
         prof->functions[i].call_count = 0;
         prof->functions[i].total_cycles = 0;
+        prof->functions[i].self_cycles = 0;
         prof->functions[i].min_cycles = UINT64_MAX;
         prof->functions[i].max_cycles = 0;
-        prof->functions[i].last_start = 0;
-        prof->functions[i].active = 0;
     }
+    memset(prof->name_index, 0, sizeof(prof->name_index));
+    memset(prof->stacks, 0, sizeof(prof->stacks));
 }
 
-// Find or create function entry
-static jit_profile_entry_t* find_or_create_entry(jit_profile_t* prof, const char* func_name) {
-    // Search for existing entry
-    for (int i = 0; i < prof->num_functions; i++) {
-        if (strcmp(prof->functions[i].name, func_name) == 0) {
-            return &prof->functions[i];
+__attribute__((weak)) uint32_t jit_profile_cpu_id(void) {
+    return 0;
+}
+
+// Find a function ID through the name index (open addressing, linear probe).
+// Returns the ID, or -1 with *slot_out set to the empty slot for insertion.
+static jit_func_id_t lookup_id(jit_profile_t* prof, const char* func_name,
+                               uint32_t hash, int* slot_out) {
+    int slot = hash & (JIT_PROFILE_HASH_SIZE - 1);
+
+    for (int probe = 0; probe < JIT_PROFILE_HASH_SIZE; probe++) {
+        int idx = prof->name_index[slot];
+        if (idx == 0) {
+            if (slot_out) *slot_out = slot;
+            return -1;
+        }
+
+        // Entries keep a truncated name; longer names match on that prefix
+        jit_profile_entry_t* entry = &prof->functions[idx - 1];
+        if (entry->name_hash == hash &&
+            strncmp(entry->name, func_name, JIT_MAX_FUNC_NAME - 1) == 0) {
+            return idx - 1;
         }
+
+        slot = (slot + 1) & (JIT_PROFILE_HASH_SIZE - 1);
+    }
+
+    if (slot_out) *slot_out = -1;
+    return -1;
+}
+
+static jit_profile_entry_t* find_entry(jit_profile_t* prof, const char* func_name) {
+    jit_func_id_t id = lookup_id(prof, func_name, jit_hash_name(func_name), NULL);
+    return id >= 0 ? &prof->functions[id] : NULL;
+}
+
+jit_func_id_t jit_profile_register(jit_profile_t* prof, const char* func_name) {
+    uint32_t hash = jit_hash_name(func_name);
+    int slot;
+
+    jit_func_id_t id = lookup_id(prof, func_name, hash, &slot);
+    if (id >= 0) {
+        return id;
     }
 
     // Create new entry
-    if (prof->num_functions >= JIT_MAX_FUNCTIONS) {
-        return NULL;  // Out of space
+    if (prof->num_functions >= JIT_MAX_FUNCTIONS || slot < 0) {
+        return -1;  // Out of space
     }
 
-    jit_profile_entry_t* entry = &prof->functions[prof->num_functions];
+    id = prof->num_functions;
+    jit_profile_entry_t* entry = &prof->functions[id];
     strncpy(entry->name, func_name, JIT_MAX_FUNC_NAME - 1);
     entry->name[JIT_MAX_FUNC_NAME - 1] = '\0';
+    entry->name_hash = hash;
     entry->call_count = 0;
     entry->total_cycles = 0;
+    entry->self_cycles = 0;
     entry->min_cycles = UINT64_MAX;
     entry->max_cycles = 0;
-    entry->active = 0;
+    prof->name_index[slot] = (int8_t)(id + 1);
     prof->num_functions++;
 
-    return entry;
+    return id;
 }
 
-void jit_profile_begin(jit_profile_t* prof, const char* func_name) {
-    jit_profile_entry_t* entry = find_or_create_entry(prof, func_name);
-    if (!entry || entry->active) {
-        return;  // Nested calls not supported
+static inline jit_shadow_stack_t* current_stack(jit_profile_t* prof) {
+    uint32_t cpu = jit_profile_cpu_id();
+    return &prof->stacks[cpu < JIT_MAX_CPUS ? cpu : 0];
+}
+
+void jit_profile_begin_id(jit_profile_t* prof, jit_func_id_t id) {
+    if (id < 0 || id >= prof->num_functions) {
+        return;
     }
 
-    entry->last_start = cpu_rdtsc();
-    entry->active = 1;
+    jit_shadow_stack_t* stack = current_stack(prof);
+    int depth = stack->depth++;
+
+    // Frames beyond the tracked depth are counted but not timed
+    if (depth < JIT_SHADOW_STACK_DEPTH) {
+        jit_shadow_frame_t* frame = &stack->frames[depth];
+        frame->func_id = id;
+        frame->child_cycles = 0;
+        frame->start = cpu_rdtsc();
+    }
 }
 
-void jit_profile_end(jit_profile_t* prof, const char* func_name) {
+void jit_profile_end_id(jit_profile_t* prof, jit_func_id_t id) {
     uint64_t end_time = cpu_rdtsc();
 
-    jit_profile_entry_t* entry = find_or_create_entry(prof, func_name);
-    if (!entry || !entry->active) {
+    if (id < 0 || id >= prof->num_functions) {
+        return;
+    }
+
+    jit_shadow_stack_t* stack = current_stack(prof);
+    if (stack->depth == 0) {
+        stack->mismatches++;
         return;
     }
+    if (stack->depth > JIT_SHADOW_STACK_DEPTH) {
+        stack->depth--;
+        return;
+    }
+
+    // Unwind frames whose end() was skipped (early return) until the match
+    int top = stack->depth - 1;
+    while (top >= 0 && stack->frames[top].func_id != id) {
+        top--;
+    }
+    if (top < 0) {
+        stack->mismatches++;
+        return;
+    }
+    if (top != stack->depth - 1) {
+        stack->mismatches++;
+    }
+    stack->depth = top;
 
-    uint64_t cycles = end_time - entry->last_start;
+    jit_shadow_frame_t* frame = &stack->frames[top];
+    uint64_t cycles = end_time - frame->start;
 
+    jit_profile_entry_t* entry = &prof->functions[id];
     entry->call_count++;
     entry->total_cycles += cycles;
+    entry->self_cycles += cycles - frame->child_cycles;
 
     if (cycles < entry->min_cycles) {
         entry->min_cycles = cycles;
@@ -77,51 +156,53 @@ void jit_profile_end(jit_profile_t* prof, const char* func_name) {
         entry->max_cycles = cycles;
     }
 
-    entry->active = 0;
+    // Charge this call to the caller's children
+    if (top > 0) {
+        stack->frames[top - 1].child_cycles += cycles;
+    }
+}
+
+void jit_profile_begin(jit_profile_t* prof, const char* func_name) {
+    jit_profile_begin_id(prof, jit_profile_register(prof, func_name));
+}
+
+void jit_profile_end(jit_profile_t* prof, const char* func_name) {
+    jit_profile_end_id(prof, lookup_id(prof, func_name, jit_hash_name(func_name), NULL));
 }
 
 uint64_t jit_get_call_count(jit_profile_t* prof, const char* func_name) {
-    for (int i = 0; i < prof->num_functions; i++) {
-        if (strcmp(prof->functions[i].name, func_name) == 0) {
-            return prof->functions[i].call_count;
-        }
-    }
-    return 0;
+    jit_profile_entry_t* entry = find_entry(prof, func_name);
+    return entry ? entry->call_count : 0;
 }
 
 uint64_t jit_get_avg_cycles(jit_profile_t* prof, const char* func_name) {
-    for (int i = 0; i < prof->num_functions; i++) {
-        if (strcmp(prof->functions[i].name, func_name) == 0) {
-            if (prof->functions[i].call_count == 0) {
-                return 0;
-            }
-            return prof->functions[i].total_cycles / prof->functions[i].call_count;
-        }
+    jit_profile_entry_t* entry = find_entry(prof, func_name);
+    if (!entry || entry->call_count == 0) {
+        return 0;
     }
-    return 0;
+    return entry->total_cycles / entry->call_count;
 }
 
 void jit_print_stats(jit_profile_t* prof, const char* func_name) {
-    for (int i = 0; i < prof->num_functions; i++) {
-        if (strcmp(prof->functions[i].name, func_name) == 0) {
-            jit_profile_entry_t* e = &prof->functions[i];
-
-            serial_puts(func_name);
-            serial_puts(": calls=");
-            serial_put_uint64(e->call_count);
-            serial_puts(", avg=");
-            serial_put_uint64(e->call_count > 0 ? e->total_cycles / e->call_count : 0);
-            serial_puts(", min=");
-            serial_put_uint64(e->min_cycles != UINT64_MAX ? e->min_cycles : 0);
-            serial_puts(", max=");
-            serial_put_uint64(e->max_cycles);
-            serial_puts("\n");
-            return;
-        }
+    jit_profile_entry_t* e = find_entry(prof, func_name);
+    if (!e) {
+        serial_puts(func_name);
+        serial_puts(": not found\n");
+        return;
     }
 
     serial_puts(func_name);
-    serial_puts(": not found\n");
+    serial_puts(": calls=");
+    serial_put_uint64(e->call_count);
+    serial_puts(", avg=");
+    serial_put_uint64(e->call_count > 0 ? e->total_cycles / e->call_count : 0);
+    serial_puts(", self=");
+    serial_put_uint64(e->call_count > 0 ? e->self_cycles / e->call_count : 0);
+    serial_puts(", min=");
+    serial_put_uint64(e->min_cycles != UINT64_MAX ? e->min_cycles : 0);
+    serial_puts(", max=");
+    serial_put_uint64(e->max_cycles);
+    serial_puts("\n");
 }
 
 void jit_print_all_stats(jit_profile_t* prof) {
@@ -20,6 +20,7 @@ extern "C" {
 // Types defined in jit_runtime.h:
 // - jit_profile_t
 // - jit_profile_entry_t
+// - jit_func_id_t, jit_shadow_stack_t
 // - JIT_MAX_FUNCTIONS
 // - JIT_MAX_FUNC_NAME
 
@@ -28,9 +29,22 @@ extern "C" {
  */
 void jit_profile_init(jit_profile_t* prof);
 
+/**
+ * Intern a function name, returning its ID (index into prof->functions)
+ * Only the first JIT_MAX_FUNC_NAME - 1 characters are kept and compared
+ */
+jit_func_id_t jit_profile_register(jit_profile_t* prof, const char* func_name);
+
+/**
+ * Begin/end profiling by interned ID (hot path: array index + rdtsc)
+ * Pushes/pops the calling core's shadow stack, so calls may nest
+ */
+void jit_profile_begin_id(jit_profile_t* prof, jit_func_id_t id);
+void jit_profile_end_id(jit_profile_t* prof, jit_func_id_t id);
+
 /**
  * Begin profiling a function
- * Starts cycle counter for the named function
+ * Looks up the ID through the FNV-1a name index, then begins by ID
  */
 void jit_profile_begin(jit_profile_t* prof, const char* func_name);
 
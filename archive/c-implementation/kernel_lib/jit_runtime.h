@@ -19,45 +19,112 @@ extern "C" {
 
 #define JIT_MAX_FUNCTIONS 32
 #define JIT_MAX_FUNC_NAME 32
+#define JIT_PROFILE_HASH_SIZE 64    // Name index slots (power of 2, > JIT_MAX_FUNCTIONS)
+#define JIT_MAX_CPUS 4              // Per-core shadow stacks
+#define JIT_SHADOW_STACK_DEPTH 64   // Nesting depth tracked per core
+
+/**
+ * Interned function ID (index into jit_profile_t.functions), -1 = invalid
+ */
+typedef int jit_func_id_t;
 
 /**
  * Function profiling data
  */
 typedef struct {
     char name[JIT_MAX_FUNC_NAME];
+    uint32_t name_hash;     // FNV-1a of name
     uint64_t call_count;
-    uint64_t total_cycles;
+    uint64_t total_cycles;  // Inclusive (callees counted)
+    uint64_t self_cycles;   // Exclusive (nested profiled calls subtracted)
     uint64_t min_cycles;
     uint64_t max_cycles;
-    uint64_t last_start;  // Start timestamp for current call
-    int active;           // 1 if currently being profiled
 } jit_profile_entry_t;
 
+/**
+ * One active call on a core's shadow stack
+ */
+typedef struct {
+    jit_func_id_t func_id;
+    uint64_t start;         // TSC at begin
+    uint64_t child_cycles;  // Cycles spent in nested profiled calls
+} jit_shadow_frame_t;
+
+typedef struct {
+    jit_shadow_frame_t frames[JIT_SHADOW_STACK_DEPTH];
+    int depth;              // May exceed JIT_SHADOW_STACK_DEPTH (untracked frames)
+    uint32_t mismatches;    // end() calls that did not match the top frame
+} jit_shadow_stack_t;
+
 /**
  * Global profiling state
  */
 typedef struct jit_profile_t {
     jit_profile_entry_t functions[JIT_MAX_FUNCTIONS];
     int num_functions;
+    int8_t name_index[JIT_PROFILE_HASH_SIZE];    // Function ID + 1, 0 = empty slot
+    jit_shadow_stack_t stacks[JIT_MAX_CPUS];
 } jit_profile_t;
 
+/**
+ * FNV-1a hash of a function name (used for the name index)
+ * Only the JIT_MAX_FUNC_NAME - 1 characters that are stored count, so a
+ * longer name hashes like the truncated copy kept in its entry.
+ */
+static inline uint32_t jit_hash_name(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < JIT_MAX_FUNC_NAME - 1 && name[i]; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
 /**
  * Initialize profiling system
  */
 void jit_profile_init(jit_profile_t* prof);
 
 /**
- * Begin profiling a function
- * Call at the start of the function you want to profile
+ * Intern a function name and return its ID (registers it on first use)
+ * Do this once, outside the measured code; returns -1 if the table is full
+ */
+jit_func_id_t jit_profile_register(jit_profile_t* prof, const char* func_name);
+
+/**
+ * Begin/end profiling by ID: an array index plus rdtsc, no string work.
+ * Calls may nest (including recursion); each core keeps its own shadow stack.
+ */
+void jit_profile_begin_id(jit_profile_t* prof, jit_func_id_t id);
+void jit_profile_end_id(jit_profile_t* prof, jit_func_id_t id);
+
+/**
+ * Begin profiling a function by name (hash lookup; prefer the _id variants
+ * or JIT_PROFILE_ID on hot paths)
  */
 void jit_profile_begin(jit_profile_t* prof, const char* func_name);
 
 /**
- * End profiling a function
- * Call at the end of the function
+ * End profiling a function by name
  */
 void jit_profile_end(jit_profile_t* prof, const char* func_name);
 
+/**
+ * Core index for the shadow stack (weak, returns 0; SMP kernels override)
+ */
+uint32_t jit_profile_cpu_id(void);
+
+/**
+ * Interned ID cached per call site: registered on first execution only
+ *   jit_profile_begin_id(&prof, JIT_PROFILE_ID(&prof, "matmul"));
+ */
+#define JIT_PROFILE_ID(prof, name) __extension__ ({                     \
+        static jit_func_id_t _jit_id = -1;                               \
+        if (__builtin_expect(_jit_id < 0, 0)) {                          \
+            _jit_id = jit_profile_register((prof), (name));              \
+        }                                                                \
+        _jit_id;                                                         \
+    })
+
 /**
  * Get call count for a function
  */
@@ -0,0 +1,240 @@
+/**
+ * Allocation Profiler - Implementation
+ */
+
+#include "alloc_profile.h"
+#include "malloc.h"
+#include "string.h"
+#include "../cpu/features.h"
+#include "../io/serial.h"
+
+static alloc_profile_t g_alloc_profile;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+int alloc_profile_size_class(size_t size) {
+    if (size <= 16) {
+        return 0;
+    }
+
+    // Class k holds (2^(k+3), 2^(k+4)]
+    int bits = (int)(sizeof(unsigned long) * 8) - __builtin_clzl((unsigned long)(size - 1));
+    int cls = bits - 4;
+    return cls < ALLOC_PROFILE_SIZE_CLASSES ? cls : ALLOC_PROFILE_SIZE_CLASSES - 1;
+}
+
+// Record a sampled call site (open addressing, linear probe)
+static void record_site(uintptr_t site, size_t size) {
+    uint32_t slot = (uint32_t)((site >> 2) * 2654435761u) % ALLOC_PROFILE_MAX_SITES;
+
+    for (int probe = 0; probe < ALLOC_PROFILE_MAX_SITES; probe++) {
+        alloc_call_site_t* s = &g_alloc_profile.sites[slot];
+
+        if (s->site == site) {
+            s->samples++;
+            s->bytes += size;
+            return;
+        }
+        if (s->site == 0) {
+            s->site = site;
+            s->samples = 1;
+            s->bytes = size;
+            g_alloc_profile.num_sites++;
+            return;
+        }
+
+        slot = (slot + 1) % ALLOC_PROFILE_MAX_SITES;
+    }
+
+    g_alloc_profile.dropped_site_samples++;
+}
+
+static void count_event(void) {
+    g_alloc_profile.events++;
+    if ((g_alloc_profile.events & (ALLOC_PROFILE_TIMELINE_EVERY - 1)) == 0) {
+        alloc_profile_sample_timeline();
+    }
+}
+
+// ============================================================================
+// RECORDING HOOKS
+// ============================================================================
+
+void alloc_profile_record_alloc(size_t size, void* caller) {
+    alloc_profile_t* p = &g_alloc_profile;
+
+    alloc_size_class_t* cls = &p->classes[alloc_profile_size_class(size)];
+    cls->allocs++;
+    cls->bytes += size;
+
+    p->total_allocs++;
+    p->live_bytes += size;
+    if (p->live_bytes > p->peak_live_bytes) {
+        p->peak_live_bytes = p->live_bytes;
+    }
+
+    // Call sites are sampled: hashing every return address costs too much
+    if ((p->total_allocs & (ALLOC_PROFILE_SITE_SAMPLE - 1)) == 0) {
+        record_site((uintptr_t)caller, size);
+    }
+
+    count_event();
+}
+
+void alloc_profile_record_free(size_t size) {
+    alloc_profile_t* p = &g_alloc_profile;
+
+    p->total_frees++;
+    if (size) {
+        p->classes[alloc_profile_size_class(size)].frees++;
+        p->live_bytes = (size < p->live_bytes) ? p->live_bytes - size : 0;
+    }
+
+    count_event();
+}
+
+void alloc_profile_record_failure(size_t size) {
+    (void)size;
+    g_alloc_profile.failed_allocs++;
+}
+
+// ============================================================================
+// QUERY
+// ============================================================================
+
+const alloc_profile_t* alloc_profile_get(void) {
+    return &g_alloc_profile;
+}
+
+void alloc_profile_sample_timeline(void) {
+    alloc_profile_t* p = &g_alloc_profile;
+
+    alloc_timeline_point_t* pt = &p->timeline[p->timeline_head];
+    pt->tsc = cpu_rdtsc();
+    pt->live_bytes = p->live_bytes;
+
+    p->timeline_head = (p->timeline_head + 1) % ALLOC_PROFILE_TIMELINE;
+    if (p->timeline_count < ALLOC_PROFILE_TIMELINE) {
+        p->timeline_count++;
+    }
+}
+
+void alloc_profile_reset(void) {
+    uint64_t live = g_alloc_profile.live_bytes;
+    memset(&g_alloc_profile, 0, sizeof(g_alloc_profile));
+    g_alloc_profile.live_bytes = live;
+    g_alloc_profile.peak_live_bytes = live;
+}
+
+// ============================================================================
+// JSON EXPORT
+// ============================================================================
+
+static void put_field(const char* indent, const char* name, uint64_t value, int last) {
+    serial_puts(indent);
+    serial_putchar('"');
+    serial_puts(name);
+    serial_puts("\": ");
+    serial_put_uint64(value);
+    serial_puts(last ? "\n" : ",\n");
+}
+
+static void put_hex(uintptr_t value) {
+    serial_puts("\"0x");
+    for (int shift = (int)(sizeof(uintptr_t) * 8) - 4; shift >= 0; shift -= 4) {
+        int nibble = (value >> shift) & 0xF;
+        serial_putchar(nibble < 10 ? '0' + nibble : 'A' + nibble - 10);
+    }
+    serial_putchar('"');
+}
+
+int alloc_profile_export_json(void) {
+    const alloc_profile_t* p = &g_alloc_profile;
+
+    malloc_stats_t heap;
+    malloc_get_stats(&heap);
+
+    // Share of free space unusable for the largest request (0 = one block)
+    uint64_t frag_permille = 0;
+    if (heap.free_bytes) {
+        frag_permille = 1000 - ((uint64_t)heap.largest_free_block * 1000) / heap.free_bytes;
+    }
+
+    serial_puts("\n=== ALLOCATION PROFILE EXPORT ===\n");
+    serial_puts("--- BEGIN JSON ---\n");
+    serial_puts("{\n");
+    serial_puts("  \"format_version\": \"1.0\",\n");
+    serial_puts("  \"type\": \"alloc_profile\",\n");
+    put_field("  ", "timestamp_cycles", cpu_rdtsc(), 0);
+
+    serial_puts("  \"heap\": {\n");
+    put_field("    ", "heap_size", heap.heap_size, 0);
+    put_field("    ", "current_usage", heap.current_usage, 0);
+    put_field("    ", "peak_usage", heap.peak_usage, 0);
+    put_field("    ", "free_bytes", heap.free_bytes, 0);
+    put_field("    ", "largest_free_block", heap.largest_free_block, 0);
+    put_field("    ", "fragmentation_permille", frag_permille, 1);
+    serial_puts("  },\n");
+
+    put_field("  ", "total_allocs", p->total_allocs, 0);
+    put_field("  ", "total_frees", p->total_frees, 0);
+    put_field("  ", "failed_allocs", p->failed_allocs, 0);
+    put_field("  ", "live_bytes", p->live_bytes, 0);
+    put_field("  ", "peak_live_bytes", p->peak_live_bytes, 0);
+
+    // Size classes: max_bytes of the last class is 0 (unbounded)
+    serial_puts("  \"size_classes\": [\n");
+    for (int i = 0; i < ALLOC_PROFILE_SIZE_CLASSES; i++) {
+        const alloc_size_class_t* c = &p->classes[i];
+        uint64_t max_bytes = (i == ALLOC_PROFILE_SIZE_CLASSES - 1) ? 0 : (16ull << i);
+
+        serial_puts("    { \"max_bytes\": ");
+        serial_put_uint64(max_bytes);
+        serial_puts(", \"allocs\": ");
+        serial_put_uint64(c->allocs);
+        serial_puts(", \"frees\": ");
+        serial_put_uint64(c->frees);
+        serial_puts(", \"bytes\": ");
+        serial_put_uint64(c->bytes);
+        serial_puts(i < ALLOC_PROFILE_SIZE_CLASSES - 1 ? " },\n" : " }\n");
+    }
+    serial_puts("  ],\n");
+
+    put_field("  ", "site_sample_rate", ALLOC_PROFILE_SITE_SAMPLE, 0);
+    put_field("  ", "dropped_site_samples", p->dropped_site_samples, 0);
+    serial_puts("  \"call_sites\": [\n");
+    uint32_t printed = 0;
+    for (int i = 0; i < ALLOC_PROFILE_MAX_SITES; i++) {
+        const alloc_call_site_t* s = &p->sites[i];
+        if (s->site == 0) continue;
+
+        serial_puts("    { \"address\": ");
+        put_hex(s->site);
+        serial_puts(", \"samples\": ");
+        serial_put_uint(s->samples);
+        serial_puts(", \"bytes\": ");
+        serial_put_uint64(s->bytes);
+        serial_puts(++printed < p->num_sites ? " },\n" : " }\n");
+    }
+    serial_puts("  ],\n");
+
+    // Timeline, oldest sample first
+    serial_puts("  \"timeline\": [\n");
+    uint32_t start = (p->timeline_head + ALLOC_PROFILE_TIMELINE - p->timeline_count) % ALLOC_PROFILE_TIMELINE;
+    for (uint32_t i = 0; i < p->timeline_count; i++) {
+        const alloc_timeline_point_t* pt = &p->timeline[(start + i) % ALLOC_PROFILE_TIMELINE];
+        serial_puts("    { \"tsc\": ");
+        serial_put_uint64(pt->tsc);
+        serial_puts(", \"live_bytes\": ");
+        serial_put_uint64(pt->live_bytes);
+        serial_puts(i + 1 < p->timeline_count ? " },\n" : " }\n");
+    }
+    serial_puts("  ]\n");
+
+    serial_puts("}\n");
+    serial_puts("--- END JSON ---\n\n");
+
+    return 0;
+}
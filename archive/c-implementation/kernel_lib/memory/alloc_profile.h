@@ -0,0 +1,134 @@
+/**
+ * Allocation Profiler - Heap Telemetry
+ *
+ * Low-overhead allocation profiling shared by all kernel_lib allocators
+ * (malloc.c, malloc_bump.c, malloc_llvm.c):
+ * - Per-size-class histograms (power-of-two classes)
+ * - Per-call-site counts (sampled return addresses)
+ * - Live-bytes timeline (ring buffer of RDTSC-stamped samples)
+ * - Fragmentation ratio (from the active allocator's free space)
+ *
+ * The allocators reference the record hooks as weak symbols, so profiling
+ * costs nothing unless this file is linked in (e.g. by calling
+ * alloc_profile_export_json()).
+ */
+
+#ifndef ALLOC_PROFILE_H
+#define ALLOC_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+#define ALLOC_PROFILE_SIZE_CLASSES 20   // <=16B, <=32B, ... <=4MB, larger
+#define ALLOC_PROFILE_MAX_SITES 32      // Distinct call sites tracked
+#define ALLOC_PROFILE_SITE_SAMPLE 64    // Sample 1 in N allocations (power of 2)
+#define ALLOC_PROFILE_TIMELINE 64       // Live-bytes samples kept
+#define ALLOC_PROFILE_TIMELINE_EVERY 256 // Events between timeline samples (power of 2)
+
+// ============================================================================
+// DATA STRUCTURES
+// ============================================================================
+
+typedef struct {
+    uint64_t allocs;            // Allocations in this class
+    uint64_t frees;             // Frees in this class (allocators that know sizes)
+    uint64_t bytes;             // Bytes charged in this class
+} alloc_size_class_t;
+
+typedef struct {
+    uintptr_t site;             // Return address of the allocating call
+    uint32_t samples;           // Sampled allocations from this site
+    uint64_t bytes;             // Sampled bytes from this site
+} alloc_call_site_t;
+
+typedef struct {
+    uint64_t tsc;               // RDTSC at sample time
+    uint64_t live_bytes;        // Bytes live at sample time
+} alloc_timeline_point_t;
+
+typedef struct {
+    uint64_t total_allocs;
+    uint64_t total_frees;
+    uint64_t failed_allocs;
+    uint64_t live_bytes;
+    uint64_t peak_live_bytes;
+    uint32_t events;            // Alloc + free events (drives sampling)
+
+    alloc_size_class_t classes[ALLOC_PROFILE_SIZE_CLASSES];
+
+    alloc_call_site_t sites[ALLOC_PROFILE_MAX_SITES];
+    uint32_t num_sites;
+    uint32_t dropped_site_samples;  // Samples lost because the table was full
+
+    alloc_timeline_point_t timeline[ALLOC_PROFILE_TIMELINE];
+    uint32_t timeline_head;     // Next slot to write
+    uint32_t timeline_count;    // Valid samples (<= ALLOC_PROFILE_TIMELINE)
+} alloc_profile_t;
+
+// ============================================================================
+// RECORDING HOOKS (called by allocators)
+// ============================================================================
+
+/**
+ * Record a successful allocation
+ * size: bytes charged to the allocation (the size the allocator will later
+ *       pass to alloc_profile_record_free), caller: return address of the
+ *       allocating call
+ */
+void alloc_profile_record_alloc(size_t size, void* caller);
+
+/**
+ * Record a free of 'size' bytes (0 if the allocator does not know the size)
+ */
+void alloc_profile_record_free(size_t size);
+
+/**
+ * Record an allocation that returned NULL
+ */
+void alloc_profile_record_failure(size_t size);
+
+// ============================================================================
+// QUERY / EXPORT
+// ============================================================================
+
+/**
+ * Get size class index for a request size
+ */
+int alloc_profile_size_class(size_t size);
+
+/**
+ * Get the global allocation profile
+ */
+const alloc_profile_t* alloc_profile_get(void);
+
+/**
+ * Append a live-bytes sample to the timeline now
+ */
+void alloc_profile_sample_timeline(void);
+
+/**
+ * Reset all counters (live_bytes is kept so the timeline stays consistent)
+ */
+void alloc_profile_reset(void);
+
+/**
+ * Export allocation profile as JSON via serial port, framed with the same
+ * "--- BEGIN JSON ---" / "--- END JSON ---" markers as profiling_export.c
+ *
+ * Returns: 0 on success
+ */
+int alloc_profile_export_json(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALLOC_PROFILE_H
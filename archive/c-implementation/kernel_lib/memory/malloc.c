@@ -24,26 +24,48 @@ static size_t heap_offset = 0;
 // External serial for debugging
 extern void serial_puts(const char* str);
 
-void* malloc(size_t size) {
+// Allocation profiler hooks (weak: active only if alloc_profile.c is linked)
+extern void alloc_profile_record_alloc(size_t size, void* caller) __attribute__((weak));
+extern void alloc_profile_record_free(size_t size) __attribute__((weak));
+extern void alloc_profile_record_failure(size_t size) __attribute__((weak));
+
+static size_t total_allocated = 0;
+static size_t num_allocations = 0;
+
+static void* bump_alloc(size_t size, void* caller) {
     if (size == 0)
         return NULL;
 
+    size_t requested = size;
+
     // Align to 16 bytes
     size = (size + 15) & ~15;
 
     if (heap_offset + size > HEAP_SIZE) {
         serial_puts("[malloc:OOM]");
+        if (alloc_profile_record_failure)
+            alloc_profile_record_failure(requested);
         return NULL;
     }
 
     void* ptr = &heap[heap_offset];
     heap_offset += size;
+
+    total_allocated += requested;
+    num_allocations++;
+    if (alloc_profile_record_alloc)
+        alloc_profile_record_alloc(requested, caller);
+
     return ptr;
 }
 
+void* malloc(size_t size) {
+    return bump_alloc(size, __builtin_return_address(0));
+}
+
 void* calloc(size_t nmemb, size_t size) {
     size_t total = nmemb * size;
-    void* ptr = malloc(total);
+    void* ptr = bump_alloc(total, __builtin_return_address(0));
     if (ptr)
         memset(ptr, 0, total);
     return ptr;
@@ -51,9 +73,9 @@ void* calloc(size_t nmemb, size_t size) {
 
 void* realloc(void* ptr, size_t size) {
     if (!ptr)
-        return malloc(size);
+        return bump_alloc(size, __builtin_return_address(0));
 
-    void* new_ptr = malloc(size);
+    void* new_ptr = bump_alloc(size, __builtin_return_address(0));
     if (new_ptr && ptr) {
         memcpy(new_ptr, ptr, size);
     }
@@ -61,6 +83,21 @@ void* realloc(void* ptr, size_t size) {
 }
 
 void free(void* ptr) {
-    // Bump allocator: no-op
-    (void)ptr;
+    // Bump allocator: no-op (size unknown, counted as a free event only)
+    if (ptr && alloc_profile_record_free)
+        alloc_profile_record_free(0);
+}
+
+void malloc_get_stats(malloc_stats_t* stats) {
+    if (!stats)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->heap_size = HEAP_SIZE;
+    stats->current_usage = heap_offset;
+    stats->peak_usage = heap_offset;
+    stats->total_allocated = total_allocated;
+    stats->num_allocations = num_allocations;
+    stats->free_bytes = HEAP_SIZE - heap_offset;
+    stats->largest_free_block = HEAP_SIZE - heap_offset;  // Bump never fragments
 }
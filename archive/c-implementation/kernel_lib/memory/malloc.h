@@ -35,6 +35,26 @@ void* realloc(void* ptr, size_t size);
  */
 void free(void* ptr);
 
+/**
+ * Allocator statistics (implemented by every kernel_lib allocator)
+ */
+typedef struct {
+    size_t heap_size;           // Total heap capacity
+    size_t current_usage;       // Bytes in use (including headers)
+    size_t peak_usage;          // High-water mark of current_usage
+    size_t total_allocated;     // Cumulative requested bytes
+    size_t total_freed;         // Cumulative freed bytes
+    size_t num_allocations;
+    size_t num_frees;
+    size_t free_bytes;          // Bytes still available
+    size_t largest_free_block;  // Largest single allocation that can succeed
+} malloc_stats_t;
+
+/**
+ * Fill in allocator statistics
+ */
+void malloc_get_stats(malloc_stats_t* stats);
+
 #ifdef __cplusplus
 }
 #endif
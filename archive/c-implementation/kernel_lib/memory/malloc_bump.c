@@ -11,6 +11,7 @@
  */
 
 #include <stddef.h>
+#include "malloc.h"
 
 // ============================================================================
 // Configuration
@@ -42,15 +43,27 @@ static unsigned long heap_offset = 0;
 extern void serial_puts(const char* str);
 extern void serial_put_uint64(unsigned long value);
 
-void* malloc(unsigned long size) {
+// Allocation profiler hooks (weak: active only if alloc_profile.c is linked)
+extern void alloc_profile_record_alloc(size_t size, void* caller) __attribute__((weak));
+extern void alloc_profile_record_free(size_t size) __attribute__((weak));
+extern void alloc_profile_record_failure(size_t size) __attribute__((weak));
+
+static unsigned long total_allocated = 0;
+static unsigned long num_allocations = 0;
+
+static void* bump_alloc(unsigned long size, void* caller) {
     if (size == 0)
         return NULL;
 
+    unsigned long requested = size;
+
     // Align size to 16 bytes
     size = (size + 15) & ~15;
 
     // Check if we have enough space
     if (heap_offset + size > HEAP_SIZE) {
+        if (alloc_profile_record_failure)
+            alloc_profile_record_failure(requested);
         return NULL;  // Out of memory
     }
 
@@ -58,25 +71,36 @@ void* malloc(unsigned long size) {
     void* ptr = &heap[heap_offset];
     heap_offset += size;
 
+    total_allocated += requested;
+    num_allocations++;
+    if (alloc_profile_record_alloc)
+        alloc_profile_record_alloc(requested, caller);
+
     return ptr;
 }
 
+void* malloc(size_t size) {
+    return bump_alloc(size, __builtin_return_address(0));
+}
+
 // ============================================================================
 // free() - No-op for Bump Allocator
 // ============================================================================
 
 void free(void* ptr) {
-    // Bump allocator doesn't free - this is intentional
-    (void)ptr;  // Suppress unused warning
+    // Bump allocator doesn't free - this is intentional.
+    // The size is unknown, so only the free event is profiled.
+    if (ptr && alloc_profile_record_free)
+        alloc_profile_record_free(0);
 }
 
 // ============================================================================
 // calloc() - Zero-initialized allocation
 // ============================================================================
 
-void* calloc(unsigned long nmemb, unsigned long size) {
+void* calloc(size_t nmemb, size_t size) {
     unsigned long total = nmemb * size;
-    void* ptr = malloc(total);
+    void* ptr = bump_alloc(total, __builtin_return_address(0));
 
     if (ptr) {
         // Zero out memory
@@ -93,9 +117,9 @@ void* calloc(unsigned long nmemb, unsigned long size) {
 // realloc() - Simple implementation
 // ============================================================================
 
-void* realloc(void* ptr, unsigned long size) {
+void* realloc(void* ptr, size_t size) {
     if (!ptr) {
-        return malloc(size);
+        return bump_alloc(size, __builtin_return_address(0));
     }
 
     if (size == 0) {
@@ -105,7 +129,7 @@ void* realloc(void* ptr, unsigned long size) {
 
     // For bump allocator, we always allocate new memory
     // (can't determine old size without metadata)
-    void* new_ptr = malloc(size);
+    void* new_ptr = bump_alloc(size, __builtin_return_address(0));
     if (!new_ptr) {
         return NULL;
     }
@@ -136,3 +160,18 @@ unsigned long malloc_get_peak(void) {
 unsigned long malloc_get_heap_size(void) {
     return HEAP_SIZE;
 }
+
+void malloc_get_stats(malloc_stats_t* stats) {
+    if (!stats)
+        return;
+
+    stats->heap_size = HEAP_SIZE;
+    stats->current_usage = heap_offset;
+    stats->peak_usage = heap_offset;
+    stats->total_allocated = total_allocated;
+    stats->total_freed = 0;
+    stats->num_allocations = num_allocations;
+    stats->num_frees = 0;
+    stats->free_bytes = HEAP_SIZE - heap_offset;
+    stats->largest_free_block = HEAP_SIZE - heap_offset;  // Bump never fragments
+}
@@ -10,27 +10,19 @@
  * Strategy: Segregated free lists with first-fit allocation
  */
 
-// For bare-metal: use local definitions
-#ifndef __STDBOOL_H
-typedef _Bool bool;
-#define true 1
-#define false 0
-#endif
-
-#ifndef __STDINT_H
-typedef unsigned char uint8_t;
-typedef unsigned int uint32_t;
-typedef unsigned long size_t;
-#endif
-
-#ifndef NULL
-#define NULL ((void*)0)
-#endif
+#include "malloc.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 // Forward declarations for string functions
 void* memset(void* s, int c, size_t n);
 void* memcpy(void* dest, const void* src, size_t n);
 
+// Allocation profiler hooks (weak: active only if alloc_profile.c is linked)
+extern void alloc_profile_record_alloc(size_t size, void* caller) __attribute__((weak));
+extern void alloc_profile_record_free(size_t size) __attribute__((weak));
+extern void alloc_profile_record_failure(size_t size) __attribute__((weak));
+
 // Debug serial output (if available)
 #ifdef DEBUG_MALLOC
 extern void serial_putchar(char c);
@@ -250,7 +242,7 @@ static void init_heap() {
 // ALLOCATION
 // ============================================================================
 
-void* malloc(size_t size) {
+static void* malloc_from(size_t size, void* caller) {
     debug_print("[malloc] malloc() called\n");
 
     if (size == 0) {
@@ -286,6 +278,9 @@ void* malloc(size_t size) {
 
     if (!current) {
         // No suitable block found
+        if (alloc_profile_record_failure) {
+            alloc_profile_record_failure(size);
+        }
         return NULL;
     }
 
@@ -329,9 +324,18 @@ void* malloc(size_t size) {
     }
     num_allocations++;
 
+    // Profile the payload size so frees (which only know the block) balance
+    if (alloc_profile_record_alloc) {
+        alloc_profile_record_alloc(current->size - BLOCK_HEADER_SIZE, caller);
+    }
+
     return block_to_ptr(current);
 }
 
+void* malloc(size_t size) {
+    return malloc_from(size, __builtin_return_address(0));
+}
+
 // ============================================================================
 // DEALLOCATION
 // ============================================================================
@@ -353,6 +357,10 @@ void free(void* ptr) {
     current_usage -= block->size;
     num_frees++;
 
+    if (alloc_profile_record_free) {
+        alloc_profile_record_free(block->size - BLOCK_HEADER_SIZE);
+    }
+
     // Add to free list
     add_to_free_list(block);
 
@@ -366,7 +374,7 @@ void free(void* ptr) {
 
 void* calloc(size_t nmemb, size_t size) {
     size_t total = nmemb * size;
-    void* ptr = malloc(total);
+    void* ptr = malloc_from(total, __builtin_return_address(0));
     if (ptr) {
         memset(ptr, 0, total);
     }
@@ -375,7 +383,7 @@ void* calloc(size_t nmemb, size_t size) {
 
 void* realloc(void* ptr, size_t size) {
     if (!ptr) {
-        return malloc(size);
+        return malloc_from(size, __builtin_return_address(0));
     }
 
     if (size == 0) {
@@ -392,7 +400,7 @@ void* realloc(void* ptr, size_t size) {
     }
 
     // Allocate new block
-    void* new_ptr = malloc(size);
+    void* new_ptr = malloc_from(size, __builtin_return_address(0));
     if (!new_ptr) {
         return NULL;
     }
@@ -426,3 +434,34 @@ size_t malloc_get_peak() {
 size_t malloc_get_heap_size() {
     return HEAP_SIZE;
 }
+
+void malloc_get_stats(malloc_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    stats->heap_size = HEAP_SIZE;
+    stats->current_usage = current_usage;
+    stats->peak_usage = peak_usage;
+    stats->total_allocated = total_allocated;
+    stats->total_freed = total_freed;
+    stats->num_allocations = num_allocations;
+    stats->num_frees = num_frees;
+    stats->free_bytes = 0;
+    stats->largest_free_block = 0;
+
+    if (!heap_initialized) {
+        stats->free_bytes = HEAP_SIZE - BLOCK_HEADER_SIZE;
+        stats->largest_free_block = HEAP_SIZE - BLOCK_HEADER_SIZE;
+        return;
+    }
+
+    // Walk the free list (O(free blocks), only on query)
+    for (Block* b = free_list; b; b = b->next) {
+        size_t payload = b->size - BLOCK_HEADER_SIZE;
+        stats->free_bytes += payload;
+        if (payload > stats->largest_free_block) {
+            stats->largest_free_block = payload;
+        }
+    }
+}
@@ -2,8 +2,14 @@
 // This test demonstrates the merged interface+runtime capabilities
 
 #include "kernel/jit_interface.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <iostream>
 #include <cstring>
+#include <filesystem>
+#include <string>
 
 // Simulate cycle counting (in real kernel, use rdtsc)
 static inline uint64_t read_cycles() {
@@ -12,6 +18,157 @@ static inline uint64_t read_cycles() {
     return fake_cycles;
 }
 
+typedef size_t (*StrlenFunc)(const char*);
+
+// Load minimal.bc in a fresh context with the object cache at 'dir', run
+// strlen once (forcing its compile) and return that context's stats
+static bool run_with_object_cache(const char* dir, JITStats* stats) {
+    JITContext* ctx = jit_create();
+    if (!ctx) return false;
+
+    JITModule* mod = nullptr;
+    bool ok = jit_set_object_cache(ctx, dir, nullptr) == 0;
+    if (ok) {
+        mod = jit_load_bitcode(ctx, "libs/minimal.bc");
+        StrlenFunc fn = mod ? (StrlenFunc)jit_find_function(ctx, "strlen") : nullptr;
+        ok = fn && fn("cache") == 5;
+    }
+    if (!ok) {
+        std::cerr << "    [ERROR] " << jit_get_last_error(ctx) << "\n";
+    }
+
+    jit_get_stats(ctx, stats);
+    if (mod) jit_unload_module(mod);
+    jit_destroy(ctx);
+    return ok;
+}
+
+// Load minimal.bc with a low OSR threshold and run strlen over a string
+// long enough that its loop header crosses it mid-call
+static bool run_with_osr(JITStats* stats) {
+    JITContext* ctx = jit_create();
+    if (!ctx) return false;
+
+    jit_set_osr_threshold(ctx, 64);
+    JITModule* mod = jit_load_bitcode(ctx, "libs/minimal.bc");
+    StrlenFunc fn = mod ? (StrlenFunc)jit_find_function(ctx, "strlen") : nullptr;
+
+    // The first call moves into the continuation; later calls reuse it
+    std::string text(4096, 'x');
+    bool ok = fn != nullptr;
+    for (int i = 0; ok && i < 3; i++) {
+        ok = fn(text.c_str()) == text.size();
+    }
+    if (!ok) {
+        std::cerr << "    [ERROR] " << jit_get_last_error(ctx) << "\n";
+    }
+
+    jit_get_stats(ctx, stats);
+    if (mod) jit_unload_module(mod);
+    jit_destroy(ctx);
+    return ok;
+}
+
+// Tier strlen up O0 -> O1 -> O2/O3 in a fresh context. The stub address
+// must stay put, keep returning the right length and report the new tier.
+static bool run_tier_up(JITStats* stats) {
+    JITContext* ctx = jit_create();
+    if (!ctx) return false;
+
+    JITModule* mod = jit_load_bitcode(ctx, "libs/minimal.bc");
+    StrlenFunc stub = mod ? (StrlenFunc)jit_find_function(ctx, "strlen") : nullptr;
+    bool ok = stub && stub("tier") == 4;
+
+    const JITOptLevel tiers[] = {JIT_OPT_BASIC, JIT_OPT_AGGRESSIVE};
+    for (JITOptLevel opt : tiers) {
+        if (!ok) break;
+        JITFunctionInfo info;
+        ok = jit_recompile_function(ctx, "strlen", opt) == 0 &&
+             (StrlenFunc)jit_find_function(ctx, "strlen") == stub &&
+             stub("tiered up") == 9 &&
+             jit_get_function_info(ctx, "strlen", &info) == 0 &&
+             info.current_opt_level == opt;
+    }
+    if (!ok) {
+        std::cerr << "    [ERROR] " << jit_get_last_error(ctx) << "\n";
+    }
+
+    // Unknown functions have no pristine body to rebuild from
+    if (ok && jit_recompile_function(ctx, "no_such_function", JIT_OPT_BASIC) != -1) {
+        std::cerr << "    [ERROR] Recompiling an unknown function succeeded\n";
+        ok = false;
+    }
+
+    jit_get_stats(ctx, stats);
+    if (mod) jit_unload_module(mod);
+    jit_destroy(ctx);
+    return ok;
+}
+
+// True if some loop in 'function' of the bitcode at 'path' carries the
+// llvm.loop hint 'key'
+static bool exportedLoopHint(const char* path, const char* function, const char* key) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) return false;
+    llvm::LLVMContext context;
+    auto module = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), context);
+    if (!module) {
+        llvm::consumeError(module.takeError());
+        return false;
+    }
+    llvm::Function* F = (*module)->getFunction(function);
+    if (!F) return false;
+
+    for (auto& BB : *F) {
+        llvm::MDNode* id = BB.getTerminator()->getMetadata(llvm::LLVMContext::MD_loop);
+        if (!id) continue;
+        for (unsigned i = 1; i < id->getNumOperands(); i++) {
+            auto* hint = llvm::dyn_cast<llvm::MDNode>(id->getOperand(i));
+            auto* name = hint && hint->getNumOperands() ? llvm::dyn_cast<llvm::MDString>(hint->getOperand(0))
+                                                        : nullptr;
+            if (name && name->getString() == key) return true;
+        }
+    }
+    return false;
+}
+
+// Give the O2/O3 tier its own target, profile strlen's loop over long
+// strings and tier up with it. The loop averages far more than
+// JIT_VECTORIZE_MIN_TRIP iterations per entry, so the exported profile
+// must ask for vectorization.
+static bool run_loop_profile() {
+    JITContext* ctx = jit_create();
+    if (!ctx) return false;
+
+    bool ok = jit_set_tier_target(ctx, JIT_OPT_AGGRESSIVE, nullptr,
+                                  jit_probe_cpu_features() & JIT_CPU_VECTOR_FEATURES) == 0;
+    if (ok && jit_set_tier_target(ctx, JIT_OPT_AGGRESSIVE, "not-a-cpu", 0) != -1) {
+        std::cerr << "    [ERROR] Unknown CPU name accepted\n";
+        ok = false;
+    }
+
+    JITModule* mod = ok ? jit_load_bitcode(ctx, "libs/minimal.bc") : nullptr;
+    StrlenFunc fn = mod ? (StrlenFunc)jit_find_function(ctx, "strlen") : nullptr;
+    std::string text(256, 'x');
+    ok = fn != nullptr;
+    for (int i = 0; ok && i < 8; i++) {
+        ok = fn(text.c_str()) == text.size();
+    }
+    ok = ok && jit_recompile_function(ctx, "strlen", JIT_OPT_AGGRESSIVE) == 0 &&
+         fn(text.c_str()) == text.size() &&
+         jit_export_profiled_bitcode(ctx, "bin/minimal_loops.bc") == 0;
+    if (!ok) {
+        std::cerr << "    [ERROR] " << jit_get_last_error(ctx) << "\n";
+    } else if (!exportedLoopHint("bin/minimal_loops.bc", "strlen", "llvm.loop.vectorize.enable")) {
+        std::cerr << "    [ERROR] strlen loop exported without a vectorize hint\n";
+        ok = false;
+    }
+
+    if (mod) jit_unload_module(mod);
+    jit_destroy(ctx);
+    return ok;
+}
+
 int main() {
     std::cout << "=== BareFlow JIT Interface Test (LLVM 18) ===\n\n";
 
@@ -36,7 +193,6 @@ int main() {
 
     // 3. Find strlen function
     std::cout << "[3] Looking up 'strlen' function...\n";
-    typedef size_t (*StrlenFunc)(const char*);
     StrlenFunc strlen_jit = (StrlenFunc)jit_find_function(ctx, "strlen");
     if (!strlen_jit) {
         std::cerr << "    [ERROR] " << jit_get_last_error(ctx) << "\n";
@@ -101,6 +257,21 @@ int main() {
     }
     std::cout << "\n";
 
+    // 6b. Call-graph edges counted by the O0 instrumentation
+    std::cout << "[6b] Call edges (hottest first):\n";
+    JITCallEdge edges[16];
+    int edge_count = jit_get_call_edges(ctx, edges, 16);
+    for (int i = 0; i < edge_count; i++) {
+        std::cout << "    " << edges[i].caller << " -> " << edges[i].callee
+                  << " (site " << edges[i].callsite << "): " << edges[i].count << "\n";
+    }
+    if (jit_export_profiled_bitcode(ctx, "bin/minimal_profiled.bc") == 0) {
+        std::cout << "    [OK] Edge profile exported to bin/minimal_profiled.bc\n";
+    } else {
+        std::cerr << "    [ERROR] " << jit_get_last_error(ctx) << "\n";
+    }
+    std::cout << "\n";
+
     // 7. Get global statistics
     std::cout << "[7] Global JIT statistics:\n";
     JITStats stats;
@@ -110,6 +281,61 @@ int main() {
     std::cout << "    Reoptimizations: " << stats.reoptimizations << "\n";
     std::cout << "    Memory used: " << stats.memory_used_bytes << " bytes\n\n";
 
+    // 7b. Persistent object cache: a cold run compiles and stores, a second
+    // context with the same IR, tier and (default) CPU tag loads from disk
+    std::cout << "[7b] Object cache:\n";
+    const char* cache_dir = "bin/objcache";
+    std::filesystem::remove_all(cache_dir);
+    JITStats cold = {}, warm = {};
+    if (!run_with_object_cache(cache_dir, &cold) || !run_with_object_cache(cache_dir, &warm)) {
+        jit_unload_module(mod);
+        jit_destroy(ctx);
+        return 1;
+    }
+    std::cout << "    Cold: " << cold.object_cache_hits << " hit(s), "
+              << cold.object_cache_misses << " miss(es)\n";
+    std::cout << "    Warm: " << warm.object_cache_hits << " hit(s), "
+              << warm.object_cache_misses << " miss(es)\n";
+    if (cold.object_cache_hits != 0 || cold.object_cache_misses == 0 ||
+        warm.object_cache_hits == 0 || warm.object_cache_misses != 0) {
+        std::cerr << "    [ERROR] Expected only misses cold and only hits warm\n";
+        jit_unload_module(mod);
+        jit_destroy(ctx);
+        return 1;
+    }
+    std::cout << "    [OK] Warm context reused the cached objects\n\n";
+
+    // 7c. On-stack replacement of a long-running loop
+    std::cout << "[7c] On-stack replacement:\n";
+    JITStats osr = {};
+    if (!run_with_osr(&osr) || osr.osr_compiles != 1) {
+        std::cerr << "    [ERROR] Expected one OSR continuation, got " << osr.osr_compiles << "\n";
+        jit_unload_module(mod);
+        jit_destroy(ctx);
+        return 1;
+    }
+    std::cout << "    [OK] strlen moved to its O3 continuation mid-loop (results unchanged)\n\n";
+
+    // 7d. Explicit tier-up through jit_recompile_function
+    std::cout << "[7d] Tiered recompilation:\n";
+    JITStats tiered = {};
+    if (!run_tier_up(&tiered) || tiered.reoptimizations != 2) {
+        std::cerr << "    [ERROR] Expected two reoptimizations, got " << tiered.reoptimizations << "\n";
+        jit_unload_module(mod);
+        jit_destroy(ctx);
+        return 1;
+    }
+    std::cout << "    [OK] strlen tiered O0 -> O1 -> O2/O3 behind a stable stub\n\n";
+
+    // 7e. Per-tier target and loop trip-count profile
+    std::cout << "[7e] Tier target and loop profile:\n";
+    if (!run_loop_profile()) {
+        jit_unload_module(mod);
+        jit_destroy(ctx);
+        return 1;
+    }
+    std::cout << "    [OK] Long strlen loop exported with llvm.loop.vectorize.enable\n\n";
+
     // 8. Cleanup
     std::cout << "[8] Cleaning up...\n";
     jit_unload_module(mod);
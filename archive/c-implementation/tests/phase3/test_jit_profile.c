@@ -0,0 +1,112 @@
+// Test the JIT profiler name index and shadow stacks in userspace
+// Build: gcc -O2 -I../../kernel_lib test_jit_profile.c ../../kernel_lib/jit/profile.c -o test_jit_profile
+#include <stdio.h>
+#include <string.h>
+#include "jit/profile.h"
+
+// Serial output goes to stdout; remember whether a lookup failed
+static int g_not_found = 0;
+
+void serial_puts(const char* str) {
+    if (strstr(str, "not found")) {
+        g_not_found = 1;
+    }
+    fputs(str, stdout);
+}
+
+void serial_put_uint64(uint64_t value) {
+    printf("%llu", (unsigned long long)value);
+}
+
+static jit_profile_t g_prof;
+static int g_failures = 0;
+
+#define CHECK(cond, msg) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAIL: %s\n", msg); \
+            g_failures++; \
+        } \
+    } while (0)
+
+static void test_register_lookup(void) {
+    printf("[Test] Register and look up\n");
+    jit_profile_init(&g_prof);
+
+    jit_func_id_t a = jit_profile_register(&g_prof, "matmul");
+    jit_func_id_t b = jit_profile_register(&g_prof, "softmax");
+    CHECK(a == 0 && b == 1, "IDs not handed out in order");
+    CHECK(jit_profile_register(&g_prof, "matmul") == a, "Same name got a new ID");
+    CHECK(g_prof.num_functions == 2, "Duplicate entry created");
+
+    jit_profile_begin(&g_prof, "softmax");
+    jit_profile_end(&g_prof, "softmax");
+    CHECK(jit_get_call_count(&g_prof, "softmax") == 1, "Call not recorded by name");
+    CHECK(jit_get_call_count(&g_prof, "matmul") == 0, "Call charged to the wrong name");
+    CHECK(jit_get_call_count(&g_prof, "missing") == 0, "Unknown name has calls");
+}
+
+static void test_nesting(void) {
+    printf("[Test] Nested calls\n");
+    jit_profile_init(&g_prof);
+
+    jit_func_id_t outer = jit_profile_register(&g_prof, "forward");
+    jit_func_id_t inner = jit_profile_register(&g_prof, "attention");
+
+    for (int i = 0; i < 10; i++) {
+        jit_profile_begin_id(&g_prof, outer);
+        jit_profile_begin_id(&g_prof, inner);
+        jit_profile_end_id(&g_prof, inner);
+        jit_profile_end_id(&g_prof, outer);
+    }
+
+    jit_profile_entry_t* o = &g_prof.functions[outer];
+    jit_profile_entry_t* n = &g_prof.functions[inner];
+    CHECK(o->call_count == 10 && n->call_count == 10, "Wrong call counts");
+    CHECK(o->total_cycles >= n->total_cycles, "Outer shorter than the call it contains");
+    CHECK(o->self_cycles == o->total_cycles - n->total_cycles, "Inner time not subtracted from outer");
+    CHECK(g_prof.stacks[0].depth == 0 && g_prof.stacks[0].mismatches == 0, "Shadow stack unbalanced");
+
+    // An end() skipped by an early return is unwound by the caller's end()
+    jit_profile_begin_id(&g_prof, outer);
+    jit_profile_begin_id(&g_prof, inner);
+    jit_profile_end_id(&g_prof, outer);
+    CHECK(g_prof.stacks[0].depth == 0, "Skipped frame not unwound");
+    CHECK(g_prof.stacks[0].mismatches == 1, "Skipped end() not counted");
+}
+
+static void test_long_names(void) {
+    printf("[Test] Names longer than JIT_MAX_FUNC_NAME\n");
+    jit_profile_init(&g_prof);
+
+    const char* name = "tinyllama_attention_head_projection_kernel";
+    CHECK(strlen(name) >= JIT_MAX_FUNC_NAME, "Test name too short");
+
+    for (int i = 0; i < 100; i++) {
+        jit_profile_begin(&g_prof, name);
+        jit_profile_end(&g_prof, name);
+    }
+
+    CHECK(g_prof.num_functions == 1, "Long name registered more than once");
+    CHECK(g_prof.stacks[0].depth == 0 && g_prof.stacks[0].mismatches == 0, "end() did not find the ID");
+    CHECK(jit_get_call_count(&g_prof, name) == 100, "Calls lost under the full name");
+    CHECK(jit_get_call_count(&g_prof, g_prof.functions[0].name) == 100,
+          "Calls lost under the stored name");
+
+    g_not_found = 0;
+    jit_print_all_stats(&g_prof);
+    CHECK(!g_not_found, "Stored name not found when printing");
+}
+
+int main() {
+    test_register_lookup();
+    test_nesting();
+    test_long_names();
+
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("All profiler tests passed\n");
+    return 0;
+}
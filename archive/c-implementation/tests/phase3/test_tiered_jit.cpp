@@ -86,9 +86,9 @@ struct TieredFunction {
     }
 
     bool shouldRecompile() const {
-        if (call_count == WARM_THRESHOLD && current_level == OPT_O0) return true;
-        if (call_count == HOT_THRESHOLD && current_level == OPT_O1) return true;
-        if (call_count == VERY_HOT_THRESHOLD && current_level == OPT_O2) return true;
+        if (call_count >= WARM_THRESHOLD && current_level == OPT_O0) return true;
+        if (call_count >= HOT_THRESHOLD && current_level == OPT_O1) return true;
+        if (call_count >= VERY_HOT_THRESHOLD && current_level == OPT_O2) return true;
         return false;
     }
 
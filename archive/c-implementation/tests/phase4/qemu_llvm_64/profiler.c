@@ -1,23 +1,65 @@
 #include "profiler.h"
+#include <stddef.h>
 #include <stdint.h>
 
 // Bare-metal definitions
-#define NULL ((void*)0)
 #define UINT64_MAX 0xFFFFFFFFFFFFFFFFULL
 
+#define AGGREGATE_BATCH 256
+
+// profiler_poll() drains once a ring is this full
+#define POLL_HIGH_WATER (TRACE_RING_SIZE / 2)
+
 // Forward declaration - serial.c
 extern void serial_puts(const char* str);
 
+// Forward declaration - malloc_simple.c
+extern void* malloc(size_t size);
+extern void free(void* ptr);
+
 // Global profiler instance
 static Profiler g_profiler = {0};
 
-// Read CPU cycle counter (rdtsc)
-static inline uint64_t read_tsc(void) {
-    uint32_t lo, hi;
-    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
-    return ((uint64_t)hi << 32) | lo;
+static void profiler_lock(void) {
+    while (__atomic_exchange_n(&g_profiler.lock, 1, __ATOMIC_ACQUIRE)) {
+        __asm__ volatile ("pause");
+    }
 }
 
+static int profiler_trylock(void) {
+    return !__atomic_exchange_n(&g_profiler.lock, 1, __ATOMIC_ACQUIRE);
+}
+
+static void profiler_unlock(void) {
+    __atomic_store_n(&g_profiler.lock, 0, __ATOMIC_RELEASE);
+}
+
+static void reset_entry(ProfileEntry* entry, const char* name) {
+    entry->name = name;
+    entry->call_count = 0;
+    entry->total_cycles = 0;
+    entry->min_cycles = UINT64_MAX;
+    entry->max_cycles = 0;
+}
+
+// Double the entry table (caller holds the lock)
+static int grow_entries(void) {
+    int new_capacity = g_profiler.capacity ? g_profiler.capacity * 2 : 32;
+    ProfileEntry* entries = (ProfileEntry*)malloc((size_t)new_capacity * sizeof(ProfileEntry));
+    if (!entries) return -1;
+
+    for (int i = 0; i < g_profiler.num_entries; i++) {
+        entries[i] = g_profiler.entries[i];
+    }
+
+    free(g_profiler.entries);
+    g_profiler.entries = entries;
+    g_profiler.capacity = new_capacity;
+    return 0;
+}
+
+static void hot_paths_locked(int* hot_indices, int max_count);
+
 // Simple integer to string conversion
 static void uint64_to_str(uint64_t value, char* buf, int buf_size) {
     if (buf_size < 2) return;
@@ -46,61 +88,117 @@ static void uint64_to_str(uint64_t value, char* buf, int buf_size) {
 
 // Initialize profiler
 void profiler_init(void) {
-    for (int i = 0; i < MAX_PROFILED_FUNCTIONS; i++) {
-        g_profiler.entries[i].name = NULL;
-        g_profiler.entries[i].call_count = 0;
-        g_profiler.entries[i].total_cycles = 0;
-        g_profiler.entries[i].min_cycles = UINT64_MAX;
-        g_profiler.entries[i].max_cycles = 0;
-    }
     g_profiler.num_entries = 0;
     g_profiler.enabled = 1;  // Enabled by default
+    g_profiler.lock = 0;
+
+    // Boot CPU takes ring 0; other cores take theirs on their first record
+    trace_ring_init_cpu();
 
-    serial_puts("[Profiler] Initialized (rdtsc-based)\n");
+    serial_puts("[Profiler] Initialized (per-core trace rings)\n");
 }
 
 // Register a new function for profiling
 int profiler_register(const char* name) {
-    if (g_profiler.num_entries >= MAX_PROFILED_FUNCTIONS) {
-        serial_puts("[Profiler] ERROR: Max functions reached\n");
+    profiler_lock();
+
+    if (g_profiler.num_entries >= g_profiler.capacity && grow_entries() != 0) {
+        profiler_unlock();
+        serial_puts("[Profiler] ERROR: Out of memory for function table\n");
         return -1;
     }
 
-    int index = g_profiler.num_entries++;
-    g_profiler.entries[index].name = name;
-    g_profiler.entries[index].call_count = 0;
-    g_profiler.entries[index].total_cycles = 0;
-    g_profiler.entries[index].min_cycles = UINT64_MAX;
-    g_profiler.entries[index].max_cycles = 0;
+    int index = g_profiler.num_entries;
+    reset_entry(&g_profiler.entries[index], name);
+    g_profiler.num_entries = index + 1;
 
+    profiler_unlock();
     return index;
 }
 
 // Start timing a function call
 uint64_t profiler_start(void) {
     if (!g_profiler.enabled) return 0;
-    return read_tsc();
+    uint32_t cpu;
+    return trace_ring_now(&cpu);
 }
 
-// End timing and record results
+// End timing and record results (lock-free: one store into this core's ring)
 void profiler_end(int func_index, uint64_t start_cycles) {
-    if (!g_profiler.enabled || func_index < 0 || func_index >= g_profiler.num_entries) {
+    if (!g_profiler.enabled || func_index < 0) {
         return;
     }
 
-    uint64_t end_cycles = read_tsc();
-    uint64_t elapsed = end_cycles - start_cycles;
+    uint32_t cpu;
+    uint64_t end_cycles = trace_ring_now(&cpu);
+    trace_ring_push(cpu, (uint32_t)func_index, start_cycles, end_cycles - start_cycles);
+}
+
+// Drain all rings into the aggregated entries (caller holds the lock)
+static void aggregate_locked(void) {
+    TraceRecord batch[AGGREGATE_BATCH];
+
+    for (uint32_t cpu = 0; cpu < TRACE_MAX_CPUS; cpu++) {
+        uint32_t n;
+        while ((n = trace_ring_drain(cpu, batch, AGGREGATE_BATCH)) > 0) {
+            for (uint32_t i = 0; i < n; i++) {
+                if ((int)batch[i].func_id >= g_profiler.num_entries) continue;
+
+                ProfileEntry* entry = &g_profiler.entries[batch[i].func_id];
+                uint64_t elapsed = batch[i].tsc_delta;
+
+                entry->call_count++;
+                entry->total_cycles += elapsed;
+                if (elapsed < entry->min_cycles) {
+                    entry->min_cycles = elapsed;
+                }
+                if (elapsed > entry->max_cycles) {
+                    entry->max_cycles = elapsed;
+                }
+            }
+        }
+    }
+}
+
+void profiler_aggregate(void) {
+    profiler_lock();
+    aggregate_locked();
+    profiler_unlock();
+}
 
-    ProfileEntry* entry = &g_profiler.entries[func_index];
-    entry->call_count++;
-    entry->total_cycles += elapsed;
+static int rings_past(uint32_t level) {
+    for (uint32_t cpu = 0; cpu < TRACE_MAX_CPUS; cpu++) {
+        if (trace_ring_pending(cpu) >= level) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    if (elapsed < entry->min_cycles) {
-        entry->min_cycles = elapsed;
+void profiler_poll(void) {
+    // Another core already aggregating drains these rings too
+    if (rings_past(POLL_HIGH_WATER) && profiler_trylock()) {
+        aggregate_locked();
+        profiler_unlock();
     }
-    if (elapsed > entry->max_cycles) {
-        entry->max_cycles = elapsed;
+}
+
+void profiler_consumer_loop(void) {
+    for (;;) {
+        if (rings_past(1)) {
+            profiler_aggregate();
+        } else {
+            __asm__ volatile ("pause");
+        }
+    }
+}
+
+uint64_t profiler_dropped(void) {
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu <= TRACE_MAX_CPUS; cpu++) {
+        total += trace_ring_dropped(cpu);
     }
+    return total;
 }
 
 // Print profiling report
@@ -110,13 +208,27 @@ void profiler_report(void) {
     serial_puts("  Profiler Report (\"Grow to Shrink\")\n");
     serial_puts("========================================\n\n");
 
+    // Held for the whole report: registration may replace entries[]
+    profiler_lock();
+
     if (g_profiler.num_entries == 0) {
+        profiler_unlock();
         serial_puts("No functions profiled.\n\n");
         return;
     }
 
     char buf[32];
 
+    aggregate_locked();
+
+    uint64_t dropped = profiler_dropped();
+    if (dropped) {
+        serial_puts("  Dropped records (ring full): ");
+        uint64_to_str(dropped, buf, sizeof(buf));
+        serial_puts(buf);
+        serial_puts("\n\n");
+    }
+
     for (int i = 0; i < g_profiler.num_entries; i++) {
         ProfileEntry* entry = &g_profiler.entries[i];
 
@@ -165,7 +277,7 @@ void profiler_report(void) {
 
     // Find top 5 hot paths by total cycles
     int hot_indices[5] = {-1, -1, -1, -1, -1};
-    profiler_get_hot_paths(hot_indices, 5);
+    hot_paths_locked(hot_indices, 5);
 
     for (int i = 0; i < 5 && hot_indices[i] != -1; i++) {
         ProfileEntry* entry = &g_profiler.entries[hot_indices[i]];
@@ -185,6 +297,8 @@ void profiler_report(void) {
     serial_puts("Next: Boot 10-100 → JIT compile hot paths\n");
     serial_puts("      Boot 100+   → Dead code elimination\n");
     serial_puts("========================================\n\n");
+
+    profiler_unlock();
 }
 
 // Enable profiler
@@ -201,6 +315,13 @@ void profiler_disable(void) {
 
 // Identify hot paths (sorted by total cycles, descending)
 void profiler_get_hot_paths(int* hot_indices, int max_count) {
+    profiler_lock();
+    aggregate_locked();
+    hot_paths_locked(hot_indices, max_count);
+    profiler_unlock();
+}
+
+static void hot_paths_locked(int* hot_indices, int max_count) {
     // Simple selection sort to find top N
     for (int i = 0; i < max_count; i++) {
         hot_indices[i] = -1;
@@ -2,9 +2,7 @@
 #define PROFILER_H
 
 #include <stdint.h>
-
-// Maximum number of profiled functions
-#define MAX_PROFILED_FUNCTIONS 32
+#include "trace_ring.h"
 
 // Profiling entry for a single function
 typedef struct {
@@ -16,10 +14,14 @@ typedef struct {
 } ProfileEntry;
 
 // Profiler state
+// Calls are recorded into per-core trace rings (trace_ring.h); entries[]
+// only holds aggregated totals and grows with registration (no fixed limit)
 typedef struct {
-    ProfileEntry entries[MAX_PROFILED_FUNCTIONS];
+    ProfileEntry* entries;      // Indexed by function id
     int num_entries;
+    int capacity;
     int enabled;                // 0 = disabled, 1 = enabled
+    volatile int lock;          // Guards entries[] (registration, aggregation, report), never taken on the call path
 } Profiler;
 
 // Initialize profiler
@@ -34,6 +36,20 @@ uint64_t profiler_start(void);
 // End timing and record results
 void profiler_end(int func_index, uint64_t start_cycles);
 
+// Drain all per-core trace rings into the aggregated entries.
+void profiler_aggregate(void);
+
+// Cheap check for hot paths (e.g. once per token): drains only once some
+// ring is half full, and never waits for another core that is aggregating
+void profiler_poll(void);
+
+// Background consumer for a core that does not record: drains the rings
+// as records arrive. Never returns.
+void profiler_consumer_loop(void);
+
+// Total records dropped because a core's ring was full
+uint64_t profiler_dropped(void);
+
 // Print profiling report
 void profiler_report(void);
 
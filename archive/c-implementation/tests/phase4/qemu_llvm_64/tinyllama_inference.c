@@ -378,5 +378,9 @@ int tinyllama_forward_token(
     matmul_int8(logits, &model->output, x);
 
     free(x);
+
+    // Aggregation is left to a consumer core; this only drains rings that
+    // are filling up faster than it keeps up (or when there is none)
+    profiler_poll();
     return 0;
 }
@@ -0,0 +1,129 @@
+#include "trace_ring.h"
+
+#define IA32_GS_BASE 0xC0000101
+#define IA32_TSC_AUX 0xC0000103
+
+#define TRACE_CPU_MAGIC 0x52435254u     // "TRCR"
+
+static TraceRing g_rings[TRACE_MAX_CPUS];
+static int g_have_rdtscp = 0;
+static uint32_t g_cpus_claimed = 0;
+static uint64_t g_unowned_dropped = 0;  // Records of cores past TRACE_MAX_CPUS
+
+// Without RDTSCP: per-core block at the GS base. Nothing else in this
+// kernel uses GS. A core that never registered still has GS base 0; the
+// identity map covers address 0, and what sits there never matches the magic.
+typedef struct {
+    uint32_t magic;
+    uint32_t cpu;
+} TraceCpu;
+
+static TraceCpu g_trace_cpu[TRACE_MAX_CPUS + 1];
+
+static int cpu_has_rdtscp(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000));
+    if (eax < 0x80000001) return 0;
+
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000001));
+    return (edx >> 27) & 1;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    __asm__ volatile ("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+uint32_t trace_ring_init_cpu(void) {
+    // Same answer on every core, so racing first records are harmless
+    g_have_rdtscp = cpu_has_rdtscp();
+
+    uint32_t cpu = __atomic_fetch_add(&g_cpus_claimed, 1, __ATOMIC_RELAXED);
+    if (cpu >= TRACE_MAX_CPUS) {
+        cpu = TRACE_MAX_CPUS;
+    }
+
+    // RDTSCP returns IA32_TSC_AUX in ECX: one instruction gives both the
+    // timestamp and the ring index. 0 is the reset value, so store index + 1.
+    if (g_have_rdtscp) {
+        wrmsr(IA32_TSC_AUX, cpu + 1);
+    } else {
+        g_trace_cpu[cpu].magic = TRACE_CPU_MAGIC;
+        g_trace_cpu[cpu].cpu = cpu;
+        wrmsr(IA32_GS_BASE, (uint64_t)(uintptr_t)&g_trace_cpu[cpu]);
+    }
+    return cpu;
+}
+
+uint64_t trace_ring_now(uint32_t* cpu) {
+    uint32_t lo, hi;
+
+    if (g_have_rdtscp) {
+        uint32_t aux;
+        __asm__ volatile ("rdtscp" : "=a"(lo), "=d"(hi), "=c"(aux));
+        *cpu = aux ? aux - 1 : trace_ring_init_cpu();
+    } else {
+        // One GS-relative load instead of a serializing CPUID per call
+        uint32_t magic, index;
+        __asm__ volatile ("movl %%gs:0, %0\n\tmovl %%gs:4, %1" : "=r"(magic), "=r"(index));
+        *cpu = magic == TRACE_CPU_MAGIC ? index : trace_ring_init_cpu();
+        __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    }
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+void trace_ring_push(uint32_t cpu, uint32_t func_id, uint64_t tsc_start, uint64_t tsc_delta) {
+    if (cpu >= TRACE_MAX_CPUS) {
+        __atomic_fetch_add(&g_unowned_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    TraceRing* ring = &g_rings[cpu];
+
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= TRACE_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+
+    TraceRecord* rec = &ring->records[head & TRACE_RING_MASK];
+    rec->func_id = func_id;
+    rec->tsc_delta = tsc_delta > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)tsc_delta;
+    rec->tsc_start = tsc_start;
+
+    // Publish the record before the aggregator can see the new head
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t trace_ring_pending(uint32_t cpu) {
+    if (cpu >= TRACE_MAX_CPUS) return 0;
+    TraceRing* ring = &g_rings[cpu];
+
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return (uint32_t)(head - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED));
+}
+
+uint32_t trace_ring_drain(uint32_t cpu, TraceRecord* out, uint32_t max) {
+    if (cpu >= TRACE_MAX_CPUS) return 0;
+    TraceRing* ring = &g_rings[cpu];
+
+    uint64_t tail = ring->tail;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    uint32_t n = 0;
+    while (tail != head && n < max) {
+        out[n++] = ring->records[tail & TRACE_RING_MASK];
+        tail++;
+    }
+
+    // Hand the slots back to the producer
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    return n;
+}
+
+uint64_t trace_ring_dropped(uint32_t cpu) {
+    if (cpu == TRACE_MAX_CPUS) {
+        return __atomic_load_n(&g_unowned_dropped, __ATOMIC_RELAXED);
+    }
+    return cpu < TRACE_MAX_CPUS ? g_rings[cpu].dropped : 0;
+}
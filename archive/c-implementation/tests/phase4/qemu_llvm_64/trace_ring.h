@@ -0,0 +1,58 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+
+// Per-core single-producer/single-consumer trace rings.
+//
+// Each core appends compact call records to its own ring with no locks and
+// no shared cache lines; a single aggregator (profiler_aggregate) drains all
+// rings. A full ring drops the record and counts it instead of blocking.
+
+#define TRACE_MAX_CPUS 16
+#define TRACE_RING_SIZE 4096           // Records per core (power of 2)
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+#define TRACE_CACHE_LINE 64
+
+// One profiled call (16 bytes)
+typedef struct {
+    uint32_t func_id;
+    uint32_t tsc_delta;                // Saturates at 0xFFFFFFFF cycles
+    uint64_t tsc_start;
+} TraceRecord;
+
+typedef struct {
+    // Producer side (owning core only)
+    volatile uint64_t head __attribute__((aligned(TRACE_CACHE_LINE)));
+    uint64_t dropped;
+    // Consumer side (aggregator only)
+    volatile uint64_t tail __attribute__((aligned(TRACE_CACHE_LINE)));
+    TraceRecord records[TRACE_RING_SIZE] __attribute__((aligned(TRACE_CACHE_LINE)));
+} TraceRing;
+
+// Give the calling core the next free ring and cache its index where
+// trace_ring_now() finds it without CPUID (IA32_TSC_AUX with RDTSCP, a
+// per-core block at the GS base without). A core runs this on its first
+// record, so APs need no bring-up hook; profiler_init() runs it on the
+// boot core so that core gets ring 0. Returns the ring index, or
+// TRACE_MAX_CPUS when every ring is taken (the core's records are dropped).
+uint32_t trace_ring_init_cpu(void);
+
+// Current TSC and the calling core's ring index
+uint64_t trace_ring_now(uint32_t* cpu);
+
+// Append a record to the calling core's ring (lock-free, wait-free)
+void trace_ring_push(uint32_t cpu, uint32_t func_id, uint64_t tsc_start, uint64_t tsc_delta);
+
+// Records waiting in one core's ring
+uint32_t trace_ring_pending(uint32_t cpu);
+
+// Drain up to 'max' records from one core's ring (aggregator only)
+// Returns the number of records copied to 'out'
+uint32_t trace_ring_drain(uint32_t cpu, TraceRecord* out, uint32_t max);
+
+// Records dropped on 'cpu' because its ring was full
+// (cpu == TRACE_MAX_CPUS: records of cores that got no ring)
+uint64_t trace_ring_dropped(uint32_t cpu);
+
+#endif // TRACE_RING_H
@@ -2,7 +2,12 @@
  * Test: C++ Runtime Validation
  *
  * Validates that the bare-metal C++ runtime works correctly.
- * Tests: operator new/delete, static initialization, simple classes.
+ * Tests: operator new/delete, static initialization, simple classes,
+ * compile-session arenas.
+ *
+ * Build (links the kernel_lib operator new/delete over the host's):
+ *   g++ -fno-exceptions -fno-rtti test_cpp_runtime.cpp \
+ *     ../../kernel_lib/cpp_runtime/new.cpp -o test_cpp_runtime
  */
 
 #include <stddef.h>
@@ -21,6 +26,8 @@ extern "C" {
 #include <unistd.h>
 #include <stdio.h>
 
+#include "../../kernel_lib/cpp_runtime/compile_arena.h"
+
 // ============================================================================
 // Test Classes
 // ============================================================================
@@ -149,6 +156,69 @@ void test_constructors_destructors() {
     printf("  ✅ PASS: RAII works correctly\n");
 }
 
+static bool in_region(const void* ptr, const uint8_t* base, size_t capacity) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return p >= base && p < base + capacity;
+}
+
+bool test_compile_arena() {
+    printf("\n=== Test 6: Compile-Session Arena ===\n");
+
+    SimpleClass* late = nullptr;
+    SimpleClass* kept = nullptr;
+    uint8_t* first_base = nullptr;
+    size_t capacity = 0;
+    {
+        CompileArenaScope session(64 * 1024);
+        if (!session.active()) {
+            printf("  ❌ FAIL: Session did not start\n");
+            return false;
+        }
+        first_base = session.stats().base;
+        capacity = session.stats().capacity;
+
+        int* scratch = new int[16];
+        late = new SimpleClass(7);
+        {
+            CompileArenaEscape escape;
+            kept = new SimpleClass(8);
+        }
+        if (!in_region(scratch, first_base, capacity) || !in_region(late, first_base, capacity)) {
+            printf("  ❌ FAIL: Session allocation not served from the region\n");
+            return false;
+        }
+        if (in_region(kept, first_base, capacity)) {
+            printf("  ❌ FAIL: Escaped allocation landed in the region\n");
+            return false;
+        }
+        if (session.stats().num_allocs != 2) {
+            printf("  ❌ FAIL: Expected 2 region allocations, got %zu\n", session.stats().num_allocs);
+            return false;
+        }
+        delete[] scratch;
+    }
+    if (compile_arena_current() != nullptr) {
+        printf("  ❌ FAIL: Session still active after scope\n");
+        return false;
+    }
+
+    // Deleting a session object after the session ended must not reach free()
+    delete late;
+    delete kept;
+
+    {
+        CompileArenaScope session(16 * 1024);
+        if (!session.active() || session.stats().base != first_base) {
+            printf("  ❌ FAIL: Ended region not reused by the next session\n");
+            return false;
+        }
+        delete new int(1);
+    }
+
+    printf("  ✅ PASS: Compile-session arena works\n");
+    return true;
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -171,6 +241,9 @@ int main() {
     test_virtual_functions();
     test_static_local();
     test_constructors_destructors();
+    if (!test_compile_arena()) {
+        return 1;
+    }
 
     // Call static local test again to verify guard
     test_static_local();
@@ -183,6 +256,7 @@ int main() {
     printf("   - Static initialization: ✓\n");
     printf("   - Constructors/destructors: ✓\n");
     printf("   - RAII scope management: ✓\n");
+    printf("   - Compile-session arenas: ✓\n");
     printf("\n");
     printf("Ready for LLVM integration!\n");
 
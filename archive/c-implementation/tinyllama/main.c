@@ -83,6 +83,11 @@ void main(void) {
     jit_profile_t profiler;
     jit_profile_init(&profiler);
 
+    // Intern function IDs once; begin/end below are then index + rdtsc
+    jit_func_id_t fib_id = jit_profile_register(&profiler, "fibonacci");
+    jit_func_id_t sum_id = jit_profile_register(&profiler, "sum_to_n");
+    jit_func_id_t primes_id = jit_profile_register(&profiler, "count_primes");
+
     vga_setcolor(0x0F, 0x00);  // White on black
 
     // ========================================================================
@@ -114,9 +119,9 @@ void main(void) {
     serial_puts("[tinyllama] Running Fibonacci test...\n");
 
     for (int i = 0; i < 10; i++) {
-        jit_profile_begin(&profiler, "fibonacci");
+        jit_profile_begin_id(&profiler, fib_id);
         int result = fibonacci(10);
-        jit_profile_end(&profiler, "fibonacci");
+        jit_profile_end_id(&profiler, fib_id);
 
         if (i == 0) {
             vga_writestring("  First result: ");
@@ -149,9 +154,9 @@ void main(void) {
     serial_puts("[tinyllama] Running Sum test...\n");
 
     for (int i = 0; i < 100; i++) {
-        jit_profile_begin(&profiler, "sum_to_n");
+        jit_profile_begin_id(&profiler, sum_id);
         int result = sum_to_n(1000);
-        jit_profile_end(&profiler, "sum_to_n");
+        jit_profile_end_id(&profiler, sum_id);
 
         if (i == 0) {
             vga_writestring("  First result: ");
@@ -184,9 +189,9 @@ void main(void) {
     serial_puts("[tinyllama] Running Prime counting test...\n");
 
     for (int i = 0; i < 5; i++) {
-        jit_profile_begin(&profiler, "count_primes");
+        jit_profile_begin_id(&profiler, primes_id);
         int result = count_primes(100);
-        jit_profile_end(&profiler, "count_primes");
+        jit_profile_end_id(&profiler, primes_id);
 
         if (i == 0) {
             vga_writestring("  Primes found: ");
@@ -12,6 +12,7 @@
 
 #include "../kernel_lib/runtime.h"
 #include "../kernel_lib/jit_runtime.h"
+#include "../kernel_lib/memory/alloc_profile.h"
 
 // External functions from kernel_lib_llvm.a
 extern void* malloc(size_t size);
@@ -180,6 +181,40 @@ static int test_string_functions(void) {
     return 0;
 }
 
+static int test_alloc_profile(void) {
+    serial_puts("=== Test 5: Allocation Profile ===\n");
+
+    const alloc_profile_t* prof = alloc_profile_get();
+    uint64_t allocs_before = prof->total_allocs;
+    uint64_t class_before = prof->classes[alloc_profile_size_class(64)].allocs;
+
+    void* p = malloc(64);
+    if (!p) {
+        serial_puts("  FAIL: malloc(64) returned NULL\n\n");
+        return 1;
+    }
+
+    if (prof->total_allocs != allocs_before + 1) {
+        serial_puts("  FAIL: allocation not recorded\n\n");
+        return 1;
+    }
+    if (prof->classes[alloc_profile_size_class(64)].allocs != class_before + 1) {
+        serial_puts("  FAIL: size class not charged\n\n");
+        return 1;
+    }
+    if (prof->peak_live_bytes < prof->live_bytes) {
+        serial_puts("  FAIL: peak below live bytes\n\n");
+        return 1;
+    }
+
+    free(p);
+
+    serial_puts("  Allocations recorded: ");
+    serial_put_uint((uint32_t)prof->total_allocs);
+    serial_puts("\n  PASS\n\n");
+    return 0;
+}
+
 // ============================================================================
 // Main Entry Point
 // ============================================================================
@@ -202,12 +237,13 @@ void main(void) {
     failures += test_large_allocation();
     failures += test_calloc();
     failures += test_string_functions();
+    failures += test_alloc_profile();
 
     print_stats("Final state");
 
     if (failures == 0) {
         serial_puts("========================================\n");
-        serial_puts("  ALL TESTS PASSED (4/4)\n");
+        serial_puts("  ALL TESTS PASSED (5/5)\n");
         serial_puts("========================================\n\n");
 
         serial_puts("Validation:\n");
@@ -217,6 +253,7 @@ void main(void) {
         serial_puts("  Large allocations (10 MB) working\n");
         serial_puts("  String functions working\n");
         serial_puts("  Serial I/O working\n");
+        serial_puts("  Allocation profile recording\n");
         serial_puts("\n");
         serial_puts("kernel_lib_llvm.a validated in QEMU!\n");
         serial_puts("\n");
@@ -228,6 +265,8 @@ void main(void) {
         serial_puts("========================================\n");
     }
 
+    alloc_profile_export_json();
+
     serial_puts("\nSystem halted. Close QEMU to exit.\n");
 
     // Halt
@@ -8,7 +8,7 @@
 
 // External functions
 extern void* memset(void* s, int c, size_t n);
-extern uint64_t rdtsc(void);
+extern void* memcpy(void* dest, const void* src, size_t n);
 
 // ============================================================================
 // INITIALIZATION
@@ -22,6 +22,9 @@ int adaptive_jit_init(adaptive_jit_t* ajit) {
     // Initialize function profiler with JIT enabled
     function_profiler_init(&ajit->profiler, true);
 
+    // Serialized brackets for execute() (no frequency calibration)
+    timebase_init();
+
     ajit->enabled = true;
     ajit->function_count = 0;
 
@@ -39,6 +42,7 @@ void adaptive_jit_shutdown(adaptive_jit_t* ajit) {
         }
     }
 
+    function_profiler_destroy(&ajit->profiler);
     ajit->enabled = false;
 }
 
@@ -76,10 +80,17 @@ int adaptive_jit_register_function(
     entry->code_v3 = NULL;
     entry->current_code = initial_code;  // Start with O0
     entry->compiled_level = OPT_LEVEL_O0;
+    entry->pattern = MICRO_JIT_PATTERN_NONE;
+    entry->specialized = false;
+    entry->specialized_value = 0;
+    entry->deopt_count = 0;
+    entry->no_speculate = false;
+    entry->compile_queued = false;
+    entry->from_ir = false;
     entry->is_active = true;
 
-    // Initialize JIT context (we'll compile on demand)
-    micro_jit_init(&entry->jit_ctx, NULL);
+    // JIT context gets a fresh code buffer per tier on recompilation
+    memset(&entry->jit_ctx, 0, sizeof(entry->jit_ctx));
 
     ajit->function_count++;
 
@@ -90,6 +101,22 @@ int adaptive_jit_register_function(
     return func_id;
 }
 
+int adaptive_jit_register_specializable(
+    adaptive_jit_t* ajit,
+    const char* func_name,
+    const char* module_name,
+    void* generic_code,
+    micro_jit_pattern_t pattern)
+{
+    if (!generic_code || pattern == MICRO_JIT_PATTERN_NONE) return -1;
+
+    int func_id = adaptive_jit_register_function(ajit, func_name, module_name, generic_code);
+    if (func_id < 0) return -1;
+
+    ajit->functions[func_id].pattern = pattern;
+    return func_id;
+}
+
 // ============================================================================
 // ATOMIC CODE SWAPPING
 // ============================================================================
@@ -109,41 +136,370 @@ void adaptive_jit_swap_code(jit_function_entry_t* entry, void* new_code, opt_lev
     serial_puts("\n");
 }
 
+// Replace every version pointer that refers to old_code
+static void patch_code_refs(jit_function_entry_t* entry, void* old_code, void* new_code) {
+    if (entry->from_ir && entry->code_v0 == old_code) entry->code_v0 = new_code;
+    if (entry->code_v1 == old_code) entry->code_v1 = new_code;
+    if (entry->code_v2 == old_code) entry->code_v2 = new_code;
+    if (entry->code_v3 == old_code) entry->code_v3 = new_code;
+
+    if (entry->current_code == old_code) {
+        __atomic_store_n(&entry->current_code, new_code, __ATOMIC_RELEASE);
+    }
+}
+
+// Free a superseded tier and clear the version pointers into it
+static void retire_code(jit_function_entry_t* entry, micro_jit_ctx_t* ctx) {
+    if (!ctx->code_buffer) return;
+
+    patch_code_refs(entry, jit_code_exec_address(ctx->code_buffer), NULL);
+    micro_jit_destroy(ctx);
+}
+
+// ============================================================================
+// DIRECT CALL SITES
+// ============================================================================
+
+// CPUID is serializing: this core refetches instructions after it
+static void serialize_instruction_fetch(void) {
+    uint32_t eax = 0, ebx, ecx = 0, edx;
+    asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx) : : "memory");
+}
+
+// Point a compiled site at its callee's current code. baseline_jit aligns
+// the rel32 field to 4 bytes, so this is one atomic store: a core running
+// the caller meanwhile fetches the old or the new target, never a torn one.
+// Returns true if the displacement changed.
+static bool patch_call_site(adaptive_jit_t* ajit, jit_call_site_t* site) {
+    micro_jit_ctx_t* ctx = &ajit->functions[site->caller].jit_ctx;
+    void* target = __atomic_load_n(&ajit->functions[site->callee].current_code, __ATOMIC_ACQUIRE);
+    if (!ctx->code_buffer || !target) return false;
+
+    uint32_t* field = (uint32_t*)(ctx->code_buffer + site->offset);
+    uintptr_t next = (uintptr_t)jit_code_exec_address(ctx->code_buffer) + site->offset + 4;
+    uint32_t rel = (uint32_t)((uintptr_t)target - next);
+    if (__atomic_load_n(field, __ATOMIC_RELAXED) == rel) return false;
+
+    // No-ops under dual mapping, where the RW view is always writable
+    jit_mark_writable(field, sizeof(rel));
+    __atomic_store_n(field, rel, __ATOMIC_RELEASE);
+    jit_mark_executable(field, sizeof(rel));
+
+    ajit->call_site_patches++;
+    return true;
+}
+
+// Re-target every compiled site calling 'callee_id' (-1: all of them)
+static void bind_call_sites(adaptive_jit_t* ajit, int callee_id) {
+    bool patched = false;
+
+    for (int i = 0; i < MAX_JIT_CALL_SITES; i++) {
+        jit_call_site_t* site = &ajit->call_sites[i];
+        if (!site->in_use || site->caller < 0) continue;
+        if (callee_id >= 0 && site->callee != callee_id) continue;
+        if (patch_call_site(ajit, site)) patched = true;
+    }
+
+    // Cross-modifying code: whoever runs the patched bytes must serialize
+    // first. Patching happens outside JIT code on the core that runs it next.
+    if (patched) {
+        serialize_instruction_fetch();
+    }
+}
+
+// Swap in new code and take the direct calls to the function along
+static void publish_code(adaptive_jit_t* ajit, jit_function_entry_t* entry,
+                         void* new_code, opt_level_t new_level) {
+    adaptive_jit_swap_code(entry, new_code, new_level);
+    bind_call_sites(ajit, (int)(entry - ajit->functions));
+}
+
+// Give the profiler what the sites counted: untimed calls of the callee and
+// the caller -> callee edge, keyed by return address like execute()'s edges
+static void collect_call_sites(adaptive_jit_t* ajit) {
+    function_profiler_t* profiler = &ajit->profiler;
+
+    for (int i = 0; i < MAX_JIT_CALL_SITES; i++) {
+        jit_call_site_t* site = &ajit->call_sites[i];
+        if (!site->in_use || site->caller < 0) continue;
+
+        uint32_t count = __atomic_load_n(&site->count, __ATOMIC_RELAXED);
+        uint32_t delta = count - site->counted;
+        if (delta == 0) continue;
+        site->counted = count;
+
+        jit_function_entry_t* caller = &ajit->functions[site->caller];
+        jit_function_entry_t* callee = &ajit->functions[site->callee];
+        function_profiler_record_untimed(profiler, callee->profiler_id, delta);
+
+        uint32_t return_address = (uint32_t)(uintptr_t)jit_code_exec_address(caller->jit_ctx.code_buffer) +
+                                  site->offset + 4;
+        uint64_t* edge = function_profiler_edge_counter(profiler, caller->profiler_id,
+                                                        callee->profiler_id, return_address);
+        if (edge) {
+            *edge += delta;
+        } else {
+            profiler->edges_dropped += delta;
+        }
+    }
+}
+
+// Drop the sites a caller's IR reserved but never got compiled
+static void release_ir_sites(adaptive_jit_t* ajit, const baseline_ir_t* ir) {
+    for (int i = 0; i < ir->num_insns; i++) {
+        const baseline_insn_t* insn = &ir->insns[i];
+        if (insn->op != BASELINE_OP_CALL_DIRECT) continue;
+        if (insn->imm < 0 || insn->imm >= MAX_JIT_CALL_SITES) continue;
+
+        jit_call_site_t* site = &ajit->call_sites[insn->imm];
+        if (site->caller < 0) {
+            site->in_use = false;
+        }
+    }
+}
+
+int adaptive_jit_emit_call(
+    adaptive_jit_t* ajit,
+    baseline_ir_t* ir,
+    int callee_id,
+    int ret_kind,
+    const int* args,
+    int argc)
+{
+    if (!ir) return -1;
+    if (!ajit || callee_id < 0 || callee_id >= ajit->function_count ||
+        !ajit->functions[callee_id].is_active) {
+        ir->error = true;
+        return -1;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < MAX_JIT_CALL_SITES; i++) {
+        if (!ajit->call_sites[i].in_use) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        ir->error = true;
+        return -1;
+    }
+
+    jit_call_site_t* site = &ajit->call_sites[slot];
+    memset(site, 0, sizeof(jit_call_site_t));
+    site->caller = -1;
+    site->callee = callee_id;
+    site->in_use = true;
+
+    // Bound to today's code; register_ir re-binds if the callee moves first
+    void* target = __atomic_load_n(&ajit->functions[callee_id].current_code, __ATOMIC_ACQUIRE);
+    int dst = baseline_ir_call_direct(ir, target, &site->count, slot, ret_kind, args, argc);
+    if (ir->error) {
+        site->in_use = false;
+    }
+    return dst;
+}
+
+int adaptive_jit_register_ir(
+    adaptive_jit_t* ajit,
+    const char* func_name,
+    const char* module_name,
+    const baseline_ir_t* ir)
+{
+    if (!ajit || !ir) return -1;
+
+    micro_jit_ctx_t ctx;
+    void* code = NULL;
+    if (micro_jit_init(&ctx, NULL) == 0) {
+        code = baseline_jit_compile(&ctx, ir);
+        if (!code) {
+            micro_jit_destroy(&ctx);
+        }
+    }
+
+    int func_id = code ? adaptive_jit_register_function(ajit, func_name, module_name, code) : -1;
+    if (func_id < 0) {
+        if (code) {
+            micro_jit_destroy(&ctx);
+        }
+        release_ir_sites(ajit, ir);
+        return -1;
+    }
+
+    jit_function_entry_t* entry = &ajit->functions[func_id];
+    entry->jit_ctx = ctx;
+    entry->from_ir = true;
+    function_profiler_set_ir_size(&ajit->profiler, entry->profiler_id, (uint32_t)ir->num_insns);
+
+    for (int k = 0; k < ctx.num_patch_sites; k++) {
+        jit_call_site_t* site = &ajit->call_sites[ctx.patch_sites[k].tag];
+        site->caller = func_id;
+        site->offset = ctx.patch_sites[k].offset;
+    }
+    bind_call_sites(ajit, -1);
+
+    return func_id;
+}
+
 // ============================================================================
 // EXECUTION WITH PROFILING
 // ============================================================================
 
-int adaptive_jit_execute(adaptive_jit_t* ajit, int func_id) {
+// Crossed a tier threshold, or a clone deoptimized and must be reverted
+static bool needs_compile(adaptive_jit_t* ajit, jit_function_entry_t* entry) {
+    return (entry->specialized && entry->no_speculate) ||
+           function_profiler_needs_recompile(&ajit->profiler, entry->profiler_id);
+}
+
+// Shared by both execute entry points; 'callsite' is the caller's return
+// address so each call site gets its own edge counter
+static int execute_profiled(adaptive_jit_t* ajit, int func_id, bool has_arg,
+                            int32_t arg, uint32_t callsite) {
     if (!ajit || func_id < 0 || func_id >= ajit->function_count) return -1;
 
     jit_function_entry_t* entry = &ajit->functions[func_id];
     if (!entry->is_active) return -1;
 
     // Get current code pointer (atomic load)
-    typedef int (*func_ptr_t)(void);
-    func_ptr_t func = (func_ptr_t)__atomic_load_n(&entry->current_code, __ATOMIC_ACQUIRE);
+    void* code = __atomic_load_n(&entry->current_code, __ATOMIC_ACQUIRE);
+
+    // Call-graph edge from the enclosing JIT function
+    function_profiler_t* profiler = &ajit->profiler;
+    int caller_id = profiler->current_func;
+    function_profiler_record_edge(profiler, caller_id, entry->profiler_id, callsite);
+
+    if (has_arg) {
+        function_profiler_record_arg(profiler, entry->profiler_id, 0, (uint32_t)arg);
+    }
 
     // Profile execution
-    uint64_t start = rdtsc();
-    int result = func();
-    uint64_t end = rdtsc();
-    uint64_t cycles = end - start;
+    pmu_counts_t pmu_start, pmu_end, pmu_diff;
+    pmu_read(&pmu_start);
+    profiler->current_func = entry->profiler_id;
+    uint64_t start = timebase_begin();
+    int result = has_arg ? ((int (*)(int))code)(arg) : ((int (*)(void))code)();
+    uint64_t end = timebase_end();
+    profiler->current_func = caller_id;
+    pmu_read(&pmu_end);
+    uint64_t cycles = timebase_elapsed(start, end);
 
     // Record in profiler
-    function_profiler_record(&ajit->profiler, entry->profiler_id, cycles);
+    pmu_delta(&pmu_start, &pmu_end, &pmu_diff);
+    function_profiler_record_pmu(&ajit->profiler, entry->profiler_id, cycles, &pmu_diff);
 
-    // Check if recompilation is needed
-    if (function_profiler_needs_recompile(&ajit->profiler, entry->profiler_id)) {
-        adaptive_jit_recompile_function(ajit, func_id);
+    // Tier-up is left to an idle slice; the caller only pays for the flag
+    if (!entry->compile_queued && needs_compile(ajit, entry)) {
+        entry->compile_queued = true;
+        ajit->compile_pending++;
     }
 
     return result;
 }
 
+int adaptive_jit_execute(adaptive_jit_t* ajit, int func_id) {
+    return execute_profiled(ajit, func_id, false, 0,
+                            (uint32_t)(uintptr_t)__builtin_return_address(0));
+}
+
+int adaptive_jit_execute_arg(adaptive_jit_t* ajit, int func_id, int32_t arg) {
+    return execute_profiled(ajit, func_id, true, arg,
+                            (uint32_t)(uintptr_t)__builtin_return_address(0));
+}
+
 // ============================================================================
 // RECOMPILATION
 // ============================================================================
 
+static void set_tier_code(jit_function_entry_t* entry, opt_level_t level, void* code) {
+    if (level == OPT_LEVEL_O1) entry->code_v1 = code;
+    else if (level == OPT_LEVEL_O2) entry->code_v2 = code;
+    else if (level == OPT_LEVEL_O3) entry->code_v3 = code;
+}
+
+// Deopt hook of specialized clones. It runs inside the clone that failed
+// its guard, so it only flags the entry; the clone is retired later.
+static void on_guard_failure(void* arg) {
+    jit_function_entry_t* entry = (jit_function_entry_t*)arg;
+    entry->deopt_count++;
+    entry->no_speculate = true;
+}
+
+// Put the generic code back in place of a clone whose guard failed
+static int revert_deoptimized(adaptive_jit_t* ajit, jit_function_entry_t* entry,
+                              opt_level_t level) {
+    serial_puts("[DEOPT] ");
+    serial_puts(ajit->profiler.functions[entry->profiler_id].name);
+    serial_puts(": guard failed ");
+    serial_put_uint(entry->deopt_count);
+    serial_puts("x, back to generic code\n");
+
+    publish_code(ajit, entry, entry->code_v0, level);
+    retire_code(entry, &entry->jit_ctx);
+    entry->specialized = false;
+    return 1;
+}
+
+// Tier-up of a pattern function: a guarded clone for the dominant argument
+// value, or the generic code while calls are spread over several values
+// (or once speculation has failed for it)
+static int recompile_specialized(adaptive_jit_t* ajit, jit_function_entry_t* entry,
+                                 opt_level_t next_level) {
+    const value_profile_t* args = function_profiler_arg_profile(&ajit->profiler,
+                                                                entry->profiler_id, 0);
+    uint32_t value = 0;
+
+    if (entry->no_speculate ||
+        !value_profile_dominant(args, SPECIALIZE_MIN_SHARE, SPECIALIZE_MIN_SAMPLES, &value)) {
+        serial_puts(entry->no_speculate ? "[SPECIALIZE] Deoptimized before, keeping generic code\n"
+                                        : "[SPECIALIZE] No dominant argument, keeping generic code\n");
+        if (entry->specialized) {
+            // The workload moved off the old constant: stop paying for the guard
+            publish_code(ajit, entry, entry->code_v0, next_level);
+            retire_code(entry, &entry->jit_ctx);
+            entry->specialized = false;
+        }
+        entry->compiled_level = next_level;
+        function_profiler_mark_recompiled(&ajit->profiler, entry->profiler_id, next_level);
+        return 0;
+    }
+
+    if (entry->specialized && entry->specialized_value == (int32_t)value) {
+        // Clone is still right for the workload; nothing to regenerate
+        set_tier_code(entry, next_level, entry->current_code);
+        entry->compiled_level = next_level;
+        function_profiler_mark_recompiled(&ajit->profiler, entry->profiler_id, next_level);
+        return 0;
+    }
+
+    micro_jit_ctx_t new_ctx;
+    if (micro_jit_init(&new_ctx, NULL) != 0) {
+        return -1;
+    }
+
+    void* new_code = micro_jit_compile_guarded(&new_ctx, entry->pattern, (int32_t)value,
+                                               on_guard_failure, entry);
+    if (!new_code) {
+        micro_jit_destroy(&new_ctx);
+        return -1;
+    }
+
+    serial_puts("[SPECIALIZE] ");
+    serial_puts(micro_jit_pattern_name(entry->pattern));
+    serial_puts("(n == ");
+    serial_put_uint(value);
+    serial_puts(") clone, guard deoptimizes to generic\n");
+
+    set_tier_code(entry, next_level, new_code);
+    publish_code(ajit, entry, new_code, next_level);
+    retire_code(entry, &entry->jit_ctx);
+    entry->jit_ctx = new_ctx;
+    entry->specialized = true;
+    entry->specialized_value = (int32_t)value;
+
+    function_profiler_mark_recompiled(&ajit->profiler, entry->profiler_id, next_level);
+    return 1;
+}
+
 int adaptive_jit_recompile_function(adaptive_jit_t* ajit, int func_id) {
     if (!ajit || func_id < 0 || func_id >= ajit->function_count) return -1;
 
@@ -153,14 +509,16 @@ int adaptive_jit_recompile_function(adaptive_jit_t* ajit, int func_id) {
     opt_level_t current = profile->opt_level;
     opt_level_t next_level = OPT_LEVEL_O0;
 
-    // Determine next optimization level
-    if (current == OPT_LEVEL_O0 && profile->call_count >= JIT_THRESHOLD_O1) {
-        next_level = OPT_LEVEL_O1;
-    } else if (current == OPT_LEVEL_O1 && profile->call_count >= JIT_THRESHOLD_O2) {
-        next_level = OPT_LEVEL_O2;
-    } else if (current == OPT_LEVEL_O2 && profile->call_count >= JIT_THRESHOLD_O3) {
-        next_level = OPT_LEVEL_O3;
-    } else {
+    // Not from on_guard_failure(): the clone is still running there
+    if (entry->specialized && entry->no_speculate) {
+        return revert_deoptimized(ajit, entry, current);
+    }
+
+    // Re-run the cost model: the function may have cooled while queued, or
+    // grown hot enough since to skip a level
+    next_level = function_profiler_target_level(&ajit->profiler, entry->profiler_id);
+    if (next_level <= current) {
+        function_profiler_mark_recompiled(&ajit->profiler, entry->profiler_id, current);
         return 0;  // No recompilation needed
     }
 
@@ -170,7 +528,28 @@ int adaptive_jit_recompile_function(adaptive_jit_t* ajit, int func_id) {
     serial_putchar('0' + current);
     serial_puts(" -> O");
     serial_putchar('0' + next_level);
-    serial_puts("\n");
+    serial_puts(" (");
+    serial_puts(function_profiler_bound_name(function_profiler_classify(&ajit->profiler, entry->profiler_id)));
+    serial_puts("-bound)\n");
+
+    if (entry->pattern != MICRO_JIT_PATTERN_NONE) {
+        return recompile_specialized(ajit, entry, next_level);
+    }
+
+    if (entry->from_ir) {
+        // Baseline code is the only tier this tree generates from IR
+        set_tier_code(entry, next_level, entry->current_code);
+        entry->compiled_level = next_level;
+        function_profiler_mark_recompiled(&ajit->profiler, entry->profiler_id, next_level);
+        return 0;
+    }
+
+    // Each tier is emitted into its own buffer so the live version is never
+    // overwritten while the new one is being generated
+    micro_jit_ctx_t new_ctx;
+    if (micro_jit_init(&new_ctx, NULL) != 0) {
+        return -1;
+    }
 
     // For demonstration: fibonacci hardcoded compilation
     // In a real system, this would invoke LLVM with different -O levels
@@ -180,21 +559,26 @@ int adaptive_jit_recompile_function(adaptive_jit_t* ajit, int func_id) {
     // In practice, this would be Micro-JIT with different code generation strategies
     if (next_level == OPT_LEVEL_O1) {
         // Compile O1 version (same as O0 for now in demo)
-        new_code = micro_jit_compile_fibonacci(&entry->jit_ctx, 5);
+        new_code = micro_jit_compile_fibonacci(&new_ctx, 5);
         entry->code_v1 = new_code;
     } else if (next_level == OPT_LEVEL_O2) {
         // Compile O2 version
-        new_code = micro_jit_compile_fibonacci(&entry->jit_ctx, 5);
+        new_code = micro_jit_compile_fibonacci(&new_ctx, 5);
         entry->code_v2 = new_code;
     } else if (next_level == OPT_LEVEL_O3) {
         // Compile O3 version
-        new_code = micro_jit_compile_fibonacci(&entry->jit_ctx, 5);
+        new_code = micro_jit_compile_fibonacci(&new_ctx, 5);
         entry->code_v3 = new_code;
     }
 
     if (new_code) {
         // ATOMIC CODE SWAP - zero downtime!
-        adaptive_jit_swap_code(entry, new_code, next_level);
+        publish_code(ajit, entry, new_code, next_level);
+
+        // Retire the previous tier. Safe on a single core: recompilation runs
+        // from an idle slice (or an explicit call), never under JIT code.
+        retire_code(entry, &entry->jit_ctx);
+        entry->jit_ctx = new_ctx;
 
         // Mark as recompiled in profiler
         function_profiler_mark_recompiled(&ajit->profiler, entry->profiler_id, next_level);
@@ -202,21 +586,208 @@ int adaptive_jit_recompile_function(adaptive_jit_t* ajit, int func_id) {
         return 1;  // Success
     }
 
+    micro_jit_destroy(&new_ctx);
     return -1;  // Compilation failed
 }
 
 void adaptive_jit_check_and_recompile(adaptive_jit_t* ajit) {
     if (!ajit) return;
 
+    // Direct calls never pass through execute()
+    collect_call_sites(ajit);
+
     // Check all registered functions
     for (int i = 0; i < ajit->function_count; i++) {
         jit_function_entry_t* entry = &ajit->functions[i];
-        if (entry->is_active && function_profiler_needs_recompile(&ajit->profiler, entry->profiler_id)) {
-            adaptive_jit_recompile_function(ajit, i);
+        if (entry->is_active && !entry->compile_queued && needs_compile(ajit, entry)) {
+            entry->compile_queued = true;
+            ajit->compile_pending++;
         }
     }
 }
 
+// ============================================================================
+// BACKGROUND COMPILE QUEUE
+// ============================================================================
+
+// Hottest queued entry. Priority is read at dequeue time, so a function that
+// kept getting called while it waited moves ahead of the others.
+static int next_queued(adaptive_jit_t* ajit) {
+    int best = -1;
+    uint64_t best_calls = 0;
+
+    for (int i = 0; i < ajit->function_count; i++) {
+        jit_function_entry_t* entry = &ajit->functions[i];
+        if (!entry->is_active || !entry->compile_queued) continue;
+
+        uint64_t calls = ajit->profiler.functions[entry->profiler_id].call_count;
+        if (best < 0 || calls > best_calls) {
+            best = i;
+            best_calls = calls;
+        }
+    }
+
+    return best;
+}
+
+int adaptive_jit_compile_pending(adaptive_jit_t* ajit, uint64_t budget_cycles) {
+    if (!ajit) return 0;
+
+    int compiled = 0;
+    uint64_t slice_start = timebase_begin();
+
+    // Callees reached only through direct call sites get queued here
+    adaptive_jit_check_and_recompile(ajit);
+
+    while (ajit->compile_pending > 0) {
+        int func_id = next_queued(ajit);
+        if (func_id < 0) {
+            ajit->compile_pending = 0;
+            break;
+        }
+
+        jit_function_entry_t* entry = &ajit->functions[func_id];
+        entry->compile_queued = false;
+        ajit->compile_pending--;
+
+        uint64_t start = timebase_begin();
+        if (adaptive_jit_recompile_function(ajit, func_id) > 0) {
+            compiled++;
+            ajit->background_compiles++;
+        }
+        uint64_t end = timebase_end();
+
+        uint64_t cycles = end - start;
+        ajit->compile_cycles += cycles;
+        if (cycles > ajit->max_compile_cycles) {
+            ajit->max_compile_cycles = cycles;
+        }
+
+        if (budget_cycles && end - slice_start >= budget_cycles) {
+            break;
+        }
+    }
+
+    // Tier-ups free the tiers they supersede; once those holes add up,
+    // close them in the same slice. Holes pinned by code adaptive_jit does
+    // not own cannot be closed, so a pass that would not help backs off.
+    if (compiled > 0) {
+        if (ajit->compact_skip > 0) {
+            ajit->compact_skip--;
+        } else {
+            jit_pool_stats_t stats;
+            jit_get_pool_stats(JIT_POOL_CODE, &stats);
+            if (stats.fragmentation_bytes >= COMPACT_MIN_FRAGMENTATION) {
+                if (adaptive_jit_compact_code(ajit) > 0) {
+                    ajit->compact_backoff = 0;
+                } else {
+                    ajit->compact_backoff = ajit->compact_backoff
+                        ? ajit->compact_backoff * 2 : 1;
+                    if (ajit->compact_backoff > COMPACT_MAX_BACKOFF) {
+                        ajit->compact_backoff = COMPACT_MAX_BACKOFF;
+                    }
+                    ajit->compact_skip = ajit->compact_backoff;
+                }
+            }
+        }
+    }
+
+    return compiled;
+}
+
+// ============================================================================
+// CODE POOL COMPACTION
+// ============================================================================
+
+int adaptive_jit_compact_code(adaptive_jit_t* ajit) {
+    if (!ajit) return -1;
+
+    int order[MAX_JIT_FUNCTIONS];
+    void* blocks[MAX_JIT_FUNCTIONS];
+    size_t sizes[MAX_JIT_FUNCTIONS];
+    int count = 0;
+
+    // Live JIT code, highest address first (insertion sort): the space the
+    // top function leaves joins the free tail, and the next one down is then
+    // next to it
+    for (int i = 0; i < ajit->function_count; i++) {
+        jit_function_entry_t* entry = &ajit->functions[i];
+        if (!entry->is_active || !entry->jit_ctx.code_buffer || entry->jit_ctx.code_size == 0) {
+            continue;
+        }
+
+        uint8_t* code = entry->jit_ctx.code_buffer;
+        int pos = count++;
+        while (pos > 0 && ajit->functions[order[pos - 1]].jit_ctx.code_buffer < code) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+
+    if (count == 0) return 0;
+
+    for (int k = 0; k < count; k++) {
+        blocks[k] = ajit->functions[order[k]].jit_ctx.code_buffer;
+        sizes[k] = ajit->functions[order[k]].jit_ctx.code_size;
+    }
+
+    // Only moves whose old space joins up with other free space pay off;
+    // leave the pool alone if none does
+    uint8_t move[MAX_JIT_FUNCTIONS];
+    size_t before, projected;
+    if (jit_plan_compaction(JIT_POOL_CODE, blocks, sizes, count, JIT_ALLOC_EXECUTABLE,
+                            move, &before, &projected) != 0) {
+        return -1;
+    }
+    if (projected >= before) {
+        return 0;
+    }
+
+    // Each function gets its new block before the old one is freed. Nothing
+    // runs JIT code meanwhile (called between executions, single core).
+    int relocated = 0;
+    for (int k = 0; k < count; k++) {
+        jit_function_entry_t* entry = &ajit->functions[order[k]];
+        micro_jit_ctx_t* ctx = &entry->jit_ctx;
+        if (!move[k]) continue;
+
+        void* placed = jit_alloc_below(sizes[k], ctx->code_buffer, JIT_POOL_CODE, JIT_ALLOC_EXECUTABLE);
+        if (!placed) continue;
+
+        void* old_exec = jit_code_exec_address(ctx->code_buffer);
+        memcpy(placed, ctx->code_buffer, sizes[k]);
+        micro_jit_destroy(ctx);
+
+        ctx->code_buffer = (uint8_t*)placed;
+        ctx->code_size = sizes[k];
+        ctx->code_capacity = sizes[k];
+
+        // Internal rel32 jumps move with the code; direct calls are re-bound
+        // below. The patch site list in jit_ctx is unchanged (same bytes).
+        jit_mark_executable(placed, sizes[k]);
+        patch_code_refs(entry, old_exec, jit_code_exec_address(placed));
+        relocated++;
+    }
+
+    // Callers and callees both moved
+    bind_call_sites(ajit, -1);
+    ajit->compactions++;
+
+    jit_pool_stats_t after;
+    jit_get_pool_stats(JIT_POOL_CODE, &after);
+
+    serial_puts("[COMPACT] Relocated ");
+    serial_put_int(relocated);
+    serial_puts(" functions, fragmentation ");
+    serial_put_uint((unsigned int)before);
+    serial_puts(" -> ");
+    serial_put_uint((unsigned int)after.fragmentation_bytes);
+    serial_puts(" bytes\n");
+
+    return relocated;
+}
+
 // ============================================================================
 // QUERY FUNCTIONS
 // ============================================================================
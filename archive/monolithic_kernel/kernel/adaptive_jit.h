@@ -3,9 +3,28 @@
  *
  * Combines function_profiler with Micro-JIT to implement adaptive optimization:
  * 1. Profile function calls and cycle counts
- * 2. Detect hot paths (100/1000/10000 call thresholds)
+ * 2. Detect hot paths (tier_policy cost model over decayed hotness)
  * 3. Trigger JIT recompilation at higher optimization levels
  * 4. Atomically swap code pointers for zero-downtime optimization
+ *
+ * Tier-ups never run on the caller's path: execute() only queues a function
+ * the cost model flagged. The single core compiles in idle-time slices
+ * (adaptive_jit_compile_pending() between tokens or before hlt), hottest
+ * function first, and publishes through adaptive_jit_swap_code().
+ *
+ * Functions registered with a micro_jit pattern take one int argument whose
+ * values are profiled. When one value dominates at a tier-up, the new tier
+ * is a clone specialized for that constant behind a guard. A call that
+ * fails the guard deoptimizes: it finishes in the interpreted generic IR,
+ * and marks the function so the next idle slice puts the generic code back
+ * and no later tier-up specializes it again.
+ *
+ * JIT-to-JIT calls skip execute(): a caller built as baseline IR calls
+ * another adaptive function through a direct call rel32 site (with its own
+ * hit counter) that is bound to the callee's current code and re-patched
+ * whenever that changes, so hot call chains pay no pointer load, indirect
+ * branch or profiler bookkeeping. Site counts are folded into the profiler
+ * (calls and edges, untimed) by the periodic check and the compile queue.
  */
 
 #ifndef ADAPTIVE_JIT_H
@@ -15,6 +34,7 @@
 #include <stdbool.h>
 #include "function_profiler.h"
 #include "micro_jit.h"
+#include "baseline_jit.h"
 #include "jit_allocator.h"
 
 #ifdef __cplusplus
@@ -26,6 +46,20 @@ extern "C" {
 // ============================================================================
 
 #define MAX_JIT_FUNCTIONS 32
+#define MAX_JIT_CALL_SITES 64
+
+// Specialize when one argument value covers at least 90% of the calls
+// (lower bound from the value profile) over at least this many samples
+#define SPECIALIZE_MIN_SHARE    9000            // Basis points
+#define SPECIALIZE_MIN_SAMPLES  100
+
+// Free code-pool bytes stranded outside the largest free block before an
+// idle slice that tiered something up also compacts the pool
+#define COMPACT_MIN_FRAGMENTATION (2 * MAX_JIT_CODE_SIZE)
+
+// Most compiling slices skipped after compaction attempts that would not
+// have reduced fragmentation (the wait doubles per failed attempt)
+#define COMPACT_MAX_BACKOFF 64
 
 /**
  * JIT-compiled function entry
@@ -33,15 +67,35 @@ extern "C" {
 typedef struct {
     int profiler_id;             // Function ID in profiler
     void* code_v0;               // O0 version (initial)
-    void* code_v1;               // O1 version (100+ calls)
-    void* code_v2;               // O2 version (1000+ calls)
-    void* code_v3;               // O3 version (10000+ calls)
+    void* code_v1;               // O1 version
+    void* code_v2;               // O2 version
+    void* code_v3;               // O3 version (tier_policy.c picks the level)
     void* current_code;          // Active version (atomic pointer)
     micro_jit_ctx_t jit_ctx;     // JIT context for this function
     opt_level_t compiled_level;  // Highest compiled optimization level
+    micro_jit_pattern_t pattern; // Shape for value specialization (NONE: int f(void))
+    bool specialized;            // current_code is a guarded clone
+    int32_t specialized_value;   // Argument value the clone was folded for
+    uint32_t deopt_count;        // Guard failures in specialized code
+    bool no_speculate;           // A guard failed: stay generic from now on
+    bool compile_queued;         // Tier-up waiting for an idle slice
+    bool from_ir;                // Registered as baseline IR (code_v0 is in jit_ctx)
     bool is_active;              // Entry in use
 } jit_function_entry_t;
 
+/**
+ * Direct call site: a call rel32 in the caller's code, bound to the
+ * callee's current code. The site bumps 'count' itself.
+ */
+typedef struct {
+    int caller;                  // Function ID holding the site, -1 until compiled
+    int callee;
+    uint32_t offset;             // rel32 field in the caller's code buffer
+    uint32_t count;              // Calls through the site
+    uint32_t counted;            // Part of 'count' already given to the profiler
+    bool in_use;
+} jit_call_site_t;
+
 /**
  * Adaptive JIT manager
  */
@@ -50,6 +104,20 @@ typedef struct {
     jit_function_entry_t functions[MAX_JIT_FUNCTIONS];
     int function_count;
     bool enabled;
+
+    // Background compile queue
+    int compile_pending;         // Entries with compile_queued set
+    uint32_t background_compiles;
+    uint64_t compile_cycles;     // Total spent in idle slices
+    uint64_t max_compile_cycles; // Longest single tier-up
+
+    // Direct JIT-to-JIT calls
+    jit_call_site_t call_sites[MAX_JIT_CALL_SITES];
+    uint32_t call_site_patches;  // Displacements rewritten after a tier change
+
+    uint32_t compactions;        // Successful code pool compactions
+    uint32_t compact_backoff;    // Current wait after a compaction that would not help
+    uint32_t compact_skip;       // Compiling slices left before the next attempt
 } adaptive_jit_t;
 
 // ============================================================================
@@ -77,6 +145,49 @@ int adaptive_jit_register_function(
     void* initial_code
 );
 
+/**
+ * Register an int f(int n) function that micro_jit can regenerate as
+ * 'pattern'. 'generic_code' handles every n and is what a deoptimized
+ * function goes back to, so it must not move or be freed while registered.
+ * Returns: function ID or -1 on error
+ */
+int adaptive_jit_register_specializable(
+    adaptive_jit_t* ajit,
+    const char* func_name,
+    const char* module_name,
+    void* generic_code,
+    micro_jit_pattern_t pattern
+);
+
+/**
+ * Emit a direct call to adaptive function 'callee_id' into 'ir', the body
+ * of a caller that will be passed to adaptive_jit_register_ir(); see
+ * baseline_ir_call for the rest.
+ * Returns: result vreg, or -1 (void call, or error: check ir->error)
+ */
+int adaptive_jit_emit_call(
+    adaptive_jit_t* ajit,
+    baseline_ir_t* ir,
+    int callee_id,
+    int ret_kind,
+    const int* args,
+    int argc
+);
+
+/**
+ * Compile 'ir' with the baseline JIT and register the result. Its direct
+ * call sites are bound now and follow their callees' tier changes.
+ * Baseline code is the only tier for IR functions, so their tier-ups only
+ * advance the level.
+ * Returns: function ID or -1 on error
+ */
+int adaptive_jit_register_ir(
+    adaptive_jit_t* ajit,
+    const char* func_name,
+    const char* module_name,
+    const baseline_ir_t* ir
+);
+
 /**
  * Execute a function with profiling and adaptive recompilation
  * This wraps the function call with cycle counting and triggers
@@ -87,21 +198,62 @@ int adaptive_jit_register_function(
 int adaptive_jit_execute(adaptive_jit_t* ajit, int func_id);
 
 /**
- * Check for hot functions and trigger recompilation
+ * Same as adaptive_jit_execute for int f(int n) functions; 'arg' is
+ * recorded in the function's value profile
+ */
+int adaptive_jit_execute_arg(adaptive_jit_t* ajit, int func_id, int32_t arg);
+
+/**
+ * Check for hot functions and queue their tier-ups (after folding direct
+ * call site counts into the profiler)
  * Call this periodically or after N function calls
  */
 void adaptive_jit_check_and_recompile(adaptive_jit_t* ajit);
 
+/**
+ * Run queued tier-ups, most-called function first, until 'budget_cycles'
+ * are spent (0: drain the queue). At least one job runs per call so the
+ * queue always makes progress. If any ran and the code pool's fragmentation
+ * reached COMPACT_MIN_FRAGMENTATION, the pool is compacted afterwards when
+ * that is projected to reduce it; otherwise the next attempts are spaced
+ * out (up to COMPACT_MAX_BACKOFF compiling slices apart).
+ * Must not be called while JIT code runs.
+ *
+ * Returns: number of functions recompiled
+ */
+int adaptive_jit_compile_pending(adaptive_jit_t* ajit, uint64_t budget_cycles);
+
 /**
  * Manually trigger recompilation of a function to next optimization level
+ * (synchronous, bypasses the queue)
  */
 int adaptive_jit_recompile_function(adaptive_jit_t* ajit, int func_id);
 
 /**
  * Atomically swap function code pointer (zero-downtime optimization)
+ * Direct call sites are not re-targeted; adaptive_jit's own tier changes
+ * go through a path that does both.
  */
 void adaptive_jit_swap_code(jit_function_entry_t* entry, void* new_code, opt_level_t new_level);
 
+/**
+ * Compact the JIT code pool
+ *
+ * Moves live JIT functions toward the pool base, highest address first:
+ * each goes into the lowest free block below it that fits, so the space it
+ * leaves joins the free tail. current_code/code_vN and direct call sites
+ * are patched to the new addresses. Superseded tiers are already freed on
+ * tier-up; this closes the holes they leave behind.
+ * The moves are planned first (jit_plan_compaction): a function only moves
+ * if that reduces fragmentation_bytes, and nothing moves if none does.
+ * A function's old code is freed only after its new block exists.
+ * Must not be called while JIT code is executing.
+ *
+ * Returns: number of functions relocated (0 if it would not help), or -1
+ * if the pool layout could not be projected
+ */
+int adaptive_jit_compact_code(adaptive_jit_t* ajit);
+
 /**
  * Get current optimization level for a function
  */
@@ -0,0 +1,292 @@
+/**
+ * Adaptive JIT Test Suite (code pool compaction)
+ */
+
+#include "adaptive_jit_test.h"
+#include "adaptive_jit.h"
+#include "test_helpers.h"
+#include "vga.h"
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+static int g_tests_passed = 0;
+static int g_tests_total = 0;
+
+#define TEST_START(name) \
+    terminal_writestring("\n[Test] "); \
+    terminal_writestring(name); \
+    terminal_writestring("\n"); \
+    g_tests_total++;
+
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        terminal_writestring("  FAIL: "); \
+        terminal_writestring(message); \
+        terminal_writestring("\n"); \
+        return 0; \
+    }
+
+#define TEST_PASS() \
+    terminal_writestring("  PASS\n"); \
+    g_tests_passed++; \
+    return 1;
+
+#define FILL_MAX 512
+
+static adaptive_jit_t g_ajit;
+static void* g_fill[FILL_MAX];
+static int g_fill_count = 0;
+static int g_callee = -1;
+static int g_caller = -1;
+
+static int seven(void) {
+    return 7;
+}
+
+// What the demo tier-up of an opaque function compiles (fibonacci(5))
+static int five(void) {
+    return 5;
+}
+
+// IR caller(n) = sum of n direct calls to 'callee'
+static int register_caller(const char* name, int callee) {
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    int n = baseline_ir_arg(&ir, BASELINE_INT, 0);
+    int acc = baseline_ir_const(&ir, 0);
+    int k = baseline_ir_const(&ir, 0);
+    int one = baseline_ir_const(&ir, 1);
+    int loop = baseline_ir_label(&ir);
+    int done = baseline_ir_label(&ir);
+
+    baseline_ir_place(&ir, loop);
+    baseline_ir_branch(&ir, BASELINE_GE, k, n, done);
+    int r = adaptive_jit_emit_call(&g_ajit, &ir, callee, BASELINE_INT, NULL, 0);
+    baseline_ir_mov(&ir, acc, baseline_ir_binop(&ir, BASELINE_OP_ADD, acc, r));
+    baseline_ir_mov(&ir, k, baseline_ir_binop(&ir, BASELINE_OP_ADD, k, one));
+    baseline_ir_jump(&ir, loop);
+    baseline_ir_place(&ir, done);
+    baseline_ir_ret(&ir, acc);
+
+    return adaptive_jit_register_ir(&g_ajit, name, "test", &ir);
+}
+
+// AOT callee seven() and an IR caller of it
+static int setup(void) {
+    adaptive_jit_init(&g_ajit);
+    g_callee = adaptive_jit_register_function(&g_ajit, "seven", "test", (void*)seven);
+    if (g_callee < 0) return -1;
+
+    g_caller = register_caller("caller", g_callee);
+    return g_caller < 0 ? -1 : 0;
+}
+
+// setup() with a free block below the caller's code for it to slide into
+static int setup_above_hole(void) {
+    void* hole = jit_alloc_code(MAX_JIT_CODE_SIZE);
+    if (!hole) return -1;
+    int result = setup();
+    jit_free_code(hole);
+    return result;
+}
+
+static size_t code_fragmentation(void) {
+    jit_pool_stats_t stats;
+    jit_get_pool_stats(JIT_POOL_CODE, &stats);
+    return stats.fragmentation_bytes;
+}
+
+// Take every free byte of the code pool, largest blocks first
+static void fill_code_pool(void) {
+    size_t size = MAX_JIT_CODE_SIZE;
+
+    g_fill_count = 0;
+    while (size >= 16 && g_fill_count < FILL_MAX) {
+        void* p = jit_alloc_code(size);
+        if (p) {
+            g_fill[g_fill_count++] = p;
+        } else {
+            size /= 2;
+        }
+    }
+}
+
+static void release_fill(void) {
+    for (int i = 0; i < g_fill_count; i++) {
+        jit_free_code(g_fill[i]);
+    }
+    g_fill_count = 0;
+}
+
+// ============================================================================
+// Test Cases
+// ============================================================================
+
+static int test_compaction_relocates(void) {
+    TEST_START("Compaction relocates IR code and re-binds call sites");
+
+    TEST_ASSERT(setup_above_hole() == 0, "Setup failed");
+    jit_function_entry_t* caller = &g_ajit.functions[g_caller];
+    void* old = caller->current_code;
+
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, g_caller, 10) == 70, "Wrong result before");
+    size_t fragmentation = code_fragmentation();
+
+    // Only the IR caller has JIT code; seven() is AOT
+    TEST_ASSERT(adaptive_jit_compact_code(&g_ajit) == 1, "Expected one function relocated");
+    TEST_ASSERT((uint8_t*)caller->current_code < (uint8_t*)old, "Code did not move down");
+    TEST_ASSERT(caller->code_v0 == caller->current_code, "code_v0 not patched");
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, g_caller, 10) == 70, "Wrong result after");
+    TEST_ASSERT(code_fragmentation() < fragmentation, "Fragmentation did not go down");
+    TEST_ASSERT(g_ajit.compactions == 1, "Compaction not counted");
+
+    adaptive_jit_shutdown(&g_ajit);
+    TEST_PASS();
+}
+
+static int test_compaction_without_room(void) {
+    TEST_START("Compaction with a full code pool leaves IR code in place");
+
+    TEST_ASSERT(setup_above_hole() == 0, "Setup failed");
+    jit_function_entry_t* caller = &g_ajit.functions[g_caller];
+    void* old = caller->current_code;
+
+    fill_code_pool();
+    terminal_writestring("  filled with ");
+    test_print_count(g_fill_count);
+    terminal_writestring(" blocks\n");
+
+    TEST_ASSERT(adaptive_jit_compact_code(&g_ajit) == 0, "Relocated without room");
+    TEST_ASSERT(g_ajit.compactions == 0, "Counted a compaction that did nothing");
+    TEST_ASSERT(caller->current_code == old && caller->code_v0 == old, "Code pointers changed");
+    TEST_ASSERT(caller->jit_ctx.code_buffer != NULL, "Code buffer released");
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, g_caller, 10) == 70, "Function broken after failure");
+
+    release_fill();
+    size_t fragmentation = code_fragmentation();
+    TEST_ASSERT(adaptive_jit_compact_code(&g_ajit) == 1, "Compaction failed once room was back");
+    TEST_ASSERT(code_fragmentation() < fragmentation, "Fragmentation did not go down");
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, g_caller, 10) == 70, "Wrong result after retry");
+
+    adaptive_jit_shutdown(&g_ajit);
+    TEST_PASS();
+}
+
+static int test_idle_slice_compacts(void) {
+    TEST_START("Idle slice compacts a fragmented pool after a tier-up");
+
+    // Fillers first, so the caller's code lands above them
+    void* blocks[8];
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = jit_alloc_code(MAX_JIT_CODE_SIZE);
+        TEST_ASSERT(blocks[i] != NULL, "Could not allocate filler");
+    }
+    TEST_ASSERT(setup() == 0, "Setup failed");
+    int hot = adaptive_jit_register_function(&g_ajit, "five", "test", (void*)five);
+    TEST_ASSERT(hot >= 0, "Could not register five");
+    int hot_caller = register_caller("five_caller", hot);
+    TEST_ASSERT(hot_caller >= 0, "Could not register five_caller");
+
+    // Holes between live blocks, well past COMPACT_MIN_FRAGMENTATION
+    for (int i = 0; i < 8; i += 2) {
+        jit_free_code(blocks[i]);
+    }
+    void* caller_code = g_ajit.functions[g_caller].current_code;
+    size_t fragmentation = code_fragmentation();
+
+    // Direct calls arrive in bulk and tier five() up into one of the holes
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, hot_caller, 2000) == 10000, "Wrong result before");
+    uint32_t before = g_ajit.compactions;
+    int compiled = adaptive_jit_compile_pending(&g_ajit, 0);
+
+    TEST_ASSERT(compiled > 0, "five() did not tier up");
+    TEST_ASSERT(g_ajit.functions[hot].jit_ctx.code_buffer != NULL, "No JIT code for five()");
+    TEST_ASSERT(g_ajit.compactions == before + 1, "Idle slice did not compact");
+    TEST_ASSERT(code_fragmentation() < fragmentation, "Fragmentation did not go down");
+    TEST_ASSERT(g_ajit.functions[g_caller].current_code != caller_code, "Caller did not move");
+
+    // Every relocated function still computes what it did before
+    TEST_ASSERT(adaptive_jit_execute(&g_ajit, hot) == 5, "Relocated five() broken");
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, hot_caller, 10) == 50,
+                "Call site not re-bound after compaction");
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, g_caller, 10) == 70, "Relocated caller broken");
+
+    for (int i = 1; i < 8; i += 2) {
+        jit_free_code(blocks[i]);
+    }
+    adaptive_jit_shutdown(&g_ajit);
+    TEST_PASS();
+}
+
+static int test_idle_slice_backs_off(void) {
+    TEST_START("Idle slice backs off when compaction would not help");
+
+    TEST_ASSERT(setup() == 0, "Setup failed");
+    int hot = adaptive_jit_register_function(&g_ajit, "five", "test", (void*)five);
+    TEST_ASSERT(hot >= 0, "Could not register five");
+    int hot_caller = register_caller("five_caller", hot);
+    TEST_ASSERT(hot_caller >= 0, "Could not register five_caller");
+
+    // Holes above every function: the only code that could move is five()'s
+    // new tier, and moving it down would just move a hole
+    void* blocks[8];
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = jit_alloc_code(MAX_JIT_CODE_SIZE);
+        TEST_ASSERT(blocks[i] != NULL, "Could not allocate filler");
+    }
+    for (int i = 0; i < 8; i += 2) {
+        jit_free_code(blocks[i]);
+    }
+    size_t fragmentation = code_fragmentation();
+    TEST_ASSERT(fragmentation >= COMPACT_MIN_FRAGMENTATION, "Pool not fragmented enough");
+
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, hot_caller, 2000) == 10000, "Wrong result before");
+    TEST_ASSERT(adaptive_jit_compile_pending(&g_ajit, 0) > 0, "five() did not tier up");
+
+    TEST_ASSERT(g_ajit.compactions == 0, "Compacted without a gain");
+    TEST_ASSERT(g_ajit.compact_backoff == 1 && g_ajit.compact_skip == 1, "No backoff after the attempt");
+    TEST_ASSERT(code_fragmentation() <= fragmentation, "Fragmentation went up");
+    TEST_ASSERT(adaptive_jit_execute_arg(&g_ajit, hot_caller, 10) == 50, "five_caller broken");
+
+    for (int i = 1; i < 8; i += 2) {
+        jit_free_code(blocks[i]);
+    }
+    adaptive_jit_shutdown(&g_ajit);
+    TEST_PASS();
+}
+
+// ============================================================================
+// Main Test Entry Point
+// ============================================================================
+
+int test_adaptive_jit(void) {
+    terminal_writestring("\n");
+    terminal_writestring("========================================\n");
+    terminal_writestring("  Adaptive JIT Test Suite\n");
+    terminal_writestring("========================================\n");
+
+    g_tests_passed = 0;
+    g_tests_total = 0;
+
+    if (jit_allocator_init(256 * 1024, 512 * 1024, 128 * 1024) != 0) {
+        terminal_writestring("  FAIL: No JIT allocator\n");
+        return 1;
+    }
+
+    test_compaction_relocates();
+    test_compaction_without_room();
+    test_idle_slice_compacts();
+    test_idle_slice_backs_off();
+
+    terminal_writestring("\n========================================\n");
+    terminal_writestring("  Results: ");
+    test_print_count(g_tests_passed);
+    terminal_writestring(" / ");
+    test_print_count(g_tests_total);
+    terminal_writestring(" tests passed\n");
+    terminal_writestring("========================================\n\n");
+
+    return (g_tests_passed == g_tests_total) ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#ifndef ADAPTIVE_JIT_TEST_H
+#define ADAPTIVE_JIT_TEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Test adaptive JIT code pool compaction
+ *
+ * Returns: 0 on success, non-zero on failure
+ */
+int test_adaptive_jit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADAPTIVE_JIT_TEST_H
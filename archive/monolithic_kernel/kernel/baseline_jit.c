@@ -0,0 +1,1367 @@
+// ============================================================================
+// BAREFLOW - Baseline JIT Implementation
+// ============================================================================
+
+#include "baseline_jit.h"
+#include "jit_allocator.h"
+#include <stddef.h>
+
+extern void* memset(void* s, int c, size_t n);
+extern void* memcpy(void* dest, const void* src, size_t n);
+
+// Allocatable registers. Ints live in callee-saved GPRs so calls never
+// force a spill; EAX/ECX/EDX are the emitter's scratch (MUL/DIV/shifts
+// need them anyway). XMM0/XMM1 are scratch, the rest allocatable.
+static const uint8_t g_int_regs[] = { REG_EBX, REG_ESI, REG_EDI };
+static const uint8_t g_float_regs[] = { 2, 3, 4, 5, 6, 7 };
+#define NUM_INT_REGS    ((int)sizeof(g_int_regs))
+#define NUM_FLOAT_REGS  ((int)sizeof(g_float_regs))
+
+// Frame: [ebp+8+4i] args, [ebp-4..-12] saved EBX/ESI/EDI, then slots
+#define ARG_DISP(i)     (8 + 4 * (i))
+#define SLOT_DISP(k)    (-16 - 4 * (k))
+
+// ============================================================================
+// IR Builder
+// ============================================================================
+
+void baseline_ir_init(baseline_ir_t* ir) {
+    if (!ir) return;
+    memset(ir, 0, sizeof(baseline_ir_t));
+}
+
+static baseline_insn_t* append(baseline_ir_t* ir, baseline_op_t op) {
+    if (ir->error || ir->num_insns >= BASELINE_MAX_INSNS) {
+        ir->error = true;
+        return NULL;
+    }
+
+    baseline_insn_t* insn = &ir->insns[ir->num_insns++];
+    memset(insn, 0, sizeof(baseline_insn_t));
+    insn->op = op;
+    insn->dst = insn->a = insn->b = -1;
+    return insn;
+}
+
+static int new_vreg(baseline_ir_t* ir, baseline_kind_t kind) {
+    if (ir->error || ir->num_vregs >= BASELINE_MAX_VREGS) {
+        ir->error = true;
+        return -1;
+    }
+
+    ir->kinds[ir->num_vregs] = kind;
+    if (kind == BASELINE_FLOAT) {
+        ir->uses_float = true;
+    }
+    return ir->num_vregs++;
+}
+
+// Flags the IR on failure so a bad build surfaces at compile time
+static bool expect(baseline_ir_t* ir, bool ok) {
+    if (!ok) ir->error = true;
+    return !ir->error;
+}
+
+static bool is_vreg(const baseline_ir_t* ir, int v, baseline_kind_t kind) {
+    return v >= 0 && v < ir->num_vregs && ir->kinds[v] == kind;
+}
+
+static bool is_any_vreg(const baseline_ir_t* ir, int v) {
+    return v >= 0 && v < ir->num_vregs;
+}
+
+int baseline_ir_const(baseline_ir_t* ir, int32_t value) {
+    int dst = new_vreg(ir, BASELINE_INT);
+    baseline_insn_t* insn = append(ir, BASELINE_OP_CONST);
+    if (!insn || dst < 0) return -1;
+
+    insn->dst = dst;
+    insn->imm = value;
+    return dst;
+}
+
+int baseline_ir_fconst(baseline_ir_t* ir, float value) {
+    union { float f; int32_t i; } bits = { value };
+
+    int dst = new_vreg(ir, BASELINE_FLOAT);
+    baseline_insn_t* insn = append(ir, BASELINE_OP_CONST);
+    if (!insn || dst < 0) return -1;
+
+    insn->dst = dst;
+    insn->imm = bits.i;
+    return dst;
+}
+
+int baseline_ir_arg(baseline_ir_t* ir, baseline_kind_t kind, int index) {
+    if (!expect(ir, index >= 0)) return -1;
+
+    int dst = new_vreg(ir, kind);
+    baseline_insn_t* insn = append(ir, BASELINE_OP_ARG);
+    if (!insn || dst < 0) return -1;
+
+    insn->dst = dst;
+    insn->imm = index;
+    return dst;
+}
+
+int baseline_ir_binop(baseline_ir_t* ir, baseline_op_t op, int a, int b) {
+    if (!expect(ir, is_any_vreg(ir, a) && op >= BASELINE_OP_ADD && op <= BASELINE_OP_SAR)) {
+        return -1;
+    }
+
+    baseline_kind_t kind = (baseline_kind_t)ir->kinds[a];
+    if (!expect(ir, is_vreg(ir, b, kind) && (kind == BASELINE_INT || op <= BASELINE_OP_DIV))) {
+        return -1;
+    }
+
+    int dst = new_vreg(ir, kind);
+    baseline_insn_t* insn = append(ir, op);
+    if (!insn || dst < 0) return -1;
+
+    insn->dst = dst;
+    insn->a = a;
+    insn->b = b;
+    return dst;
+}
+
+void baseline_ir_mov(baseline_ir_t* ir, int dst, int src) {
+    if (!expect(ir, is_any_vreg(ir, dst) && is_vreg(ir, src, (baseline_kind_t)ir->kinds[dst]))) {
+        return;
+    }
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_MOV);
+    if (!insn) return;
+
+    insn->dst = dst;
+    insn->a = src;
+}
+
+int baseline_ir_convert(baseline_ir_t* ir, baseline_kind_t to, int a) {
+    baseline_kind_t from = to == BASELINE_INT ? BASELINE_FLOAT : BASELINE_INT;
+    if (!expect(ir, is_vreg(ir, a, from))) return -1;
+
+    int dst = new_vreg(ir, to);
+    baseline_insn_t* insn = append(ir, to == BASELINE_INT ? BASELINE_OP_F2I : BASELINE_OP_I2F);
+    if (!insn || dst < 0) return -1;
+
+    insn->dst = dst;
+    insn->a = a;
+    return dst;
+}
+
+int baseline_ir_load(baseline_ir_t* ir, baseline_kind_t kind, int base, int32_t disp) {
+    if (!expect(ir, is_vreg(ir, base, BASELINE_INT))) return -1;
+
+    int dst = new_vreg(ir, kind);
+    baseline_insn_t* insn = append(ir, BASELINE_OP_LOAD);
+    if (!insn || dst < 0) return -1;
+
+    insn->dst = dst;
+    insn->a = base;
+    insn->imm = disp;
+    return dst;
+}
+
+void baseline_ir_store(baseline_ir_t* ir, int base, int32_t disp, int value) {
+    if (!expect(ir, is_vreg(ir, base, BASELINE_INT) && is_any_vreg(ir, value))) return;
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_STORE);
+    if (!insn) return;
+
+    insn->a = base;
+    insn->b = value;
+    insn->imm = disp;
+}
+
+int baseline_ir_call(baseline_ir_t* ir, void* fn, int ret_kind, const int* args, int argc) {
+    if (!expect(ir, fn && argc >= 0 && argc <= BASELINE_MAX_CALL_ARGS && (argc == 0 || args))) {
+        return -1;
+    }
+    for (int i = 0; i < argc; i++) {
+        if (!expect(ir, is_any_vreg(ir, args[i]))) return -1;
+    }
+
+    int dst = ret_kind < 0 ? -1 : new_vreg(ir, (baseline_kind_t)ret_kind);
+    baseline_insn_t* insn = append(ir, BASELINE_OP_CALL);
+    if (!insn || ir->error) return -1;
+
+    insn->dst = dst;
+    insn->fn = fn;
+    insn->argc = argc;
+    for (int i = 0; i < argc; i++) {
+        insn->args[i] = args[i];
+    }
+    return dst;
+}
+
+int baseline_ir_call_direct(baseline_ir_t* ir, void* fn, uint32_t* counter, int32_t tag,
+                            int ret_kind, const int* args, int argc) {
+    int dst = baseline_ir_call(ir, fn, ret_kind, args, argc);
+    if (ir->error) return -1;
+
+    baseline_insn_t* insn = &ir->insns[ir->num_insns - 1];
+    insn->op = BASELINE_OP_CALL_DIRECT;
+    insn->counter = counter;
+    insn->imm = tag;
+    return dst;
+}
+
+int baseline_ir_label(baseline_ir_t* ir) {
+    if (!expect(ir, ir->num_labels < BASELINE_MAX_LABELS)) return -1;
+    return ir->num_labels++;
+}
+
+void baseline_ir_place(baseline_ir_t* ir, int label) {
+    if (!expect(ir, label >= 0 && label < ir->num_labels)) return;
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_LABEL);
+    if (insn) insn->imm = label;
+}
+
+void baseline_ir_jump(baseline_ir_t* ir, int label) {
+    if (!expect(ir, label >= 0 && label < ir->num_labels)) return;
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_JUMP);
+    if (insn) insn->imm = label;
+}
+
+void baseline_ir_branch(baseline_ir_t* ir, baseline_cond_t cond, int a, int b, int label) {
+    if (!expect(ir, is_any_vreg(ir, a) && label >= 0 && label < ir->num_labels)) return;
+
+    baseline_kind_t kind = (baseline_kind_t)ir->kinds[a];
+    if (!expect(ir, is_vreg(ir, b, kind) && (kind == BASELINE_INT || cond <= BASELINE_GE))) {
+        return;
+    }
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_BRANCH);
+    if (!insn) return;
+
+    insn->cond = cond;
+    insn->a = a;
+    insn->b = b;
+    insn->imm = label;
+}
+
+void baseline_ir_ret(baseline_ir_t* ir, int value) {
+    if (!expect(ir, value == -1 || is_any_vreg(ir, value))) return;
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_RET);
+    if (insn) insn->a = value;
+}
+
+void baseline_ir_tailjump(baseline_ir_t* ir, void* fn) {
+    if (!expect(ir, fn != NULL)) return;
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_TAILJUMP);
+    if (insn) insn->fn = fn;
+}
+
+// The runtime interprets resume IRs to their end: they can't speculate
+// themselves, and a direct call's target may have been retired since
+static bool resumable(const baseline_ir_t* resume_ir) {
+    if (resume_ir->error || resume_ir->num_insns == 0) return false;
+
+    for (int i = 0; i < resume_ir->num_insns; i++) {
+        baseline_op_t op = (baseline_op_t)resume_ir->insns[i].op;
+        if (op == BASELINE_OP_GUARD || op == BASELINE_OP_CALL_DIRECT) return false;
+    }
+    return true;
+}
+
+int baseline_ir_deopt_point(baseline_ir_t* ir, const baseline_ir_t* resume_ir, int resume_at) {
+    if (!expect(ir, ir->num_deopts < BASELINE_MAX_DEOPTS && resume_ir && resume_ir != ir &&
+                    resumable(resume_ir) && resume_at >= 0 && resume_at < resume_ir->num_insns)) {
+        return -1;
+    }
+
+    baseline_deopt_t* deopt = &ir->deopts[ir->num_deopts];
+    memset(deopt, 0, sizeof(baseline_deopt_t));
+    deopt->resume_ir = resume_ir;
+    deopt->resume_at = resume_at;
+    return ir->num_deopts++;
+}
+
+void baseline_ir_deopt_value(baseline_ir_t* ir, int deopt, int value, int resume_vreg) {
+    if (!expect(ir, deopt >= 0 && deopt < ir->num_deopts && is_any_vreg(ir, value))) return;
+
+    baseline_deopt_t* point = &ir->deopts[deopt];
+    if (!expect(ir, point->num_values < BASELINE_MAX_DEOPT_VALUES &&
+                    is_vreg(point->resume_ir, resume_vreg, (baseline_kind_t)ir->kinds[value]))) {
+        return;
+    }
+
+    point->value[point->num_values] = value;
+    point->resume_vreg[point->num_values++] = resume_vreg;
+}
+
+void baseline_ir_guard(baseline_ir_t* ir, baseline_cond_t cond, int a, int b, int deopt) {
+    if (!expect(ir, is_any_vreg(ir, a) && deopt >= 0 && deopt < ir->num_deopts)) return;
+
+    baseline_kind_t kind = (baseline_kind_t)ir->kinds[a];
+    if (!expect(ir, is_vreg(ir, b, kind) && (kind == BASELINE_INT || cond <= BASELINE_GE))) {
+        return;
+    }
+
+    baseline_insn_t* insn = append(ir, BASELINE_OP_GUARD);
+    if (!insn) return;
+
+    insn->cond = cond;
+    insn->a = a;
+    insn->b = b;
+    insn->imm = deopt;
+}
+
+void baseline_ir_set_deopt_hook(baseline_ir_t* ir, void (*hook)(void* arg), void* arg) {
+    if (!ir) return;
+    ir->deopt_hook = hook;
+    ir->deopt_hook_arg = arg;
+}
+
+// ============================================================================
+// Register Allocation (linear scan)
+// ============================================================================
+
+typedef struct {
+    int start;              // First mention, -1 if unused
+    int end;                // Last mention, stretched over loops
+    int8_t reg;             // Physical register, -1 when in a slot
+    int16_t slot;
+    bool no_reg;            // Float live across a call (XMM is caller-saved)
+} interval_t;
+
+static void mention(interval_t* iv, int v, int index) {
+    if (v < 0) return;
+    if (iv[v].start < 0) iv[v].start = index;
+    iv[v].end = index;
+}
+
+static bool build_intervals(const baseline_ir_t* ir, interval_t* iv, int* label_index) {
+    for (int v = 0; v < ir->num_vregs; v++) {
+        iv[v].start = iv[v].end = -1;
+        iv[v].reg = -1;
+        iv[v].slot = -1;
+        iv[v].no_reg = false;
+    }
+    for (int l = 0; l < ir->num_labels; l++) {
+        label_index[l] = -1;
+    }
+
+    for (int i = 0; i < ir->num_insns; i++) {
+        const baseline_insn_t* insn = &ir->insns[i];
+        mention(iv, insn->a, i);
+        mention(iv, insn->b, i);
+        for (int k = 0; k < insn->argc; k++) {
+            mention(iv, insn->args[k], i);
+        }
+        mention(iv, insn->dst, i);
+
+        // A guard reads everything its deopt point carries
+        if (insn->op == BASELINE_OP_GUARD) {
+            const baseline_deopt_t* deopt = &ir->deopts[insn->imm];
+            for (int k = 0; k < deopt->num_values; k++) {
+                mention(iv, deopt->value[k], i);
+            }
+        }
+
+        if (insn->op == BASELINE_OP_LABEL) {
+            label_index[insn->imm] = i;
+        }
+    }
+
+    // A value live into a loop header stays live to the back edge, or the
+    // next iteration would read a register reused in between. Repeat until
+    // stable: stretching for an inner loop can make a value reach an outer one.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < ir->num_insns; i++) {
+            const baseline_insn_t* insn = &ir->insns[i];
+            if (insn->op != BASELINE_OP_JUMP && insn->op != BASELINE_OP_BRANCH) continue;
+
+            int target = label_index[insn->imm];
+            if (target < 0) return false;       // Label never placed
+            if (target > i) continue;
+
+            for (int v = 0; v < ir->num_vregs; v++) {
+                if (iv[v].start >= 0 && iv[v].start < target && iv[v].end >= target &&
+                    iv[v].end < i) {
+                    iv[v].end = i;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < ir->num_insns; i++) {
+        if (ir->insns[i].op != BASELINE_OP_CALL && ir->insns[i].op != BASELINE_OP_CALL_DIRECT) continue;
+        for (int v = 0; v < ir->num_vregs; v++) {
+            if (ir->kinds[v] == BASELINE_FLOAT && iv[v].start < i && iv[v].end > i) {
+                iv[v].no_reg = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Poletto & Sarkar: walk intervals by start, expire the finished ones,
+// and when the class is full spill whichever interval ends last
+static int allocate_registers(const baseline_ir_t* ir, interval_t* iv) {
+    int order[BASELINE_MAX_VREGS];
+    int count = 0;
+
+    for (int v = 0; v < ir->num_vregs; v++) {
+        if (iv[v].start < 0) continue;
+        int pos = count++;
+        while (pos > 0 && iv[order[pos - 1]].start > iv[v].start) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = v;
+    }
+
+    int active[BASELINE_MAX_VREGS];
+    int num_active = 0;
+    int num_slots = 0;
+
+    for (int k = 0; k < count; k++) {
+        int v = order[k];
+        baseline_kind_t kind = (baseline_kind_t)ir->kinds[v];
+        const uint8_t* regs = kind == BASELINE_INT ? g_int_regs : g_float_regs;
+        int num_regs = kind == BASELINE_INT ? NUM_INT_REGS : NUM_FLOAT_REGS;
+
+        // Expire intervals that ended before this one starts
+        int kept = 0;
+        for (int j = 0; j < num_active; j++) {
+            if (iv[active[j]].end >= iv[v].start) {
+                active[kept++] = active[j];
+            }
+        }
+        num_active = kept;
+
+        if (iv[v].no_reg) {
+            iv[v].slot = num_slots++;
+            continue;
+        }
+
+        // Free register of this class?
+        int8_t free_reg = -1;
+        for (int r = 0; r < num_regs && free_reg < 0; r++) {
+            bool taken = false;
+            for (int j = 0; j < num_active; j++) {
+                if (ir->kinds[active[j]] == kind && iv[active[j]].reg == regs[r]) {
+                    taken = true;
+                    break;
+                }
+            }
+            if (!taken) free_reg = regs[r];
+        }
+
+        if (free_reg >= 0) {
+            iv[v].reg = free_reg;
+            active[num_active++] = v;
+            continue;
+        }
+
+        // Full: the active interval that ends last gives up its register
+        int victim = -1;
+        for (int j = 0; j < num_active; j++) {
+            int u = active[j];
+            if (ir->kinds[u] == kind && iv[u].reg >= 0 &&
+                (victim < 0 || iv[u].end > iv[active[victim]].end)) {
+                victim = j;
+            }
+        }
+
+        if (victim >= 0 && iv[active[victim]].end > iv[v].end) {
+            int u = active[victim];
+            iv[v].reg = iv[u].reg;
+            iv[u].reg = -1;
+            iv[u].slot = num_slots++;
+            active[victim] = v;
+        } else {
+            iv[v].slot = num_slots++;
+        }
+    }
+
+    return num_slots;
+}
+
+// ============================================================================
+// x86 Encoding
+// ============================================================================
+
+typedef struct {
+    micro_jit_ctx_t* ctx;
+    const baseline_ir_t* ir;
+    const interval_t* iv;
+    int32_t scratch_disp;   // Frame slot for ST0 <-> XMM moves
+    size_t label_pos[BASELINE_MAX_LABELS + BASELINE_MAX_DEOPTS];   // Labels, then deopt stubs
+    size_t fixup_at[BASELINE_MAX_INSNS];    // rel32 fields to patch
+    int fixup_label[BASELINE_MAX_INSNS];
+    int num_fixups;
+    void* direct_target[MICRO_JIT_MAX_PATCH_SITES];     // Per ctx->patch_sites entry
+    bool overflow;
+} emitter_t;
+
+static void emit8(emitter_t* e, uint8_t byte) {
+    micro_jit_ctx_t* ctx = e->ctx;
+    if (ctx->code_size < ctx->code_capacity) {
+        ctx->code_buffer[ctx->code_size++] = byte;
+    } else {
+        e->overflow = true;
+    }
+}
+
+static void emit32(emitter_t* e, int32_t value) {
+    emit8(e, value & 0xFF);
+    emit8(e, (value >> 8) & 0xFF);
+    emit8(e, (value >> 16) & 0xFF);
+    emit8(e, (value >> 24) & 0xFF);
+}
+
+static void emit_modrm_reg(emitter_t* e, int reg, int rm) {
+    emit8(e, 0xC0 | (reg << 3) | rm);
+}
+
+// [base + disp]; ESP as base needs a SIB byte, EBP can't use the no-disp form
+static void emit_modrm_mem(emitter_t* e, int reg, int base, int32_t disp) {
+    int mod = (disp == 0 && base != REG_EBP) ? 0x00 : (disp >= -128 && disp <= 127) ? 0x40 : 0x80;
+
+    emit8(e, mod | (reg << 3) | base);
+    if (base == REG_ESP) {
+        emit8(e, 0x24);
+    }
+    if (mod == 0x40) {
+        emit8(e, (uint8_t)disp);
+    } else if (mod == 0x80) {
+        emit32(e, disp);
+    }
+}
+
+// op reg, r/m (register form)
+static void emit_rr(emitter_t* e, uint8_t opcode, int reg, int rm) {
+    emit8(e, opcode);
+    emit_modrm_reg(e, reg, rm);
+}
+
+// op reg, [base + disp]
+static void emit_rm(emitter_t* e, uint8_t opcode, int reg, int base, int32_t disp) {
+    emit8(e, opcode);
+    emit_modrm_mem(e, reg, base, disp);
+}
+
+// SSE: [prefix] 0F op /r, register form
+static void emit_sse_rr(emitter_t* e, uint8_t prefix, uint8_t opcode, int reg, int rm) {
+    if (prefix) emit8(e, prefix);
+    emit8(e, 0x0F);
+    emit_rr(e, opcode, reg, rm);
+}
+
+static void emit_sse_rm(emitter_t* e, uint8_t prefix, uint8_t opcode, int reg, int base, int32_t disp) {
+    if (prefix) emit8(e, prefix);
+    emit8(e, 0x0F);
+    emit_rm(e, opcode, reg, base, disp);
+}
+
+static void emit_mov_reg_imm(emitter_t* e, int reg, int32_t imm) {
+    emit8(e, 0xB8 + reg);
+    emit32(e, imm);
+}
+
+// sub/add esp, imm32
+static void emit_adjust_esp(emitter_t* e, int32_t bytes) {
+    if (bytes == 0) return;
+    emit8(e, 0x81);
+    emit_modrm_reg(e, bytes > 0 ? 5 : 0, REG_ESP);
+    emit32(e, bytes > 0 ? bytes : -bytes);
+}
+
+static void emit_fixup(emitter_t* e, int label) {
+    e->fixup_at[e->num_fixups] = e->ctx->code_size;
+    e->fixup_label[e->num_fixups++] = label;
+    emit32(e, 0);
+}
+
+// ============================================================================
+// Operand Access
+// ============================================================================
+
+static int32_t slot_disp(const emitter_t* e, int v) {
+    return SLOT_DISP(e->iv[v].slot);
+}
+
+// Register holding int vreg v, reloading into 'scratch' if it was spilled
+static int use_int(emitter_t* e, int v, int scratch) {
+    if (e->iv[v].reg >= 0) return e->iv[v].reg;
+    emit_rm(e, 0x8B, scratch, REG_EBP, slot_disp(e, v));         // mov scratch, [slot]
+    return scratch;
+}
+
+static void def_int(emitter_t* e, int v, int src) {
+    if (e->iv[v].reg >= 0) {
+        if (e->iv[v].reg != src) emit_rr(e, 0x89, src, e->iv[v].reg);   // mov reg, src
+    } else {
+        emit_rm(e, 0x89, src, REG_EBP, slot_disp(e, v));            // mov [slot], src
+    }
+}
+
+static int use_float(emitter_t* e, int v, int scratch) {
+    if (e->iv[v].reg >= 0) return e->iv[v].reg;
+    emit_sse_rm(e, 0xF3, 0x10, scratch, REG_EBP, slot_disp(e, v)); // movss scratch, [slot]
+    return scratch;
+}
+
+static void def_float(emitter_t* e, int v, int src) {
+    if (e->iv[v].reg >= 0) {
+        if (e->iv[v].reg != src) emit_sse_rr(e, 0, 0x28, e->iv[v].reg, src);   // movaps
+    } else {
+        emit_sse_rm(e, 0xF3, 0x11, src, REG_EBP, slot_disp(e, v));      // movss [slot], src
+    }
+}
+
+// Leave the frame: everything but the final ret
+static void emit_epilogue(emitter_t* e) {
+    emit_rm(e, 0x8D, REG_ESP, REG_EBP, -12);    // lea esp, [ebp-12]
+    emit8(e, 0x58 + REG_EDI);                   // pop edi
+    emit8(e, 0x58 + REG_ESI);                   // pop esi
+    emit8(e, 0x58 + REG_EBX);                   // pop ebx
+    emit8(e, 0x58 + REG_EBP);                   // pop ebp
+}
+
+// ============================================================================
+// Instruction Selection
+// ============================================================================
+
+static uint8_t int_alu_opcode(baseline_op_t op) {
+    switch (op) {
+        case BASELINE_OP_ADD: return 0x03;
+        case BASELINE_OP_SUB: return 0x2B;
+        case BASELINE_OP_AND: return 0x23;
+        case BASELINE_OP_OR:  return 0x0B;
+        default:              return 0x33;  // XOR
+    }
+}
+
+static uint8_t jcc_opcode(baseline_cond_t cond, bool is_float) {
+    // ucomiss sets CF/ZF like an unsigned compare (unordered counts as less)
+    switch (cond) {
+        case BASELINE_EQ:  return 0x84;
+        case BASELINE_NE:  return 0x85;
+        case BASELINE_LT:  return is_float ? 0x82 : 0x8C;
+        case BASELINE_LE:  return is_float ? 0x86 : 0x8E;
+        case BASELINE_GT:  return is_float ? 0x87 : 0x8F;
+        case BASELINE_GE:  return is_float ? 0x83 : 0x8D;
+        case BASELINE_LTU: return 0x82;
+        default:           return 0x83;     // GEU
+    }
+}
+
+static void emit_int_binop(emitter_t* e, const baseline_insn_t* insn) {
+    baseline_op_t op = (baseline_op_t)insn->op;
+
+    if (op == BASELINE_OP_SHL || op == BASELINE_OP_SHR || op == BASELINE_OP_SAR) {
+        int rb = use_int(e, insn->b, REG_ECX);
+        if (rb != REG_ECX) emit_rr(e, 0x89, rb, REG_ECX);
+        int ra = use_int(e, insn->a, REG_EAX);
+        if (ra != REG_EAX) emit_rr(e, 0x89, ra, REG_EAX);
+        emit_rr(e, 0xD3, op == BASELINE_OP_SHL ? 4 : op == BASELINE_OP_SHR ? 5 : 7, REG_EAX);
+        def_int(e, insn->dst, REG_EAX);
+        return;
+    }
+
+    int ra = use_int(e, insn->a, REG_EAX);
+    if (ra != REG_EAX) emit_rr(e, 0x89, ra, REG_EAX);
+    int rb = use_int(e, insn->b, REG_ECX);
+
+    if (op == BASELINE_OP_DIV || op == BASELINE_OP_MOD) {
+        emit8(e, 0x99);                         // cdq
+        emit_rr(e, 0xF7, 7, rb);                // idiv rb
+        def_int(e, insn->dst, op == BASELINE_OP_DIV ? REG_EAX : REG_EDX);
+        return;
+    }
+
+    if (op == BASELINE_OP_MUL) {
+        emit8(e, 0x0F);
+        emit_rr(e, 0xAF, REG_EAX, rb);          // imul eax, rb
+    } else {
+        emit_rr(e, int_alu_opcode(op), REG_EAX, rb);
+    }
+    def_int(e, insn->dst, REG_EAX);
+}
+
+static void emit_float_binop(emitter_t* e, const baseline_insn_t* insn) {
+    static const uint8_t opcodes[] = { 0x58, 0x5C, 0x59, 0x5E };     // add, sub, mul, div
+
+    int xa = use_float(e, insn->a, 0);
+    if (xa != 0) emit_sse_rr(e, 0, 0x28, 0, xa);                     // movaps xmm0, xa
+    int xb = use_float(e, insn->b, 1);
+    emit_sse_rr(e, 0xF3, opcodes[insn->op - BASELINE_OP_ADD], 0, xb);
+    def_float(e, insn->dst, 0);
+}
+
+// Counted call rel32. The displacement is padded to a 4-byte boundary so a
+// re-target is one aligned store that no instruction fetch can see torn.
+// It is filled in once the code's final (executable) address is known.
+static void emit_direct_call(emitter_t* e, const baseline_insn_t* insn) {
+    micro_jit_ctx_t* ctx = e->ctx;
+
+    if (insn->counter) {
+        emit8(e, 0x83);                         // add dword [counter], 1
+        emit8(e, 0x05);
+        emit32(e, (int32_t)(uintptr_t)insn->counter);
+        emit8(e, 1);
+    }
+    while ((ctx->code_size + 1) & 3) {
+        emit8(e, 0x90);
+    }
+    emit8(e, 0xE8);
+
+    if (ctx->num_patch_sites >= MICRO_JIT_MAX_PATCH_SITES) {
+        e->overflow = true;
+        return;
+    }
+    micro_jit_patch_site_t* site = &ctx->patch_sites[ctx->num_patch_sites++];
+    site->offset = (uint32_t)ctx->code_size;
+    site->tag = insn->imm;
+    e->direct_target[ctx->num_patch_sites - 1] = insn->fn;
+    emit32(e, 0);
+}
+
+static void emit_call(emitter_t* e, const baseline_insn_t* insn) {
+    // Outgoing area keeps ESP 16-byte aligned at the call
+    int32_t area = (insn->argc * 4 + 15) & ~15;
+    emit_adjust_esp(e, area);
+
+    for (int k = 0; k < insn->argc; k++) {
+        int v = insn->args[k];
+        if (e->ir->kinds[v] == BASELINE_FLOAT) {
+            int x = use_float(e, v, 0);
+            emit_sse_rm(e, 0xF3, 0x11, x, REG_ESP, 4 * k);
+        } else {
+            int r = use_int(e, v, REG_EAX);
+            emit_rm(e, 0x89, r, REG_ESP, 4 * k);
+        }
+    }
+
+    if (insn->op == BASELINE_OP_CALL_DIRECT) {
+        emit_direct_call(e, insn);
+    } else {
+        emit_mov_reg_imm(e, REG_EAX, (int32_t)(uintptr_t)insn->fn);
+        emit_rr(e, 0xFF, 2, REG_EAX);           // call eax
+    }
+    emit_adjust_esp(e, -area);
+
+    if (insn->dst < 0) return;
+    if (e->ir->kinds[insn->dst] == BASELINE_FLOAT) {
+        // cdecl returns floats in ST0
+        emit_rm(e, 0xD9, 3, REG_EBP, e->scratch_disp);                  // fstp dword [scratch]
+        emit_sse_rm(e, 0xF3, 0x10, 0, REG_EBP, e->scratch_disp);        // movss xmm0, [scratch]
+        def_float(e, insn->dst, 0);
+    } else {
+        def_int(e, insn->dst, REG_EAX);
+    }
+}
+
+static void emit_insn(emitter_t* e, const baseline_insn_t* insn) {
+    const baseline_ir_t* ir = e->ir;
+    bool is_float = insn->dst >= 0 ? ir->kinds[insn->dst] == BASELINE_FLOAT
+                  : insn->a >= 0 ? ir->kinds[insn->a] == BASELINE_FLOAT : false;
+
+    switch ((baseline_op_t)insn->op) {
+        case BASELINE_OP_CONST:
+            if (is_float) {
+                emit_mov_reg_imm(e, REG_EAX, insn->imm);
+                emit_sse_rr(e, 0x66, 0x6E, 0, REG_EAX);                 // movd xmm0, eax
+                def_float(e, insn->dst, 0);
+            } else if (e->iv[insn->dst].reg >= 0) {
+                emit_mov_reg_imm(e, e->iv[insn->dst].reg, insn->imm);
+            } else {
+                emit_rm(e, 0xC7, 0, REG_EBP, slot_disp(e, insn->dst));  // mov dword [slot], imm
+                emit32(e, insn->imm);
+            }
+            break;
+
+        case BASELINE_OP_ARG:
+            if (is_float) {
+                emit_sse_rm(e, 0xF3, 0x10, 0, REG_EBP, ARG_DISP(insn->imm));
+                def_float(e, insn->dst, 0);
+            } else {
+                emit_rm(e, 0x8B, REG_EAX, REG_EBP, ARG_DISP(insn->imm));
+                def_int(e, insn->dst, REG_EAX);
+            }
+            break;
+
+        case BASELINE_OP_MOV:
+            if (is_float) {
+                def_float(e, insn->dst, use_float(e, insn->a, 0));
+            } else {
+                def_int(e, insn->dst, use_int(e, insn->a, REG_EAX));
+            }
+            break;
+
+        case BASELINE_OP_ADD:
+        case BASELINE_OP_SUB:
+        case BASELINE_OP_MUL:
+        case BASELINE_OP_DIV:
+            if (is_float) {
+                emit_float_binop(e, insn);
+                break;
+            }
+            emit_int_binop(e, insn);
+            break;
+
+        case BASELINE_OP_MOD:
+        case BASELINE_OP_AND:
+        case BASELINE_OP_OR:
+        case BASELINE_OP_XOR:
+        case BASELINE_OP_SHL:
+        case BASELINE_OP_SHR:
+        case BASELINE_OP_SAR:
+            emit_int_binop(e, insn);
+            break;
+
+        case BASELINE_OP_I2F:
+            emit_sse_rr(e, 0xF3, 0x2A, 0, use_int(e, insn->a, REG_EAX));      // cvtsi2ss
+            def_float(e, insn->dst, 0);
+            break;
+
+        case BASELINE_OP_F2I:
+            emit_sse_rr(e, 0xF3, 0x2C, REG_EAX, use_float(e, insn->a, 0));    // cvttss2si
+            def_int(e, insn->dst, REG_EAX);
+            break;
+
+        case BASELINE_OP_LOAD: {
+            int base = use_int(e, insn->a, REG_EAX);
+            if (is_float) {
+                emit_sse_rm(e, 0xF3, 0x10, 0, base, insn->imm);
+                def_float(e, insn->dst, 0);
+            } else {
+                emit_rm(e, 0x8B, REG_EAX, base, insn->imm);
+                def_int(e, insn->dst, REG_EAX);
+            }
+            break;
+        }
+
+        case BASELINE_OP_STORE: {
+            int base = use_int(e, insn->a, REG_EAX);
+            if (ir->kinds[insn->b] == BASELINE_FLOAT) {
+                emit_sse_rm(e, 0xF3, 0x11, use_float(e, insn->b, 0), base, insn->imm);
+            } else {
+                emit_rm(e, 0x89, use_int(e, insn->b, REG_ECX), base, insn->imm);
+            }
+            break;
+        }
+
+        case BASELINE_OP_CALL:
+        case BASELINE_OP_CALL_DIRECT:
+            emit_call(e, insn);
+            break;
+
+        case BASELINE_OP_LABEL:
+            e->label_pos[insn->imm] = e->ctx->code_size;
+            break;
+
+        case BASELINE_OP_JUMP:
+            emit8(e, 0xE9);
+            emit_fixup(e, insn->imm);
+            break;
+
+        case BASELINE_OP_BRANCH:
+            if (is_float) {
+                int xa = use_float(e, insn->a, 0);
+                emit_sse_rr(e, 0, 0x2E, xa, use_float(e, insn->b, 1));      // ucomiss xa, xb
+            } else {
+                int ra = use_int(e, insn->a, REG_EAX);
+                emit_rr(e, 0x39, use_int(e, insn->b, REG_ECX), ra);         // cmp ra, rb
+            }
+            emit8(e, 0x0F);
+            emit8(e, jcc_opcode((baseline_cond_t)insn->cond, is_float));
+            emit_fixup(e, insn->imm);
+            break;
+
+        case BASELINE_OP_GUARD:
+            // Same compare as a branch; the inverse jcc leaves for the stub
+            if (is_float) {
+                int xa = use_float(e, insn->a, 0);
+                emit_sse_rr(e, 0, 0x2E, xa, use_float(e, insn->b, 1));      // ucomiss xa, xb
+            } else {
+                int ra = use_int(e, insn->a, REG_EAX);
+                emit_rr(e, 0x39, use_int(e, insn->b, REG_ECX), ra);         // cmp ra, rb
+            }
+            emit8(e, 0x0F);
+            emit8(e, jcc_opcode((baseline_cond_t)insn->cond, is_float) ^ 1);
+            emit_fixup(e, BASELINE_MAX_LABELS + insn->imm);
+            break;
+
+        case BASELINE_OP_RET:
+            if (insn->a >= 0 && is_float) {
+                emit_sse_rm(e, 0xF3, 0x11, use_float(e, insn->a, 0), REG_EBP, e->scratch_disp);
+                emit_rm(e, 0xD9, 0, REG_EBP, e->scratch_disp);              // fld dword [scratch]
+            } else if (insn->a >= 0) {
+                int r = use_int(e, insn->a, REG_EAX);
+                if (r != REG_EAX) emit_rr(e, 0x89, r, REG_EAX);
+            }
+            emit_epilogue(e);
+            emit8(e, 0xC3);
+            break;
+
+        case BASELINE_OP_TAILJUMP:
+            // Args are still where our caller put them
+            emit_epilogue(e);
+            emit_mov_reg_imm(e, REG_EAX, (int32_t)(uintptr_t)insn->fn);
+            emit_rr(e, 0xFF, 4, REG_EAX);       // jmp eax
+            break;
+    }
+}
+
+// ============================================================================
+// Deoptimization
+// ============================================================================
+
+// Stack map of one deopt point, stored after the code it belongs to
+typedef struct {
+    const baseline_ir_t* resume_ir;
+    void (*hook)(void* arg);
+    void* hook_arg;
+    int16_t resume_at;
+    uint8_t num_values;
+    bool ret_float;
+    struct {
+        int8_t resume_vreg;
+        int8_t reg;         // Index into the stub's register save area, -1: frame slot
+        int16_t disp;       // EBP-relative slot
+    } values[BASELINE_MAX_DEOPT_VALUES];
+} deopt_record_t;
+
+// Stub register save area: EBX, ESI, EDI, then XMM2-XMM7
+#define DEOPT_SAVED_GPRS    3
+#define DEOPT_SAVE_BYTES    ((DEOPT_SAVED_GPRS + NUM_FLOAT_REGS) * 4)
+
+typedef union {
+    uint32_t i;
+    float f;
+} deopt_value_t;
+
+typedef uint32_t (*deopt_int_fn_t)(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+typedef float (*deopt_float_fn_t)(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+
+// cdecl with six 32-bit slots: float arguments are passed as their bits,
+// and surplus arguments are ignored by the callee (the caller pops them)
+static uint32_t deopt_call(void* fn, const uint32_t* slots, bool ret_float) {
+    if (ret_float) {
+        deopt_value_t r;
+        r.f = ((deopt_float_fn_t)fn)(slots[0], slots[1], slots[2], slots[3], slots[4], slots[5]);
+        return r.i;
+    }
+    return ((deopt_int_fn_t)fn)(slots[0], slots[1], slots[2], slots[3], slots[4], slots[5]);
+}
+
+static bool interp_compare(baseline_cond_t cond, bool is_float, deopt_value_t a, deopt_value_t b) {
+    if (is_float) {
+        // Same outcomes as ucomiss + jcc: unordered counts as less
+        bool unordered = a.f != a.f || b.f != b.f;
+        switch (cond) {
+            case BASELINE_EQ: return unordered || a.f == b.f;
+            case BASELINE_NE: return !unordered && a.f != b.f;
+            case BASELINE_LT: return unordered || a.f < b.f;
+            case BASELINE_LE: return unordered || a.f <= b.f;
+            case BASELINE_GT: return !unordered && a.f > b.f;
+            default:          return !unordered && a.f >= b.f;
+        }
+    }
+
+    int32_t sa = (int32_t)a.i, sb = (int32_t)b.i;
+    switch (cond) {
+        case BASELINE_EQ:  return a.i == b.i;
+        case BASELINE_NE:  return a.i != b.i;
+        case BASELINE_LT:  return sa < sb;
+        case BASELINE_LE:  return sa <= sb;
+        case BASELINE_GT:  return sa > sb;
+        case BASELINE_GE:  return sa >= sb;
+        case BASELINE_LTU: return a.i < b.i;
+        default:           return a.i >= b.i;
+    }
+}
+
+static uint32_t interp_int_binop(baseline_op_t op, uint32_t a, uint32_t b) {
+    int32_t sa = (int32_t)a, sb = (int32_t)b;
+    switch (op) {
+        case BASELINE_OP_ADD: return a + b;
+        case BASELINE_OP_SUB: return a - b;
+        case BASELINE_OP_MUL: return a * b;
+        case BASELINE_OP_DIV: return sb ? (uint32_t)(sa / sb) : 0;  // Compiled code would fault
+        case BASELINE_OP_MOD: return sb ? (uint32_t)(sa % sb) : 0;
+        case BASELINE_OP_AND: return a & b;
+        case BASELINE_OP_OR:  return a | b;
+        case BASELINE_OP_XOR: return a ^ b;
+        case BASELINE_OP_SHL: return a << (b & 31);
+        case BASELINE_OP_SHR: return a >> (b & 31);
+        default:              return (uint32_t)(sa >> (b & 31));    // SAR
+    }
+}
+
+static float interp_float_binop(baseline_op_t op, float a, float b) {
+    switch (op) {
+        case BASELINE_OP_ADD: return a + b;
+        case BASELINE_OP_SUB: return a - b;
+        case BASELINE_OP_MUL: return a * b;
+        default:              return a / b;
+    }
+}
+
+// Run 'ir' from instruction 'pc' to its end with 'vals' as the register
+// file. Slow, but only deoptimized calls get here, once each.
+static uint32_t interpret(const baseline_ir_t* ir, int pc, deopt_value_t* vals,
+                          const uint32_t* args, bool ret_float) {
+    int label_index[BASELINE_MAX_LABELS];
+    for (int i = 0; i < ir->num_insns; i++) {
+        if (ir->insns[i].op == BASELINE_OP_LABEL) {
+            label_index[ir->insns[i].imm] = i;
+        }
+    }
+
+    while (pc < ir->num_insns) {
+        const baseline_insn_t* insn = &ir->insns[pc++];
+        baseline_op_t op = (baseline_op_t)insn->op;
+        bool is_float = insn->dst >= 0 ? ir->kinds[insn->dst] == BASELINE_FLOAT
+                      : insn->a >= 0 ? ir->kinds[insn->a] == BASELINE_FLOAT : false;
+
+        switch (op) {
+            case BASELINE_OP_CONST:
+                vals[insn->dst].i = (uint32_t)insn->imm;
+                break;
+
+            case BASELINE_OP_ARG:
+                vals[insn->dst].i = args[insn->imm];
+                break;
+
+            case BASELINE_OP_MOV:
+                vals[insn->dst] = vals[insn->a];
+                break;
+
+            case BASELINE_OP_ADD:
+            case BASELINE_OP_SUB:
+            case BASELINE_OP_MUL:
+            case BASELINE_OP_DIV:
+                if (is_float) {
+                    vals[insn->dst].f = interp_float_binop(op, vals[insn->a].f, vals[insn->b].f);
+                    break;
+                }
+                vals[insn->dst].i = interp_int_binop(op, vals[insn->a].i, vals[insn->b].i);
+                break;
+
+            case BASELINE_OP_MOD:
+            case BASELINE_OP_AND:
+            case BASELINE_OP_OR:
+            case BASELINE_OP_XOR:
+            case BASELINE_OP_SHL:
+            case BASELINE_OP_SHR:
+            case BASELINE_OP_SAR:
+                vals[insn->dst].i = interp_int_binop(op, vals[insn->a].i, vals[insn->b].i);
+                break;
+
+            case BASELINE_OP_I2F:
+                vals[insn->dst].f = (float)(int32_t)vals[insn->a].i;
+                break;
+
+            case BASELINE_OP_F2I:
+                vals[insn->dst].i = (uint32_t)(int32_t)vals[insn->a].f;
+                break;
+
+            case BASELINE_OP_LOAD:
+                vals[insn->dst].i = *(const uint32_t*)(uintptr_t)(vals[insn->a].i + insn->imm);
+                break;
+
+            case BASELINE_OP_STORE:
+                *(uint32_t*)(uintptr_t)(vals[insn->a].i + insn->imm) = vals[insn->b].i;
+                break;
+
+            case BASELINE_OP_CALL:
+            case BASELINE_OP_CALL_DIRECT: {
+                uint32_t slots[BASELINE_MAX_CALL_ARGS] = { 0 };
+                for (int k = 0; k < insn->argc; k++) {
+                    slots[k] = vals[insn->args[k]].i;
+                }
+                uint32_t result = deopt_call(insn->fn, slots, is_float);
+                if (insn->dst >= 0) vals[insn->dst].i = result;
+                break;
+            }
+
+            case BASELINE_OP_LABEL:
+            case BASELINE_OP_GUARD:     // Resume IRs have none
+                break;
+
+            case BASELINE_OP_JUMP:
+                pc = label_index[insn->imm];
+                break;
+
+            case BASELINE_OP_BRANCH:
+                if (interp_compare((baseline_cond_t)insn->cond, is_float,
+                                   vals[insn->a], vals[insn->b])) {
+                    pc = label_index[insn->imm];
+                }
+                break;
+
+            case BASELINE_OP_RET:
+                return insn->a >= 0 ? vals[insn->a].i : 0;
+
+            case BASELINE_OP_TAILJUMP:
+                // The callee sees our arguments (as many as the slots hold)
+                return deopt_call(insn->fn, args, ret_float);
+        }
+    }
+
+    return 0;
+}
+
+// Called by a deopt stub with the record, its register save area and the
+// failing function's frame; finishes the call in the resume IR
+static uint32_t deopt_run(const deopt_record_t* rec, const uint32_t* saved, uintptr_t frame) {
+    if (rec->hook) {
+        rec->hook(rec->hook_arg);
+    }
+
+    const baseline_ir_t* ir = rec->resume_ir;
+    const uint32_t* args = (const uint32_t*)(frame + ARG_DISP(0));
+
+    // Arguments and constants the resume IR defined before resume_at would
+    // otherwise read as 0; carried values then overwrite any of them that
+    // the skipped code went on to reassign
+    deopt_value_t vals[BASELINE_MAX_VREGS];
+    memset(vals, 0, sizeof(vals));
+    for (int i = 0; i < rec->resume_at; i++) {
+        const baseline_insn_t* insn = &ir->insns[i];
+        if (insn->op == BASELINE_OP_CONST) {
+            vals[insn->dst].i = (uint32_t)insn->imm;
+        } else if (insn->op == BASELINE_OP_ARG) {
+            vals[insn->dst].i = args[insn->imm];
+        }
+    }
+
+    for (int k = 0; k < rec->num_values; k++) {
+        uint32_t bits = rec->values[k].reg >= 0 ? saved[rec->values[k].reg]
+                      : *(const uint32_t*)(frame + rec->values[k].disp);
+        vals[rec->values[k].resume_vreg].i = bits;
+    }
+
+    return interpret(ir, rec->resume_at, vals, args, rec->ret_float);
+}
+
+static uint32_t deopt_resume_int(const deopt_record_t* rec, const uint32_t* saved, uintptr_t frame) {
+    return deopt_run(rec, saved, frame);
+}
+
+// Float results go back in ST0 like any cdecl function's
+static float deopt_resume_float(const deopt_record_t* rec, const uint32_t* saved, uintptr_t frame) {
+    deopt_value_t r;
+    r.i = deopt_run(rec, saved, frame);
+    return r.f;
+}
+
+static bool returns_float(const baseline_ir_t* ir) {
+    for (int i = 0; i < ir->num_insns; i++) {
+        const baseline_insn_t* insn = &ir->insns[i];
+        if (insn->op == BASELINE_OP_RET && insn->a >= 0 && ir->kinds[insn->a] == BASELINE_FLOAT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Out-of-line exit for deopt point 'd'. Guards reach it with ESP 16-byte
+// aligned (nothing pushed); 48 bytes of saves keep it so for the call.
+// Returns the offset of the imm32 that must hold the record's distance from
+// the pop (3 bytes before it, which is where the call left ECX pointing).
+static size_t emit_deopt_stub(emitter_t* e, int d, bool ret_float) {
+    e->label_pos[BASELINE_MAX_LABELS + d] = e->ctx->code_size;
+
+    emit_adjust_esp(e, NUM_FLOAT_REGS * 4);
+    if (e->ir->uses_float) {
+        for (int k = 0; k < NUM_FLOAT_REGS; k++) {
+            emit_sse_rm(e, 0xF3, 0x11, g_float_regs[k], REG_ESP, 4 * k);    // movss [esp+4k], xmm
+        }
+    }
+    for (int k = DEOPT_SAVED_GPRS - 1; k >= 0; k--) {
+        emit8(e, 0x50 + g_int_regs[k]);         // push edi, esi, ebx
+    }
+    emit_rr(e, 0x89, REG_ESP, REG_EAX);         // mov eax, esp (save area)
+    emit8(e, 0x50 + REG_EBP);                   // push ebp (frame)
+    emit8(e, 0x50 + REG_EAX);                   // push eax
+
+    // Record address, position independently: call next; pop ecx; add ecx, rel
+    emit8(e, 0xE8);
+    emit32(e, 0);
+    emit8(e, 0x58 + REG_ECX);
+    emit_rr(e, 0x81, 0, REG_ECX);               // add ecx, imm32
+    size_t field = e->ctx->code_size;
+    emit32(e, 0);                               // Filled with record - base
+    emit8(e, 0x50 + REG_ECX);
+
+    emit_mov_reg_imm(e, REG_EAX, (int32_t)(uintptr_t)(ret_float ? (void*)deopt_resume_float
+                                                                : (void*)deopt_resume_int));
+    emit_rr(e, 0xFF, 2, REG_EAX);               // call eax
+    emit_epilogue(e);
+    emit8(e, 0xC3);
+    return field;
+}
+
+static void emit_deopt_record(emitter_t* e, int d, bool ret_float) {
+    const baseline_deopt_t* deopt = &e->ir->deopts[d];
+    deopt_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.resume_ir = deopt->resume_ir;
+    rec.hook = e->ir->deopt_hook;
+    rec.hook_arg = e->ir->deopt_hook_arg;
+    rec.resume_at = (int16_t)deopt->resume_at;
+    rec.num_values = (uint8_t)deopt->num_values;
+    rec.ret_float = ret_float;
+
+    for (int k = 0; k < deopt->num_values; k++) {
+        const interval_t* iv = &e->iv[deopt->value[k]];
+        rec.values[k].resume_vreg = deopt->resume_vreg[k];
+        rec.values[k].reg = -1;
+        if (iv->reg >= 0 && e->ir->kinds[deopt->value[k]] == BASELINE_FLOAT) {
+            rec.values[k].reg = DEOPT_SAVED_GPRS + iv->reg - g_float_regs[0];
+        } else if (iv->reg >= 0) {
+            for (int r = 0; r < DEOPT_SAVED_GPRS; r++) {
+                if (g_int_regs[r] == iv->reg) rec.values[k].reg = r;
+            }
+        } else {
+            rec.values[k].disp = (int16_t)SLOT_DISP(iv->slot);
+        }
+    }
+
+    const uint8_t* bytes = (const uint8_t*)&rec;
+    for (size_t i = 0; i < sizeof(rec); i++) {
+        emit8(e, bytes[i]);
+    }
+}
+
+// ============================================================================
+// SSE Check
+// ============================================================================
+
+#define CR0_EM          (1u << 2)
+#define CR4_OSFXSR      (1u << 9)
+
+static int g_sse_state = 0;     // 0 unknown, 1 enabled, -1 unavailable
+
+// Float code needs SSE2 (movd, cvt*) and the CR0/CR4 bits boot sets up in
+// cpu_init(); the JIT only checks, it never changes control registers
+static bool sse_enabled(void) {
+    if (g_sse_state != 0) {
+        return g_sse_state > 0;
+    }
+
+    uint32_t eax, ebx, ecx, edx, cr0, cr4;
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+
+    bool usable = (edx & (1u << 26)) && !(cr0 & CR0_EM) && (cr4 & CR4_OSFXSR);   // SSE2
+    g_sse_state = usable ? 1 : -1;
+    return usable;
+}
+
+// ============================================================================
+// Compilation
+// ============================================================================
+
+void* baseline_jit_compile(micro_jit_ctx_t* ctx, const baseline_ir_t* ir) {
+    if (!ctx || !ctx->code_buffer || !ir || ir->error || ir->num_insns == 0) {
+        return NULL;
+    }
+    if (ir->uses_float && !sse_enabled()) {
+        return NULL;
+    }
+    // The deopt interpreter does float math in C, which needs the FPU on
+    for (int d = 0; d < ir->num_deopts; d++) {
+        if (ir->deopts[d].resume_ir->uses_float && !sse_enabled()) {
+            return NULL;
+        }
+    }
+
+    interval_t iv[BASELINE_MAX_VREGS];
+    int label_index[BASELINE_MAX_LABELS];
+    if (!build_intervals(ir, iv, label_index)) {
+        return NULL;
+    }
+    int num_slots = allocate_registers(ir, iv);
+
+    emitter_t e;
+    e.ctx = ctx;
+    e.ir = ir;
+    e.iv = iv;
+    e.scratch_disp = SLOT_DISP(num_slots);
+    e.num_fixups = 0;
+    e.overflow = false;
+
+    jit_mark_writable(ctx->code_buffer, ctx->code_capacity);
+    ctx->code_size = 0;
+    ctx->num_patch_sites = 0;
+
+    // Prologue. Entry ESP is 12 mod 16; after EBP and the three saved
+    // registers it is 12 mod 16 again, so a frame of 12 mod 16 bytes
+    // (slots plus the ST0 scratch) leaves it aligned for calls.
+    int32_t frame = (((num_slots + 1) * 4 + 4 + 15) & ~15) - 4;
+
+    emit8(&e, 0x50 + REG_EBP);                  // push ebp
+    emit_rr(&e, 0x89, REG_ESP, REG_EBP);        // mov ebp, esp
+    emit8(&e, 0x50 + REG_EBX);
+    emit8(&e, 0x50 + REG_ESI);
+    emit8(&e, 0x50 + REG_EDI);
+    emit_adjust_esp(&e, frame);
+
+    for (int i = 0; i < ir->num_insns; i++) {
+        emit_insn(&e, &ir->insns[i]);
+    }
+
+    // Deopt stubs after the body, their records after that (4-aligned)
+    size_t record_field[BASELINE_MAX_DEOPTS];
+    size_t record_at[BASELINE_MAX_DEOPTS];
+    if (ir->num_deopts > 0) {
+        bool ret_float = returns_float(ir);
+        for (int d = 0; d < ir->num_deopts; d++) {
+            ret_float = ret_float || returns_float(ir->deopts[d].resume_ir);
+        }
+        for (int d = 0; d < ir->num_deopts; d++) {
+            record_field[d] = emit_deopt_stub(&e, d, ret_float);
+        }
+        while (ctx->code_size & 3) {
+            emit8(&e, 0xCC);                    // int3, never reached
+        }
+        for (int d = 0; d < ir->num_deopts; d++) {
+            record_at[d] = ctx->code_size;
+            emit_deopt_record(&e, d, ret_float);
+        }
+    }
+
+    if (e.overflow) {
+        return NULL;
+    }
+
+    for (int f = 0; f < e.num_fixups; f++) {
+        int32_t rel = (int32_t)(e.label_pos[e.fixup_label[f]] - (e.fixup_at[f] + 4));
+        uint8_t* field = ctx->code_buffer + e.fixup_at[f];
+        field[0] = rel & 0xFF;
+        field[1] = (rel >> 8) & 0xFF;
+        field[2] = (rel >> 16) & 0xFF;
+        field[3] = (rel >> 24) & 0xFF;
+    }
+
+    for (int d = 0; d < ir->num_deopts; d++) {
+        int32_t rel = (int32_t)(record_at[d] - (record_field[d] - 3));
+        memcpy(ctx->code_buffer + record_field[d], &rel, sizeof(rel));
+    }
+
+    // Direct calls are relative to where the code runs, not where it's written
+    uintptr_t exec = (uintptr_t)jit_code_exec_address(ctx->code_buffer);
+    for (int k = 0; k < ctx->num_patch_sites; k++) {
+        uint32_t offset = ctx->patch_sites[k].offset;
+        int32_t rel = (int32_t)((uintptr_t)e.direct_target[k] - (exec + offset + 4));
+        memcpy(ctx->code_buffer + offset, &rel, sizeof(rel));
+    }
+
+    return micro_jit_finalize(ctx);
+}
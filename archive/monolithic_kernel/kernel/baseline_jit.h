@@ -0,0 +1,235 @@
+// ============================================================================
+// BAREFLOW - Baseline JIT (Single-Pass Emitter over a Small IR)
+// ============================================================================
+// File: kernel/baseline_jit.h
+// Purpose: First tier for arbitrary code: build a function in a tiny
+//          virtual-register IR, get native x86 back in one pass
+// ============================================================================
+//
+// The IR is a linear list of instructions over virtual registers (vregs),
+// each either an int32 or a float. Vregs may be reassigned (baseline_ir_mov),
+// which is how loop variables are expressed; control flow uses labels.
+//
+// Compilation:
+//   1. Live intervals, first to last mention, stretched over every loop
+//      (backward branch) they are live into
+//   2. Linear-scan allocation: ints on EBX/ESI/EDI (callee-saved, so they
+//      survive calls), floats on XMM2-XMM7; floats live across a call and
+//      anything that doesn't fit get a stack slot
+//   3. One pass emission, EAX/ECX/EDX and XMM0/XMM1 as scratch
+//
+// Generated code is cdecl (args on the stack, int result in EAX, float in
+// ST0) and keeps EBP as frame pointer for the sample profiler's stack walks.
+// Plain calls are absolute through EAX, so code without direct calls is
+// position independent; direct calls are call rel32 sites listed in the
+// context's patch_sites, which whoever moves the code must re-target
+// (adaptive_jit_compact_code() does).
+//
+// Speculation: a guard checks an assumption the code was specialized on
+// and, when it fails, branches to an out-of-line deopt stub. The stub
+// saves the allocatable registers and hands the guard's stack map (where
+// each live value sits: register or frame slot) to the runtime, which
+// rebuilds the values of another, unspecialized IR from it and interprets
+// that IR from the recorded instruction to the end of the call. Stubs and
+// their stack maps live in the code buffer, so they move with the code.
+//
+// The kernel runs in 32-bit protected mode, so this targets IA-32: no REX
+// prefixes, eight GPRs and XMM0-XMM7. Float ops need SSE2, enabled in
+// CR0/CR4 at boot; without it, compiles that use them return NULL.
+// ============================================================================
+
+#ifndef BASELINE_JIT_H
+#define BASELINE_JIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "micro_jit.h"
+
+#define BASELINE_MAX_INSNS      256
+#define BASELINE_MAX_VREGS      64
+#define BASELINE_MAX_LABELS     32
+#define BASELINE_MAX_CALL_ARGS  6
+#define BASELINE_MAX_DEOPTS     8       // Deopt points (stack maps) per IR
+#define BASELINE_MAX_DEOPT_VALUES 16    // Values carried by one deopt point
+
+typedef enum {
+    BASELINE_OP_CONST,      // dst = imm
+    BASELINE_OP_ARG,        // dst = cdecl argument imm
+    BASELINE_OP_MOV,        // dst = a
+    BASELINE_OP_ADD,        // dst = a op b (int or float by dst kind)
+    BASELINE_OP_SUB,
+    BASELINE_OP_MUL,
+    BASELINE_OP_DIV,        // Signed for ints
+    BASELINE_OP_MOD,        // Ints only
+    BASELINE_OP_AND,        // AND..SAR: ints only
+    BASELINE_OP_OR,
+    BASELINE_OP_XOR,
+    BASELINE_OP_SHL,
+    BASELINE_OP_SHR,
+    BASELINE_OP_SAR,
+    BASELINE_OP_I2F,        // dst(float) = (float)a
+    BASELINE_OP_F2I,        // dst(int) = (int)a, truncating
+    BASELINE_OP_LOAD,       // dst = *(a + imm)
+    BASELINE_OP_STORE,      // *(a + imm) = b
+    BASELINE_OP_CALL,       // dst = fn(args...) (dst may be -1)
+    BASELINE_OP_CALL_DIRECT,// CALL through a patchable call rel32 (imm = tag)
+    BASELINE_OP_LABEL,      // imm = label
+    BASELINE_OP_JUMP,       // goto imm
+    BASELINE_OP_BRANCH,     // if (a cond b) goto imm
+    BASELINE_OP_RET,        // return a (-1: void)
+    BASELINE_OP_TAILJUMP,   // Leave the frame and jump to fn with the caller's args
+    BASELINE_OP_GUARD       // Unless (a cond b), deoptimize to deopt point imm
+} baseline_op_t;
+
+typedef enum {
+    BASELINE_EQ,
+    BASELINE_NE,
+    BASELINE_LT,            // Signed for ints
+    BASELINE_LE,
+    BASELINE_GT,
+    BASELINE_GE,
+    BASELINE_LTU,           // Unsigned, ints only
+    BASELINE_GEU
+} baseline_cond_t;
+
+typedef enum {
+    BASELINE_INT = 0,
+    BASELINE_FLOAT = 1
+} baseline_kind_t;
+
+typedef struct {
+    uint8_t op;             // baseline_op_t
+    uint8_t cond;           // baseline_cond_t for BRANCH / GUARD
+    uint8_t argc;           // CALL
+    int8_t dst;
+    int8_t a;
+    int8_t b;
+    int32_t imm;            // Constant, displacement, arg index or label
+    void* fn;               // CALL / TAILJUMP target
+    uint32_t* counter;      // CALL_DIRECT: bumped before the call (may be NULL)
+    int8_t args[BASELINE_MAX_CALL_ARGS];
+} baseline_insn_t;
+
+struct baseline_ir;
+
+// Where a failed guard continues: instruction 'resume_at' of 'resume_ir',
+// with resume_vreg[k] of that IR set to value[k] of this one. The resume
+// IR's ARG and CONST instructions before resume_at are re-evaluated (with
+// the function's own arguments), so only values computed or reassigned
+// there need to be carried.
+typedef struct {
+    const struct baseline_ir* resume_ir;
+    int resume_at;
+    int num_values;
+    int8_t value[BASELINE_MAX_DEOPT_VALUES];
+    int8_t resume_vreg[BASELINE_MAX_DEOPT_VALUES];
+} baseline_deopt_t;
+
+typedef struct baseline_ir {
+    baseline_insn_t insns[BASELINE_MAX_INSNS];
+    uint8_t kinds[BASELINE_MAX_VREGS];      // baseline_kind_t per vreg
+    int num_insns;
+    int num_vregs;
+    int num_labels;
+    bool uses_float;
+    bool error;             // Overflow or kind mismatch; compile refuses
+    baseline_deopt_t deopts[BASELINE_MAX_DEOPTS];
+    int num_deopts;
+    void (*deopt_hook)(void* arg);          // Run on every guard failure (may be NULL)
+    void* deopt_hook_arg;
+} baseline_ir_t;
+
+// ============================================================================
+// IR BUILDER
+// ============================================================================
+// Builders return the new vreg (or label), or -1 once the IR is in error.
+
+void baseline_ir_init(baseline_ir_t* ir);
+
+int baseline_ir_const(baseline_ir_t* ir, int32_t value);
+int baseline_ir_fconst(baseline_ir_t* ir, float value);
+int baseline_ir_arg(baseline_ir_t* ir, baseline_kind_t kind, int index);
+
+/**
+ * dst = a op b; the result has the operands' kind
+ */
+int baseline_ir_binop(baseline_ir_t* ir, baseline_op_t op, int a, int b);
+
+/**
+ * Reassign an existing vreg (loop variables)
+ */
+void baseline_ir_mov(baseline_ir_t* ir, int dst, int src);
+
+int baseline_ir_convert(baseline_ir_t* ir, baseline_kind_t to, int a);
+
+/**
+ * 32-bit load/store at base + disp ('base' is an int vreg holding an address)
+ */
+int baseline_ir_load(baseline_ir_t* ir, baseline_kind_t kind, int base, int32_t disp);
+void baseline_ir_store(baseline_ir_t* ir, int base, int32_t disp, int value);
+
+/**
+ * Call a cdecl function; returns the result vreg of 'ret_kind', or -1 with
+ * ret_kind < 0 for void
+ */
+int baseline_ir_call(baseline_ir_t* ir, void* fn, int ret_kind, const int* args, int argc);
+
+int baseline_ir_label(baseline_ir_t* ir);
+void baseline_ir_place(baseline_ir_t* ir, int label);
+void baseline_ir_jump(baseline_ir_t* ir, int label);
+void baseline_ir_branch(baseline_ir_t* ir, baseline_cond_t cond, int a, int b, int label);
+
+/**
+ * Return 'value' (-1 for void)
+ */
+void baseline_ir_ret(baseline_ir_t* ir, int value);
+
+/**
+ * Same as baseline_ir_call, but emitted as a call rel32 whose displacement
+ * is 4-byte aligned and recorded in ctx->patch_sites with 'tag', so the
+ * call can be re-targeted while the code is live. 'counter', if non-NULL,
+ * is incremented (not atomically) on every call through the site.
+ */
+int baseline_ir_call_direct(baseline_ir_t* ir, void* fn, uint32_t* counter, int32_t tag,
+                            int ret_kind, const int* args, int argc);
+
+/**
+ * Tail-jump to 'fn', which receives this function's own arguments
+ */
+void baseline_ir_tailjump(baseline_ir_t* ir, void* fn);
+
+/**
+ * New deopt point resuming 'resume_ir' (complete, and without guards or
+ * direct calls; it must outlive the compiled code) at instruction
+ * 'resume_at'. Returns the deopt point, -1 on error.
+ */
+int baseline_ir_deopt_point(baseline_ir_t* ir, const baseline_ir_t* resume_ir, int resume_at);
+
+/**
+ * Carry 'value' into the resume IR's 'resume_vreg' (same kind) at 'deopt'
+ */
+void baseline_ir_deopt_value(baseline_ir_t* ir, int deopt, int value, int resume_vreg);
+
+/**
+ * Continue if (a cond b), otherwise leave through deopt point 'deopt'.
+ * Values it carries are read as they are at the guard.
+ */
+void baseline_ir_guard(baseline_ir_t* ir, baseline_cond_t cond, int a, int b, int deopt);
+
+/**
+ * Called (from the failing code, before resuming) on each guard failure,
+ * e.g. to stop re-speculating; must not free or patch the running code
+ */
+void baseline_ir_set_deopt_hook(baseline_ir_t* ir, void (*hook)(void* arg), void* arg);
+
+// ============================================================================
+// COMPILATION
+// ============================================================================
+
+/**
+ * Compile 'ir' into ctx's code buffer (replacing what was there)
+ * Returns: function pointer on success, NULL on error
+ */
+void* baseline_jit_compile(micro_jit_ctx_t* ctx, const baseline_ir_t* ir);
+
+#endif // BASELINE_JIT_H
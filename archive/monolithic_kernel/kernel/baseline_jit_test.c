@@ -0,0 +1,307 @@
+/**
+ * Baseline JIT Test Suite
+ */
+
+#include "baseline_jit_test.h"
+#include "baseline_jit.h"
+#include "jit_allocator.h"
+#include "test_helpers.h"
+#include "vga.h"
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+static int g_tests_passed = 0;
+static int g_tests_total = 0;
+static micro_jit_ctx_t g_ctx;
+
+#define TEST_START(name) \
+    terminal_writestring("\n[Test] "); \
+    terminal_writestring(name); \
+    terminal_writestring("\n"); \
+    g_tests_total++;
+
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        terminal_writestring("  FAIL: "); \
+        terminal_writestring(message); \
+        terminal_writestring("\n"); \
+        return 0; \
+    }
+
+#define TEST_PASS() \
+    terminal_writestring("  PASS\n"); \
+    g_tests_passed++; \
+    return 1;
+
+typedef int (*int_fn1_t)(int);
+typedef int (*int_fn3_t)(int, int, int*);
+typedef float (*float_fn_t)(float, int);
+
+static int digits3(int a, int b, int c) {
+    return a * 100 + b * 10 + c;
+}
+
+static float fmul(float a, float b) {
+    return a * b;
+}
+
+static int g_deopt_hooks = 0;
+
+static void count_deopt(void* arg) {
+    (void)arg;
+    g_deopt_hooks++;
+}
+
+// Unspecialized sum(n): acc = 0; for (i = 0; i < n; i++) acc += i
+// Returns the instruction index of the loop label in *loop_at
+static void build_sum(baseline_ir_t* ir, int* loop_at, int* acc_out, int* i_out) {
+    baseline_ir_init(ir);
+
+    int n = baseline_ir_arg(ir, BASELINE_INT, 0);
+    int acc = baseline_ir_const(ir, 0);
+    int i = baseline_ir_const(ir, 0);
+    int one = baseline_ir_const(ir, 1);
+    int loop = baseline_ir_label(ir);
+    int done = baseline_ir_label(ir);
+
+    *loop_at = ir->num_insns;
+    baseline_ir_place(ir, loop);
+    baseline_ir_branch(ir, BASELINE_GE, i, n, done);
+    baseline_ir_mov(ir, acc, baseline_ir_binop(ir, BASELINE_OP_ADD, acc, i));
+    baseline_ir_mov(ir, i, baseline_ir_binop(ir, BASELINE_OP_ADD, i, one));
+    baseline_ir_jump(ir, loop);
+    baseline_ir_place(ir, done);
+    baseline_ir_ret(ir, acc);
+
+    *acc_out = acc;
+    *i_out = i;
+}
+
+// ============================================================================
+// Test Cases
+// ============================================================================
+
+static int test_int_ops(void) {
+    TEST_START("Integer div/mod, call, load/store");
+
+    // f(x, y, p): p[1] = digits3(x / y, x % y, y); return p[1] - 1
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    int x = baseline_ir_arg(&ir, BASELINE_INT, 0);
+    int y = baseline_ir_arg(&ir, BASELINE_INT, 1);
+    int p = baseline_ir_arg(&ir, BASELINE_INT, 2);
+    int q = baseline_ir_binop(&ir, BASELINE_OP_DIV, x, y);
+    int r = baseline_ir_binop(&ir, BASELINE_OP_MOD, x, y);
+    int args[3] = { q, r, y };
+    int c = baseline_ir_call(&ir, (void*)digits3, BASELINE_INT, args, 3);
+    baseline_ir_store(&ir, p, 4, c);
+    int l = baseline_ir_load(&ir, BASELINE_INT, p, 4);
+    baseline_ir_ret(&ir, baseline_ir_binop(&ir, BASELINE_OP_SUB, l, baseline_ir_const(&ir, 1)));
+    TEST_ASSERT(!ir.error, "IR construction failed");
+
+    int_fn3_t fn = (int_fn3_t)baseline_jit_compile(&g_ctx, &ir);
+    TEST_ASSERT(fn != NULL, "Compilation failed");
+
+    // Signed division truncates towards zero: -17 / 5 = -3, -17 % 5 = -2
+    int mem[2] = { 0, 0 };
+    int expect = digits3(-3, -2, 5);
+    TEST_ASSERT(fn(-17, 5, mem) == expect - 1, "Wrong result");
+    TEST_ASSERT(mem[1] == expect && mem[0] == 0, "Store hit the wrong address");
+
+    TEST_PASS();
+}
+
+static int test_float_ops(void) {
+    TEST_START("Float args, call, convert and return");
+
+    // f(a, n): (fmul(a, (float)n) + 0.5) / 2
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    int a = baseline_ir_arg(&ir, BASELINE_FLOAT, 0);
+    int n = baseline_ir_arg(&ir, BASELINE_INT, 1);
+    int args[2] = { a, baseline_ir_convert(&ir, BASELINE_FLOAT, n) };
+    int m = baseline_ir_call(&ir, (void*)fmul, BASELINE_FLOAT, args, 2);
+    int s = baseline_ir_binop(&ir, BASELINE_OP_ADD, m, baseline_ir_fconst(&ir, 0.5f));
+    baseline_ir_ret(&ir, baseline_ir_binop(&ir, BASELINE_OP_DIV, s, baseline_ir_fconst(&ir, 2.0f)));
+    TEST_ASSERT(!ir.error, "IR construction failed");
+
+    float_fn_t fn = (float_fn_t)baseline_jit_compile(&g_ctx, &ir);
+    TEST_ASSERT(fn != NULL, "Compilation failed (no SSE?)");
+    TEST_ASSERT(fn(1.5f, 3) == 2.5f, "Wrong result for (1.5, 3)");
+    TEST_ASSERT(fn(2.0f, 4) == 4.25f, "Wrong result for (2.0, 4)");
+
+    // Float to int truncates
+    baseline_ir_init(&ir);
+    int f = baseline_ir_convert(&ir, BASELINE_FLOAT, baseline_ir_arg(&ir, BASELINE_INT, 0));
+    f = baseline_ir_binop(&ir, BASELINE_OP_MUL, f, baseline_ir_fconst(&ir, 1.75f));
+    baseline_ir_ret(&ir, baseline_ir_convert(&ir, BASELINE_INT, f));
+
+    int_fn1_t trunc = (int_fn1_t)baseline_jit_compile(&g_ctx, &ir);
+    TEST_ASSERT(trunc != NULL, "Compilation failed");
+    TEST_ASSERT(trunc(3) == 5 && trunc(-3) == -5, "F2I did not truncate");
+
+    TEST_PASS();
+}
+
+static int test_spills(void) {
+    TEST_START("Register pressure and spills across a call");
+
+    // 14 values live across a call: more than EBX/ESI/EDI can hold
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    int x = baseline_ir_arg(&ir, BASELINE_INT, 0);
+    int v[14];
+    for (int i = 0; i < 14; i++) {
+        v[i] = baseline_ir_binop(&ir, BASELINE_OP_ADD, x, baseline_ir_const(&ir, i));
+    }
+    int args[3] = { v[0], v[1], v[2] };
+    int acc = baseline_ir_call(&ir, (void*)digits3, BASELINE_INT, args, 3);
+    for (int i = 0; i < 14; i++) {
+        acc = baseline_ir_binop(&ir, BASELINE_OP_ADD, acc, v[i]);
+    }
+    baseline_ir_ret(&ir, acc);
+    TEST_ASSERT(!ir.error, "IR construction failed");
+
+    int_fn1_t fn = (int_fn1_t)baseline_jit_compile(&g_ctx, &ir);
+    TEST_ASSERT(fn != NULL, "Compilation failed");
+
+    int expect = digits3(1, 2, 3);
+    for (int i = 0; i < 14; i++) {
+        expect += 1 + i;
+    }
+    TEST_ASSERT(fn(1) == expect, "Spilled value corrupted");
+
+    TEST_PASS();
+}
+
+static int test_loop(void) {
+    TEST_START("Loop with reassigned vregs");
+
+    baseline_ir_t ir;
+    int loop_at, acc, i;
+    build_sum(&ir, &loop_at, &acc, &i);
+
+    int_fn1_t fn = (int_fn1_t)baseline_jit_compile(&g_ctx, &ir);
+    TEST_ASSERT(fn != NULL, "Compilation failed");
+    TEST_ASSERT(fn(0) == 0 && fn(1) == 0 && fn(100) == 4950, "Wrong sum");
+
+    TEST_PASS();
+}
+
+static int test_deopt_mid_loop(void) {
+    TEST_START("Guard failure resumes mid-loop");
+
+    // The resume IR must outlive the compiled code
+    static baseline_ir_t generic;
+    int loop_at, acc, i;
+    build_sum(&generic, &loop_at, &acc, &i);
+
+    // Clone specialized on n == 10 that has already run the first five
+    // iterations (acc = 0+1+2+3+4, i = 5). Only acc and i are carried:
+    // n and the loop step are the generic IR's own ARG/CONST
+    baseline_ir_t spec;
+    baseline_ir_init(&spec);
+    baseline_ir_set_deopt_hook(&spec, count_deopt, NULL);
+
+    int n = baseline_ir_arg(&spec, BASELINE_INT, 0);
+    int spec_acc = baseline_ir_const(&spec, 10);
+    int spec_i = baseline_ir_const(&spec, 5);
+    int deopt = baseline_ir_deopt_point(&spec, &generic, loop_at);
+    baseline_ir_deopt_value(&spec, deopt, spec_acc, acc);
+    baseline_ir_deopt_value(&spec, deopt, spec_i, i);
+    baseline_ir_guard(&spec, BASELINE_EQ, n, baseline_ir_const(&spec, 10), deopt);
+    baseline_ir_ret(&spec, baseline_ir_const(&spec, 45));
+    TEST_ASSERT(!spec.error, "IR construction failed");
+
+    int_fn1_t fn = (int_fn1_t)baseline_jit_compile(&g_ctx, &spec);
+    TEST_ASSERT(fn != NULL, "Compilation failed");
+
+    g_deopt_hooks = 0;
+    TEST_ASSERT(fn(10) == 45, "Guarded path returned wrong value");
+    TEST_ASSERT(g_deopt_hooks == 0, "Guard failed on the specialized value");
+
+    // Resumes at i = 5 with n = 8: 10 + 5 + 6 + 7
+    int result = fn(8);
+    terminal_writestring("  deopt sum(8) = ");
+    test_print_count(result);
+    terminal_writestring("\n");
+    TEST_ASSERT(result == 28, "Resumed loop lost its arguments or constants");
+    TEST_ASSERT(g_deopt_hooks == 1, "Deopt hook not run once");
+
+    // Guard fails before the loop was ever entered
+    TEST_ASSERT(fn(3) == 10, "Resume with the loop already finished");
+    TEST_ASSERT(g_deopt_hooks == 2, "Deopt hook not run on second failure");
+
+    TEST_PASS();
+}
+
+static int test_deopt_point_validation(void) {
+    TEST_START("Deopt point validation");
+
+    static baseline_ir_t generic;
+    int loop_at, acc, i;
+    build_sum(&generic, &loop_at, &acc, &i);
+
+    // Out of range resume index
+    baseline_ir_t spec;
+    baseline_ir_init(&spec);
+    TEST_ASSERT(baseline_ir_deopt_point(&spec, &generic, generic.num_insns) < 0,
+                "Accepted resume index past the end");
+    TEST_ASSERT(spec.error, "IR not marked in error");
+
+    // Resume IRs may not speculate themselves
+    baseline_ir_t guarded;
+    baseline_ir_init(&guarded);
+    int x = baseline_ir_arg(&guarded, BASELINE_INT, 0);
+    int d = baseline_ir_deopt_point(&guarded, &generic, loop_at);
+    baseline_ir_guard(&guarded, BASELINE_NE, x, baseline_ir_const(&guarded, 0), d);
+    baseline_ir_ret(&guarded, x);
+    TEST_ASSERT(!guarded.error, "Guarded IR construction failed");
+
+    baseline_ir_init(&spec);
+    TEST_ASSERT(baseline_ir_deopt_point(&spec, &guarded, 0) < 0,
+                "Accepted a resume IR with guards");
+
+    TEST_PASS();
+}
+
+// ============================================================================
+// Main Test Entry Point
+// ============================================================================
+
+int test_baseline_jit(void) {
+    terminal_writestring("\n");
+    terminal_writestring("========================================\n");
+    terminal_writestring("  Baseline JIT Test Suite\n");
+    terminal_writestring("========================================\n");
+
+    g_tests_passed = 0;
+    g_tests_total = 0;
+
+    if (jit_allocator_init(256 * 1024, 512 * 1024, 128 * 1024) != 0 ||
+        micro_jit_init(&g_ctx, NULL) != 0) {
+        terminal_writestring("  FAIL: No JIT code buffer\n");
+        return 1;
+    }
+
+    test_int_ops();
+    test_float_ops();
+    test_spills();
+    test_loop();
+    test_deopt_mid_loop();
+    test_deopt_point_validation();
+
+    micro_jit_destroy(&g_ctx);
+
+    terminal_writestring("\n========================================\n");
+    terminal_writestring("  Results: ");
+    test_print_count(g_tests_passed);
+    terminal_writestring(" / ");
+    test_print_count(g_tests_total);
+    terminal_writestring(" tests passed\n");
+    terminal_writestring("========================================\n\n");
+
+    return (g_tests_passed == g_tests_total) ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#ifndef BASELINE_JIT_TEST_H
+#define BASELINE_JIT_TEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Test baseline JIT code generation and deoptimization
+ *
+ * Returns: 0 on success, non-zero on failure
+ */
+int test_baseline_jit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BASELINE_JIT_TEST_H
@@ -33,6 +33,18 @@ void function_profiler_init(function_profiler_t* profiler, bool enable_jit) {
 
     memset(profiler, 0, sizeof(function_profiler_t));
     profiler->jit_enabled = enable_jit;
+    profiler->current_func = FUNC_NONE;
+}
+
+void function_profiler_destroy(function_profiler_t* profiler) {
+    if (!profiler) return;
+
+    for (int i = 0; i < profiler->function_count; i++) {
+        free(profiler->functions[i].latency);
+        profiler->functions[i].latency = NULL;
+        free(profiler->functions[i].args);
+        profiler->functions[i].args = NULL;
+    }
 }
 
 // ============================================================================
@@ -58,10 +70,18 @@ int function_profiler_register(
     func->total_cycles = 0;
     func->min_cycles = UINT64_MAX;
     func->max_cycles = 0;
+    tier_state_init(&func->tier, 0);
     func->opt_level = OPT_LEVEL_O0;
+    func->target_level = OPT_LEVEL_O0;
     func->needs_recompile = false;
     func->is_hot = false;
 
+    // Histograms are 1.2 KB each: allocate only for registered functions
+    func->latency = (latency_histogram_t*)malloc(sizeof(latency_histogram_t));
+    latency_hist_init(func->latency);
+    func->args = NULL;
+    func->num_args = 0;
+
     profiler->function_count++;
     return id;
 }
@@ -70,10 +90,39 @@ int function_profiler_register(
 // Call Recording
 // ============================================================================
 
+// Single calls re-run the cost model every this many calls
+#define TIER_CHECK_INTERVAL 8
+
+// Flag a tier-up once the cost model finds a level worth compiling. While
+// the flag waits for the compiler the target keeps moving up if a higher
+// level starts paying off.
+static void check_thresholds(function_profiler_t* profiler, function_profile_t* func,
+                             uint64_t calls) {
+    if (!profiler->jit_enabled) return;
+    if (calls == 1 && (func->call_count & (TIER_CHECK_INTERVAL - 1)) != 0) return;
+
+    tier_decision_t decision;
+    tier_decide(&func->tier, profiler->total_calls, func->opt_level, &decision);
+    if (decision.level > (int)func->opt_level &&
+        (!func->needs_recompile || decision.level > (int)func->target_level)) {
+        func->target_level = (opt_level_t)decision.level;
+        func->needs_recompile = true;
+    }
+}
+
 void function_profiler_record(
     function_profiler_t* profiler,
     int func_id,
     uint64_t cycles)
+{
+    function_profiler_record_pmu(profiler, func_id, cycles, NULL);
+}
+
+void function_profiler_record_pmu(
+    function_profiler_t* profiler,
+    int func_id,
+    uint64_t cycles,
+    const pmu_counts_t* pmu)
 {
     if (!profiler || func_id < 0 || func_id >= profiler->function_count) return;
 
@@ -81,6 +130,13 @@ void function_profiler_record(
 
     func->call_count++;
     func->total_cycles += cycles;
+    latency_hist_record(func->latency, cycles);
+
+    if (pmu) {
+        for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+            func->pmu_counts[e] += pmu->counts[e];
+        }
+    }
 
     if (cycles < func->min_cycles) {
         func->min_cycles = cycles;
@@ -90,29 +146,124 @@ void function_profiler_record(
     }
 
     profiler->total_calls++;
+    tier_record_calls(&func->tier, profiler->total_calls, 1);
+    tier_record_cycles(&func->tier, cycles);
+    check_thresholds(profiler, func, 1);
+}
+
+void function_profiler_record_untimed(
+    function_profiler_t* profiler,
+    int func_id,
+    uint64_t calls)
+{
+    if (!profiler || func_id < 0 || func_id >= profiler->function_count || calls == 0) return;
 
-    // Check if JIT recompilation is needed
-    if (profiler->jit_enabled && !func->needs_recompile) {
-        uint64_t calls = func->call_count;
-        opt_level_t current = func->opt_level;
+    function_profile_t* func = &profiler->functions[func_id];
+    func->call_count += calls;
+    profiler->total_calls += calls;
+    tier_record_calls(&func->tier, profiler->total_calls,
+                      calls > UINT32_MAX ? UINT32_MAX : (uint32_t)calls);
+    check_thresholds(profiler, func, calls);
+}
 
-        // Trigger recompilation at thresholds
-        if (current == OPT_LEVEL_O0 && calls >= JIT_THRESHOLD_O1) {
-            func->needs_recompile = true;
-        }
-        else if (current == OPT_LEVEL_O1 && calls >= JIT_THRESHOLD_O2) {
-            func->needs_recompile = true;
-        }
-        else if (current == OPT_LEVEL_O2 && calls >= JIT_THRESHOLD_O3) {
-            func->needs_recompile = true;
+// ============================================================================
+// Argument Values
+// ============================================================================
+
+void function_profiler_record_arg(
+    function_profiler_t* profiler,
+    int func_id,
+    int arg_index,
+    uint32_t value)
+{
+    if (!profiler || func_id < 0 || func_id >= profiler->function_count) return;
+    if (arg_index < 0 || arg_index >= VALUE_PROFILE_MAX_ARGS) return;
+
+    function_profile_t* func = &profiler->functions[func_id];
+
+    // Only functions whose arguments are profiled pay for the slots
+    if (!func->args) {
+        func->args = (value_profile_t*)malloc(VALUE_PROFILE_MAX_ARGS * sizeof(value_profile_t));
+        if (!func->args) return;
+        for (int i = 0; i < VALUE_PROFILE_MAX_ARGS; i++) {
+            value_profile_init(&func->args[i]);
         }
     }
+
+    value_profile_record(&func->args[arg_index], value);
+    if (arg_index >= func->num_args) {
+        func->num_args = arg_index + 1;
+    }
+}
+
+const value_profile_t* function_profiler_arg_profile(
+    function_profiler_t* profiler,
+    int func_id,
+    int arg_index)
+{
+    if (!profiler || func_id < 0 || func_id >= profiler->function_count) return NULL;
+
+    function_profile_t* func = &profiler->functions[func_id];
+    if (!func->args || arg_index < 0 || arg_index >= func->num_args) return NULL;
+
+    return &func->args[arg_index];
+}
+
+// ============================================================================
+// Bound Classification
+// ============================================================================
+
+func_bound_t function_profiler_classify(
+    function_profiler_t* profiler,
+    int func_id)
+{
+    if (!profiler || func_id < 0 || func_id >= profiler->function_count) {
+        return FUNC_BOUND_UNKNOWN;
+    }
+
+    const uint64_t* counts = profiler->functions[func_id].pmu_counts;
+    uint64_t instructions = counts[PMU_EVENT_INSTRUCTIONS];
+    if (instructions == 0) {
+        return FUNC_BOUND_UNKNOWN;
+    }
+
+    // Compare misses * 1000 against instructions * MPKI (no 64-bit division)
+    uint64_t memory_misses = counts[PMU_EVENT_LLC_MISSES];
+    if (counts[PMU_EVENT_DTLB_MISSES] > memory_misses) {
+        memory_misses = counts[PMU_EVENT_DTLB_MISSES];
+    }
+    if (memory_misses * 1000 >= instructions * BOUND_MEMORY_MPKI) {
+        return FUNC_BOUND_MEMORY;
+    }
+    if (counts[PMU_EVENT_BRANCH_MISSES] * 1000 >= instructions * BOUND_BRANCH_MPKI) {
+        return FUNC_BOUND_BRANCH;
+    }
+    return FUNC_BOUND_COMPUTE;
+}
+
+const char* function_profiler_bound_name(func_bound_t bound) {
+    switch (bound) {
+        case FUNC_BOUND_COMPUTE: return "compute";
+        case FUNC_BOUND_MEMORY:  return "memory";
+        case FUNC_BOUND_BRANCH:  return "branch";
+        default:                 return "unknown";
+    }
 }
 
 // ============================================================================
 // JIT Recompilation Checks
 // ============================================================================
 
+void function_profiler_set_ir_size(
+    function_profiler_t* profiler,
+    int func_id,
+    uint32_t instructions)
+{
+    if (!profiler || func_id < 0 || func_id >= profiler->function_count) return;
+
+    profiler->functions[func_id].tier.ir_size = instructions ? instructions : TIER_DEFAULT_SIZE;
+}
+
 bool function_profiler_needs_recompile(
     function_profiler_t* profiler,
     int func_id)
@@ -132,10 +283,28 @@ void function_profiler_mark_recompiled(
     if (!profiler || func_id < 0 || func_id >= profiler->function_count) return;
 
     function_profile_t* func = &profiler->functions[func_id];
+    if (new_level != func->opt_level) {
+        tier_level_changed(&func->tier, func->opt_level, new_level);
+    }
     func->opt_level = new_level;
+    func->target_level = new_level;
     func->needs_recompile = false;
 }
 
+opt_level_t function_profiler_target_level(
+    function_profiler_t* profiler,
+    int func_id)
+{
+    if (!profiler || func_id < 0 || func_id >= profiler->function_count) {
+        return OPT_LEVEL_O0;
+    }
+
+    function_profile_t* func = &profiler->functions[func_id];
+    tier_decision_t decision;
+    tier_decide(&func->tier, profiler->total_calls, func->opt_level, &decision);
+    return (opt_level_t)decision.level;
+}
+
 // ============================================================================
 // Hot Function Detection
 // ============================================================================
@@ -179,6 +348,133 @@ int function_profiler_get_hot_functions(
     return count;
 }
 
+// ============================================================================
+// Call-Graph Edges
+// ============================================================================
+
+static uint32_t edge_hash(int caller_id, int callee_id, uint32_t callsite) {
+    uint32_t h = callsite * 0x9E3779B1u;
+    h ^= (uint32_t)caller_id * 0x85EBCA6Bu;
+    h ^= (uint32_t)callee_id * 0xC2B2AE35u;
+    return (h ^ (h >> 16)) & (MAX_CALL_EDGES - 1);
+}
+
+uint64_t* function_profiler_edge_counter(
+    function_profiler_t* profiler,
+    int caller_id,
+    int callee_id,
+    uint32_t callsite)
+{
+    if (!profiler) return NULL;
+    if (caller_id < 0 || caller_id >= profiler->function_count) return NULL;
+    if (callee_id < 0 || callee_id >= profiler->function_count) return NULL;
+
+    uint32_t slot = edge_hash(caller_id, callee_id, callsite);
+    for (int probe = 0; probe < MAX_CALL_EDGES; probe++) {
+        call_edge_t* edge = &profiler->edges[slot];
+
+        if (!edge->in_use) {
+            edge->caller = (uint16_t)caller_id;
+            edge->callee = (uint16_t)callee_id;
+            edge->callsite = callsite;
+            edge->count = 0;
+            edge->in_use = true;
+            profiler->edge_count++;
+            return &edge->count;
+        }
+        if (edge->caller == caller_id && edge->callee == callee_id &&
+            edge->callsite == callsite) {
+            return &edge->count;
+        }
+
+        slot = (slot + 1) & (MAX_CALL_EDGES - 1);
+    }
+
+    return NULL;
+}
+
+void function_profiler_record_edge(
+    function_profiler_t* profiler,
+    int caller_id,
+    int callee_id,
+    uint32_t callsite)
+{
+    if (!profiler || caller_id == FUNC_NONE) return;
+
+    uint64_t* counter = function_profiler_edge_counter(profiler, caller_id, callee_id, callsite);
+    if (counter) {
+        (*counter)++;
+    } else {
+        profiler->edges_dropped++;
+    }
+}
+
+int function_profiler_get_hot_edges(
+    function_profiler_t* profiler,
+    int* edge_ids,
+    int max_count)
+{
+    if (!profiler || !edge_ids || max_count <= 0) return 0;
+
+    // Insertion into a sorted top-N list (N is small)
+    int count = 0;
+    for (int i = 0; i < MAX_CALL_EDGES; i++) {
+        const call_edge_t* edge = &profiler->edges[i];
+        if (!edge->in_use || edge->count == 0) continue;
+
+        int pos = count < max_count ? count : max_count;
+        while (pos > 0 && profiler->edges[edge_ids[pos - 1]].count < edge->count) {
+            if (pos < max_count) {
+                edge_ids[pos] = edge_ids[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max_count) {
+            edge_ids[pos] = i;
+            if (count < max_count) count++;
+        }
+    }
+
+    return count;
+}
+
+// ============================================================================
+// Branch Sites
+// ============================================================================
+
+uint64_t* function_profiler_branch_counters(
+    function_profiler_t* profiler,
+    int func_id,
+    uint32_t site)
+{
+    if (!profiler) return NULL;
+    if (func_id < 0 || func_id >= profiler->function_count) return NULL;
+
+    uint32_t slot = site * 0x9E3779B1u;
+    slot ^= (uint32_t)func_id * 0x85EBCA6Bu;
+    slot = (slot ^ (slot >> 16)) & (MAX_BRANCH_SITES - 1);
+
+    for (int probe = 0; probe < MAX_BRANCH_SITES; probe++) {
+        branch_site_t* branch = &profiler->branches[slot];
+
+        if (!branch->in_use) {
+            branch->func = (uint16_t)func_id;
+            branch->site = site;
+            branch->count[0] = branch->count[1] = 0;
+            branch->in_use = true;
+            profiler->branch_count++;
+            return branch->count;
+        }
+        if (branch->func == func_id && branch->site == site) {
+            return branch->count;
+        }
+
+        slot = (slot + 1) & (MAX_BRANCH_SITES - 1);
+    }
+
+    return NULL;
+}
+
 // ============================================================================
 // Statistics Printing (for VGA debugging)
 // ============================================================================
@@ -276,30 +572,258 @@ void function_profiler_print_stats(function_profiler_t* profiler) {
             terminal_writestring(", Max: ");
             print_uint64(func->max_cycles);
             terminal_writestring("\n");
+
+            terminal_writestring("    p50: ");
+            print_uint64(latency_hist_percentile(func->latency, LATENCY_P50));
+            terminal_writestring(", p99: ");
+            print_uint64(latency_hist_percentile(func->latency, LATENCY_P99));
+            terminal_writestring(", p999: ");
+            print_uint64(latency_hist_percentile(func->latency, LATENCY_P999));
+            terminal_writestring("\n");
+        }
+
+        if (pmu_available()) {
+            terminal_writestring("    Instructions: ");
+            print_uint64(func->pmu_counts[PMU_EVENT_INSTRUCTIONS]);
+            terminal_writestring(", LLC misses: ");
+            print_uint64(func->pmu_counts[PMU_EVENT_LLC_MISSES]);
+            terminal_writestring(", Bound: ");
+            terminal_writestring(function_profiler_bound_name(function_profiler_classify(profiler, i)));
+            terminal_writestring("\n");
+        }
+
+        for (int a = 0; a < func->num_args; a++) {
+            value_slot_t top[VALUE_PROFILE_SLOTS];
+            int n = value_profile_top(&func->args[a], top, VALUE_PROFILE_SLOTS);
+            if (n == 0) continue;
+
+            terminal_writestring("    Arg ");
+            print_int(a);
+            terminal_writestring(" top values:");
+            for (int k = 0; k < n; k++) {
+                terminal_writestring(" ");
+                print_uint64(top[k].value);
+                terminal_writestring(" x");
+                print_uint64(top[k].count);
+            }
+            terminal_writestring("\n");
         }
 
         terminal_writestring("    Opt level: O");
         print_int(func->opt_level);
+        terminal_writestring(", hotness ");
+        print_uint64(tier_hotness(&func->tier, profiler->total_calls));
         if (func->needs_recompile) {
-            terminal_writestring(" [NEEDS RECOMPILE]");
+            terminal_writestring(" [NEEDS RECOMPILE -> O");
+            print_int(func->target_level);
+            terminal_writestring("]");
         }
         if (func->is_hot) {
             terminal_writestring(" [HOT]");
         }
         terminal_writestring("\n\n");
     }
+
+    int hot_edges[8];
+    int edge_count = function_profiler_get_hot_edges(profiler, hot_edges, 8);
+    if (edge_count > 0) {
+        terminal_writestring("Hot call edges:\n");
+        for (int i = 0; i < edge_count; i++) {
+            const call_edge_t* edge = &profiler->edges[hot_edges[i]];
+            terminal_writestring("  ");
+            terminal_writestring(profiler->functions[edge->caller].name);
+            terminal_writestring(" -> ");
+            terminal_writestring(profiler->functions[edge->callee].name);
+            terminal_writestring(": ");
+            print_uint64(edge->count);
+            terminal_writestring("\n");
+        }
+        if (profiler->edges_dropped) {
+            terminal_writestring("  (edge table full, ");
+            print_uint64(profiler->edges_dropped);
+            terminal_writestring(" calls not attributed)\n");
+        }
+        terminal_writestring("\n");
+    }
 }
 
 // ============================================================================
 // JSON Export (for automation tools)
 // ============================================================================
 
+// Per-function worst case: two escaped 63-char names, fixed text, 13 numbers
+#define JSON_BYTES_PER_FUNCTION 896
+// Per profiled argument: fixed text, 2 + 3 numbers per slot
+#define JSON_BYTES_PER_ARG (64 + VALUE_PROFILE_SLOTS * 72)
+#define JSON_BYTES_HEADER 384
+// Per-edge worst case: two escaped names, fixed text, 2 numbers
+#define JSON_BYTES_PER_EDGE 384
+// Per-branch worst case: one escaped name, fixed text, 3 numbers
+#define JSON_BYTES_PER_BRANCH 256
+
+typedef struct {
+    char* buf;
+    size_t len;
+} json_buf_t;
+
+static void json_str(json_buf_t* j, const char* str) {
+    while (*str) {
+        j->buf[j->len++] = *str++;
+    }
+}
+
+// Bounded copy for names, escaping the characters JSON cares about
+static void json_name(json_buf_t* j, const char* str) {
+    j->buf[j->len++] = '"';
+    for (int i = 0; str && str[i] && i < 63; i++) {
+        if (str[i] == '"' || str[i] == '\\') {
+            j->buf[j->len++] = '\\';
+        }
+        j->buf[j->len++] = str[i];
+    }
+    j->buf[j->len++] = '"';
+}
+
+static void json_u64(json_buf_t* j, uint64_t value) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n > 0) {
+        j->buf[j->len++] = digits[--n];
+    }
+}
+
 char* function_profiler_export_json(function_profiler_t* profiler) {
     if (!profiler) return NULL;
 
-    // TODO: Implement JSON export with proper sprintf/vsprintf
-    // For now, use VGA printing via function_profiler_print_stats()
-    // JSON export will be added when we integrate llvm-libc's sprintf
+    size_t capacity = JSON_BYTES_HEADER + (size_t)profiler->function_count * JSON_BYTES_PER_FUNCTION +
+                      (size_t)profiler->edge_count * JSON_BYTES_PER_EDGE +
+                      (size_t)profiler->branch_count * JSON_BYTES_PER_BRANCH;
+    for (int i = 0; i < profiler->function_count; i++) {
+        capacity += (size_t)profiler->functions[i].num_args * JSON_BYTES_PER_ARG;
+    }
+    json_buf_t j = { (char*)malloc(capacity), 0 };
+    if (!j.buf) return NULL;
+
+    json_str(&j, "{\n  \"format_version\": \"1.0\",\n  \"type\": \"function_profile\",\n");
+    json_str(&j, "  \"pmu_available\": ");
+    json_str(&j, pmu_available() ? "true" : "false");
+    json_str(&j, ",\n  \"timebase\": { \"tsc_hz\": ");
+    json_u64(&j, timebase_hz());
+    json_str(&j, ", \"invariant\": ");
+    json_str(&j, timebase_invariant() ? "true" : "false");
+    json_str(&j, ", \"fence\": \"");
+    json_str(&j, timebase_fence_name(timebase_fence()));
+    json_str(&j, "\", \"overhead_cycles\": ");
+    json_u64(&j, timebase_overhead());
+    json_str(&j, " }");
+    json_str(&j, ",\n  \"total_calls\": ");
+    json_u64(&j, profiler->total_calls);
+    json_str(&j, ",\n  \"functions\": [\n");
+
+    for (int i = 0; i < profiler->function_count; i++) {
+        const function_profile_t* func = &profiler->functions[i];
+
+        json_str(&j, "    { \"name\": ");
+        json_name(&j, func->name);
+        json_str(&j, ", \"module\": ");
+        json_name(&j, func->module_name);
+        json_str(&j, ", \"calls\": ");
+        json_u64(&j, func->call_count);
+        json_str(&j, ", \"total_cycles\": ");
+        json_u64(&j, func->total_cycles);
+        json_str(&j, ", \"total_ns\": ");
+        json_u64(&j, timebase_cycles_to_ns(func->total_cycles));
+        json_str(&j, ", \"min_cycles\": ");
+        json_u64(&j, func->call_count ? func->min_cycles : 0);
+        json_str(&j, ", \"max_cycles\": ");
+        json_u64(&j, func->max_cycles);
+        json_str(&j, ", \"p50_cycles\": ");
+        json_u64(&j, latency_hist_percentile(func->latency, LATENCY_P50));
+        json_str(&j, ", \"p99_cycles\": ");
+        json_u64(&j, latency_hist_percentile(func->latency, LATENCY_P99));
+        json_str(&j, ", \"p999_cycles\": ");
+        json_u64(&j, latency_hist_percentile(func->latency, LATENCY_P999));
+        json_str(&j, ", \"opt_level\": ");
+        json_u64(&j, func->opt_level);
+        json_str(&j, ", \"hotness\": ");
+        json_u64(&j, tier_hotness(&func->tier, profiler->total_calls));
+        json_str(&j, ", \"bound\": \"");
+        json_str(&j, function_profiler_bound_name(function_profiler_classify(profiler, i)));
+        json_str(&j, "\", \"pmu\": {");
+        for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+            json_str(&j, e ? ", \"" : " \"");
+            json_str(&j, pmu_event_name((pmu_event_t)e));
+            json_str(&j, "\": ");
+            json_u64(&j, func->pmu_counts[e]);
+        }
+        json_str(&j, " }, \"args\": [");
+        for (int a = 0; a < func->num_args; a++) {
+            value_slot_t top[VALUE_PROFILE_SLOTS];
+            int n = value_profile_top(&func->args[a], top, VALUE_PROFILE_SLOTS);
+
+            json_str(&j, a ? ", { \"samples\": " : " { \"samples\": ");
+            json_u64(&j, func->args[a].total);
+            json_str(&j, ", \"top\": [");
+            for (int k = 0; k < n; k++) {
+                json_str(&j, k ? ", [" : "[");
+                json_u64(&j, top[k].value);
+                json_str(&j, ", ");
+                json_u64(&j, top[k].count);
+                json_str(&j, ", ");
+                json_u64(&j, top[k].error);
+                json_str(&j, "]");
+            }
+            json_str(&j, "] }");
+        }
+        json_str(&j, func->num_args ? " ]" : "]");
+        json_str(&j, i + 1 < profiler->function_count ? " },\n" : " }\n");
+    }
 
-    return NULL;
+    // Call graph: functions are referenced by name so the host can map
+    // edges onto the module's IR
+    json_str(&j, "  ],\n  \"edges\": [");
+    bool first_edge = true;
+    for (int i = 0; i < MAX_CALL_EDGES; i++) {
+        const call_edge_t* edge = &profiler->edges[i];
+        if (!edge->in_use || edge->count == 0) continue;
+
+        json_str(&j, first_edge ? "\n    { \"caller\": " : ",\n    { \"caller\": ");
+        json_name(&j, profiler->functions[edge->caller].name);
+        json_str(&j, ", \"callee\": ");
+        json_name(&j, profiler->functions[edge->callee].name);
+        json_str(&j, ", \"callsite\": ");
+        json_u64(&j, edge->callsite);
+        json_str(&j, ", \"count\": ");
+        json_u64(&j, edge->count);
+        json_str(&j, " }");
+        first_edge = false;
+    }
+    json_str(&j, first_edge ? "],\n" : "\n  ],\n");
+    json_str(&j, "  \"edges_dropped\": ");
+    json_u64(&j, profiler->edges_dropped);
+
+    json_str(&j, ",\n  \"branches\": [");
+    bool first_branch = true;
+    for (int i = 0; i < MAX_BRANCH_SITES; i++) {
+        const branch_site_t* branch = &profiler->branches[i];
+        if (!branch->in_use || (branch->count[0] | branch->count[1]) == 0) continue;
+
+        json_str(&j, first_branch ? "\n    { \"function\": " : ",\n    { \"function\": ");
+        json_name(&j, profiler->functions[branch->func].name);
+        json_str(&j, ", \"site\": ");
+        json_u64(&j, branch->site);
+        json_str(&j, ", \"true\": ");
+        json_u64(&j, branch->count[1]);
+        json_str(&j, ", \"false\": ");
+        json_u64(&j, branch->count[0]);
+        json_str(&j, " }");
+        first_branch = false;
+    }
+    json_str(&j, first_branch ? "]\n}\n" : "\n  ]\n}\n");
+    j.buf[j.len] = '\0';
+    return j.buf;
 }
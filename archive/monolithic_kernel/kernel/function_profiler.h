@@ -10,14 +10,21 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "pmu.h"
+#include "latency_histogram.h"
+#include "value_profile.h"
+#include "timebase.h"
+#include "tier_policy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // Maximum number of functions we can track
 #define MAX_FUNCTIONS 128
 
-// JIT recompilation thresholds
-#define JIT_THRESHOLD_O1  100   // After 100 calls, recompile with -O1
-#define JIT_THRESHOLD_O2  1000  // After 1000 calls, recompile with -O2
-#define JIT_THRESHOLD_O3  10000 // After 10000 calls, recompile with -O3
+// Recompilation is decided by tier_policy's cost model (decayed hotness,
+// cycles per call, IR size), not by fixed call counts
 
 // Optimization levels
 typedef enum {
@@ -27,6 +34,18 @@ typedef enum {
     OPT_LEVEL_O3 = 3   // Aggressive optimization
 } opt_level_t;
 
+// What limits a function, from its PMU counts
+typedef enum {
+    FUNC_BOUND_UNKNOWN = 0,  // No PMU data (e.g. QEMU without a virtual PMU)
+    FUNC_BOUND_COMPUTE,      // Few cache/TLB misses and mispredicts per instruction
+    FUNC_BOUND_MEMORY,       // LLC or dTLB misses dominate
+    FUNC_BOUND_BRANCH        // Branch mispredicts dominate
+} func_bound_t;
+
+// Classification thresholds, in events per 1000 instructions
+#define BOUND_MEMORY_MPKI  5    // LLC or dTLB misses
+#define BOUND_BRANCH_MPKI  10   // Branch mispredicts
+
 // Function profile structure
 typedef struct {
     const char* name;           // Function name (e.g., "module_fibonacci::fib")
@@ -36,17 +55,56 @@ typedef struct {
     uint64_t total_cycles;      // Total cycles spent in function
     uint64_t min_cycles;        // Minimum cycles per call
     uint64_t max_cycles;        // Maximum cycles per call
+    uint64_t pmu_counts[PMU_EVENT_COUNT]; // Summed PMU deltas (0 if no PMU)
+    latency_histogram_t* latency; // Per-call cycle distribution (NULL if allocation failed)
+    value_profile_t* args;      // Top argument values (NULL until one is recorded)
+    int num_args;               // Highest recorded argument index + 1
+    tier_state_t tier;          // Hotness and cost-model inputs
     opt_level_t opt_level;      // Current optimization level
+    opt_level_t target_level;   // Level the cost model picked (when needs_recompile)
     bool needs_recompile;       // JIT recompilation flag
     bool is_hot;                // Hot path indicator
 } function_profile_t;
 
+// Call-graph edges: one counter per (caller, callee, call site). Call sites
+// are return addresses for instrumented calls, or the source line for
+// PROFILE_FUNCTION_CALL. Slots are found by hashing (open addressing), so
+// a counter never moves once handed out.
+#define MAX_CALL_EDGES 256      // Power of two
+#define FUNC_NONE      (-1)     // No profiled function is running
+
+typedef struct {
+    uint16_t caller;            // Function IDs
+    uint16_t callee;
+    uint32_t callsite;
+    uint64_t count;
+    bool in_use;
+} call_edge_t;
+
+// Conditional branches: outcome counts per (function, branch site), sites
+// numbered by the code that owns them (the IR interpreter uses branch order
+// within the function). Same hashed layout as the edge table.
+#define MAX_BRANCH_SITES 512    // Power of two
+
+typedef struct {
+    uint16_t func;
+    uint32_t site;
+    uint64_t count[2];          // Condition false [0] / true [1]
+    bool in_use;
+} branch_site_t;
+
 // Function profiler manager
 typedef struct {
     function_profile_t functions[MAX_FUNCTIONS];
     int function_count;
     uint64_t total_calls;       // Total function calls across all functions
     bool jit_enabled;           // Enable JIT recompilation triggers
+    call_edge_t edges[MAX_CALL_EDGES];
+    int edge_count;
+    uint64_t edges_dropped;     // Edge calls not counted because the table was full
+    branch_site_t branches[MAX_BRANCH_SITES];
+    int branch_count;
+    int current_func;           // Innermost profiled function (FUNC_NONE at top level)
 } function_profiler_t;
 
 // ============================================================================
@@ -58,6 +116,11 @@ typedef struct {
  */
 void function_profiler_init(function_profiler_t* profiler, bool enable_jit);
 
+/**
+ * Release per-function latency histograms
+ */
+void function_profiler_destroy(function_profiler_t* profiler);
+
 /**
  * Register a function for profiling
  * Returns: function ID (index) or -1 on error
@@ -79,15 +142,90 @@ void function_profiler_record(
     uint64_t cycles
 );
 
+/**
+ * Record a function call with cycle count and PMU deltas
+ * 'pmu' may be NULL (same as function_profiler_record)
+ */
+void function_profiler_record_pmu(
+    function_profiler_t* profiler,
+    int func_id,
+    uint64_t cycles,
+    const pmu_counts_t* pmu
+);
+
+/**
+ * Count 'calls' calls whose cycles weren't measured (direct JIT-to-JIT
+ * calls counted at the call site); they still drive the tier thresholds
+ */
+void function_profiler_record_untimed(
+    function_profiler_t* profiler,
+    int func_id,
+    uint64_t calls
+);
+
+/**
+ * Record the value of argument 'arg_index' (< VALUE_PROFILE_MAX_ARGS) for
+ * the current call, e.g. fibonacci's n or a matmul dimension
+ */
+void function_profiler_record_arg(
+    function_profiler_t* profiler,
+    int func_id,
+    int arg_index,
+    uint32_t value
+);
+
+/**
+ * Value profile of one argument, NULL if none was recorded
+ */
+const value_profile_t* function_profiler_arg_profile(
+    function_profiler_t* profiler,
+    int func_id,
+    int arg_index
+);
+
+/**
+ * Classify a function as compute-, memory- or branch-bound from its
+ * accumulated PMU counts
+ */
+func_bound_t function_profiler_classify(
+    function_profiler_t* profiler,
+    int func_id
+);
+
+/**
+ * Name of a bound class ("compute", "memory", "branch", "unknown")
+ */
+const char* function_profiler_bound_name(func_bound_t bound);
+
+/**
+ * Size of a function's IR in instructions, for the compile cost estimate
+ * (functions without one are costed at TIER_DEFAULT_SIZE)
+ */
+void function_profiler_set_ir_size(
+    function_profiler_t* profiler,
+    int func_id,
+    uint32_t instructions
+);
+
 /**
  * Check if a function needs JIT recompilation
- * Returns true if call count crossed a threshold
+ * Returns true once the cost model finds a level worth compiling
+ * (function_profile_t.target_level; later calls may still raise it)
  */
 bool function_profiler_needs_recompile(
     function_profiler_t* profiler,
     int func_id
 );
 
+/**
+ * Level the cost model picks for a function right now (its current level
+ * if no recompilation pays off); may skip levels
+ */
+opt_level_t function_profiler_target_level(
+    function_profiler_t* profiler,
+    int func_id
+);
+
 /**
  * Mark a function as recompiled with new optimization level
  */
@@ -107,14 +245,60 @@ int function_profiler_get_hot_functions(
     int max_count
 );
 
+/**
+ * Counter for the call edge caller -> callee at 'callsite', created on
+ * first use. Instrumented code increments it directly.
+ * Returns: counter address, NULL if the IDs are invalid or the table is full
+ */
+uint64_t* function_profiler_edge_counter(
+    function_profiler_t* profiler,
+    int caller_id,
+    int callee_id,
+    uint32_t callsite
+);
+
+/**
+ * Count one call along caller -> callee at 'callsite'
+ * (no-op when caller_id is FUNC_NONE)
+ */
+void function_profiler_record_edge(
+    function_profiler_t* profiler,
+    int caller_id,
+    int callee_id,
+    uint32_t callsite
+);
+
+/**
+ * Get the hottest call edges (indices into profiler->edges), by count
+ * Returns: number of edges written
+ */
+int function_profiler_get_hot_edges(
+    function_profiler_t* profiler,
+    int* edge_ids,      // Output array (max_count entries)
+    int max_count
+);
+
+/**
+ * Outcome counters of branch 'site' in 'func_id', created on first use.
+ * Index with the condition (0 false, 1 true); instrumented code and the IR
+ * interpreter increment them directly.
+ * Returns: counter pair, NULL if the ID is invalid or the table is full
+ */
+uint64_t* function_profiler_branch_counters(
+    function_profiler_t* profiler,
+    int func_id,
+    uint32_t site
+);
+
 /**
  * Print profiling statistics (for debugging)
  */
 void function_profiler_print_stats(function_profiler_t* profiler);
 
 /**
- * Export profiling data to JSON format
- * Returns: JSON string (caller must free)
+ * Export profiling data (cycles, PMU counts, bound class, top argument
+ * values as [value, count, error], call edges, branch outcomes) to JSON format
+ * Returns: JSON string (caller must free), NULL on allocation failure
  */
 char* function_profiler_export_json(function_profiler_t* profiler);
 
@@ -122,18 +306,32 @@ char* function_profiler_export_json(function_profiler_t* profiler);
 // Helper Macros for Function Wrapping
 // ============================================================================
 
-// Macro to wrap a function call with profiling
+// Macro to wrap a function call with profiling (cycles + PMU counters).
+// Nested uses also count the caller -> callee edge for this source line.
 #define PROFILE_FUNCTION_CALL(profiler, func_id, func_call) \
     do { \
         uint64_t start_cycles, end_cycles; \
-        __asm__ __volatile__("rdtsc" : "=A"(start_cycles)); \
+        pmu_counts_t pmu_start, pmu_end, pmu_diff; \
+        int caller_id = (profiler)->current_func; \
+        function_profiler_record_edge(profiler, caller_id, func_id, __LINE__); \
+        (profiler)->current_func = (func_id); \
+        pmu_read(&pmu_start); \
+        start_cycles = timebase_begin(); \
         func_call; \
-        __asm__ __volatile__("rdtsc" : "=A"(end_cycles)); \
-        function_profiler_record(profiler, func_id, end_cycles - start_cycles); \
+        end_cycles = timebase_end(); \
+        pmu_read(&pmu_end); \
+        pmu_delta(&pmu_start, &pmu_end, &pmu_diff); \
+        (profiler)->current_func = caller_id; \
+        function_profiler_record_pmu(profiler, func_id, \
+                                     timebase_elapsed(start_cycles, end_cycles), &pmu_diff); \
     } while(0)
 
 // Example usage:
 // int result;
 // PROFILE_FUNCTION_CALL(&profiler, fib_id, result = fibonacci(20));
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // FUNCTION_PROFILER_H
@@ -39,6 +39,7 @@ void test_function_profiler(void) {
     // Initialize profiler with JIT enabled
     function_profiler_t profiler;
     function_profiler_init(&profiler, true);
+    timebase_init();
 
     // Register test functions
     int fib_id = function_profiler_register(&profiler, "test_fibonacci", "test", (void*)test_fibonacci);
@@ -54,32 +55,46 @@ void test_function_profiler(void) {
 
     for (int i = 0; i < 50; i++) {
         uint64_t start, end;
-        __asm__ __volatile__("rdtsc" : "=A"(start));
+        start = timebase_begin();
         int result = test_fibonacci(10);
-        __asm__ __volatile__("rdtsc" : "=A"(end));
-        function_profiler_record(&profiler, fib_id, end - start);
+        end = timebase_end();
+        function_profiler_record(&profiler, fib_id, timebase_elapsed(start, end));
         (void)result;  // Suppress unused warning
     }
 
     terminal_setcolor(VGA_YELLOW, VGA_BLACK);
-    terminal_writestring("\n[TEST 2] Calling test_sum(1000) x 150 times\n");
+    terminal_writestring("\n[TEST 2] Calling test_sum(n) x 150 times, n mostly 1000\n");
     terminal_setcolor(VGA_LIGHT_GREY, VGA_BLACK);
 
     for (int i = 0; i < 150; i++) {
+        // Mostly n = 1000, occasionally another size
+        int n = (i % 25 == 24) ? 500 + i : 1000;
         uint64_t start, end;
-        __asm__ __volatile__("rdtsc" : "=A"(start));
-        int result = test_sum(1000);
-        __asm__ __volatile__("rdtsc" : "=A"(end));
-        function_profiler_record(&profiler, sum_id, end - start);
+        function_profiler_record_arg(&profiler, sum_id, 0, (uint32_t)n);
+        start = timebase_begin();
+        int result = test_sum(n);
+        end = timebase_end();
+        function_profiler_record(&profiler, sum_id, timebase_elapsed(start, end));
         (void)result;
     }
 
-    // Check if sum should be recompiled (should trigger at 100 calls)
+    uint32_t dominant;
+    if (value_profile_dominant(function_profiler_arg_profile(&profiler, sum_id, 0),
+                               9000, 100, &dominant) && dominant == 1000) {
+        terminal_setcolor(VGA_LIGHT_GREEN, VGA_BLACK);
+        terminal_writestring("✓ test_sum argument n = 1000 is dominant (specialization candidate)\n");
+        terminal_setcolor(VGA_LIGHT_GREY, VGA_BLACK);
+    }
+
+    // Check if sum should be recompiled (once the cost model says it pays off)
     if (function_profiler_needs_recompile(&profiler, sum_id)) {
+        opt_level_t target = profiler.functions[sum_id].target_level;
         terminal_setcolor(VGA_LIGHT_GREEN, VGA_BLACK);
-        terminal_writestring("✓ test_sum reached JIT threshold! Would recompile to O1\n");
+        char level_str[] = "✓ test_sum is worth recompiling! Would recompile to O?\n";
+        level_str[sizeof(level_str) - 3] = (char)('0' + target);
+        terminal_writestring(level_str);
         terminal_setcolor(VGA_LIGHT_GREY, VGA_BLACK);
-        function_profiler_mark_recompiled(&profiler, sum_id, OPT_LEVEL_O1);
+        function_profiler_mark_recompiled(&profiler, sum_id, target);
     }
 
     terminal_setcolor(VGA_YELLOW, VGA_BLACK);
@@ -88,10 +103,10 @@ void test_function_profiler(void) {
 
     for (int i = 0; i < 20; i++) {
         uint64_t start, end;
-        __asm__ __volatile__("rdtsc" : "=A"(start));
+        start = timebase_begin();
         int result = test_factorial(10);
-        __asm__ __volatile__("rdtsc" : "=A"(end));
-        function_profiler_record(&profiler, fact_id, end - start);
+        end = timebase_end();
+        function_profiler_record(&profiler, fact_id, timebase_elapsed(start, end));
         (void)result;
     }
 
@@ -114,6 +129,7 @@ void test_function_profiler(void) {
 
     // Print full statistics
     function_profiler_print_stats(&profiler);
+    function_profiler_destroy(&profiler);
 
     terminal_setcolor(VGA_LIGHT_GREEN, VGA_BLACK);
     terminal_writestring("\n✓ Function profiler test complete!\n");
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include "idt.h"
+#include "sample_profiler.h"
 #include "vga.h"
 
 struct idt_entry {
@@ -28,6 +29,7 @@ extern void isr_gpf(void);
 extern void isr_page_fault(void);
 extern void irq_timer(void);
 extern void irq_keyboard(void);
+extern void irq_lapic_timer(void);
 
 static struct idt_entry idt[256];
 static volatile uint32_t timer_ticks = 0;
@@ -82,6 +84,9 @@ void idt_init(void) {
     set_entry(0x20, (uint32_t)irq_timer, 0x08, 0x8E);     // IRQ0
     set_entry(0x21, (uint32_t)irq_keyboard, 0x08, 0x8E); // IRQ1
 
+    // Local APIC timer (sample_profiler.c)
+    set_entry(SAMPLE_VECTOR, (uint32_t)irq_lapic_timer, 0x08, 0x8E);
+
     struct idt_ptr ptr;
     ptr.limit = sizeof(idt) - 1;
     ptr.base = (uint32_t)idt;
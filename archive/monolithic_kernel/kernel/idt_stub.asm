@@ -3,6 +3,7 @@
 extern exception_handler
 extern timer_handler
 extern keyboard_handler
+extern sample_profiler_tick
 
 global default_isr
 global isr_div_zero
@@ -16,6 +17,7 @@ global isr_gpf
 global isr_page_fault
 global irq_timer
 global irq_keyboard
+global irq_lapic_timer
 
 ; Default ISR
 default_isr:
@@ -101,3 +103,13 @@ irq_keyboard:
     call keyboard_handler
     popa
     iret
+
+; Local APIC timer: hand the saved registers and the interrupt frame
+; (sample_frame_t) to the sampling profiler
+irq_lapic_timer:
+    pusha
+    push esp
+    call sample_profiler_tick
+    add esp, 4
+    popa
+    iret
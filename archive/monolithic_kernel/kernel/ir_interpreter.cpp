@@ -0,0 +1,1440 @@
+// ir_interpreter.cpp - Threaded-dispatch bytecode interpreter for LLVM IR
+// See ir_interpreter.h for the execution and profiling model.
+
+#include "ir_interpreter.h"
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/GetElementPtrTypeIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Operator.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace llvm;
+
+// ============================================================================
+// Bytecode
+// ============================================================================
+//
+// Every SSA value of a function owns a 64-bit slot in the frame: arguments
+// first, then instruction results and translator temporaries, then the
+// constant pool (copied in at entry), then the alloca area. Integers are
+// kept sign-extended from their width (i1 true is all ones), so equality
+// and signed ops need no fixup and unsigned ops mask their operands with
+// the width mask carried in 'imm'. Only the low 32 bits of a float slot
+// are meaningful.
+
+#define IR_INTERP_OPCODES(X) \
+    X(MOV) X(ADD) X(SUB) X(MUL) X(SDIV) X(UDIV) X(SREM) X(UREM) \
+    X(AND) X(OR) X(XOR) X(SHL) X(LSHR) X(ASHR) X(ADDI) X(SCALE_ADD) \
+    X(EQ) X(NE) X(SLT) X(SLE) X(SGT) X(SGE) X(ULT) X(ULE) X(UGT) X(UGE) \
+    X(FADD32) X(FSUB32) X(FMUL32) X(FDIV32) X(FNEG32) X(FCMP32) \
+    X(FADD64) X(FSUB64) X(FMUL64) X(FDIV64) X(FNEG64) X(FCMP64) \
+    X(TRUNC) X(ZEXT) X(SITOFP32) X(SITOFP64) X(UITOFP32) X(UITOFP64) \
+    X(FPTOSI32) X(FPTOSI64) X(FPTOUI32) X(FPTOUI64) X(FPTRUNC) X(FPEXT) \
+    X(SELECT) X(LOCAL) \
+    X(LOAD1) X(LOAD8) X(LOAD16) X(LOAD32) X(LOAD64) \
+    X(STORE1) X(STORE8) X(STORE16) X(STORE32) X(STORE64) \
+    X(BR) X(CONDBR) X(CASE) X(CALL) X(NATIVE) X(RET) X(RET_VOID) X(TRAP)
+
+enum Opcode : uint16_t {
+#define IR_INTERP_ENUM(name) OP_##name,
+    IR_INTERP_OPCODES(IR_INTERP_ENUM)
+#undef IR_INTERP_ENUM
+    OP_COUNT
+};
+
+struct InterpFunction;
+
+struct Insn {
+    const void* handler;    // Threaded code: address of the opcode's handler
+    uint16_t op;
+    uint8_t bits;           // Width of an integer result
+    uint8_t argc;           // CALL / NATIVE
+    uint32_t dst;
+    uint32_t a, b, c;       // Operand slots (c: select's false value or a branch target)
+    int64_t imm;            // Constant, width mask, offset, scale or branch target
+    void* aux;              // Callee: InterpFunction or native function
+    uint64_t* count;        // Call-edge counter, or branch outcome pair
+};
+
+// Parameter / return classes, for normalization at the API boundary
+enum ValueKind : uint8_t {
+    KIND_VOID,
+    KIND_INT,
+    KIND_FLOAT,
+    KIND_DOUBLE,
+    KIND_POINTER
+};
+
+struct InterpFunction {
+    std::string name;
+    int profile_id = -1;
+    bool translated = false;    // False: unsupported (see 'error')
+    std::string error;
+    std::vector<Insn> code;
+    std::vector<uint32_t> call_args;    // Argument slots, indexed by CALL/NATIVE 'a'
+    std::vector<uint64_t> constants;
+    std::vector<ValueKind> arg_kinds;
+    std::vector<uint8_t> arg_bits;
+    ValueKind ret_kind = KIND_VOID;
+    uint8_t ret_bits = 0;
+    uint32_t const_base = 0;    // First constant slot
+    uint32_t locals_slot = 0;   // First slot of the alloca area
+    uint32_t frame_slots = 0;
+};
+
+typedef uintptr_t (*NativeFunction)(uintptr_t, uintptr_t, uintptr_t,
+                                    uintptr_t, uintptr_t, uintptr_t);
+
+struct IRInterpreter {
+    function_profiler_t* profiler = nullptr;
+    std::unique_ptr<LLVMContext> llvm_ctx;
+    std::unique_ptr<uint64_t[]> stack;
+    size_t sp = 0;
+    const void* const* handlers = nullptr;
+    std::deque<InterpFunction> functions;   // Deque: CALL holds their addresses
+    std::unordered_map<std::string, int> function_index;
+    std::unordered_map<std::string, void*> symbols;
+    std::deque<std::string> module_names;   // Registered with the profiler by pointer
+    std::vector<std::unique_ptr<uint8_t[]>> global_storage;
+    uint64_t scratch_counts[2] = {0, 0};    // Counter target when the profiler has no slot
+    IRInterpStats stats = {};
+    std::string last_error;
+};
+
+static inline uint64_t sx(uint64_t value, unsigned bits) {
+    unsigned shift = 64 - bits;
+    return (uint64_t)((int64_t)(value << shift) >> shift);
+}
+
+static inline uint64_t widthMask(unsigned bits) {
+    return bits >= 64 ? ~0ull : (1ull << bits) - 1;
+}
+
+static inline float f32(uint64_t slot) {
+    uint32_t raw = (uint32_t)slot;
+    float value;
+    memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+static inline uint64_t fromF32(float value) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+static inline double f64(uint64_t slot) {
+    double value;
+    memcpy(&value, &slot, sizeof(value));
+    return value;
+}
+
+static inline uint64_t fromF64(double value) {
+    uint64_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+// ============================================================================
+// Interpreter loop
+// ============================================================================
+
+// Run 'fn' with its arguments already in place at the stack top. Called
+// with fn == nullptr once, to publish the handler table to the translator.
+static bool execute(IRInterpreter* in, const InterpFunction* fn, uint64_t* result) {
+    static const void* const handlers[] = {
+#define IR_INTERP_LABEL(name) &&op_##name,
+        IR_INTERP_OPCODES(IR_INTERP_LABEL)
+#undef IR_INTERP_LABEL
+    };
+
+    // Locals live above the first dispatch: computed goto may not jump
+    // over their initialization
+    uint64_t* r;
+    uint8_t* locals;
+    const Insn* code;
+    const Insn* ip;
+    function_profiler_t* profiler = in->profiler;
+    int caller = FUNC_NONE;
+    uint64_t start = 0;
+    bool ok = true;
+
+    if (!fn) {
+        in->handlers = handlers;
+        return true;
+    }
+    if (!fn->translated) {
+        in->last_error = fn->name + ": " + fn->error;
+        return false;
+    }
+    if (in->sp + fn->frame_slots > IR_INTERP_STACK_SLOTS) {
+        in->last_error = "interpreter stack overflow in " + fn->name;
+        return false;
+    }
+
+    r = in->stack.get() + in->sp;
+    in->sp += fn->frame_slots;
+    memcpy(r + fn->const_base, fn->constants.data(), fn->constants.size() * sizeof(uint64_t));
+    locals = reinterpret_cast<uint8_t*>(r + fn->locals_slot);
+    code = fn->code.data();
+    ip = code;
+    in->stats.calls++;
+
+    if (profiler) {
+        caller = profiler->current_func;
+        profiler->current_func = fn->profile_id;
+        start = timebase_begin();
+    }
+
+#define NEXT()        goto *(++ip)->handler
+#define JUMP(target)  do { ip = code + (target); goto *ip->handler; } while (0)
+#define ADDR(slot)    reinterpret_cast<void*>((uintptr_t)(r[slot] + ip->imm))
+
+    goto *ip->handler;
+
+op_MOV:       r[ip->dst] = r[ip->a]; NEXT();
+op_ADD:       r[ip->dst] = sx(r[ip->a] + r[ip->b], ip->bits); NEXT();
+op_SUB:       r[ip->dst] = sx(r[ip->a] - r[ip->b], ip->bits); NEXT();
+op_MUL:       r[ip->dst] = sx(r[ip->a] * r[ip->b], ip->bits); NEXT();
+op_AND:       r[ip->dst] = r[ip->a] & r[ip->b]; NEXT();
+op_OR:        r[ip->dst] = r[ip->a] | r[ip->b]; NEXT();
+op_XOR:       r[ip->dst] = r[ip->a] ^ r[ip->b]; NEXT();
+op_SHL:       r[ip->dst] = sx(r[ip->a] << (r[ip->b] & 63), ip->bits); NEXT();
+op_LSHR:      r[ip->dst] = sx((r[ip->a] & ip->imm) >> (r[ip->b] & 63), ip->bits); NEXT();
+op_ASHR:      r[ip->dst] = (uint64_t)((int64_t)r[ip->a] >> (r[ip->b] & 63)); NEXT();
+op_ADDI:      r[ip->dst] = r[ip->a] + ip->imm; NEXT();
+op_SCALE_ADD: r[ip->dst] = r[ip->a] + r[ip->b] * ip->imm; NEXT();
+
+op_SDIV:
+op_SREM: {
+    int64_t x = (int64_t)r[ip->a], y = (int64_t)r[ip->b];
+    if (y == 0 || (x == INT64_MIN && y == -1)) goto divide_error;
+    r[ip->dst] = sx((uint64_t)(ip->op == OP_SDIV ? x / y : x % y), ip->bits);
+    NEXT();
+}
+op_UDIV:
+op_UREM: {
+    uint64_t x = r[ip->a] & ip->imm, y = r[ip->b] & ip->imm;
+    if (y == 0) goto divide_error;
+    r[ip->dst] = sx(ip->op == OP_UDIV ? x / y : x % y, ip->bits);
+    NEXT();
+}
+
+op_EQ:  r[ip->dst] = -(uint64_t)(r[ip->a] == r[ip->b]); NEXT();
+op_NE:  r[ip->dst] = -(uint64_t)(r[ip->a] != r[ip->b]); NEXT();
+op_SLT: r[ip->dst] = -(uint64_t)((int64_t)r[ip->a] < (int64_t)r[ip->b]); NEXT();
+op_SLE: r[ip->dst] = -(uint64_t)((int64_t)r[ip->a] <= (int64_t)r[ip->b]); NEXT();
+op_SGT: r[ip->dst] = -(uint64_t)((int64_t)r[ip->a] > (int64_t)r[ip->b]); NEXT();
+op_SGE: r[ip->dst] = -(uint64_t)((int64_t)r[ip->a] >= (int64_t)r[ip->b]); NEXT();
+op_ULT: r[ip->dst] = -(uint64_t)((r[ip->a] & ip->imm) < (r[ip->b] & ip->imm)); NEXT();
+op_ULE: r[ip->dst] = -(uint64_t)((r[ip->a] & ip->imm) <= (r[ip->b] & ip->imm)); NEXT();
+op_UGT: r[ip->dst] = -(uint64_t)((r[ip->a] & ip->imm) > (r[ip->b] & ip->imm)); NEXT();
+op_UGE: r[ip->dst] = -(uint64_t)((r[ip->a] & ip->imm) >= (r[ip->b] & ip->imm)); NEXT();
+
+op_FADD32: r[ip->dst] = fromF32(f32(r[ip->a]) + f32(r[ip->b])); NEXT();
+op_FSUB32: r[ip->dst] = fromF32(f32(r[ip->a]) - f32(r[ip->b])); NEXT();
+op_FMUL32: r[ip->dst] = fromF32(f32(r[ip->a]) * f32(r[ip->b])); NEXT();
+op_FDIV32: r[ip->dst] = fromF32(f32(r[ip->a]) / f32(r[ip->b])); NEXT();
+op_FNEG32: r[ip->dst] = fromF32(-f32(r[ip->a])); NEXT();
+op_FADD64: r[ip->dst] = fromF64(f64(r[ip->a]) + f64(r[ip->b])); NEXT();
+op_FSUB64: r[ip->dst] = fromF64(f64(r[ip->a]) - f64(r[ip->b])); NEXT();
+op_FMUL64: r[ip->dst] = fromF64(f64(r[ip->a]) * f64(r[ip->b])); NEXT();
+op_FDIV64: r[ip->dst] = fromF64(f64(r[ip->a]) / f64(r[ip->b])); NEXT();
+op_FNEG64: r[ip->dst] = fromF64(-f64(r[ip->a])); NEXT();
+
+// 'imm' is the FCmpInst predicate, which is a mask of the outcomes it
+// accepts: 1 equal, 2 greater, 4 less, 8 unordered
+op_FCMP32: {
+    float x = f32(r[ip->a]), y = f32(r[ip->b]);
+    int outcome = (x != x || y != y) ? 8 : x < y ? 4 : x > y ? 2 : 1;
+    r[ip->dst] = (ip->imm & outcome) ? ~0ull : 0;
+    NEXT();
+}
+op_FCMP64: {
+    double x = f64(r[ip->a]), y = f64(r[ip->b]);
+    int outcome = (x != x || y != y) ? 8 : x < y ? 4 : x > y ? 2 : 1;
+    r[ip->dst] = (ip->imm & outcome) ? ~0ull : 0;
+    NEXT();
+}
+
+op_TRUNC:    r[ip->dst] = sx(r[ip->a], ip->bits); NEXT();
+op_ZEXT:     r[ip->dst] = r[ip->a] & ip->imm; NEXT();
+op_SITOFP32: r[ip->dst] = fromF32((float)(int64_t)r[ip->a]); NEXT();
+op_SITOFP64: r[ip->dst] = fromF64((double)(int64_t)r[ip->a]); NEXT();
+op_UITOFP32: r[ip->dst] = fromF32((float)(r[ip->a] & ip->imm)); NEXT();
+op_UITOFP64: r[ip->dst] = fromF64((double)(r[ip->a] & ip->imm)); NEXT();
+op_FPTOSI32: r[ip->dst] = sx((uint64_t)(int64_t)f32(r[ip->a]), ip->bits); NEXT();
+op_FPTOSI64: r[ip->dst] = sx((uint64_t)(int64_t)f64(r[ip->a]), ip->bits); NEXT();
+op_FPTOUI32: r[ip->dst] = sx((uint64_t)f32(r[ip->a]), ip->bits); NEXT();
+op_FPTOUI64: r[ip->dst] = sx((uint64_t)f64(r[ip->a]), ip->bits); NEXT();
+op_FPTRUNC:  r[ip->dst] = fromF32((float)f64(r[ip->a])); NEXT();
+op_FPEXT:    r[ip->dst] = fromF64((double)f32(r[ip->a])); NEXT();
+
+op_SELECT: r[ip->dst] = r[ip->a] ? r[ip->b] : r[ip->c]; NEXT();
+op_LOCAL:  r[ip->dst] = (uint64_t)(uintptr_t)(locals + ip->imm); NEXT();
+
+op_LOAD1:  { uint8_t v; memcpy(&v, ADDR(ip->a), 1); r[ip->dst] = -(uint64_t)(v & 1); NEXT(); }
+op_LOAD8:  { int8_t v;  memcpy(&v, ADDR(ip->a), 1); r[ip->dst] = (uint64_t)(int64_t)v; NEXT(); }
+op_LOAD16: { int16_t v; memcpy(&v, ADDR(ip->a), 2); r[ip->dst] = (uint64_t)(int64_t)v; NEXT(); }
+op_LOAD32: { int32_t v; memcpy(&v, ADDR(ip->a), 4); r[ip->dst] = (uint64_t)(int64_t)v; NEXT(); }
+op_LOAD64: { memcpy(&r[ip->dst], ADDR(ip->a), 8); NEXT(); }
+op_STORE1:  { uint8_t v = r[ip->b] & 1; memcpy(ADDR(ip->a), &v, 1); NEXT(); }
+op_STORE8:  { uint8_t v = (uint8_t)r[ip->b]; memcpy(ADDR(ip->a), &v, 1); NEXT(); }
+op_STORE16: { uint16_t v = (uint16_t)r[ip->b]; memcpy(ADDR(ip->a), &v, 2); NEXT(); }
+op_STORE32: { uint32_t v = (uint32_t)r[ip->b]; memcpy(ADDR(ip->a), &v, 4); NEXT(); }
+op_STORE64: { memcpy(ADDR(ip->a), &r[ip->b], 8); NEXT(); }
+
+op_BR: JUMP(ip->imm);
+op_CONDBR: {
+    uint64_t taken = r[ip->a] != 0;
+    ip->count[taken]++;
+    JUMP(taken ? (uint32_t)ip->imm : ip->c);
+}
+op_CASE: {
+    uint64_t hit = r[ip->a] == (uint64_t)ip->imm;
+    ip->count[hit]++;
+    if (hit) JUMP(ip->c);
+    NEXT();
+}
+
+op_CALL: {
+    const uint32_t* args = fn->call_args.data() + ip->a;
+    uint64_t* callee_args = in->stack.get() + in->sp;
+    uint64_t value = 0;
+    if (in->sp + ip->argc > IR_INTERP_STACK_SLOTS) {
+        in->last_error = "interpreter stack overflow in " + fn->name;
+        goto fail;
+    }
+    (*ip->count)++;
+    for (unsigned k = 0; k < ip->argc; k++) {
+        callee_args[k] = r[args[k]];
+    }
+    if (!execute(in, static_cast<const InterpFunction*>(ip->aux), &value)) goto fail;
+    r[ip->dst] = value;
+    NEXT();
+}
+op_NATIVE: {
+    const uint32_t* args = fn->call_args.data() + ip->a;
+    uintptr_t v[IR_INTERP_MAX_NATIVE_ARGS] = {0, 0, 0, 0, 0, 0};
+    for (unsigned k = 0; k < ip->argc; k++) {
+        v[k] = (uintptr_t)r[args[k]];
+    }
+    NativeFunction native = reinterpret_cast<NativeFunction>(ip->aux);
+    r[ip->dst] = sx(native(v[0], v[1], v[2], v[3], v[4], v[5]), ip->bits);
+    NEXT();
+}
+
+op_RET:
+    if (result) *result = r[ip->a];
+    goto done;
+op_RET_VOID:
+    goto done;
+op_TRAP:
+    in->last_error = fn->name + ": reached unreachable code";
+    goto fail;
+
+#undef NEXT
+#undef JUMP
+#undef ADDR
+
+divide_error:
+    in->last_error = fn->name + ": integer division by zero or overflow";
+fail:
+    ok = false;
+done:
+    if (profiler) {
+        uint64_t end = timebase_end();
+        profiler->current_func = caller;
+        if (fn->profile_id >= 0) {
+            function_profiler_record(profiler, fn->profile_id, timebase_elapsed(start, end));
+        }
+    }
+    in->sp -= fn->frame_slots;
+    return ok;
+}
+
+// ============================================================================
+// Module loading
+// ============================================================================
+
+static void* resolveSymbol(IRInterpreter* in, const std::string& name) {
+    auto it = in->symbols.find(name);
+    if (it != in->symbols.end()) return it->second;
+    return sys::DynamicLibrary::SearchForAddressOfSymbol(name);
+}
+
+// Per-load state: the module's own globals and functions, including ones
+// with internal linkage that aren't visible by name
+struct ModuleLoad {
+    IRInterpreter* in;
+    Module* module;
+    const DataLayout* dl;
+    std::unordered_map<const GlobalValue*, uint8_t*> globals;
+    std::unordered_map<const Function*, InterpFunction*> functions;
+};
+
+static bool valueKind(const DataLayout& dl, Type* type, ValueKind& kind, uint8_t& bits) {
+    bits = 0;
+    if (type->isVoidTy()) {
+        kind = KIND_VOID;
+    } else if (type->isIntegerTy() && type->getIntegerBitWidth() <= 64) {
+        kind = KIND_INT;
+        bits = (uint8_t)type->getIntegerBitWidth();
+    } else if (type->isFloatTy()) {
+        kind = KIND_FLOAT;
+    } else if (type->isDoubleTy()) {
+        kind = KIND_DOUBLE;
+    } else if (type->isPointerTy()) {
+        kind = KIND_POINTER;
+        bits = (uint8_t)dl.getPointerSizeInBits();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Slot value of a constant operand
+static bool constantValue(ModuleLoad& load, const Constant* C, uint64_t& out) {
+    const DataLayout& dl = *load.dl;
+
+    if (auto* ci = dyn_cast<ConstantInt>(C)) {
+        if (ci->getBitWidth() > 64) return false;
+        out = (uint64_t)ci->getSExtValue();
+        return true;
+    }
+    if (auto* cf = dyn_cast<ConstantFP>(C)) {
+        if (cf->getType()->isFloatTy()) {
+            out = fromF32(cf->getValueAPF().convertToFloat());
+        } else if (cf->getType()->isDoubleTy()) {
+            out = fromF64(cf->getValueAPF().convertToDouble());
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (isa<ConstantPointerNull>(C) || isa<UndefValue>(C)) {
+        out = 0;
+        return true;
+    }
+    if (auto* alias = dyn_cast<GlobalAlias>(C)) {
+        return constantValue(load, alias->getAliasee(), out);
+    }
+    if (auto* gv = dyn_cast<GlobalValue>(C)) {
+        auto it = load.globals.find(gv);
+        if (it != load.globals.end()) {
+            out = (uint64_t)(uintptr_t)it->second;
+            return true;
+        }
+        // Interpreted functions have no native address to take
+        if (auto* F = dyn_cast<Function>(gv)) {
+            if (!F->isDeclaration() || load.in->function_index.count(F->getName().str())) {
+                return false;
+            }
+        }
+        void* addr = resolveSymbol(load.in, gv->getName().str());
+        out = (uint64_t)(uintptr_t)addr;
+        return addr != nullptr;
+    }
+    if (auto* ce = dyn_cast<ConstantExpr>(C)) {
+        uint64_t base;
+        switch (ce->getOpcode()) {
+            case Instruction::GetElementPtr: {
+                auto* gep = cast<GEPOperator>(ce);
+                APInt offset(dl.getIndexSizeInBits(gep->getPointerAddressSpace()), 0);
+                if (!gep->accumulateConstantOffset(dl, offset)) return false;
+                if (!constantValue(load, cast<Constant>(gep->getPointerOperand()), base)) return false;
+                out = base + (uint64_t)offset.getSExtValue();
+                return true;
+            }
+            case Instruction::BitCast:
+            case Instruction::AddrSpaceCast:
+            case Instruction::IntToPtr:
+                return constantValue(load, ce->getOperand(0), out);
+            case Instruction::PtrToInt:
+                if (!constantValue(load, ce->getOperand(0), base)) return false;
+                out = sx(base, std::min(64u, ce->getType()->getIntegerBitWidth()));
+                return true;
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+// Write a global's initializer into its storage
+static bool writeConstant(ModuleLoad& load, uint8_t* dst, const Constant* C) {
+    const DataLayout& dl = *load.dl;
+    Type* type = C->getType();
+
+    if (isa<ConstantAggregateZero>(C) || isa<UndefValue>(C) || isa<ConstantPointerNull>(C)) {
+        memset(dst, 0, dl.getTypeStoreSize(type));
+        return true;
+    }
+    if (auto* data = dyn_cast<ConstantDataSequential>(C)) {
+        StringRef raw = data->getRawDataValues();
+        memcpy(dst, raw.data(), raw.size());
+        return true;
+    }
+    if (auto* array = dyn_cast<ConstantArray>(C)) {
+        uint64_t stride = dl.getTypeAllocSize(array->getType()->getElementType());
+        for (unsigned i = 0; i < array->getNumOperands(); i++) {
+            if (!writeConstant(load, dst + i * stride, array->getOperand(i))) return false;
+        }
+        return true;
+    }
+    if (auto* record = dyn_cast<ConstantStruct>(C)) {
+        const StructLayout* layout = dl.getStructLayout(record->getType());
+        for (unsigned i = 0; i < record->getNumOperands(); i++) {
+            if (!writeConstant(load, dst + layout->getElementOffset(i), record->getOperand(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t value;
+    if (!constantValue(load, C, value)) return false;
+    if (type->isIntegerTy(1)) value &= 1;
+    uint64_t size = dl.getTypeStoreSize(type);
+    if (size > sizeof(value)) return false;
+    memcpy(dst, &value, size);      // Little-endian host
+    return true;
+}
+
+// Storage for the module's global variables: definitions are allocated
+// (and published by name unless local), declarations resolved
+static bool allocateGlobals(ModuleLoad& load) {
+    IRInterpreter* in = load.in;
+    const DataLayout& dl = *load.dl;
+
+    for (GlobalVariable& gv : load.module->globals()) {
+        if (gv.isDeclaration()) {
+            void* addr = resolveSymbol(in, gv.getName().str());
+            if (addr) load.globals[&gv] = static_cast<uint8_t*>(addr);
+            continue;
+        }
+
+        uint64_t size = std::max<uint64_t>(dl.getTypeAllocSize(gv.getValueType()), 1);
+        uint64_t align = std::max<uint64_t>(gv.getAlign().valueOrOne().value(),
+                                            dl.getPreferredAlign(&gv).value());
+        std::unique_ptr<uint8_t[]> storage(new uint8_t[size + align]());
+        uint8_t* addr = reinterpret_cast<uint8_t*>(
+            ((uintptr_t)storage.get() + align - 1) & ~(uintptr_t)(align - 1));
+        in->global_storage.push_back(std::move(storage));
+
+        load.globals[&gv] = addr;
+        if (!gv.hasLocalLinkage()) {
+            in->symbols[gv.getName().str()] = addr;
+        }
+    }
+
+    for (GlobalVariable& gv : load.module->globals()) {
+        if (gv.isDeclaration() || !gv.hasInitializer()) continue;
+        if (!writeConstant(load, load.globals[&gv], gv.getInitializer())) {
+            in->last_error = "unsupported initializer for global " + gv.getName().str();
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Translation
+// ============================================================================
+
+static const uint32_t kConstantSlot = 0x80000000u;  // Operand refers to the constant pool
+
+struct BranchFixup {
+    size_t insn;
+    bool in_c;              // Target field: 'c' (else 'imm')
+    BasicBlock* from;
+    BasicBlock* to;
+    bool direct;            // Phi moves already emitted, jump to the block itself
+};
+
+class Translator {
+public:
+    Translator(ModuleLoad& load, Function& F, InterpFunction& out)
+        : load(load), dl(*load.dl), F(F), out(out) {}
+
+    bool run();
+
+private:
+    ModuleLoad& load;
+    const DataLayout& dl;
+    Function& F;
+    InterpFunction& out;
+
+    std::unordered_map<const Value*, uint32_t> slots;
+    std::map<uint64_t, uint32_t> constant_slots;
+    std::unordered_map<const BasicBlock*, size_t> block_start;
+    std::vector<BranchFixup> fixups;
+    uint32_t num_slots = 0;
+    uint32_t locals_bytes = 0;
+    uint32_t call_site = 0;
+    uint32_t branch_site = 0;
+
+    bool fail(const std::string& why) {
+        out.error = why;
+        return false;
+    }
+
+    Insn& emit(Opcode op, uint32_t dst = 0, uint32_t a = 0, uint32_t b = 0, int64_t imm = 0) {
+        Insn insn = {};
+        insn.op = op;
+        insn.dst = dst;
+        insn.a = a;
+        insn.b = b;
+        insn.imm = imm;
+        out.code.push_back(insn);
+        return out.code.back();
+    }
+
+    uint32_t temp() { return num_slots++; }
+
+    bool operand(Value* V, uint32_t& slot);
+    uint64_t* branchCounters();
+    void target(size_t insn, bool in_c, BasicBlock* from, BasicBlock* to, bool direct);
+    void emitPhiMoves(BasicBlock* from, BasicBlock* to);
+
+    bool translateInstruction(Instruction& I);
+    bool translateBinary(BinaryOperator& I);
+    bool translateCast(CastInst& I);
+    bool translateGEP(GetElementPtrInst& I);
+    bool translateCall(CallInst& I);
+    bool translateIntrinsic(IntrinsicInst& I);
+    bool translateTerminator(Instruction& I);
+};
+
+bool Translator::operand(Value* V, uint32_t& slot) {
+    auto it = slots.find(V);
+    if (it != slots.end()) {
+        slot = it->second;
+        return true;
+    }
+
+    auto* C = dyn_cast<Constant>(V);
+    uint64_t value;
+    if (!C || !constantValue(load, C, value)) {
+        std::string text;
+        raw_string_ostream os(text);
+        V->printAsOperand(os, false);
+        return fail("unsupported operand " + os.str());
+    }
+
+    auto found = constant_slots.find(value);
+    if (found == constant_slots.end()) {
+        found = constant_slots.emplace(value, kConstantSlot | (uint32_t)out.constants.size()).first;
+        out.constants.push_back(value);
+    }
+    slot = found->second;
+    return true;
+}
+
+uint64_t* Translator::branchCounters() {
+    uint64_t* counters = nullptr;
+    if (load.in->profiler && out.profile_id >= 0) {
+        counters = function_profiler_branch_counters(load.in->profiler, out.profile_id, branch_site);
+    }
+    branch_site++;
+    return counters ? counters : load.in->scratch_counts;
+}
+
+void Translator::target(size_t insn, bool in_c, BasicBlock* from, BasicBlock* to, bool direct) {
+    fixups.push_back({insn, in_c, from, to, direct});
+}
+
+// Parallel copy of 'to's phis for the edge from 'from'. Goes through
+// temporaries when one phi reads another, which a plain sequence would
+// clobber (swap loops).
+void Translator::emitPhiMoves(BasicBlock* from, BasicBlock* to) {
+    std::vector<std::pair<uint32_t, uint32_t>> moves;
+    for (PHINode& phi : to->phis()) {
+        uint32_t src;
+        if (!operand(phi.getIncomingValueForBlock(from), src)) return;
+        uint32_t dst = slots[&phi];
+        if (dst != src) moves.push_back({dst, src});
+    }
+
+    bool overlap = false;
+    for (auto& move : moves) {
+        for (auto& other : moves) {
+            if (other.second == move.first) overlap = true;
+        }
+    }
+
+    if (!overlap) {
+        for (auto& move : moves) emit(OP_MOV, move.first, move.second);
+        return;
+    }
+
+    std::vector<uint32_t> temps;
+    for (auto& move : moves) {
+        temps.push_back(temp());
+        emit(OP_MOV, temps.back(), move.second);
+    }
+    for (size_t i = 0; i < moves.size(); i++) {
+        emit(OP_MOV, moves[i].first, temps[i]);
+    }
+}
+
+bool Translator::translateBinary(BinaryOperator& I) {
+    uint32_t a, b;
+    if (!operand(I.getOperand(0), a) || !operand(I.getOperand(1), b)) return false;
+    uint32_t dst = slots[&I];
+    Type* type = I.getType();
+
+    if (type->isFloatTy() || type->isDoubleTy()) {
+        bool wide = type->isDoubleTy();
+        Opcode op;
+        switch (I.getOpcode()) {
+            case Instruction::FAdd: op = wide ? OP_FADD64 : OP_FADD32; break;
+            case Instruction::FSub: op = wide ? OP_FSUB64 : OP_FSUB32; break;
+            case Instruction::FMul: op = wide ? OP_FMUL64 : OP_FMUL32; break;
+            case Instruction::FDiv: op = wide ? OP_FDIV64 : OP_FDIV32; break;
+            default: return fail(std::string("unsupported float op ") + I.getOpcodeName());
+        }
+        emit(op, dst, a, b);
+        return true;
+    }
+    if (!type->isIntegerTy() || type->getIntegerBitWidth() > 64) {
+        return fail(std::string("unsupported operand type for ") + I.getOpcodeName());
+    }
+
+    unsigned bits = type->getIntegerBitWidth();
+    Opcode op;
+    switch (I.getOpcode()) {
+        case Instruction::Add:  op = OP_ADD; break;
+        case Instruction::Sub:  op = OP_SUB; break;
+        case Instruction::Mul:  op = OP_MUL; break;
+        case Instruction::SDiv: op = OP_SDIV; break;
+        case Instruction::UDiv: op = OP_UDIV; break;
+        case Instruction::SRem: op = OP_SREM; break;
+        case Instruction::URem: op = OP_UREM; break;
+        case Instruction::And:  op = OP_AND; break;
+        case Instruction::Or:   op = OP_OR; break;
+        case Instruction::Xor:  op = OP_XOR; break;
+        case Instruction::Shl:  op = OP_SHL; break;
+        case Instruction::LShr: op = OP_LSHR; break;
+        case Instruction::AShr: op = OP_ASHR; break;
+        default: return fail(std::string("unsupported op ") + I.getOpcodeName());
+    }
+    emit(op, dst, a, b, (int64_t)widthMask(bits)).bits = (uint8_t)bits;
+    return true;
+}
+
+bool Translator::translateCast(CastInst& I) {
+    uint32_t a;
+    if (!operand(I.getOperand(0), a)) return false;
+    uint32_t dst = slots[&I];
+    Type* from = I.getSrcTy();
+    Type* to = I.getDestTy();
+    if (from->isVectorTy() || to->isVectorTy()) return fail("vector cast");
+
+    unsigned from_bits = from->isPointerTy() ? dl.getPointerSizeInBits()
+                       : from->isIntegerTy() ? from->getIntegerBitWidth() : 0;
+    unsigned to_bits = to->isPointerTy() ? dl.getPointerSizeInBits()
+                     : to->isIntegerTy() ? to->getIntegerBitWidth() : 0;
+    if (from_bits > 64 || to_bits > 64) return fail("integer wider than 64 bits");
+
+    switch (I.getOpcode()) {
+        case Instruction::Trunc:
+            emit(OP_TRUNC, dst, a).bits = (uint8_t)to_bits;
+            return true;
+        case Instruction::ZExt:
+            emit(OP_ZEXT, dst, a, 0, (int64_t)widthMask(from_bits));
+            return true;
+        case Instruction::SExt:
+        case Instruction::AddrSpaceCast:
+            emit(OP_MOV, dst, a);
+            return true;
+        case Instruction::PtrToInt:
+        case Instruction::IntToPtr:
+            if (to_bits < from_bits) {
+                emit(OP_TRUNC, dst, a).bits = (uint8_t)to_bits;
+            } else if (to_bits > from_bits) {
+                emit(OP_ZEXT, dst, a, 0, (int64_t)widthMask(from_bits));
+            } else {
+                emit(OP_MOV, dst, a);
+            }
+            return true;
+        case Instruction::BitCast:
+            // Float -> i32 must come out sign-extended like any i32
+            if (to->isIntegerTy(32)) {
+                emit(OP_TRUNC, dst, a).bits = 32;
+            } else {
+                emit(OP_MOV, dst, a);
+            }
+            return true;
+        case Instruction::SIToFP:
+            if (!to->isFloatTy() && !to->isDoubleTy()) break;
+            emit(to->isDoubleTy() ? OP_SITOFP64 : OP_SITOFP32, dst, a);
+            return true;
+        case Instruction::UIToFP:
+            if (!to->isFloatTy() && !to->isDoubleTy()) break;
+            emit(to->isDoubleTy() ? OP_UITOFP64 : OP_UITOFP32, dst, a, 0, (int64_t)widthMask(from_bits));
+            return true;
+        case Instruction::FPToSI:
+            if (!from->isFloatTy() && !from->isDoubleTy()) break;
+            emit(from->isDoubleTy() ? OP_FPTOSI64 : OP_FPTOSI32, dst, a).bits = (uint8_t)to_bits;
+            return true;
+        case Instruction::FPToUI:
+            if (!from->isFloatTy() && !from->isDoubleTy()) break;
+            emit(from->isDoubleTy() ? OP_FPTOUI64 : OP_FPTOUI32, dst, a).bits = (uint8_t)to_bits;
+            return true;
+        case Instruction::FPTrunc:
+            if (!from->isDoubleTy() || !to->isFloatTy()) break;
+            emit(OP_FPTRUNC, dst, a);
+            return true;
+        case Instruction::FPExt:
+            if (!from->isFloatTy() || !to->isDoubleTy()) break;
+            emit(OP_FPEXT, dst, a);
+            return true;
+        default:
+            break;
+    }
+    return fail(std::string("unsupported cast ") + I.getOpcodeName());
+}
+
+// Constant indices fold into one offset; each variable index adds a
+// scaled term
+bool Translator::translateGEP(GetElementPtrInst& I) {
+    if (I.getType()->isVectorTy()) return fail("vector getelementptr");
+
+    uint32_t acc;
+    if (!operand(I.getPointerOperand(), acc)) return false;
+    int64_t offset = 0;
+
+    for (auto it = gep_type_begin(I), end = gep_type_end(I); it != end; ++it) {
+        Value* index = it.getOperand();
+        if (StructType* record = it.getStructTypeOrNull()) {
+            unsigned field = (unsigned)cast<ConstantInt>(index)->getZExtValue();
+            offset += (int64_t)dl.getStructLayout(record)->getElementOffset(field);
+            continue;
+        }
+
+        int64_t size = (int64_t)dl.getTypeAllocSize(it.getIndexedType());
+        if (auto* ci = dyn_cast<ConstantInt>(index)) {
+            offset += ci->getSExtValue() * size;
+            continue;
+        }
+
+        uint32_t index_slot;
+        if (!operand(index, index_slot)) return false;
+        uint32_t sum = temp();
+        emit(OP_SCALE_ADD, sum, acc, index_slot, size);
+        acc = sum;
+    }
+
+    emit(OP_ADDI, slots[&I], acc, 0, offset);
+    return true;
+}
+
+bool Translator::translateIntrinsic(IntrinsicInst& I) {
+    uint32_t dst = slots.count(&I) ? slots[&I] : 0;
+
+    switch (I.getIntrinsicID()) {
+        case Intrinsic::dbg_declare:
+        case Intrinsic::dbg_value:
+        case Intrinsic::dbg_label:
+        case Intrinsic::lifetime_start:
+        case Intrinsic::lifetime_end:
+        case Intrinsic::assume:
+        case Intrinsic::experimental_noalias_scope_decl:
+            return true;
+
+        case Intrinsic::memcpy:
+        case Intrinsic::memmove:
+        case Intrinsic::memset: {
+            void* native = I.getIntrinsicID() == Intrinsic::memcpy ? (void*)&memcpy
+                         : I.getIntrinsicID() == Intrinsic::memmove ? (void*)&memmove
+                         : (void*)&memset;
+            uint32_t base = (uint32_t)out.call_args.size();
+            for (unsigned k = 0; k < 3; k++) {
+                uint32_t slot;
+                if (!operand(I.getArgOperand(k), slot)) return false;
+                out.call_args.push_back(slot);
+            }
+            Insn& insn = emit(OP_NATIVE, temp(), base);
+            insn.argc = 3;
+            insn.bits = 64;
+            insn.aux = native;
+            return true;
+        }
+
+        case Intrinsic::fmuladd: {
+            Type* type = I.getType();
+            if (!type->isFloatTy() && !type->isDoubleTy()) break;
+            uint32_t a, b, c;
+            if (!operand(I.getArgOperand(0), a) || !operand(I.getArgOperand(1), b) ||
+                !operand(I.getArgOperand(2), c)) {
+                return false;
+            }
+            uint32_t product = temp();
+            emit(type->isDoubleTy() ? OP_FMUL64 : OP_FMUL32, product, a, b);
+            emit(type->isDoubleTy() ? OP_FADD64 : OP_FADD32, dst, product, c);
+            return true;
+        }
+
+        case Intrinsic::smax:
+        case Intrinsic::smin:
+        case Intrinsic::umax:
+        case Intrinsic::umin: {
+            if (!I.getType()->isIntegerTy() || I.getType()->getIntegerBitWidth() > 64) break;
+            uint32_t a, b;
+            if (!operand(I.getArgOperand(0), a) || !operand(I.getArgOperand(1), b)) return false;
+            Intrinsic::ID id = I.getIntrinsicID();
+            Opcode op = id == Intrinsic::smax ? OP_SGT : id == Intrinsic::smin ? OP_SLT
+                      : id == Intrinsic::umax ? OP_UGT : OP_ULT;
+            uint32_t pick = temp();
+            emit(op, pick, a, b, (int64_t)widthMask(I.getType()->getIntegerBitWidth()));
+            emit(OP_SELECT, dst, pick, a).c = b;
+            return true;
+        }
+
+        case Intrinsic::abs: {
+            if (!I.getType()->isIntegerTy() || I.getType()->getIntegerBitWidth() > 64) break;
+            uint32_t a, zero;
+            if (!operand(I.getArgOperand(0), a) ||
+                !operand(ConstantInt::get(I.getType(), 0), zero)) {
+                return false;
+            }
+            uint32_t negative = temp(), negated = temp();
+            emit(OP_SLT, negative, a, zero);
+            emit(OP_SUB, negated, zero, a).bits = (uint8_t)I.getType()->getIntegerBitWidth();
+            emit(OP_SELECT, dst, negative, negated).c = a;
+            return true;
+        }
+
+        default:
+            break;
+    }
+    return fail("unsupported intrinsic " + I.getCalledFunction()->getName().str());
+}
+
+bool Translator::translateCall(CallInst& I) {
+    if (auto* intrinsic = dyn_cast<IntrinsicInst>(&I)) return translateIntrinsic(*intrinsic);
+
+    Function* callee = I.getCalledFunction();
+    if (!callee || I.isInlineAsm()) return fail("indirect call or inline asm");
+    uint32_t site = call_site++;
+
+    for (unsigned k = 0; k < I.arg_size(); k++) {
+        if (I.paramHasAttr(k, Attribute::ByVal) || I.paramHasAttr(k, Attribute::InAlloca) ||
+            I.paramHasAttr(k, Attribute::Preallocated)) {
+            return fail("by-value aggregate argument in call to " + callee->getName().str());
+        }
+    }
+
+    uint32_t dst = slots.count(&I) ? slots[&I] : temp();
+    uint32_t base = (uint32_t)out.call_args.size();
+
+    // Interpreted callee: this module's own, or a public one loaded earlier
+    InterpFunction* target = nullptr;
+    auto local = load.functions.find(callee);
+    if (local != load.functions.end()) {
+        target = local->second;
+    } else if (callee->isDeclaration()) {
+        auto found = load.in->function_index.find(callee->getName().str());
+        if (found != load.in->function_index.end()) {
+            target = &load.in->functions[found->second];
+        }
+    }
+
+    if (target) {
+        if (callee->isVarArg()) return fail("call to variadic " + callee->getName().str());
+        for (unsigned k = 0; k < I.arg_size(); k++) {
+            uint32_t slot;
+            if (!operand(I.getArgOperand(k), slot)) return false;
+            out.call_args.push_back(slot);
+        }
+
+        uint64_t* counter = nullptr;
+        function_profiler_t* profiler = load.in->profiler;
+        if (profiler && out.profile_id >= 0 && target->profile_id >= 0) {
+            counter = function_profiler_edge_counter(profiler, out.profile_id, target->profile_id, site);
+        }
+
+        Insn& insn = emit(OP_CALL, dst, base);
+        insn.argc = (uint8_t)I.arg_size();
+        insn.aux = target;
+        insn.count = counter ? counter : load.in->scratch_counts;
+        return true;
+    }
+
+    // Native callee: integer/pointer arguments and result, no wider than a
+    // pointer, passed as uintptr_t
+    unsigned pointer_bits = dl.getPointerSizeInBits();
+    if (I.arg_size() > IR_INTERP_MAX_NATIVE_ARGS) {
+        return fail("too many arguments for native " + callee->getName().str());
+    }
+    for (unsigned k = 0; k < I.arg_size(); k++) {
+        Type* type = I.getArgOperand(k)->getType();
+        if (!type->isPointerTy() && !(type->isIntegerTy() && type->getIntegerBitWidth() <= pointer_bits)) {
+            return fail("unsupported argument type for native " + callee->getName().str());
+        }
+    }
+    Type* ret = I.getType();
+    if (!ret->isVoidTy() && !ret->isPointerTy() &&
+        !(ret->isIntegerTy() && ret->getIntegerBitWidth() <= pointer_bits)) {
+        return fail("unsupported return type for native " + callee->getName().str());
+    }
+
+    void* native = resolveSymbol(load.in, callee->getName().str());
+    if (!native) return fail("unresolved symbol " + callee->getName().str());
+
+    for (unsigned k = 0; k < I.arg_size(); k++) {
+        uint32_t slot;
+        if (!operand(I.getArgOperand(k), slot)) return false;
+
+        // The native ABI wants i1 and zeroext parameters zero-extended
+        Type* type = I.getArgOperand(k)->getType();
+        if (type->isIntegerTy(1) || I.paramHasAttr(k, Attribute::ZExt)) {
+            uint32_t extended = temp();
+            emit(OP_ZEXT, extended, slot, 0, (int64_t)widthMask(type->getIntegerBitWidth()));
+            slot = extended;
+        }
+        out.call_args.push_back(slot);
+    }
+
+    Insn& insn = emit(OP_NATIVE, dst, base);
+    insn.argc = (uint8_t)I.arg_size();
+    insn.bits = (uint8_t)(ret->isIntegerTy() ? ret->getIntegerBitWidth() : 64);
+    insn.aux = native;
+    return true;
+}
+
+bool Translator::translateTerminator(Instruction& I) {
+    BasicBlock* from = I.getParent();
+
+    if (auto* br = dyn_cast<BranchInst>(&I)) {
+        if (br->isUnconditional()) {
+            emitPhiMoves(from, br->getSuccessor(0));
+            target(out.code.size(), false, from, br->getSuccessor(0), true);
+            emit(OP_BR);
+            return out.error.empty();
+        }
+
+        uint32_t cond;
+        if (!operand(br->getCondition(), cond)) return false;
+        Insn& insn = emit(OP_CONDBR, 0, cond);
+        insn.count = branchCounters();
+        size_t index = out.code.size() - 1;
+        target(index, false, from, br->getSuccessor(0), false);
+        target(index, true, from, br->getSuccessor(1), false);
+        return true;
+    }
+
+    if (auto* sw = dyn_cast<SwitchInst>(&I)) {
+        uint32_t cond;
+        if (!operand(sw->getCondition(), cond)) return false;
+        if (sw->getCondition()->getType()->getIntegerBitWidth() > 64) return fail("switch wider than 64 bits");
+
+        for (auto& c : sw->cases()) {
+            Insn& insn = emit(OP_CASE, 0, cond, 0, c.getCaseValue()->getSExtValue());
+            insn.count = branchCounters();
+            target(out.code.size() - 1, true, from, c.getCaseSuccessor(), false);
+        }
+        emitPhiMoves(from, sw->getDefaultDest());
+        target(out.code.size(), false, from, sw->getDefaultDest(), true);
+        emit(OP_BR);
+        return out.error.empty();
+    }
+
+    if (auto* ret = dyn_cast<ReturnInst>(&I)) {
+        if (!ret->getReturnValue()) {
+            emit(OP_RET_VOID);
+            return true;
+        }
+        uint32_t value;
+        if (!operand(ret->getReturnValue(), value)) return false;
+        emit(OP_RET, 0, value);
+        return true;
+    }
+
+    if (isa<UnreachableInst>(&I)) {
+        emit(OP_TRAP);
+        return true;
+    }
+
+    return fail(std::string("unsupported terminator ") + I.getOpcodeName());
+}
+
+bool Translator::translateInstruction(Instruction& I) {
+    if (I.isTerminator()) return translateTerminator(I);
+    if (isa<PHINode>(&I)) return true;      // Moves are on the incoming edges
+
+    Type* type = I.getType();
+    if (type->isVectorTy() || type->isStructTy() || type->isArrayTy() ||
+        (type->isIntegerTy() && type->getIntegerBitWidth() > 64)) {
+        return fail(std::string("unsupported value type in ") + I.getOpcodeName());
+    }
+
+    if (auto* binary = dyn_cast<BinaryOperator>(&I)) return translateBinary(*binary);
+    if (auto* cast_inst = dyn_cast<CastInst>(&I)) return translateCast(*cast_inst);
+    if (auto* gep = dyn_cast<GetElementPtrInst>(&I)) return translateGEP(*gep);
+    if (auto* call = dyn_cast<CallInst>(&I)) return translateCall(*call);
+
+    if (auto* neg = dyn_cast<UnaryOperator>(&I)) {
+        uint32_t a;
+        if (neg->getOpcode() != Instruction::FNeg) return fail("unsupported unary op");
+        if (!operand(neg->getOperand(0), a)) return false;
+        if (!neg->getType()->isFloatTy() && !neg->getType()->isDoubleTy()) return fail("unsupported fneg type");
+        emit(neg->getType()->isDoubleTy() ? OP_FNEG64 : OP_FNEG32, slots[&I], a);
+        return true;
+    }
+
+    if (auto* cmp = dyn_cast<ICmpInst>(&I)) {
+        uint32_t a, b;
+        if (!operand(cmp->getOperand(0), a) || !operand(cmp->getOperand(1), b)) return false;
+        Type* type = cmp->getOperand(0)->getType();
+        unsigned bits = type->isPointerTy() ? dl.getPointerSizeInBits() : type->getIntegerBitWidth();
+        if (bits > 64) return fail("integer wider than 64 bits");
+
+        Opcode op;
+        switch (cmp->getPredicate()) {
+            case ICmpInst::ICMP_EQ:  op = OP_EQ; break;
+            case ICmpInst::ICMP_NE:  op = OP_NE; break;
+            case ICmpInst::ICMP_SLT: op = OP_SLT; break;
+            case ICmpInst::ICMP_SLE: op = OP_SLE; break;
+            case ICmpInst::ICMP_SGT: op = OP_SGT; break;
+            case ICmpInst::ICMP_SGE: op = OP_SGE; break;
+            case ICmpInst::ICMP_ULT: op = OP_ULT; break;
+            case ICmpInst::ICMP_ULE: op = OP_ULE; break;
+            case ICmpInst::ICMP_UGT: op = OP_UGT; break;
+            default:                 op = OP_UGE; break;
+        }
+        emit(op, slots[&I], a, b, (int64_t)widthMask(bits));
+        return true;
+    }
+
+    if (auto* cmp = dyn_cast<FCmpInst>(&I)) {
+        uint32_t a, b;
+        if (!operand(cmp->getOperand(0), a) || !operand(cmp->getOperand(1), b)) return false;
+        Type* type = cmp->getOperand(0)->getType();
+        if (!type->isFloatTy() && !type->isDoubleTy()) return fail("unsupported fcmp type");
+        emit(type->isDoubleTy() ? OP_FCMP64 : OP_FCMP32, slots[&I], a, b, (int64_t)cmp->getPredicate());
+        return true;
+    }
+
+    if (auto* select = dyn_cast<SelectInst>(&I)) {
+        uint32_t cond, yes, no;
+        if (!operand(select->getCondition(), cond) || !operand(select->getTrueValue(), yes) ||
+            !operand(select->getFalseValue(), no)) {
+            return false;
+        }
+        emit(OP_SELECT, slots[&I], cond, yes).c = no;
+        return true;
+    }
+
+    if (auto* freeze = dyn_cast<FreezeInst>(&I)) {
+        uint32_t a;
+        if (!operand(freeze->getOperand(0), a)) return false;
+        emit(OP_MOV, slots[&I], a);
+        return true;
+    }
+
+    if (isa<LoadInst>(&I) || isa<StoreInst>(&I)) {
+        bool is_load = isa<LoadInst>(&I);
+        Value* pointer = is_load ? cast<LoadInst>(&I)->getPointerOperand()
+                                 : cast<StoreInst>(&I)->getPointerOperand();
+        Type* type = is_load ? I.getType() : cast<StoreInst>(&I)->getValueOperand()->getType();
+
+        // Widths that aren't a whole power-of-two byte count (i24, ...) are
+        // unsupported; i1 is a byte holding 0 or 1
+        bool scalar = type->isIntegerTy() || type->isFloatTy() || type->isDoubleTy() || type->isPointerTy();
+        unsigned bits = scalar ? (unsigned)dl.getTypeSizeInBits(type) : 0;
+        Opcode op;
+        switch (bits) {
+            case 1:  op = is_load ? OP_LOAD1 : OP_STORE1; break;
+            case 8:  op = is_load ? OP_LOAD8 : OP_STORE8; break;
+            case 16: op = is_load ? OP_LOAD16 : OP_STORE16; break;
+            case 32: op = is_load ? OP_LOAD32 : OP_STORE32; break;
+            case 64: op = is_load ? OP_LOAD64 : OP_STORE64; break;
+            default: return fail(std::string("unsupported memory type in ") + I.getOpcodeName());
+        }
+
+        uint32_t address;
+        if (!operand(pointer, address)) return false;
+        if (is_load) {
+            emit(op, slots[&I], address);
+        } else {
+            uint32_t value;
+            if (!operand(cast<StoreInst>(&I)->getValueOperand(), value)) return false;
+            emit(op, 0, address, value);
+        }
+        return true;
+    }
+
+    if (isa<FenceInst>(&I)) return true;    // Single-threaded interpreter
+
+    return fail(std::string("unsupported instruction ") + I.getOpcodeName());
+}
+
+bool Translator::run() {
+    if (F.isVarArg()) return fail("variadic function");
+
+    uint8_t bits;
+    if (!valueKind(dl, F.getReturnType(), out.ret_kind, out.ret_bits)) return fail("unsupported return type");
+    for (Argument& arg : F.args()) {
+        ValueKind kind;
+        if (!valueKind(dl, arg.getType(), kind, bits) || kind == KIND_VOID) {
+            return fail("unsupported parameter type");
+        }
+        if (arg.hasByValAttr() || arg.hasInAllocaAttr() || arg.hasPreallocatedAttr()) {
+            return fail("by-value aggregate parameter");
+        }
+        slots[&arg] = num_slots++;
+        out.arg_kinds.push_back(kind);
+        out.arg_bits.push_back(bits);
+    }
+
+    // Slots for every value, so phis can be written before their block is
+    // reached. Static allocas get their frame offset now.
+    std::vector<std::pair<const AllocaInst*, uint32_t>> allocas;
+    for (BasicBlock& BB : F) {
+        for (Instruction& I : BB) {
+            if (!I.getType()->isVoidTy()) slots[&I] = num_slots++;
+
+            auto* alloca = dyn_cast<AllocaInst>(&I);
+            if (!alloca) continue;
+            auto* count = dyn_cast<ConstantInt>(alloca->getArraySize());
+            if (!alloca->isStaticAlloca() || !count) return fail("dynamic alloca");
+            uint64_t align = alloca->getAlign().value();
+            if (align > 16) return fail("alloca aligned beyond 16 bytes");
+
+            locals_bytes = (uint32_t)((locals_bytes + align - 1) & ~(align - 1));
+            allocas.push_back({alloca, locals_bytes});
+            locals_bytes += (uint32_t)(dl.getTypeAllocSize(alloca->getAllocatedType()) * count->getZExtValue());
+        }
+    }
+
+    for (BasicBlock& BB : F) {
+        block_start[&BB] = out.code.size();
+        for (Instruction& I : BB) {
+            if (auto* alloca = dyn_cast<AllocaInst>(&I)) {
+                for (auto& placed : allocas) {
+                    if (placed.first == alloca) emit(OP_LOCAL, slots[&I], 0, 0, placed.second);
+                }
+                continue;
+            }
+            if (!translateInstruction(I)) return false;
+        }
+    }
+
+    // Edges into phi blocks from conditional branches and switch cases get
+    // a stub with the moves
+    std::map<std::pair<BasicBlock*, BasicBlock*>, size_t> stubs;
+    for (size_t i = 0; i < fixups.size(); i++) {
+        BranchFixup fixup = fixups[i];
+        size_t dest;
+        if (fixup.direct || fixup.to->phis().empty()) {
+            dest = block_start[fixup.to];
+        } else {
+            auto key = std::make_pair(fixup.from, fixup.to);
+            auto stub = stubs.find(key);
+            if (stub == stubs.end()) {
+                size_t start = out.code.size();
+                emitPhiMoves(fixup.from, fixup.to);
+                if (!out.error.empty()) return false;
+                fixups.push_back({out.code.size(), false, fixup.from, fixup.to, true});
+                emit(OP_BR);
+                stub = stubs.emplace(key, start).first;
+            }
+            dest = stub->second;
+        }
+
+        if (fixup.in_c) {
+            out.code[fixup.insn].c = (uint32_t)dest;
+        } else {
+            out.code[fixup.insn].imm = (int64_t)dest;
+        }
+    }
+
+    // Constants go after every value and temporary
+    out.const_base = num_slots;
+    auto patch = [&](uint32_t& slot) {
+        if (slot & kConstantSlot) slot = out.const_base + (slot & ~kConstantSlot);
+    };
+    for (Insn& insn : out.code) {
+        if (insn.op == OP_CALL || insn.op == OP_NATIVE) continue;     // 'a' indexes call_args
+        if (insn.op == OP_CONDBR || insn.op == OP_CASE) {
+            patch(insn.a);      // 'c' is a branch target
+            continue;
+        }
+        patch(insn.a);
+        patch(insn.b);
+        if (insn.op == OP_SELECT) patch(insn.c);
+    }
+    for (uint32_t& slot : out.call_args) {
+        patch(slot);
+    }
+
+    out.locals_slot = out.const_base + (uint32_t)out.constants.size();
+    out.locals_slot = (out.locals_slot + 1) & ~1u;      // 16-byte aligned allocas
+    out.frame_slots = out.locals_slot + (locals_bytes + 7) / 8;
+    out.frame_slots = (out.frame_slots + 1) & ~1u;
+    return true;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+extern "C" {
+
+IRInterpreter* ir_interp_create(function_profiler_t* profiler) {
+    IRInterpreter* in = new IRInterpreter();
+    in->profiler = profiler;
+    in->llvm_ctx = std::make_unique<LLVMContext>();
+    in->stack.reset(new uint64_t[IR_INTERP_STACK_SLOTS]);
+    sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+    execute(in, nullptr, nullptr);
+    return in;
+}
+
+void ir_interp_destroy(IRInterpreter* interp) {
+    delete interp;
+}
+
+int ir_interp_add_symbol(IRInterpreter* interp, const char* name, void* address) {
+    if (!interp || !name) return -1;
+    interp->symbols[name] = address;
+    return 0;
+}
+
+int ir_interp_load_bitcode(IRInterpreter* interp, const char* module_name,
+                           const uint8_t* data, size_t size) {
+    if (!interp || !data || size == 0) return -1;
+
+    auto buffer = MemoryBuffer::getMemBuffer(
+        StringRef(reinterpret_cast<const char*>(data), size), module_name ? module_name : "", false);
+    auto parsed = parseBitcodeFile(buffer->getMemBufferRef(), *interp->llvm_ctx);
+    if (!parsed) {
+        interp->last_error = "failed to parse bitcode: " + toString(parsed.takeError());
+        return -1;
+    }
+    std::unique_ptr<Module> module = std::move(*parsed);
+    if (module->getDataLayout().getPointerSizeInBits() != sizeof(void*) * 8) {
+        interp->last_error = "bitcode pointer width differs from the host's";
+        return -1;
+    }
+
+    interp->module_names.push_back(module_name ? module_name : module->getModuleIdentifier());
+    const char* profile_module = interp->module_names.back().c_str();
+
+    ModuleLoad load = {interp, module.get(), &module->getDataLayout(), {}, {}};
+    if (!allocateGlobals(load)) return -1;
+
+    // Register every definition first: calls between them (in any order,
+    // recursion included) bind directly to the InterpFunction
+    std::vector<std::pair<Function*, InterpFunction*>> pending;
+    for (Function& F : *module) {
+        if (F.isDeclaration()) continue;
+
+        interp->functions.emplace_back();
+        InterpFunction* fn = &interp->functions.back();
+        fn->name = F.getName().str();
+        if (interp->profiler) {
+            fn->profile_id = function_profiler_register(interp->profiler, fn->name.c_str(),
+                                                        profile_module, nullptr);
+            function_profiler_set_ir_size(interp->profiler, fn->profile_id,
+                                          F.getInstructionCount());
+        }
+        if (!F.hasLocalLinkage() || !interp->function_index.count(fn->name)) {
+            interp->function_index[fn->name] = (int)interp->functions.size() - 1;
+        }
+        load.functions[&F] = fn;
+        pending.push_back({&F, fn});
+    }
+
+    int translated = 0;
+    for (auto& entry : pending) {
+        InterpFunction* fn = entry.second;
+        Translator translator(load, *entry.first, *fn);
+        if (!translator.run()) {
+            fn->code.clear();
+            interp->stats.functions_unsupported++;
+            continue;
+        }
+
+        for (Insn& insn : fn->code) {
+            insn.handler = interp->handlers[insn.op];
+        }
+        fn->translated = true;
+        translated++;
+        interp->stats.functions_translated++;
+        interp->stats.bytecode_bytes += fn->code.size() * sizeof(Insn) +
+                                        fn->call_args.size() * sizeof(uint32_t) +
+                                        fn->constants.size() * sizeof(uint64_t);
+    }
+
+    return translated;
+}
+
+int ir_interp_find_function(IRInterpreter* interp, const char* name) {
+    if (!interp || !name) return -1;
+    auto it = interp->function_index.find(name);
+    return it == interp->function_index.end() ? -1 : it->second;
+}
+
+int ir_interp_call(IRInterpreter* interp, int fn, const uint64_t* args, int argc,
+                   uint64_t* result) {
+    if (!interp || fn < 0 || fn >= (int)interp->functions.size()) return -1;
+    const InterpFunction& function = interp->functions[fn];
+
+    if ((size_t)argc != function.arg_kinds.size() || (argc > 0 && !args)) {
+        interp->last_error = function.name + ": wrong number of arguments";
+        return -1;
+    }
+    if (interp->sp + argc > IR_INTERP_STACK_SLOTS) {
+        interp->last_error = "interpreter stack overflow in " + function.name;
+        return -1;
+    }
+
+    // Bring the arguments into the interpreter's canonical form
+    uint64_t* frame = interp->stack.get() + interp->sp;
+    for (int k = 0; k < argc; k++) {
+        frame[k] = function.arg_kinds[k] == KIND_INT ? sx(args[k], function.arg_bits[k]) : args[k];
+    }
+
+    uint64_t value = 0;
+    if (!execute(interp, &function, &value)) return -1;
+
+    if (result && function.ret_kind != KIND_VOID) {
+        if (function.ret_kind == KIND_FLOAT) {
+            value &= 0xFFFFFFFFull;
+        } else if (function.ret_kind == KIND_INT && function.ret_bits == 1) {
+            value &= 1;
+        }
+        *result = value;
+    }
+    return 0;
+}
+
+void ir_interp_get_stats(IRInterpreter* interp, IRInterpStats* stats) {
+    if (!interp || !stats) return;
+    *stats = interp->stats;
+}
+
+const char* ir_interp_get_last_error(IRInterpreter* interp) {
+    return interp ? interp->last_error.c_str() : "no interpreter";
+}
+
+} // extern "C"
@@ -0,0 +1,82 @@
+// ir_interpreter.h - Profiling interpreter tier for LLVM IR
+//
+// Runs bitcode without LLVM codegen: each function is translated once into
+// a compact register bytecode (every SSA value gets a 64-bit frame slot,
+// phis become edge moves) executed by a threaded-dispatch interpreter
+// (computed goto). LLVM is only used to parse the bitcode.
+//
+// Profiling is built into the bytecode: every interpreted function is
+// registered with the function_profiler and its calls timed; each direct
+// call instruction carries a pointer to its call-edge counter and each
+// conditional branch (and switch case) a pointer to its branch outcome
+// counters, so the profile is complete before anything is compiled.
+// Call sites are numbered like jit_llvm18's edge profile (direct calls in
+// instruction order); branch sites are conditional branches, then each
+// switch case, in instruction order.
+//
+// Values cross the API as 64-bit slots: integers sign-extended (i1 true
+// is returned as 1), pointers as addresses, float and double as their bit
+// patterns (float in the low 32 bits).
+
+#ifndef IR_INTERPRETER_H
+#define IR_INTERPRETER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "function_profiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct IRInterpreter IRInterpreter;
+
+// Interpreter stack (frames and allocas), in 64-bit slots
+#define IR_INTERP_STACK_SLOTS (256 * 1024)
+
+// Maximum arguments of a native (non-interpreted) callee; only integer and
+// pointer arguments of at most pointer width are supported there
+#define IR_INTERP_MAX_NATIVE_ARGS 6
+
+// 'profiler' may be NULL (no profiling)
+IRInterpreter* ir_interp_create(function_profiler_t* profiler);
+void ir_interp_destroy(IRInterpreter* interp);
+
+// Native symbol for declarations and external globals the bitcode uses
+// (checked before the process's own symbols). Returns 0, -1 on error.
+int ir_interp_add_symbol(IRInterpreter* interp, const char* name, void* address);
+
+// Allocate and initialize the module's globals and translate every function
+// it defines, registering them with the profiler under 'module_name'.
+// Functions using unsupported IR (vectors, aggregates in registers,
+// indirect calls, exceptions, ...) are kept but fail when called.
+// Returns the number of functions translated, -1 on error.
+int ir_interp_load_bitcode(IRInterpreter* interp, const char* module_name,
+                           const uint8_t* data, size_t size);
+
+// Handle of an interpreted function, -1 if unknown
+int ir_interp_find_function(IRInterpreter* interp, const char* name);
+
+// Run function 'fn' on 'argc' argument slots. Returns 0 and stores the
+// result (if 'result' is non-NULL and the function isn't void), -1 on
+// error (unsupported function, trap, stack overflow).
+int ir_interp_call(IRInterpreter* interp, int fn, const uint64_t* args, int argc,
+                   uint64_t* result);
+
+typedef struct {
+    uint64_t functions_translated;
+    uint64_t functions_unsupported;
+    uint64_t bytecode_bytes;
+    uint64_t calls;             // Interpreted calls, nested ones included
+} IRInterpStats;
+
+void ir_interp_get_stats(IRInterpreter* interp, IRInterpStats* stats);
+
+// Error handling
+const char* ir_interp_get_last_error(IRInterpreter* interp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IR_INTERPRETER_H
@@ -1,12 +1,20 @@
 /**
  * JIT Memory Allocator Implementation
  *
- * Uses free-list allocation with block coalescence to minimize fragmentation.
- * Each pool has its own memory region and free list.
+ * Each pool is managed by a Two-Level Segregated Fit (TLSF) allocator:
+ * - First level splits free blocks by power of two (fls(size))
+ * - Second level splits each power-of-two range into SL_INDEX_COUNT lists
+ * - Two bitmaps locate a non-empty list with ffs(), so alloc/free are O(1)
+ * - Physical neighbours are linked for O(1) coalescing on free
+ *
+ * JIT recompilation can run in the middle of inference, so the allocator
+ * must never walk an unbounded free list.
  */
 
 #include "jit_allocator.h"
+#include "paging.h"
 #include "vga.h"
+#include <stdbool.h>
 
 // External C functions
 extern void* malloc(size_t size);
@@ -21,23 +29,39 @@ extern void* memcpy(void* dest, const void* src, size_t n);
 #define BLOCK_MAGIC 0xDEADBEEF
 #define MIN_BLOCK_SIZE 32
 
+// TLSF configuration
+#define ALIGN_SIZE_LOG2      3                                   // 8-byte granularity
+#define ALIGN_SIZE           (1 << ALIGN_SIZE_LOG2)
+#define SL_INDEX_COUNT_LOG2  4                                   // 16 second-level lists
+#define SL_INDEX_COUNT       (1 << SL_INDEX_COUNT_LOG2)
+#define FL_INDEX_MAX         30                                  // Pools up to 1 GB
+#define FL_INDEX_SHIFT       (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT       (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE     (1 << FL_INDEX_SHIFT)               // 128 bytes
+
 /**
- * Block header for free list allocator
+ * Block header for TLSF allocator
  */
 typedef struct block_header {
-    uint32_t magic;             // Magic number for validation
-    size_t size;                // Size of usable memory (excluding header)
-    struct block_header* next;  // Next block in free list
-    uint32_t is_free;           // 1 if free, 0 if allocated
+    uint32_t magic;                  // Magic number for validation
+    size_t size;                     // Size of usable memory (excluding header)
+    struct block_header* prev_phys;  // Physically preceding block (NULL for first)
+    struct block_header* next_free;  // Next block in segregated list (free only)
+    struct block_header* prev_free;  // Previous block in segregated list (free only)
+    uint32_t is_free;                // 1 if free, 0 if allocated
 } block_header_t;
 
 /**
  * Memory pool structure
  */
 typedef struct {
+    uint8_t* raw_base;          // Pointer returned by malloc (freed on shutdown)
     uint8_t* base;              // Base address of pool
     size_t total_size;          // Total size of pool
-    block_header_t* free_list;  // Head of free list
+    uintptr_t exec_alias;       // RX alias base (0 = no dual mapping)
+    uint32_t fl_bitmap;         // Non-empty first-level classes
+    uint32_t sl_bitmap[FL_INDEX_COUNT];                          // Non-empty second-level lists
+    block_header_t* blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];      // Segregated free lists
     jit_pool_stats_t stats;     // Pool statistics
     int initialized;            // 1 if pool is initialized
 } memory_pool_t;
@@ -61,8 +85,10 @@ static inline size_t align_up(size_t size, size_t alignment) {
     return (size + alignment - 1) & ~(alignment - 1);
 }
 
-static inline int is_aligned(void* ptr, size_t alignment) {
-    return ((uintptr_t)ptr % alignment) == 0;
+// W^X by flipping page permissions (paging_init() done, no dual mapping).
+// Until paging is on, the kernel runs flat and protection changes are no-ops.
+static inline int code_pool_flips_pages(void) {
+    return paging_enabled() && g_pools[JIT_POOL_CODE].exec_alias == 0;
 }
 
 // Get block header from user pointer
@@ -75,30 +101,184 @@ static inline void* get_user_pointer(block_header_t* block) {
     return (void*)((uint8_t*)block + sizeof(block_header_t));
 }
 
+// Get physically following block, or NULL at the end of the pool
+static inline block_header_t* get_next_phys(memory_pool_t* pool, block_header_t* block) {
+    uint8_t* next = (uint8_t*)block + sizeof(block_header_t) + block->size;
+    if (next + sizeof(block_header_t) > pool->base + pool->total_size) {
+        return NULL;
+    }
+    return (block_header_t*)next;
+}
+
+// Index of least significant set bit (word must be non-zero)
+static inline int tlsf_ffs(uint32_t word) {
+    return __builtin_ctz(word);
+}
+
+// Index of most significant set bit (word must be non-zero)
+static inline int tlsf_fls(uint32_t word) {
+    return 31 - __builtin_clz(word);
+}
+
+// ============================================================================
+// TLSF Index Mapping
+// ============================================================================
+
+// Map a block size to the (fl, sl) list that holds it
+static void mapping_insert(size_t size, int* fl, int* sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+    } else {
+        int f = tlsf_fls((uint32_t)size);
+        *sl = (int)((size >> (f - SL_INDEX_COUNT_LOG2)) ^ (1u << SL_INDEX_COUNT_LOG2));
+        *fl = f - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+// Map a request size to the first list whose blocks are all large enough
+static void mapping_search(size_t size, int* fl, int* sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        size_t round = (1u << (tlsf_fls((uint32_t)size) - SL_INDEX_COUNT_LOG2)) - 1;
+        size += round;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+// ============================================================================
+// Segregated Free Lists
+// ============================================================================
+
+static void insert_free_block(memory_pool_t* pool, block_header_t* block) {
+    int fl, sl;
+    mapping_insert(block->size, &fl, &sl);
+
+    block_header_t* head = pool->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head) {
+        head->prev_free = block;
+    }
+    pool->blocks[fl][sl] = block;
+    block->is_free = 1;
+
+    pool->fl_bitmap |= (1u << fl);
+    pool->sl_bitmap[fl] |= (1u << sl);
+}
+
+static void remove_free_block(memory_pool_t* pool, block_header_t* block) {
+    int fl, sl;
+    mapping_insert(block->size, &fl, &sl);
+
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        pool->blocks[fl][sl] = block->next_free;
+        if (!pool->blocks[fl][sl]) {
+            pool->sl_bitmap[fl] &= ~(1u << sl);
+            if (!pool->sl_bitmap[fl]) {
+                pool->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+
+    block->next_free = NULL;
+    block->prev_free = NULL;
+    block->is_free = 0;
+}
+
+// Find a free block of at least 'size' bytes in O(1) using the bitmaps
+static block_header_t* find_free_block(memory_pool_t* pool, size_t size) {
+    int fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= FL_INDEX_COUNT) {
+        return NULL;
+    }
+
+    uint32_t sl_map = pool->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint32_t fl_map = (fl + 1 < 32) ? (pool->fl_bitmap & (~0u << (fl + 1))) : 0;
+        if (!fl_map) {
+            return NULL;
+        }
+        fl = tlsf_ffs(fl_map);
+        sl_map = pool->sl_bitmap[fl];
+    }
+    sl = tlsf_ffs(sl_map);
+
+    return pool->blocks[fl][sl];
+}
+
+// ============================================================================
+// Block Split / Merge
+// ============================================================================
+
+// Split 'block' so it keeps 'size' bytes; the remainder becomes a free block
+static void split_block(memory_pool_t* pool, block_header_t* block, size_t size) {
+    if (block->size < size + sizeof(block_header_t) + MIN_BLOCK_SIZE) {
+        return;
+    }
+
+    block_header_t* remainder = (block_header_t*)((uint8_t*)block + sizeof(block_header_t) + size);
+    remainder->magic = BLOCK_MAGIC;
+    remainder->size = block->size - size - sizeof(block_header_t);
+    remainder->prev_phys = block;
+    block->size = size;
+
+    block_header_t* next = get_next_phys(pool, remainder);
+    if (next) {
+        next->prev_phys = remainder;
+    }
+
+    insert_free_block(pool, remainder);
+}
+
+// Absorb the physically following block into 'block'
+static void absorb_next(memory_pool_t* pool, block_header_t* block, block_header_t* next) {
+    block->size += sizeof(block_header_t) + next->size;
+    next->magic = 0;
+
+    block_header_t* after = get_next_phys(pool, block);
+    if (after) {
+        after->prev_phys = block;
+    }
+}
+
 // ============================================================================
 // Pool Management
 // ============================================================================
 
-static int init_pool(memory_pool_t* pool, size_t size) {
-    if (!pool || size == 0) return -1;
+static void reset_pool_blocks(memory_pool_t* pool) {
+    pool->fl_bitmap = 0;
+    memset(pool->sl_bitmap, 0, sizeof(pool->sl_bitmap));
+    memset(pool->blocks, 0, sizeof(pool->blocks));
+
+    // Initialize with one large free block
+    block_header_t* initial_block = (block_header_t*)pool->base;
+    initial_block->magic = BLOCK_MAGIC;
+    initial_block->size = (pool->total_size - sizeof(block_header_t)) & ~(size_t)(ALIGN_SIZE - 1);
+    initial_block->prev_phys = NULL;
+    insert_free_block(pool, initial_block);
+}
+
+static int init_pool(memory_pool_t* pool, size_t size, size_t base_alignment) {
+    if (!pool || size <= sizeof(block_header_t) + MIN_BLOCK_SIZE) return -1;
 
     // Allocate memory for pool from kernel heap
-    pool->base = (uint8_t*)malloc(size);
-    if (!pool->base) {
+    pool->raw_base = (uint8_t*)malloc(size + base_alignment);
+    if (!pool->raw_base) {
         return -1;
     }
 
+    pool->base = (uint8_t*)align_up((uintptr_t)pool->raw_base, base_alignment);
     pool->total_size = size;
+    pool->exec_alias = 0;
     pool->initialized = 1;
 
-    // Initialize with one large free block
-    block_header_t* initial_block = (block_header_t*)pool->base;
-    initial_block->magic = BLOCK_MAGIC;
-    initial_block->size = size - sizeof(block_header_t);
-    initial_block->next = NULL;
-    initial_block->is_free = 1;
-
-    pool->free_list = initial_block;
+    reset_pool_blocks(pool);
 
     // Initialize statistics
     pool->stats.total_size = size;
@@ -112,9 +292,26 @@ static int init_pool(memory_pool_t* pool, size_t size) {
     return 0;
 }
 
+// Point the RX alias range back at its own frames (identity, RW+X)
+static int unmap_exec_alias(memory_pool_t* pool) {
+    if (paging_map_alias(pool->exec_alias, pool->exec_alias, pool->total_size, true, false) != 0) {
+        return -1;
+    }
+    pool->exec_alias = 0;
+    return 0;
+}
+
 static void shutdown_pool(memory_pool_t* pool) {
-    if (pool && pool->initialized && pool->base) {
-        free(pool->base);
+    if (pool && pool->initialized && pool->raw_base) {
+        // Hand the frames back to the heap as plain identity-mapped RW memory
+        if (pool == &g_pools[JIT_POOL_CODE] && paging_enabled()) {
+            if (pool->exec_alias) {
+                unmap_exec_alias(pool);
+            }
+            paging_protect_range((uintptr_t)pool->base, pool->total_size, true, false);
+        }
+        free(pool->raw_base);
+        pool->raw_base = NULL;
         pool->base = NULL;
         pool->initialized = 0;
     }
@@ -124,73 +321,100 @@ static void shutdown_pool(memory_pool_t* pool) {
 // Block Allocation
 // ============================================================================
 
-static void* alloc_from_pool(memory_pool_t* pool, size_t size, size_t alignment, uint32_t flags) {
-    if (!pool || !pool->initialized || size == 0) return NULL;
+// Payload size a request of 'size' bytes occupies
+static inline size_t block_payload_size(size_t size) {
+    return (size < MIN_BLOCK_SIZE) ? MIN_BLOCK_SIZE : align_up(size, ALIGN_SIZE);
+}
 
-    // Align size to at least MIN_BLOCK_SIZE
-    size = (size < MIN_BLOCK_SIZE) ? MIN_BLOCK_SIZE : align_up(size, 8);
+// Leading gap in front of an 'alignment'-aligned payload for a block whose
+// payload starts at 'user'. A non-zero gap is big enough to be a free block.
+static size_t alignment_gap(uintptr_t user, size_t alignment) {
+    if (alignment <= ALIGN_SIZE) {
+        return 0;
+    }
 
-    block_header_t* prev = NULL;
-    block_header_t* current = pool->free_list;
+    size_t gap = align_up(user, alignment) - user;
+    while (gap != 0 && gap < sizeof(block_header_t) + MIN_BLOCK_SIZE) {
+        gap += alignment;
+    }
+    return gap;
+}
 
-    // Find suitable free block (first-fit)
-    while (current) {
-        if (current->magic != BLOCK_MAGIC) {
-            terminal_writestring("ERROR: Corrupted block header!\n");
-            return NULL;
+// Turn free block 'block' (already off its list) into a used block of
+// 'size' payload bytes; the leading gap and the tail go back as free blocks
+static void* take_block(memory_pool_t* pool, block_header_t* block, size_t size,
+                        size_t alignment, size_t requested, uint32_t flags) {
+    size_t gap = alignment_gap((uintptr_t)get_user_pointer(block), alignment);
+    if (gap != 0) {
+        block_header_t* aligned_block = (block_header_t*)((uint8_t*)block + gap);
+        aligned_block->magic = BLOCK_MAGIC;
+        aligned_block->size = block->size - gap;
+        aligned_block->prev_phys = block;
+        aligned_block->is_free = 0;
+
+        block_header_t* next = get_next_phys(pool, aligned_block);
+        if (next) {
+            next->prev_phys = aligned_block;
         }
 
-        if (current->is_free && current->size >= size) {
-            // Check alignment requirements
-            void* user_ptr = get_user_pointer(current);
-            if (alignment > 0 && !is_aligned(user_ptr, alignment)) {
-                // Skip this block, alignment doesn't match
-                prev = current;
-                current = current->next;
-                continue;
-            }
+        block->size = gap - sizeof(block_header_t);
+        insert_free_block(pool, block);
+        block = aligned_block;
+    }
 
-            // Found suitable block - split if large enough
-            if (current->size >= size + sizeof(block_header_t) + MIN_BLOCK_SIZE) {
-                // Split block
-                block_header_t* new_block = (block_header_t*)((uint8_t*)current + sizeof(block_header_t) + size);
-                new_block->magic = BLOCK_MAGIC;
-                new_block->size = current->size - size - sizeof(block_header_t);
-                new_block->next = current->next;
-                new_block->is_free = 1;
-
-                current->size = size;
-                current->next = new_block;
-            }
+    split_block(pool, block, size);
+
+    // Update statistics
+    pool->stats.used_size += block->size + sizeof(block_header_t);
+    pool->stats.free_size -= block->size + sizeof(block_header_t);
+    pool->stats.num_allocations++;
 
-            // Mark block as allocated
-            current->is_free = 0;
+    if (pool->stats.used_size > pool->stats.peak_usage) {
+        pool->stats.peak_usage = pool->stats.used_size;
+    }
 
-            // Update statistics
-            pool->stats.used_size += current->size + sizeof(block_header_t);
-            pool->stats.free_size -= current->size + sizeof(block_header_t);
-            pool->stats.num_allocations++;
+    void* result = get_user_pointer(block);
 
-            if (pool->stats.used_size > pool->stats.peak_usage) {
-                pool->stats.peak_usage = pool->stats.used_size;
-            }
+    // Flip mode: pages never used for code are still identity RW+X, so
+    // code always starts out RW+NX until jit_mark_executable()
+    if (pool == &g_pools[JIT_POOL_CODE] && (flags & JIT_ALLOC_EXECUTABLE) && code_pool_flips_pages()) {
+        jit_mark_writable(result, block->size);
+    }
 
-            void* result = get_user_pointer(current);
+    // Zero memory if requested
+    if (flags & JIT_ALLOC_ZEROED) {
+        memset(result, 0, requested);
+    }
 
-            // Zero memory if requested
-            if (flags & JIT_ALLOC_ZEROED) {
-                memset(result, 0, size);
-            }
+    return result;
+}
 
-            return result;
-        }
+static void* alloc_from_pool(memory_pool_t* pool, size_t size, size_t alignment, uint32_t flags) {
+    if (!pool || !pool->initialized || size == 0) return NULL;
 
-        prev = current;
-        current = current->next;
+    // Align size to at least MIN_BLOCK_SIZE
+    size_t requested = size;
+    size = block_payload_size(size);
+
+    // Over-allocate for alignments stronger than the natural block alignment
+    // so a leading gap (itself a valid free block) can be split off
+    size_t search_size = size;
+    if (alignment > ALIGN_SIZE) {
+        search_size = size + alignment + sizeof(block_header_t) + MIN_BLOCK_SIZE;
     }
 
-    // No suitable block found
-    return NULL;
+    block_header_t* block = find_free_block(pool, search_size);
+    if (!block) {
+        return NULL;
+    }
+
+    if (block->magic != BLOCK_MAGIC) {
+        terminal_writestring("ERROR: Corrupted block header!\n");
+        return NULL;
+    }
+
+    remove_free_block(pool, block);
+    return take_block(pool, block, size, alignment, requested, flags);
 }
 
 static void free_to_pool(memory_pool_t* pool, void* ptr) {
@@ -209,29 +433,26 @@ static void free_to_pool(memory_pool_t* pool, void* ptr) {
         return;
     }
 
-    // Mark block as free
-    block->is_free = 1;
-
     // Update statistics
     pool->stats.used_size -= block->size + sizeof(block_header_t);
     pool->stats.free_size += block->size + sizeof(block_header_t);
     pool->stats.num_deallocations++;
 
-    // Coalesce with adjacent free blocks
-    block_header_t* current = pool->free_list;
-    while (current) {
-        if (current->is_free) {
-            // Check if next block is adjacent and free
-            block_header_t* next = (block_header_t*)((uint8_t*)current + sizeof(block_header_t) + current->size);
-            if ((uint8_t*)next < pool->base + pool->total_size && next->is_free && next->magic == BLOCK_MAGIC) {
-                // Coalesce
-                current->size += sizeof(block_header_t) + next->size;
-                current->next = next->next;
-                pool->stats.fragmentation_bytes -= sizeof(block_header_t);
-            }
-        }
-        current = current->next;
+    // Coalesce with physical neighbours in O(1)
+    block_header_t* prev = block->prev_phys;
+    if (prev && prev->is_free) {
+        remove_free_block(pool, prev);
+        absorb_next(pool, prev, block);
+        block = prev;
+    }
+
+    block_header_t* next = get_next_phys(pool, block);
+    if (next && next->is_free && next->magic == BLOCK_MAGIC) {
+        remove_free_block(pool, next);
+        absorb_next(pool, block, next);
     }
+
+    insert_free_block(pool, block);
 }
 
 // ============================================================================
@@ -244,16 +465,16 @@ int jit_allocator_init(size_t code_pool_size, size_t data_pool_size, size_t meta
     }
 
     // Initialize all pools
-    if (init_pool(&g_pools[JIT_POOL_CODE], code_pool_size) != 0) {
+    if (init_pool(&g_pools[JIT_POOL_CODE], code_pool_size, JIT_PAGE_SIZE) != 0) {
         return -1;
     }
 
-    if (init_pool(&g_pools[JIT_POOL_DATA], data_pool_size) != 0) {
+    if (init_pool(&g_pools[JIT_POOL_DATA], data_pool_size, ALIGN_SIZE) != 0) {
         shutdown_pool(&g_pools[JIT_POOL_CODE]);
         return -1;
     }
 
-    if (init_pool(&g_pools[JIT_POOL_METADATA], metadata_pool_size) != 0) {
+    if (init_pool(&g_pools[JIT_POOL_METADATA], metadata_pool_size, ALIGN_SIZE) != 0) {
         shutdown_pool(&g_pools[JIT_POOL_CODE]);
         shutdown_pool(&g_pools[JIT_POOL_DATA]);
         return -1;
@@ -278,6 +499,12 @@ void* jit_alloc(size_t size, jit_pool_type_t pool, uint32_t flags) {
         return NULL;
     }
 
+    // In flip mode, executable code gets whole pages of its own so that
+    // making it RX never covers a block header or another allocation
+    if (pool == JIT_POOL_CODE && (flags & JIT_ALLOC_EXECUTABLE) && code_pool_flips_pages()) {
+        return alloc_from_pool(&g_pools[pool], align_up(size, JIT_PAGE_SIZE), JIT_PAGE_SIZE, flags);
+    }
+
     return alloc_from_pool(&g_pools[pool], size, 0, flags);
 }
 
@@ -290,14 +517,228 @@ void* jit_alloc_aligned(size_t size, size_t alignment, jit_pool_type_t pool, uin
         return NULL;
     }
 
+    if (pool == JIT_POOL_CODE && (flags & JIT_ALLOC_EXECUTABLE) && code_pool_flips_pages()) {
+        size = align_up(size, JIT_PAGE_SIZE);
+        if (alignment < JIT_PAGE_SIZE) {
+            alignment = JIT_PAGE_SIZE;
+        }
+    }
+
     return alloc_from_pool(&g_pools[pool], size, alignment, flags);
 }
 
+// Same rounding as jit_alloc(): page-flipped code gets whole pages
+static size_t request_alignment(jit_pool_type_t pool, uint32_t flags, size_t* size) {
+    if (pool == JIT_POOL_CODE && (flags & JIT_ALLOC_EXECUTABLE) && code_pool_flips_pages()) {
+        *size = align_up(*size, JIT_PAGE_SIZE);
+        return JIT_PAGE_SIZE;
+    }
+    return 0;
+}
+
+void* jit_alloc_below(size_t size, const void* limit, jit_pool_type_t pool, uint32_t flags) {
+    if (!g_allocator_initialized || size == 0 || pool < 0 || pool > JIT_POOL_METADATA) {
+        return NULL;
+    }
+
+    memory_pool_t* p = &g_pools[pool];
+    if (!p->initialized) {
+        return NULL;
+    }
+
+    size_t requested = size;
+    size_t alignment = request_alignment(pool, flags, &size);
+    size = block_payload_size(size);
+
+    // Physical order is address order, so the first fit is the lowest one
+    for (block_header_t* b = (block_header_t*)p->base;
+         b && (const uint8_t*)b < (const uint8_t*)limit;
+         b = get_next_phys(p, b)) {
+        if (!b->is_free ||
+            alignment_gap((uintptr_t)get_user_pointer(b), alignment) + size > b->size) {
+            continue;
+        }
+        remove_free_block(p, b);
+        return take_block(p, b, size, alignment, requested, flags);
+    }
+
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Compaction projection: the pool's physical blocks replayed on a copy
+// ----------------------------------------------------------------------------
+
+#define PROJECT_MAX_BLOCKS 256
+
+typedef struct {
+    uintptr_t header;
+    size_t size;
+    int is_free;
+} projected_block_t;
+
+static projected_block_t g_projection[PROJECT_MAX_BLOCKS];
+static projected_block_t g_projection_saved[PROJECT_MAX_BLOCKS];   // Undo copy of one move
+
+// Open a slot at 'at' (shifting the rest up); -1 when the copy is full
+static int projection_insert(int* count, int at) {
+    if (*count >= PROJECT_MAX_BLOCKS) {
+        return -1;
+    }
+    for (int i = *count; i > at; i--) {
+        g_projection[i] = g_projection[i - 1];
+    }
+    (*count)++;
+    return 0;
+}
+
+static void projection_remove(int* count, int at) {
+    for (int i = at; i < *count - 1; i++) {
+        g_projection[i] = g_projection[i + 1];
+    }
+    (*count)--;
+}
+
+// Free bytes outside the largest free block, as jit_get_pool_stats() counts them
+static size_t projection_fragmentation(int count, size_t free_size) {
+    size_t largest = 0;
+    for (int i = 0; i < count; i++) {
+        if (g_projection[i].is_free && g_projection[i].size > largest) {
+            largest = g_projection[i].size;
+        }
+    }
+    return (free_size > largest + sizeof(block_header_t))
+        ? free_size - largest - sizeof(block_header_t) : 0;
+}
+
+// Move used block 'at' to the lowest fit below it (laid out as take_block()
+// does) and free the old copy with free_to_pool()'s coalescing. Adds the
+// change in free bytes to *free_size. Returns 1 if it moved, 0 if nothing
+// below fits, -1 if the copy ran out of slots.
+static int projection_move(int* count, int at, size_t size, size_t alignment, size_t* free_size) {
+    for (int i = 0; i < at; i++) {
+        projected_block_t* b = &g_projection[i];
+        size_t gap = alignment_gap(b->header + sizeof(block_header_t), alignment);
+        if (!b->is_free || gap + size > b->size) {
+            continue;
+        }
+
+        if (gap != 0) {
+            if (projection_insert(count, i + 1) != 0) return -1;
+            g_projection[i + 1].header = b->header + gap;
+            g_projection[i + 1].size = b->size - gap;
+            g_projection[i].size = gap - sizeof(block_header_t);
+            i++;
+            at++;
+        }
+
+        g_projection[i].is_free = 0;
+        if (g_projection[i].size >= size + sizeof(block_header_t) + MIN_BLOCK_SIZE) {
+            if (projection_insert(count, i + 1) != 0) return -1;
+            g_projection[i + 1].header = g_projection[i].header + sizeof(block_header_t) + size;
+            g_projection[i + 1].size = g_projection[i].size - size - sizeof(block_header_t);
+            g_projection[i + 1].is_free = 1;
+            g_projection[i].size = size;
+            at++;
+        }
+        *free_size = *free_size + g_projection[at].size - g_projection[i].size;
+
+        // Free the old copy and merge it with free neighbours
+        g_projection[at].is_free = 1;
+        if (at + 1 < *count && g_projection[at + 1].is_free) {
+            g_projection[at].size += sizeof(block_header_t) + g_projection[at + 1].size;
+            projection_remove(count, at + 1);
+        }
+        if (g_projection[at - 1].is_free) {
+            g_projection[at - 1].size += sizeof(block_header_t) + g_projection[at].size;
+            projection_remove(count, at);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int jit_plan_compaction(jit_pool_type_t pool, void* const* blocks, const size_t* sizes,
+                        int count, uint32_t flags, uint8_t* move, size_t* before, size_t* after) {
+    if (!g_allocator_initialized || !blocks || !sizes || !move || count < 0 ||
+        pool < 0 || pool > JIT_POOL_METADATA || !g_pools[pool].initialized) {
+        return -1;
+    }
+
+    memory_pool_t* p = &g_pools[pool];
+    int n = 0;
+    for (block_header_t* b = (block_header_t*)p->base; b; b = get_next_phys(p, b)) {
+        if (n >= PROJECT_MAX_BLOCKS) {
+            return -1;
+        }
+        g_projection[n].header = (uintptr_t)b;
+        g_projection[n].size = b->size;
+        g_projection[n].is_free = b->is_free;
+        n++;
+    }
+
+    size_t free_size = p->stats.free_size;
+    size_t fragmentation = projection_fragmentation(n, free_size);
+    if (before) {
+        *before = fragmentation;
+    }
+
+    for (int k = 0; k < count; k++) {
+        uintptr_t header = (uintptr_t)get_block_header(blocks[k]);
+        size_t size = sizes[k];
+        size_t alignment = request_alignment(pool, flags, &size);
+        size = block_payload_size(size);
+
+        move[k] = 0;
+        int at = 0;
+        while (at < n && g_projection[at].header != header) {
+            at++;
+        }
+        if (at == n || g_projection[at].is_free) {
+            return -1;
+        }
+
+        // Try the move and keep it only if the free space came together
+        int saved_count = n;
+        memcpy(g_projection_saved, g_projection, n * sizeof(projected_block_t));
+
+        size_t moved_free = free_size;
+        int moved = projection_move(&n, at, size, alignment, &moved_free);
+        if (moved < 0) {
+            return -1;
+        }
+
+        size_t moved_fragmentation = projection_fragmentation(n, moved_free);
+        if (moved && moved_fragmentation < fragmentation) {
+            move[k] = 1;
+            free_size = moved_free;
+            fragmentation = moved_fragmentation;
+        } else {
+            n = saved_count;
+            memcpy(g_projection, g_projection_saved, n * sizeof(projected_block_t));
+        }
+    }
+
+    if (after) {
+        *after = fragmentation;
+    }
+    return 0;
+}
+
 void jit_free(void* ptr, jit_pool_type_t pool) {
     if (!g_allocator_initialized || !ptr || pool < 0 || pool > JIT_POOL_METADATA) {
         return;
     }
 
+    // Freed code pages go back to RW+NX before the allocator reuses them
+    if (pool == JIT_POOL_CODE && code_pool_flips_pages() &&
+        ((uintptr_t)ptr & (JIT_PAGE_SIZE - 1)) == 0) {
+        block_header_t* block = get_block_header(ptr);
+        if (block->magic == BLOCK_MAGIC && !block->is_free) {
+            jit_mark_writable(ptr, block->size);
+        }
+    }
+
     free_to_pool(&g_pools[pool], ptr);
 }
 
@@ -343,7 +784,25 @@ void jit_get_pool_stats(jit_pool_type_t pool, jit_pool_stats_t* stats) {
         return;
     }
 
-    *stats = g_pools[pool].stats;
+    memory_pool_t* p = &g_pools[pool];
+    *stats = p->stats;
+
+    // Fragmentation = free bytes that cannot serve a request as large as the
+    // biggest free block (only the highest non-empty list needs scanning)
+    stats->fragmentation_bytes = 0;
+    if (p->initialized && p->fl_bitmap) {
+        int fl = tlsf_fls(p->fl_bitmap);
+        int sl = tlsf_fls(p->sl_bitmap[fl]);
+        size_t largest = 0;
+        for (block_header_t* b = p->blocks[fl][sl]; b; b = b->next_free) {
+            if (b->size > largest) {
+                largest = b->size;
+            }
+        }
+        if (p->stats.free_size > largest + sizeof(block_header_t)) {
+            stats->fragmentation_bytes = p->stats.free_size - largest - sizeof(block_header_t);
+        }
+    }
 }
 
 void jit_print_pool_stats(int pool) {
@@ -377,8 +836,8 @@ void jit_print_pool_stats(int pool) {
 }
 
 size_t jit_defragment_pool(jit_pool_type_t pool) {
-    // TODO: Implement defragmentation if needed
-    // For now, coalescing happens automatically during free()
+    // TLSF coalesces physical neighbours eagerly in free_to_pool(), so there
+    // are never two adjacent free blocks left to merge here
     (void)pool;
     return 0;
 }
@@ -390,14 +849,13 @@ void jit_reset_pool(jit_pool_type_t pool) {
 
     memory_pool_t* p = &g_pools[pool];
 
-    // Re-initialize pool with one large free block
-    block_header_t* initial_block = (block_header_t*)p->base;
-    initial_block->magic = BLOCK_MAGIC;
-    initial_block->size = p->total_size - sizeof(block_header_t);
-    initial_block->next = NULL;
-    initial_block->is_free = 1;
+    // Code pages may still be RX; headers are rewritten below
+    if (pool == JIT_POOL_CODE && code_pool_flips_pages()) {
+        paging_protect_range((uintptr_t)p->base, p->total_size, true, true);
+    }
 
-    p->free_list = initial_block;
+    // Re-initialize pool with one large free block
+    reset_pool_blocks(p);
 
     // Reset statistics
     p->stats.used_size = 0;
@@ -424,10 +882,117 @@ int jit_is_pool_pointer(const void* ptr, jit_pool_type_t* pool) {
     return 0;
 }
 
+// Validate that [ptr, ptr+size) lies in the code pool and return its page span
+static int code_page_span(void* ptr, size_t size, uintptr_t* start, size_t* len) {
+    memory_pool_t* p = &g_pools[JIT_POOL_CODE];
+    if (!g_allocator_initialized || !p->initialized || !ptr || size == 0) {
+        return -1;
+    }
+
+    uintptr_t addr = (uintptr_t)ptr;
+    uintptr_t pool_start = (uintptr_t)p->base;
+    if (addr < pool_start || addr + size > pool_start + p->total_size) {
+        return -1;
+    }
+
+    *start = addr & ~(uintptr_t)(JIT_PAGE_SIZE - 1);
+    *len = align_up(addr + size, JIT_PAGE_SIZE) - *start;
+    return 0;
+}
+
 int jit_mark_executable(void* ptr, size_t size) {
-    // In bare-metal, all memory is executable by default
-    // This function is a no-op but provided for API compatibility
-    (void)ptr;
-    (void)size;
+    uintptr_t start;
+    size_t len;
+    if (code_page_span(ptr, size, &start, &len) != 0) {
+        return -1;
+    }
+
+    // Flat bare-metal (no paging): all memory is already executable.
+    // Dual mapping: the RX alias is permanently executable.
+    if (!code_pool_flips_pages()) {
+        return 0;
+    }
+
+    // RX: read + execute, no write (paging.c invalidates each page)
+    return paging_protect_range(start, len, false, false);
+}
+
+int jit_mark_writable(void* ptr, size_t size) {
+    uintptr_t start;
+    size_t len;
+    if (code_page_span(ptr, size, &start, &len) != 0) {
+        return -1;
+    }
+
+    if (!code_pool_flips_pages()) {
+        return 0;
+    }
+
+    // RW: read + write, no execute
+    return paging_protect_range(start, len, true, true);
+}
+
+int jit_enable_code_dual_mapping(uintptr_t rx_alias_base) {
+    memory_pool_t* p = &g_pools[JIT_POOL_CODE];
+    if (!g_allocator_initialized || !p->initialized) {
+        return -1;
+    }
+    if (!paging_enabled()) {
+        return -1;  // Flat kernel: nothing to alias
+    }
+    if (rx_alias_base & (JIT_PAGE_SIZE - 1)) {
+        return -1;
+    }
+
+    // RX view of the code frames (kernel is identity-mapped: virt == phys)
+    if (paging_map_alias(rx_alias_base, (uintptr_t)p->base, p->total_size, false, false) != 0) {
+        return -1;
+    }
+
+    // RW view must never be executable
+    if (paging_protect_range((uintptr_t)p->base, p->total_size, true, true) != 0) {
+        return -1;
+    }
+
+    p->exec_alias = rx_alias_base;
     return 0;
 }
+
+int jit_disable_code_dual_mapping(void) {
+    memory_pool_t* p = &g_pools[JIT_POOL_CODE];
+    if (!p->initialized || !p->exec_alias) {
+        return -1;
+    }
+
+    // The pool view is already RW+NX, which is what flip mode starts from
+    return unmap_exec_alias(p);
+}
+
+void* jit_code_exec_address(void* ptr) {
+    memory_pool_t* p = &g_pools[JIT_POOL_CODE];
+    if (!ptr || !p->exec_alias) {
+        return ptr;
+    }
+
+    uintptr_t addr = (uintptr_t)ptr;
+    uintptr_t pool_start = (uintptr_t)p->base;
+    if (addr < pool_start || addr >= pool_start + p->total_size) {
+        return ptr;
+    }
+
+    return (void*)(p->exec_alias + (addr - pool_start));
+}
+
+void* jit_code_write_address(void* exec_ptr) {
+    memory_pool_t* p = &g_pools[JIT_POOL_CODE];
+    if (!exec_ptr || !p->exec_alias) {
+        return exec_ptr;
+    }
+
+    uintptr_t addr = (uintptr_t)exec_ptr;
+    if (addr < p->exec_alias || addr >= p->exec_alias + p->total_size) {
+        return exec_ptr;
+    }
+
+    return (void*)((uintptr_t)p->base + (addr - p->exec_alias));
+}
@@ -15,9 +15,11 @@ extern "C" {
 //
 // Features:
 // - Separate pools for code (executable) and data
-// - Fast allocation/deallocation for small objects
+// - Bounded O(1) allocation/deallocation (TLSF per pool)
 // - Memory statistics and debugging
 // - Alignment support for code requirements
+// - W^X code pool: code is emitted into RW+NX pages, then flipped to RX
+//   (or written through an RW alias of RX-mapped frames, see dual mapping)
 
 /**
  * Memory pool types
@@ -35,6 +37,16 @@ typedef enum {
 #define JIT_ALLOC_ZEROED      0x02  // Zero memory after allocation
 #define JIT_ALLOC_ALIGNED     0x04  // Align to specific boundary
 
+/**
+ * Page granularity of code pool permission changes
+ */
+#define JIT_PAGE_SIZE 4096
+
+/**
+ * Default virtual base for the RX alias of the code pool (dual mapping)
+ */
+#define JIT_CODE_RX_ALIAS_BASE 0x80000000u
+
 /**
  * Memory statistics
  */
@@ -84,6 +96,44 @@ void* jit_alloc(size_t size, jit_pool_type_t pool, uint32_t flags);
  */
 void* jit_alloc_aligned(size_t size, size_t alignment, jit_pool_type_t pool, uint32_t flags);
 
+/**
+ * Allocate from the lowest free block that starts below 'limit'
+ *
+ * Same rounding as jit_alloc(). Passing a live block as 'limit' finds it
+ * a new home closer to the pool base; code compaction moves functions down
+ * this way so the space they leave merges with the free space above.
+ *
+ * @param size Size in bytes
+ * @param limit Only free blocks below this address are considered
+ * @param pool Pool to allocate from
+ * @param flags Allocation flags (JIT_ALLOC_*)
+ * @return Pointer to allocated memory, or NULL if nothing below fits
+ */
+void* jit_alloc_below(size_t size, const void* limit, jit_pool_type_t pool, uint32_t flags);
+
+/**
+ * Pick which blocks to move toward the pool base
+ *
+ * Replays, on a copy of the block layout, moving each of 'blocks' in turn
+ * to jit_alloc_below(sizes[i], blocks[i]) and freeing the old copy. A move
+ * is kept only if it lowers fragmentation_bytes (the space it leaves has
+ * to join up with other free space); the pool itself is not touched.
+ * Doing the kept moves in the same order reproduces the projected layout.
+ * Highest block first works best: its old space joins the free tail.
+ *
+ * @param pool Pool holding the blocks
+ * @param blocks Live blocks, in the order they would be moved
+ * @param sizes Size each block is moved with
+ * @param count Number of blocks
+ * @param flags Allocation flags the moves will use
+ * @param move Receives 1 for each block worth moving, 0 otherwise
+ * @param before Receives the current fragmentation_bytes
+ * @param after Receives fragmentation_bytes after the kept moves
+ * @return 0 on success, -1 if a block is not live or the layout is too large to copy
+ */
+int jit_plan_compaction(jit_pool_type_t pool, void* const* blocks, const size_t* sizes,
+                        int count, uint32_t flags, uint8_t* move, size_t* before, size_t* after);
+
 /**
  * Free memory allocated by jit_alloc
  *
@@ -144,14 +194,67 @@ void jit_reset_pool(jit_pool_type_t pool);
 int jit_is_pool_pointer(const void* ptr, jit_pool_type_t* pool);
 
 /**
- * Mark memory as executable (no-op on bare-metal, but provided for compatibility)
+ * Mark code memory as executable (W^X: pages become RX, no longer writable)
  *
- * @param ptr Pointer to memory
+ * With paging available, the pages covering [ptr, ptr+size) are flipped to
+ * read+execute and their TLB entries invalidated. With dual mapping enabled
+ * no flip is needed (the RX alias is always executable). Before
+ * paging_init() (flat kernel) this is a no-op.
+ *
+ * @param ptr Pointer to code pool memory (RW address)
  * @param size Size in bytes
  * @return 0 on success, -1 on failure
  */
 int jit_mark_executable(void* ptr, size_t size);
 
+/**
+ * Mark code memory writable again (W^X: pages become RW+NX)
+ * Call before re-emitting or patching code in flip mode.
+ *
+ * @param ptr Pointer to code pool memory (RW address)
+ * @param size Size in bytes
+ * @return 0 on success, -1 on failure
+ */
+int jit_mark_writable(void* ptr, size_t size);
+
+/**
+ * Map the whole code pool a second time as RX at rx_alias_base
+ *
+ * Code is then always written through the RW view and executed through the
+ * RX view, so patching hot code never flips permissions and never needs a
+ * TLB shootdown on other cores.
+ *
+ * Needs paging_init(). The alias stays until jit_disable_code_dual_mapping()
+ * or jit_allocator_shutdown().
+ *
+ * @param rx_alias_base Page-aligned virtual base for the RX alias
+ * @return 0 on success, -1 if paging is off or mapping failed
+ */
+int jit_enable_code_dual_mapping(uintptr_t rx_alias_base);
+
+/**
+ * Remove the RX alias and go back to page flips
+ *
+ * The alias range is identity-mapped again. No code may be live: code
+ * marked executable through the alias is still RW+NX in the pool and has
+ * to be marked executable again before it is called.
+ *
+ * @return 0 on success, -1 if dual mapping is not enabled
+ */
+int jit_disable_code_dual_mapping(void);
+
+/**
+ * Translate an RW code pool pointer to the address code must be called at
+ * (the RX alias with dual mapping, otherwise the pointer itself)
+ */
+void* jit_code_exec_address(void* ptr);
+
+/**
+ * Translate an executable code address back to its writable RW view
+ * (used to patch code that is already live)
+ */
+void* jit_code_write_address(void* exec_ptr);
+
 /**
  * Allocate executable code memory (convenience wrapper for Micro-JIT)
  *
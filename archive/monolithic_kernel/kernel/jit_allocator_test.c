@@ -4,6 +4,7 @@
 
 #include "jit_allocator_test.h"
 #include "jit_allocator.h"
+#include "paging.h"
 #include "vga.h"
 
 // External functions
@@ -225,6 +226,79 @@ static int test_fragmentation(void) {
     TEST_PASS();
 }
 
+static int test_coalesce_to_single_block(void) {
+    TEST_START("Coalescing restores one large block");
+
+    void* ptrs[8];
+
+    for (int i = 0; i < 8; i++) {
+        ptrs[i] = jit_alloc(4096 + i * 64, JIT_POOL_DATA, 0);
+        TEST_ASSERT(ptrs[i] != NULL, "Allocation failed");
+    }
+
+    // Free in interleaved order so every merge direction is exercised
+    for (int i = 0; i < 8; i += 2) {
+        jit_free(ptrs[i], JIT_POOL_DATA);
+    }
+    for (int i = 1; i < 8; i += 2) {
+        jit_free(ptrs[i], JIT_POOL_DATA);
+    }
+
+    jit_pool_stats_t stats;
+    jit_get_pool_stats(JIT_POOL_DATA, &stats);
+    TEST_ASSERT(stats.fragmentation_bytes == 0, "Free space still fragmented");
+
+    // Nearly the whole 512KB pool must be available as one block again
+    void* big = jit_alloc(480 * 1024, JIT_POOL_DATA, 0);
+    TEST_ASSERT(big != NULL, "Large allocation after coalescing failed");
+    jit_free(big, JIT_POOL_DATA);
+
+    TEST_PASS();
+}
+
+static int test_alloc_below(void) {
+    TEST_START("Moving blocks toward the pool base");
+
+    void* ptrs[4];
+    for (int i = 0; i < 4; i++) {
+        ptrs[i] = jit_alloc(1024, JIT_POOL_DATA, 0);
+        TEST_ASSERT(ptrs[i] != NULL, "Allocation failed");
+    }
+
+    // Hole at the bottom
+    jit_free(ptrs[0], JIT_POOL_DATA);
+    TEST_ASSERT(jit_alloc_below(2048, ptrs[1], JIT_POOL_DATA, 0) == NULL,
+                "Allocated past the limit");
+
+    // Highest first: ptrs[3] fills the hole and its spot joins the free
+    // tail, which leaves nothing below ptrs[1] to move into
+    jit_pool_stats_t stats;
+    jit_get_pool_stats(JIT_POOL_DATA, &stats);
+    size_t before = 0, after = 0;
+    void* movable[2] = { ptrs[3], ptrs[1] };
+    size_t sizes[2] = { 1024, 1024 };
+    uint8_t move[2];
+    TEST_ASSERT(jit_plan_compaction(JIT_POOL_DATA, movable, sizes, 2, 0, move, &before, &after) == 0,
+                "Planning failed");
+    TEST_ASSERT(before == stats.fragmentation_bytes, "Plan disagrees with pool stats");
+    TEST_ASSERT(move[0] && !move[1], "Wrong blocks picked");
+    TEST_ASSERT(after < before, "Plan expects no improvement");
+
+    void* moved = jit_alloc_below(sizes[0], movable[0], JIT_POOL_DATA, 0);
+    TEST_ASSERT(moved == ptrs[0], "Block not moved to the lowest hole");
+    jit_free(movable[0], JIT_POOL_DATA);
+    movable[0] = moved;
+
+    jit_get_pool_stats(JIT_POOL_DATA, &stats);
+    TEST_ASSERT(stats.fragmentation_bytes == after, "Plan did not match the move");
+
+    jit_free(movable[0], JIT_POOL_DATA);
+    jit_free(ptrs[1], JIT_POOL_DATA);
+    jit_free(ptrs[2], JIT_POOL_DATA);
+
+    TEST_PASS();
+}
+
 static int test_pool_reset(void) {
     TEST_START("Pool reset");
 
@@ -247,6 +321,106 @@ static int test_pool_reset(void) {
     TEST_PASS();
 }
 
+// mov eax, imm32; ret
+static void emit_return_const(uint8_t* code, uint32_t value) {
+    code[0] = 0xB8;
+    code[1] = value & 0xFF;
+    code[2] = (value >> 8) & 0xFF;
+    code[3] = (value >> 16) & 0xFF;
+    code[4] = (value >> 24) & 0xFF;
+    code[5] = 0xC3;
+}
+
+static int page_flags(const void* ptr, uintptr_t* phys) {
+    uint32_t flags = 0;
+    if (paging_lookup((uintptr_t)ptr, phys, &flags) != 0) {
+        return -1;
+    }
+    return (int)flags;
+}
+
+static int test_code_page_flips(void) {
+    TEST_START("W^X code page flips");
+
+    int nx = paging_nx_enabled();
+
+    uint8_t* code = (uint8_t*)jit_alloc_code(64);
+    TEST_ASSERT(code != NULL, "Code allocation failed");
+    TEST_ASSERT(((uintptr_t)code & (JIT_PAGE_SIZE - 1)) == 0, "Code not page-aligned in flip mode");
+
+    int flags = page_flags(code, NULL);
+    TEST_ASSERT(flags >= 0 && (flags & PAGING_WRITABLE), "Fresh code page not writable");
+    TEST_ASSERT(!nx || (flags & PAGING_NO_EXEC), "Fresh code page executable");
+
+    emit_return_const(code, 42);
+    TEST_ASSERT(jit_mark_executable(code, 6) == 0, "Mark executable failed");
+    flags = page_flags(code, NULL);
+    TEST_ASSERT(!(flags & PAGING_WRITABLE) && !(flags & PAGING_NO_EXEC), "Code page not RX");
+
+    int (*fn)(void) = (int (*)(void))jit_code_exec_address(code);
+    TEST_ASSERT((void*)fn == (void*)code, "Flip mode moved the entry point");
+    TEST_ASSERT(fn() == 42, "RX code returned wrong value");
+
+    TEST_ASSERT(jit_mark_writable(code, 6) == 0, "Mark writable failed");
+    flags = page_flags(code, NULL);
+    TEST_ASSERT((flags & PAGING_WRITABLE) && (!nx || (flags & PAGING_NO_EXEC)), "Code page not RW+NX");
+
+    jit_free_code(code);
+
+    TEST_PASS();
+}
+
+static int check_dual_mapping(void) {
+    int nx = paging_nx_enabled();
+
+    uint8_t* code = (uint8_t*)jit_alloc_code(64);
+    TEST_ASSERT(code != NULL, "Code allocation failed");
+    emit_return_const(code, 42);
+    TEST_ASSERT(jit_mark_executable(code, 6) == 0, "Mark executable failed");
+
+    uint8_t* exec = (uint8_t*)jit_code_exec_address(code);
+    TEST_ASSERT(exec != code, "No RX alias address");
+    TEST_ASSERT(jit_code_write_address(exec) == code, "Alias does not map back to RW view");
+
+    // Both views reach the same frame: RW+NX through the pool, RX through the alias
+    uintptr_t rw_phys = 0, rx_phys = 0;
+    int rw_flags = page_flags(code, &rw_phys);
+    int rx_flags = page_flags(exec, &rx_phys);
+    TEST_ASSERT(rw_flags >= 0 && rx_flags >= 0 && rw_phys == rx_phys, "Views map different frames");
+    TEST_ASSERT((rw_flags & PAGING_WRITABLE) && (!nx || (rw_flags & PAGING_NO_EXEC)), "RW view not RW+NX");
+    TEST_ASSERT(!(rx_flags & PAGING_WRITABLE) && !(rx_flags & PAGING_NO_EXEC), "Alias not RX");
+
+    int (*fn)(void) = (int (*)(void))exec;
+    TEST_ASSERT(fn() == 42, "Alias returned wrong value");
+
+    // Patch live code through the RW view without any permission change
+    emit_return_const(code, 7);
+    TEST_ASSERT(fn() == 7, "Patch not visible through alias");
+
+    jit_free_code(code);
+    return 1;
+}
+
+static int test_code_dual_mapping(void) {
+    TEST_START("W^X code dual mapping");
+
+    TEST_ASSERT(jit_enable_code_dual_mapping(JIT_CODE_RX_ALIAS_BASE) == 0, "Dual mapping failed");
+    int ok = check_dual_mapping();
+
+    // Leave the pool in flip mode and the alias range identity-mapped
+    TEST_ASSERT(jit_disable_code_dual_mapping() == 0, "Alias not removed");
+    uintptr_t phys = 0;
+    int flags = page_flags((void*)JIT_CODE_RX_ALIAS_BASE, &phys);
+    TEST_ASSERT(flags >= 0 && phys == JIT_CODE_RX_ALIAS_BASE, "Alias range not identity-mapped again");
+    TEST_ASSERT(jit_code_exec_address((void*)JIT_CODE_RX_ALIAS_BASE) == (void*)JIT_CODE_RX_ALIAS_BASE,
+                "Exec address still translated");
+    if (!ok) {
+        return 0;
+    }
+
+    TEST_PASS();
+}
+
 // ============================================================================
 // Main Test Entry Point
 // ============================================================================
@@ -269,8 +443,18 @@ int test_jit_allocator(void) {
     test_pool_statistics();
     test_different_pools();
     test_fragmentation();
+    test_coalesce_to_single_block();
+    test_alloc_below();
     test_pool_reset();
 
+    // W^X needs the identity map the kernel sets up at boot
+    if (paging_enabled()) {
+        test_code_page_flips();
+        test_code_dual_mapping();
+    } else {
+        terminal_writestring("\n[Skip] W^X tests: paging not enabled\n");
+    }
+
     terminal_writestring("\n========================================\n");
     terminal_writestring("  Results: ");
 
@@ -8,8 +8,12 @@
 #include "adaptive_jit.h"
 
 extern void serial_puts(const char* str);
+extern void serial_putchar(char c);
 extern uint64_t __builtin_ia32_rdtsc(void);
 
+// Idle time between calls (stands in for the gap between tokens)
+#define IDLE_SLICE_CYCLES 200000
+
 // Simple integer to string
 static void print_int(int value) {
     if (value == 0) {
@@ -44,6 +48,17 @@ static void print_int(int value) {
     serial_puts(buf);
 }
 
+// Generic version the specialized clones fall back to
+static int fibonacci_generic(int n) {
+    int a = 0, b = 1;
+    for (int i = 0; i < n; i++) {
+        int temp = a + b;
+        a = b;
+        b = temp;
+    }
+    return a;
+}
+
 void jit_demo_disk_to_jit(void) {
     serial_puts("\n=== END-TO-END JIT DEMO ===\n");
     serial_puts("Demonstrating: Pattern Detection → Micro-JIT → Adaptive Optimization\n\n");
@@ -86,17 +101,22 @@ void jit_demo_disk_to_jit(void) {
     }
 
     serial_puts("    ✓ Function registered with adaptive JIT\n\n");
-    serial_puts("    Executing 150 iterations to trigger O0→O1 optimization:\n");
+    serial_puts("    Executing 150 iterations to trigger a cost-model tier-up:\n");
 
     uint64_t first_cycles = 0;
     uint64_t transition_cycles = 0;
     uint64_t final_cycles = 0;
+    uint64_t worst_cycles = 0;
 
     for (int i = 0; i < 150; i++) {
         uint64_t start = __builtin_ia32_rdtsc();
         int result = adaptive_jit_execute(&ajit, fib_id);
         uint64_t end = __builtin_ia32_rdtsc();
         uint64_t cycles = end - start;
+        if (cycles > worst_cycles) worst_cycles = cycles;
+
+        // Tier-ups compile here, off the measured call path
+        adaptive_jit_compile_pending(&ajit, IDLE_SLICE_CYCLES);
 
         if (i == 0) {
             first_cycles = cycles;
@@ -105,25 +125,74 @@ void jit_demo_disk_to_jit(void) {
             serial_puts(" cycles\n");
         } else if (i == 99) {
             transition_cycles = cycles;
-            serial_puts("      [Call 100] O0→O1 transition: ");
+            serial_puts("      [Call 100] O");
+            serial_putchar('0' + adaptive_jit_get_profile(&ajit, fib_id)->opt_level);
+            serial_puts(": ");
             print_int((int)cycles);
             serial_puts(" cycles\n");
         } else if (i == 149) {
             final_cycles = cycles;
-            serial_puts("      [Call 150] Final O1: ");
+            serial_puts("      [Call 150] Final O");
+            serial_putchar('0' + adaptive_jit_get_profile(&ajit, fib_id)->opt_level);
+            serial_puts(": ");
             print_int((int)cycles);
             serial_puts(" cycles\n");
         }
     }
 
+    serial_puts("      Worst call: ");
+    print_int((int)worst_cycles);
+    serial_puts(" cycles, longest background compile: ");
+    print_int((int)ajit.max_compile_cycles);
+    serial_puts(" cycles\n");
+
     serial_puts("\n    ✓ Adaptive optimization complete\n\n");
 
-    // Step 3: Summary
-    serial_puts("[3] Demo Summary\n");
+    // Step 3: Value specialization (n == 20 in 95% of the calls)
+    serial_puts("[3] Value Specialization\n");
+
+    int spec_id = adaptive_jit_register_specializable(&ajit, "fibonacci_n", "demo",
+                                                      (void*)fibonacci_generic,
+                                                      MICRO_JIT_PATTERN_FIBONACCI);
+    if (spec_id < 0) {
+        serial_puts("    [ERROR] Specializable registration failed\n");
+        return;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < 150; i++) {
+        int n = (i % 20 == 19) ? 10 + (i % 7) : 20;
+        if (adaptive_jit_execute_arg(&ajit, spec_id, n) != fibonacci_generic(n)) {
+            mismatches++;
+        }
+        adaptive_jit_compile_pending(&ajit, IDLE_SLICE_CYCLES);
+    }
+
+    jit_function_entry_t* spec = &ajit.functions[spec_id];
+    if (spec->specialized) {
+        serial_puts("    ✓ Clone specialized for n = ");
+        print_int(spec->specialized_value);
+        serial_puts(", no guard failure yet\n");
+    } else if (spec->no_speculate) {
+        serial_puts("    ✓ Clone for n = ");
+        print_int(spec->specialized_value);
+        serial_puts(" deoptimized (");
+        print_int((int)spec->deopt_count);
+        serial_puts(" guard failures), generic code restored\n");
+    } else {
+        serial_puts("    [WARN] No specialization (argument not dominant)\n");
+    }
+    serial_puts(mismatches == 0 ? "    ✓ Results match generic code\n\n"
+                                : "    [ERROR] Specialized results differ from generic code\n\n");
+
+    // Step 4: Summary
+    serial_puts("[4] Demo Summary\n");
     serial_puts("    ✓ Pattern detection: fibonacci identified\n");
     serial_puts("    ✓ Micro-JIT compilation: native x86 generated\n");
-    serial_puts("    ✓ Adaptive optimization: O0→O1 triggered at 100 calls\n");
+    serial_puts("    ✓ Adaptive optimization: tier chosen by hotness vs compile cost\n");
     serial_puts("    ✓ Atomic code swapping: zero-downtime optimization\n");
+    serial_puts("    ✓ Background compile queue: tier-ups in idle slices\n");
+    serial_puts("    ✓ Value profiling: guarded clone, deopt on guard failure\n");
     serial_puts("    ✓ Performance tracking: cycle measurements captured\n\n");
 
     serial_puts("=== DEMO COMPLETE ===\n");
@@ -25,6 +25,8 @@ JITModule* jit_load_bitcode_memory(JITContext* ctx, const uint8_t* data, size_t
 void jit_unload_module(JITModule* mod);
 
 // Function lookup
+// Returns the function's indirection stub: the address stays valid and
+// follows the newest tier across jit_recompile_function
 void* jit_find_function(JITContext* ctx, const char* name);
 
 // Compilation
@@ -34,6 +36,9 @@ typedef enum {
     JIT_OPT_AGGRESSIVE = 2 // -O2/-O3
 } JITOptLevel;
 
+// Rebuild the function from its load-time bitcode (plus the bodies of its
+// callees, for inlining) at the given level, with the edge profile attached,
+// and repoint its stub at the new code. Returns 0 on success, -1 on error.
 int jit_recompile_function(JITContext* ctx, const char* name, JITOptLevel opt);
 
 // Function profiling info
@@ -53,6 +58,9 @@ typedef struct {
     uint64_t memory_used_bytes;
     uint64_t total_function_calls;
     uint64_t reoptimizations;
+    uint64_t osr_compiles;      // Loop continuations built for on-stack replacement
+    uint64_t object_cache_hits;
+    uint64_t object_cache_misses;
 } JITStats;
 
 void jit_get_stats(JITContext* ctx, JITStats* stats);
@@ -60,6 +68,65 @@ void jit_get_stats(JITContext* ctx, JITStats* stats);
 // Function profiling
 #define JIT_PROFILE_THRESHOLD 100  // Calls before auto-reoptimization
 
+// On-stack replacement
+// Every loop header in the load-time tier counts its executions. At the
+// threshold the loop is compiled (O3, from the pristine bitcode) as a
+// continuation that starts at the header, the running frame's live values
+// are copied into a state-transfer frame, and execution moves there for
+// the rest of the call. Long single-call kernels get optimized mid-run.
+// A loop whose continuation fails to build keeps its counters but stops
+// asking for one.
+#define JIT_OSR_THRESHOLD 10000    // Header executions before OSR
+
+// Applies to modules loaded afterwards; 0 disables OSR instrumentation
+void jit_set_osr_threshold(JITContext* ctx, uint64_t iterations);
+
+// Persistent object cache
+// Compiled objects are stored in 'dir' keyed by (hash of the final IR,
+// tier, cpu_tag) and reused by later runs instead of compiling. cpu_tag is
+// the CPU_PROFILE_TAG from tools/gen_cpu_profile.py, or NULL for the host
+// CPU name and features. File names are 8.3 (FAT16-safe). NULL/"" dir
+// turns caching off. Returns 0 on success, -1 on error.
+int jit_set_object_cache(JITContext* ctx, const char* dir, const char* cpu_tag);
+
+// Per-tier code generation target
+// Each tier's functions carry their own target-cpu/target-features, so the
+// optimizer's cost model and the code generator see the ISA that tier may
+// use. By default the load-time and O1 tiers stay on SSE4.2 and only the
+// O2/O3 tier gets AVX2/FMA; features the host lacks are always masked off.
+#define JIT_CPU_SSE2     (1u << 0)
+#define JIT_CPU_SSE3     (1u << 1)
+#define JIT_CPU_SSSE3    (1u << 2)
+#define JIT_CPU_SSE4_1   (1u << 3)
+#define JIT_CPU_SSE4_2   (1u << 4)
+#define JIT_CPU_POPCNT   (1u << 5)
+#define JIT_CPU_AVX      (1u << 6)   // Only reported if the OS saves YMM state
+#define JIT_CPU_AVX2     (1u << 7)
+#define JIT_CPU_FMA      (1u << 8)
+#define JIT_CPU_BMI2     (1u << 9)
+#define JIT_CPU_AVX512F  (1u << 10)  // Only reported if the OS saves ZMM state
+
+#define JIT_CPU_BASELINE_FEATURES (JIT_CPU_SSE2 | JIT_CPU_SSE3 | JIT_CPU_SSSE3 | \
+                                   JIT_CPU_SSE4_1 | JIT_CPU_SSE4_2 | JIT_CPU_POPCNT)
+#define JIT_CPU_VECTOR_FEATURES   (JIT_CPU_BASELINE_FEATURES | JIT_CPU_AVX | JIT_CPU_AVX2 | \
+                                   JIT_CPU_FMA | JIT_CPU_BMI2)
+
+// JIT_CPU_* bits of the host, from CPUID (0 on non-x86 hosts)
+uint32_t jit_probe_cpu_features(void);
+
+// Target for code compiled at 'opt' from now on: 'cpu' is an LLVM CPU name
+// (NULL/"" for the host CPU), 'features' JIT_CPU_* bits. Returns 0 on
+// success, -1 on error
+int jit_set_tier_target(JITContext* ctx, JITOptLevel opt, const char* cpu, uint32_t features);
+
+// Loop profile
+// The OSR header counters double as a trip-count profile: tiers built from
+// them get branch weights on loop exits, and innermost loops get
+// llvm.loop hints (vectorize long loops, unroll short ones). Loops that
+// already carry vectorize/unroll metadata are left alone.
+#define JIT_VECTORIZE_MIN_TRIP 16  // Average trip count that forces vectorization
+#define JIT_UNROLL_MAX_COUNT   8   // Largest unroll count given to short loops
+
 // Get info for a specific function
 int jit_get_function_info(JITContext* ctx, const char* name, JITFunctionInfo* info);
 
@@ -73,6 +140,26 @@ int jit_auto_optimize(JITContext* ctx, const char* name);
 // Record function call (for profiling)
 void jit_record_call(JITContext* ctx, const char* name, uint64_t cycles);
 
+// Call-graph edge profile
+// Modules are instrumented at load (O0) with one counter per direct call
+// site. Call sites are numbered in instruction order within the caller.
+typedef struct {
+    char caller[64];
+    char callee[64];
+    uint32_t callsite;
+    uint64_t count;
+} JITCallEdge;
+
+// List call edges, hottest first. Returns the number written, -1 on error
+int jit_get_call_edges(JITContext* ctx, JITCallEdge* edges, int max_count);
+
+// Write the loaded modules (uninstrumented, linked into one) as bitcode
+// annotated with the edge profile: function entry counts, call-site
+// weights and a profile summary, plus the loop profile (exit weights and
+// llvm.loop hints), usable by `opt -O2/-O3` as PGO data.
+// Returns 0 on success, -1 on error
+int jit_export_profiled_bitcode(JITContext* ctx, const char* path);
+
 // Error handling
 const char* jit_get_last_error(JITContext* ctx);
 
@@ -3,17 +3,46 @@
 
 #include "jit_interface.h"
 
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/DebugInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
 #include <llvm/IRReader/IRReader.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/ProfileData/ProfileCommon.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/PromoteMemToReg.h>
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <cstring>
 
@@ -28,30 +57,307 @@ struct FunctionProfile {
     uint64_t total_cycles;
     uint32_t code_size;
     JITOptLevel current_opt_level;
+    uint32_t tier_generation;               // Recompilations so far (names the bodies)
+    std::vector<ResourceTrackerSP> tiers;   // Recompiled bodies, oldest first
 
     FunctionProfile() : code_ptr(nullptr), call_count(0), total_cycles(0),
-                       code_size(0), current_opt_level(JIT_OPT_NONE) {}
+                       code_size(0), current_opt_level(JIT_OPT_NONE), tier_generation(0) {}
 };
 
+// One counter per direct call site, bumped by the O0 instrumentation.
+// Kept in a deque so the addresses published to JIT code stay valid.
+struct CallEdge {
+    std::string caller;
+    std::string callee;
+    uint32_t callsite;      // Ordinal of the call within the caller
+    uint64_t count;
+};
+
+struct JITContext;
+
+// What the instrumented header sees: its counters, then enough to find its
+// site again when it asks for the continuation
+struct OSRHook {
+    uint64_t iterations;    // Header executions
+    uint64_t entries;       // Of those, arrivals from outside the loop
+    uint64_t threshold;     // Iterations before osrEntry; UINT64_MAX once it failed
+    JITContext* ctx;
+    uint32_t site_id;
+};
+
+// One loop header in the load-time tier. The continuation is compiled on
+// first request; deque storage keeps the hook address published to the
+// instrumentation valid.
+struct OSRSite {
+    std::string function;
+    uint32_t header_index;      // Block ordinal of the loop header
+    uint32_t num_live;          // Fields in the state-transfer frame
+    OSRHook hook;
+    void* entry;                // Continuation, once compiled
+    bool failed;                // Don't retry a continuation that didn't build
+    ResourceTrackerSP tracker;
+    uint64_t osr_iterations;    // Hook counts when the continuation was requested
+    uint64_t osr_entries;
+};
+
+static void* osrEntry(OSRHook* hook);
+
+// ============================================================================
+// Persistent object cache
+// ============================================================================
+//
+// Objects are keyed by a hash of the module's final bitcode, its tier and
+// the target CPU/features, so nothing that changes codegen can hit a stale
+// entry. JIT code refers to profile counters and runtime hooks by symbol
+// (resolved per process), which keeps the IR and the hash identical from
+// one boot to the next.
+//
+// Each entry is one file, <8 hex digits>.OBJ (8.3, so the directory can be
+// on the FAT16 disk), holding the full key in front of the object; a file
+// whose key doesn't match is a miss, not a hash collision.
+
+static const char kObjectCacheMagic[4] = {'B', 'F', 'O', 'C'};
+static const uint32_t kObjectCacheVersion = 1;
+
+class DiskObjectCache : public ObjectCache {
+public:
+    std::string dir;            // Empty: caching off
+    std::string cpu_tag;
+    JITStats* stats = nullptr;
+
+    std::unique_ptr<MemoryBuffer> getObject(const Module* M) override {
+        if (dir.empty()) return nullptr;
+
+        std::string key = keyFor(*M);
+        pending_keys[M] = key;
+
+        auto file = MemoryBuffer::getFile(pathFor(key), false, false);
+        if (!file) {
+            stats->object_cache_misses++;
+            return nullptr;
+        }
+
+        StringRef data = (*file)->getBuffer();
+        size_t header = sizeof(kObjectCacheMagic) + 2 * sizeof(uint32_t);
+        uint32_t version = 0, key_len = 0;
+        if (data.size() >= header) {
+            memcpy(&version, data.data() + 4, sizeof(version));
+            memcpy(&key_len, data.data() + 8, sizeof(key_len));
+        }
+        if (data.size() < header || memcmp(data.data(), kObjectCacheMagic, 4) != 0 ||
+            version != kObjectCacheVersion || data.size() < header + key_len ||
+            data.substr(header, key_len) != key) {
+            stats->object_cache_misses++;
+            return nullptr;
+        }
+
+        stats->object_cache_hits++;
+        return MemoryBuffer::getMemBufferCopy(data.substr(header + key_len), M->getModuleIdentifier());
+    }
+
+    void notifyObjectCompiled(const Module* M, MemoryBufferRef obj) override {
+        auto it = pending_keys.find(M);
+        if (it == pending_keys.end()) return;
+        std::string key = std::move(it->second);
+        pending_keys.erase(it);
+
+        // Write aside and rename, so a crash never leaves a torn entry
+        std::string path = pathFor(key);
+        std::string tmp = path.substr(0, path.size() - 3) + "TMP";
+        std::error_code ec;
+        {
+            raw_fd_ostream out(tmp, ec, sys::fs::OF_None);
+            if (ec) return;
+            uint32_t version = kObjectCacheVersion;
+            uint32_t key_len = (uint32_t)key.size();
+            out.write(kObjectCacheMagic, sizeof(kObjectCacheMagic));
+            out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+            out.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+            out << key;
+            out << obj.getBuffer();
+        }
+        if (sys::fs::rename(tmp, path)) {
+            sys::fs::remove(tmp);
+        }
+    }
+
+private:
+    std::unordered_map<const Module*, std::string> pending_keys;  // getObject -> notify
+
+    std::string keyFor(const Module& M) const {
+        SmallVector<char, 0> buffer;
+        raw_svector_ostream os(buffer);
+        WriteBitcodeToFile(M, os);
+        uint64_t hash = xxHash64(StringRef(buffer.data(), buffer.size()));
+
+        unsigned tier = 0;
+        if (auto* flag = mdconst::extract_or_null<ConstantInt>(M.getModuleFlag("bareflow.tier"))) {
+            tier = (unsigned)flag->getZExtValue();
+        }
+
+        std::string key;
+        raw_string_ostream ks(key);
+        ks << format_hex_no_prefix(hash, 16) << ".O" << tier << "." << cpu_tag << "."
+           << M.getTargetTriple();
+        return ks.str();
+    }
+
+    std::string pathFor(const std::string& key) const {
+        SmallString<128> path(dir);
+        std::string name;
+        raw_string_ostream ns(name);
+        ns << format_hex_no_prefix((uint32_t)xxHash64(key), 8, true) << ".OBJ";
+        sys::path::append(path, ns.str());
+        return path.str().str();
+    }
+};
+
+// ============================================================================
+// Tier targets
+// ============================================================================
+//
+// The JIT's target machine describes the host. Each tier's bodies carry
+// target-cpu/target-features attributes, which LLVM resolves per function,
+// so one compiler serves every tier and the feature set of a tier is part
+// of its bitcode (and so of its object cache key).
+
+struct TierTarget {
+    std::string cpu;
+    uint32_t features;          // JIT_CPU_* bits, before masking with the host's
+};
+
+static const struct {
+    uint32_t bit;
+    const char* name;           // LLVM x86 feature
+} kTierFeatures[] = {
+    {JIT_CPU_SSE2, "sse2"},     {JIT_CPU_SSE3, "sse3"},       {JIT_CPU_SSSE3, "ssse3"},
+    {JIT_CPU_SSE4_1, "sse4.1"}, {JIT_CPU_SSE4_2, "sse4.2"},   {JIT_CPU_POPCNT, "popcnt"},
+    {JIT_CPU_AVX, "avx"},       {JIT_CPU_AVX2, "avx2"},       {JIT_CPU_FMA, "fma"},
+    {JIT_CPU_BMI2, "bmi2"},     {JIT_CPU_AVX512F, "avx512f"},
+};
+
+// Every managed feature explicitly on or off, so a tier never inherits an
+// extension from its CPU name. SSE2 is never turned off: the x86-64 ABI
+// returns floats in XMM registers.
+static std::string tierFeatureString(uint32_t features) {
+    std::string fs;
+    for (const auto& feature : kTierFeatures) {
+        bool on = (features & feature.bit) != 0;
+        if (!on && feature.bit == JIT_CPU_SSE2) continue;
+        if (!fs.empty()) fs += ',';
+        fs += on ? '+' : '-';
+        fs += feature.name;
+    }
+    return fs;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+// cpu_cpuid() of kernel_lib/cpu/features.h, plus subleaf 0 for the leaves
+// that take one
+static inline void cpu_cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx,
+                             uint32_t* ecx, uint32_t* edx) {
+    uint32_t a, b, c, d;
+    __asm__ volatile("cpuid"
+                     : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
+                     : "a"(leaf), "c"(0));
+    if (eax) *eax = a;
+    if (ebx) *ebx = b;
+    if (ecx) *ecx = c;
+    if (edx) *edx = d;
+}
+
+// XCR0: register state the OS saves on context switch
+static inline uint64_t cpu_xgetbv(void) {
+    uint32_t low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((uint64_t)high << 32) | low;
+}
+#endif
+
+static ExecutorSymbolDef runtimeSymbol(const void* addr) {
+    return ExecutorSymbolDef(ExecutorAddr::fromPtr(addr), JITSymbolFlags::Exported);
+}
+
 struct JITContext {
+    std::unique_ptr<DiskObjectCache> object_cache;               // Must outlive the JIT
     std::unique_ptr<LLJIT> jit;
     std::unique_ptr<LLVMContext> context;
     std::string last_error;
     JITStats stats;
     std::unordered_map<std::string, FunctionProfile> function_profiles;
+    std::deque<CallEdge> call_edges;
+    std::unordered_map<std::string, CallEdge*> call_edge_index;  // edgeKey()
+    std::vector<std::unique_ptr<Module>> pristine_modules;        // Uninstrumented IR for later tiers
+    std::unordered_map<std::string, size_t> defining_module;      // Function -> pristine_modules index
+    std::unique_ptr<IndirectStubsManager> stubs;                  // One stub per defined function
+    std::unique_ptr<TargetMachine> target_machine;                // Host TTI for the tier pipelines
+    std::deque<OSRSite> osr_sites;                                // Indexed by site id
+    uint64_t osr_threshold;
+    uint32_t cpu_features;                                        // JIT_CPU_* bits of the host
+    std::string host_cpu;
+    TierTarget tier_targets[JIT_OPT_AGGRESSIVE + 1];              // Indexed by JITOptLevel
 
-    JITContext() : stats{0, 0, 0, 0, 0} {
+    JITContext() : stats{0, 0, 0, 0, 0, 0, 0, 0}, osr_threshold(JIT_OSR_THRESHOLD),
+                   cpu_features(jit_probe_cpu_features()) {
         InitializeNativeTarget();
         InitializeNativeTargetAsmPrinter();
         InitializeNativeTargetAsmParser();
 
         context = std::make_unique<LLVMContext>();
+        object_cache = std::make_unique<DiskObjectCache>();
+        object_cache->stats = &stats;
 
-        auto jit_expected = LLJITBuilder().create();
+        // One host description for the compiler and the tier pipelines
+        auto jtmb = JITTargetMachineBuilder::detectHost();
+        if (!jtmb) {
+            last_error = toString(jtmb.takeError());
+            return;
+        }
+        host_cpu = jtmb->getCPU();
+        tier_targets[JIT_OPT_NONE] = {host_cpu, JIT_CPU_BASELINE_FEATURES};
+        tier_targets[JIT_OPT_BASIC] = {host_cpu, JIT_CPU_BASELINE_FEATURES};
+        tier_targets[JIT_OPT_AGGRESSIVE] = {host_cpu, JIT_CPU_VECTOR_FEATURES};
+
+        auto tm = jtmb->createTargetMachine();
+        if (tm) {
+            target_machine = std::move(*tm);
+        } else {
+            consumeError(tm.takeError());
+        }
+
+        DiskObjectCache* cache = object_cache.get();
+        auto jit_expected = LLJITBuilder()
+            .setJITTargetMachineBuilder(*jtmb)
+            .setCompileFunctionCreator([cache](JITTargetMachineBuilder jtmb)
+                    -> Expected<std::unique_ptr<IRCompileLayer::IRCompiler>> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) return tm.takeError();
+                return std::make_unique<TMOwningSimpleCompiler>(std::move(*tm), cache);
+            })
+            .create();
         if (jit_expected) {
             jit = std::move(*jit_expected);
         } else {
             last_error = toString(jit_expected.takeError());
+            return;
+        }
+
+        auto stubs_builder = createLocalIndirectStubsManagerBuilder(jit->getTargetTriple());
+        if (stubs_builder) {
+            stubs = stubs_builder();
+        }
+
+        if (!stubs) {
+            last_error = "No indirect stubs support for " + jit->getTargetTriple().str();
+            jit.reset();
+            return;
+        }
+
+        SymbolMap runtime;
+        runtime[jit->mangleAndIntern("__bareflow.osr_entry")] = runtimeSymbol((const void*)&osrEntry);
+        if (auto err = jit->getMainJITDylib().define(absoluteSymbols(std::move(runtime)))) {
+            last_error = toString(std::move(err));
+            jit.reset();
         }
     }
 };
@@ -60,6 +366,852 @@ struct JITModule {
     std::string name;
 };
 
+// ============================================================================
+// Call-graph edge profiling
+// ============================================================================
+
+static std::string edgeKey(StringRef caller, uint32_t callsite) {
+    return (caller + "#" + Twine(callsite)).str();
+}
+
+// Direct calls to real functions, in instruction order (the call-site
+// numbering shared by instrumentation and annotation)
+static std::vector<CallBase*> profiledCalls(Function& F) {
+    std::vector<CallBase*> calls;
+    for (auto& BB : F) {
+        for (auto& I : BB) {
+            auto* call = dyn_cast<CallBase>(&I);
+            if (!call) continue;
+            Function* callee = call->getCalledFunction();
+            if (callee && !callee->isIntrinsic()) {
+                calls.push_back(call);
+            }
+        }
+    }
+    return calls;
+}
+
+// Insert `++counter` before every profiled call. A plain load/add/store:
+// a lost increment under contention only costs profile precision.
+// Counters are external globals; their addresses are added to `symbols`.
+static void instrumentCallEdges(JITContext* ctx, Module& M, SymbolMap& symbols) {
+    Type* i64 = Type::getInt64Ty(M.getContext());
+
+    for (auto& F : M) {
+        if (F.isDeclaration()) continue;
+
+        std::vector<CallBase*> calls = profiledCalls(F);
+        for (uint32_t site = 0; site < calls.size(); site++) {
+            std::string key = edgeKey(F.getName(), site);
+            CallEdge*& edge = ctx->call_edge_index[key];
+            std::string symbol = "__bareflow.edge." + key;
+            if (!edge) {
+                ctx->call_edges.push_back(
+                    {F.getName().str(), calls[site]->getCalledFunction()->getName().str(), site, 0});
+                edge = &ctx->call_edges.back();
+                symbols[ctx->jit->mangleAndIntern(symbol)] = runtimeSymbol(&edge->count);
+            }
+
+            IRBuilder<> builder(calls[site]);
+            Value* addr = M.getOrInsertGlobal(symbol, i64);
+            Value* count = builder.CreateLoad(i64, addr);
+            builder.CreateStore(builder.CreateAdd(count, builder.getInt64(1)), addr);
+        }
+    }
+}
+
+// Profile summary over the edge counts, so ProfileSummaryInfo can tell
+// hot from cold call sites
+class EdgeSummaryBuilder : public ProfileSummaryBuilder {
+public:
+    EdgeSummaryBuilder() : ProfileSummaryBuilder(DefaultCutoffs) {}
+
+    void addFunction(uint64_t entry_count) {
+        NumFunctions++;
+        MaxFunctionCount = std::max(MaxFunctionCount, entry_count);
+    }
+
+    void addCallSite(uint64_t count) { addCount(count); }
+
+    std::unique_ptr<ProfileSummary> build() {
+        computeDetailedSummary();
+        return std::make_unique<ProfileSummary>(
+            ProfileSummary::PSK_Sample, DetailedSummary, TotalCount, MaxCount, 0,
+            MaxFunctionCount, NumCounts, NumFunctions);
+    }
+};
+
+// Attach the edge profile to an uninstrumented module the way a sample
+// profile loader would: entry counts on functions, total call counts as
+// branch_weights on call sites (what PSI reads for sample profiles), and a
+// module-level summary. The inliner and the hot/cold splitting in the
+// default O2/O3 pipelines use these directly.
+static void annotateEdgeProfile(const JITContext* ctx, Module& M) {
+    std::unordered_map<std::string, uint64_t> entry_counts;
+    for (const auto& edge : ctx->call_edges) {
+        entry_counts[edge.callee] += edge.count;
+    }
+    // Calls from outside the JIT code (jit_record_call)
+    for (const auto& pair : ctx->function_profiles) {
+        entry_counts[pair.first] += pair.second.call_count;
+    }
+
+    EdgeSummaryBuilder summary;
+    MDBuilder md(M.getContext());
+
+    for (auto& F : M) {
+        if (F.isDeclaration()) continue;
+
+        auto entry = entry_counts.find(F.getName().str());
+        uint64_t entry_count = entry != entry_counts.end() ? entry->second : 0;
+        F.setEntryCount(Function::ProfileCount(entry_count, Function::PCT_Real));
+        summary.addFunction(entry_count);
+
+        std::vector<CallBase*> calls = profiledCalls(F);
+        for (uint32_t site = 0; site < calls.size(); site++) {
+            auto edge = ctx->call_edge_index.find(edgeKey(F.getName(), site));
+            if (edge == ctx->call_edge_index.end()) continue;
+
+            uint64_t count = edge->second->count;
+            uint32_t weight = (uint32_t)std::min<uint64_t>(count, UINT32_MAX);
+            calls[site]->setMetadata(LLVMContext::MD_prof, md.createBranchWeights({weight}));
+            summary.addCallSite(count);
+        }
+    }
+
+    M.setProfileSummary(summary.build()->getMD(M.getContext()), ProfileSummary::PSK_Sample);
+}
+
+// ============================================================================
+// Loop trip-count profile
+// ============================================================================
+
+// Header executions and entries counted at an OSR site. Once the site has a
+// continuation, calls leave the load-time tier at the header and the hook
+// counts stop describing the loop, so the counts from that point are used.
+static void osrSiteCounts(const OSRSite& site, uint64_t& iterations, uint64_t& entries) {
+    if (site.entry) {
+        iterations = site.osr_iterations;
+        entries = site.osr_entries;
+    } else {
+        iterations = site.hook.iterations;
+        entries = site.hook.entries;
+    }
+}
+
+// Vectorize/unroll metadata already on the loop (a source pragma) wins
+static bool hasTransformHints(const Loop* loop) {
+    MDNode* id = loop->getLoopID();
+    if (!id) return false;
+    for (unsigned i = 1; i < id->getNumOperands(); i++) {
+        auto* hint = dyn_cast<MDNode>(id->getOperand(i));
+        auto* key = hint && hint->getNumOperands() ? dyn_cast<MDString>(hint->getOperand(0)) : nullptr;
+        if (key && (key->getString().starts_with("llvm.loop.vectorize.") ||
+                    key->getString().starts_with("llvm.loop.unroll."))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void addLoopHint(Loop* loop, StringRef key, Constant* value) {
+    LLVMContext& C = loop->getHeader()->getContext();
+    SmallVector<Metadata*, 4> ops{nullptr};     // Self reference
+    if (MDNode* id = loop->getLoopID()) {
+        for (unsigned i = 1; i < id->getNumOperands(); i++) {
+            ops.push_back(id->getOperand(i));
+        }
+    }
+    ops.push_back(MDNode::get(C, {MDString::get(C, key), ConstantAsMetadata::get(value)}));
+    MDNode* id = MDNode::getDistinct(C, ops);
+    id->replaceOperandWith(0, id);
+    loop->setLoopID(id);
+}
+
+// Trip counts from the OSR header counters. Every counted loop gets branch
+// weights on its exit branch, which LoopVectorize and LoopUnroll read as
+// the estimated trip count; innermost loops also get llvm.loop hints:
+// vectorize when the average trip count reaches JIT_VECTORIZE_MIN_TRIP,
+// otherwise unroll by the largest power of two it covers. Sites are found
+// by function name and header block ordinal, so `M` must still have the
+// pristine names and block order.
+static void annotateLoopProfile(const JITContext* ctx, Module& M) {
+    std::unordered_map<std::string, std::vector<const OSRSite*>> sites;
+    for (const auto& site : ctx->osr_sites) {
+        sites[site.function].push_back(&site);
+    }
+    if (sites.empty()) return;
+
+    LLVMContext& C = M.getContext();
+    MDBuilder md(C);
+    for (auto& F : M) {
+        if (F.isDeclaration()) continue;
+        auto found = sites.find(F.getName().str());
+        if (found == sites.end()) continue;
+
+        std::vector<BasicBlock*> blocks;
+        for (auto& BB : F) blocks.push_back(&BB);
+        DominatorTree dt(F);
+        LoopInfo loops(dt);
+
+        for (const OSRSite* site : found->second) {
+            if (site->header_index >= blocks.size()) continue;
+            BasicBlock* header = blocks[site->header_index];
+            Loop* loop = loops.getLoopFor(header);
+            if (!loop || loop->getHeader() != header) continue;
+
+            uint64_t iterations, entries;
+            osrSiteCounts(*site, iterations, entries);
+            if (entries == 0 || iterations < entries) continue;
+
+            // Per entry the exit branch stays iterations/entries - 1 times
+            // and leaves once, whether it tests in the header (while loop:
+            // one extra header pass) or in the latch (rotated loop)
+            BasicBlock* exiting = loop->getExitingBlock();
+            auto* branch = exiting ? dyn_cast<BranchInst>(exiting->getTerminator()) : nullptr;
+            if (branch && branch->isConditional()) {
+                uint64_t scale = (iterations >> 32) + 1;
+                uint32_t stay = (uint32_t)((iterations - entries) / scale);
+                uint32_t leave = (uint32_t)std::max<uint64_t>(entries / scale, 1);
+                bool stay_first = loop->contains(branch->getSuccessor(0));
+                branch->setMetadata(LLVMContext::MD_prof,
+                                    stay_first ? md.createBranchWeights(stay, leave)
+                                               : md.createBranchWeights(leave, stay));
+            }
+
+            if (!loop->isInnermost() || hasTransformHints(loop)) continue;
+
+            uint64_t trip = exiting == header ? (iterations - entries) / entries : iterations / entries;
+            if (trip >= JIT_VECTORIZE_MIN_TRIP) {
+                addLoopHint(loop, "llvm.loop.vectorize.enable", ConstantInt::getTrue(C));
+            } else {
+                uint32_t count = 1;
+                while (count * 2 <= trip && count * 2 <= JIT_UNROLL_MAX_COUNT) {
+                    count *= 2;
+                }
+                if (count > 1) {
+                    addLoopHint(loop, "llvm.loop.unroll.count",
+                                ConstantInt::get(Type::getInt32Ty(C), count));
+                }
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Tiered recompilation
+// ============================================================================
+//
+// Every defined function `f` is reached through an ORC indirect stub that
+// owns the symbol `f`. Bodies are named f.tier<N>: tier 0 is the
+// instrumented module as loaded, later tiers are built from the pristine
+// IR by jit_recompile_function and installed by repointing the stub, so
+// existing callers (JIT code and C function pointers alike) pick up the
+// new code on their next call.
+
+static std::string tierBodyName(StringRef name, uint32_t generation) {
+    return (name + ".tier" + Twine(generation)).str();
+}
+
+// Later tiers are separate modules and reach the original module's static
+// functions and variables by symbol, so those get unique external names
+static void promoteLocalSymbols(Module& M, size_t module_id) {
+    for (GlobalValue& gv : M.global_values()) {
+        if (!gv.hasLocalLinkage()) continue;
+        auto* fn = dyn_cast<Function>(&gv);
+        if (fn && fn->isIntrinsic()) continue;
+
+        gv.setName(gv.getName() + ".m" + Twine(module_id));
+        gv.setLinkage(GlobalValue::ExternalLinkage);
+        gv.setVisibility(GlobalValue::DefaultVisibility);
+    }
+}
+
+// Rename each body to its tier-0 name and make every reference, recursion
+// included, go through an external declaration of the original name (the
+// stub). Returns the original names.
+static std::vector<std::string> routeThroughStubs(Module& M) {
+    std::vector<Function*> bodies;
+    for (auto& F : M) {
+        if (!F.isDeclaration() && !F.isIntrinsic()) {
+            bodies.push_back(&F);
+        }
+    }
+
+    std::vector<std::string> names;
+    for (Function* body : bodies) {
+        std::string name = body->getName().str();
+        body->setName(tierBodyName(name, 0));
+
+        Function* decl = Function::Create(body->getFunctionType(), GlobalValue::ExternalLinkage,
+                                          name, &M);
+        decl->setCallingConv(body->getCallingConv());
+        // An alias must keep pointing at a definition
+        body->replaceUsesWithIf(decl, [](Use& use) { return !isa<GlobalAlias>(use.getUser()); });
+        names.push_back(name);
+    }
+    return names;
+}
+
+// Publish a stub per function, along with the module's instrumentation
+// symbols, before the module that uses them is added. The stubs start null
+// and are pointed at the tier-0 bodies once compiled.
+static bool defineStubs(JITContext* ctx, const std::vector<std::string>& names, SymbolMap symbols) {
+    for (const auto& name : names) {
+        if (ctx->defining_module.count(name)) {
+            ctx->last_error = "Duplicate definition of " + name;
+            return false;
+        }
+        if (auto err = ctx->stubs->createStub(name, ExecutorAddr(),
+                                              JITSymbolFlags::Exported | JITSymbolFlags::Callable)) {
+            ctx->last_error = toString(std::move(err));
+            return false;
+        }
+        symbols[ctx->jit->mangleAndIntern(name)] = ctx->stubs->findStub(name, true);
+    }
+
+    if (auto err = ctx->jit->getMainJITDylib().define(absoluteSymbols(std::move(symbols)))) {
+        ctx->last_error = toString(std::move(err));
+        return false;
+    }
+    return true;
+}
+
+static bool pointStub(JITContext* ctx, const std::string& name, const std::string& body) {
+    auto sym = ctx->jit->lookup(body);
+    if (!sym) {
+        ctx->last_error = toString(sym.takeError());
+        return false;
+    }
+    if (auto err = ctx->stubs->updatePointer(name, *sym)) {
+        ctx->last_error = toString(std::move(err));
+        return false;
+    }
+    return true;
+}
+
+// Copy of the pristine module holding `name`, reduced to that function
+// (renamed to its tier body) plus the bodies of everything it can reach,
+// as available_externally so the optimizer may inline them while
+// out-of-line calls still go through their stubs. Mutable globals become
+// declarations so all tiers share the tier-0 storage.
+static std::unique_ptr<Module> extractTierModule(JITContext* ctx, const std::string& name,
+                                                 const std::string& body_name,
+                                                 LLVMContext& llvm_ctx) {
+    auto owner = ctx->defining_module.find(name);
+    if (owner == ctx->defining_module.end()) {
+        ctx->last_error = "No bitcode for function " + name;
+        return nullptr;
+    }
+
+    // Bitcode round trip: the tier gets its own LLVMContext
+    SmallVector<char, 0> buffer;
+    raw_svector_ostream os(buffer);
+    WriteBitcodeToFile(*ctx->pristine_modules[owner->second], os);
+    auto parsed = parseBitcodeFile(MemoryBufferRef(StringRef(buffer.data(), buffer.size()), name),
+                                   llvm_ctx);
+    if (!parsed) {
+        ctx->last_error = toString(parsed.takeError());
+        return nullptr;
+    }
+    std::unique_ptr<Module> M = std::move(*parsed);
+
+    Function* target = M->getFunction(name);
+    std::unordered_set<Function*> reachable;
+    std::vector<Function*> worklist{target};
+    while (!worklist.empty()) {
+        Function* F = worklist.back();
+        worklist.pop_back();
+        if (!reachable.insert(F).second) continue;
+        for (CallBase* call : profiledCalls(*F)) {
+            if (!call->getCalledFunction()->isDeclaration()) {
+                worklist.push_back(call->getCalledFunction());
+            }
+        }
+    }
+
+    for (auto& F : *M) {
+        if (F.isDeclaration()) continue;
+
+        // -O0 bitcode carries optnone/noinline; a tier exists to optimize
+        if (F.hasFnAttribute(Attribute::OptimizeNone)) {
+            F.removeFnAttr(Attribute::OptimizeNone);
+            F.removeFnAttr(Attribute::NoInline);
+        }
+
+        F.setComdat(nullptr);
+        if (&F == target) {
+            F.setLinkage(GlobalValue::ExternalLinkage);
+        } else if (reachable.count(&F)) {
+            F.setLinkage(GlobalValue::AvailableExternallyLinkage);
+        } else {
+            F.deleteBody();
+        }
+    }
+
+    for (auto& gv : M->globals()) {
+        if (gv.isDeclaration()) continue;
+        gv.setComdat(nullptr);
+        if (gv.isConstant()) {
+            gv.setLinkage(GlobalValue::AvailableExternallyLinkage);   // Still foldable
+        } else {
+            gv.setInitializer(nullptr);
+            gv.setLinkage(GlobalValue::ExternalLinkage);
+        }
+    }
+
+    for (auto it = M->alias_begin(); it != M->alias_end();) {
+        GlobalAlias& alias = *it++;
+        GlobalValue* decl;
+        if (isa<FunctionType>(alias.getValueType())) {
+            decl = Function::Create(cast<FunctionType>(alias.getValueType()),
+                                    GlobalValue::ExternalLinkage, "", M.get());
+        } else {
+            decl = new GlobalVariable(*M, alias.getValueType(), false,
+                                      GlobalValue::ExternalLinkage, nullptr);
+        }
+        decl->takeName(&alias);
+        alias.replaceAllUsesWith(decl);
+        alias.eraseFromParent();
+    }
+
+    // Profile is keyed by the original names, so annotate before renaming
+    annotateEdgeProfile(ctx, *M);
+    annotateLoopProfile(ctx, *M);
+    target->setName(body_name);
+
+    M->setDataLayout(ctx->jit->getDataLayout());
+    M->setTargetTriple(ctx->jit->getTargetTriple().str());
+    return M;
+}
+
+// Recorded in the module so the object cache key names the tier
+static void setTierFlag(Module& M, JITOptLevel opt) {
+    M.setModuleFlag(Module::Warning, "bareflow.tier",
+                    ConstantAsMetadata::get(ConstantInt::get(Type::getInt32Ty(M.getContext()), opt)));
+}
+
+// Stamp the tier's CPU and features on every body, callees kept for
+// inlining included (the inliner wants matching features)
+static void applyTierTarget(const JITContext* ctx, Module& M, JITOptLevel opt) {
+    if (!ctx->cpu_features) return;     // Not x86: the host defaults stand
+
+    const TierTarget& target = ctx->tier_targets[opt];
+    std::string features = tierFeatureString(target.features & ctx->cpu_features);
+    for (auto& F : M) {
+        if (F.isDeclaration()) continue;
+        F.addFnAttr("target-cpu", target.cpu);
+        F.addFnAttr("target-features", features);
+    }
+}
+
+static void optimizeTierModule(JITContext* ctx, Module& M, JITOptLevel opt) {
+    // Before the pipeline, so the vectorizer's cost model sees the tier's ISA
+    applyTierTarget(ctx, M, opt);
+
+    LoopAnalysisManager LAM;
+    FunctionAnalysisManager FAM;
+    CGSCCAnalysisManager CGAM;
+    ModuleAnalysisManager MAM;
+
+    PassBuilder PB(ctx->target_machine.get());
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    ModulePassManager MPM;
+    if (opt == JIT_OPT_NONE) {
+        MPM = PB.buildO0DefaultPipeline(OptimizationLevel::O0);
+    } else {
+        MPM = PB.buildPerModuleDefaultPipeline(
+            opt == JIT_OPT_BASIC ? OptimizationLevel::O1 : OptimizationLevel::O3);
+    }
+
+    MPM.run(M, MAM);
+    setTierFlag(M, opt);
+}
+
+// ============================================================================
+// On-stack replacement
+// ============================================================================
+//
+// The continuation for a loop is a clone of the blocks reachable from its
+// header, entered through a new block that reloads the header's live-in
+// values from a frame struct. The load-time tier fills that struct and
+// calls the continuation in place of running the rest of the loop.
+// Both sides compute the live-in list with osrLiveIns() on the same
+// (pristine or count-only instrumented) IR, so the field order matches.
+
+struct OSRLiveIns {
+    std::vector<Value*> values;
+    std::vector<bool> by_value;     // Promotable alloca: transfer contents, not address
+};
+
+// Blocks the continuation can execute: everything reachable from the header
+static std::unordered_set<BasicBlock*> osrRegion(BasicBlock* header) {
+    std::unordered_set<BasicBlock*> region;
+    std::vector<BasicBlock*> worklist{header};
+    while (!worklist.empty()) {
+        BasicBlock* BB = worklist.back();
+        worklist.pop_back();
+        if (!region.insert(BB).second) continue;
+        for (BasicBlock* succ : successors(BB)) {
+            worklist.push_back(succ);
+        }
+    }
+    return region;
+}
+
+// Header phis, then every argument or outside-region instruction used in
+// the region (such a definition dominates the header), in function order
+static OSRLiveIns osrLiveIns(Function& F, BasicBlock* header,
+                             const std::unordered_set<BasicBlock*>& region) {
+    std::unordered_set<Value*> used;
+    for (BasicBlock* BB : region) {
+        for (Instruction& I : *BB) {
+            auto* phi = dyn_cast<PHINode>(&I);
+            for (unsigned op = 0; op < I.getNumOperands(); op++) {
+                // Edges from outside the region are never taken by the continuation
+                if (phi && !region.count(phi->getIncomingBlock(op))) continue;
+                used.insert(I.getOperand(op));
+            }
+        }
+    }
+
+    OSRLiveIns live;
+    auto add = [&](Value* V) {
+        auto* alloca = dyn_cast<AllocaInst>(V);
+        live.values.push_back(V);
+        live.by_value.push_back(alloca && alloca->isStaticAlloca() &&
+                                alloca->getAllocatedType()->isSingleValueType() &&
+                                isAllocaPromotable(alloca));
+    };
+
+    for (PHINode& phi : header->phis()) {
+        add(&phi);
+    }
+    for (Argument& arg : F.args()) {
+        if (used.count(&arg)) add(&arg);
+    }
+    for (BasicBlock& BB : F) {
+        if (region.count(&BB)) continue;
+        for (Instruction& I : BB) {
+            if (used.count(&I)) add(&I);
+        }
+    }
+    return live;
+}
+
+static StructType* osrFrameType(LLVMContext& C, const OSRLiveIns& live) {
+    std::vector<Type*> fields;
+    for (size_t i = 0; i < live.values.size(); i++) {
+        auto* alloca = dyn_cast<AllocaInst>(live.values[i]);
+        fields.push_back(live.by_value[i] ? alloca->getAllocatedType() : live.values[i]->getType());
+    }
+    return StructType::get(C, fields);
+}
+
+// Loops we can leave mid-run: no EH, no varargs, nothing but first-class
+// values crossing the header
+static bool osrEligible(Function& F, const OSRLiveIns& live) {
+    if (F.isVarArg() || F.hasPersonalityFn()) return false;
+    for (Value* V : live.values) {
+        if (!V->getType()->isFirstClassType() || V->getType()->isTokenTy()) return false;
+    }
+    return true;
+}
+
+// Count header executions (and entries into the loop, for the trip-count
+// profile) and, past the threshold, hand the live state to the continuation:
+//
+//   header:    phis; entering = phi [1, outside preds], [0, latches]
+//              ++hook.iterations; hook.entries += entering
+//              br (iterations >= hook.threshold), osr.check, rest
+//   osr.check: entry = osrEntry(&hook); br entry, osr.transfer, rest
+//   osr.transfer: frame = {live...}; ret entry(&frame)
+//
+// Each hook is an external global named after its function and header
+// (typed as its two counters and threshold); the addresses are added to
+// `symbols`.
+static void instrumentOSR(JITContext* ctx, Module& M, SymbolMap& symbols) {
+    if (ctx->osr_threshold == 0) return;
+
+    LLVMContext& C = M.getContext();
+    Type* i64 = Type::getInt64Ty(C);
+    StructType* hook_type = StructType::get(C, {i64, i64, i64});
+    PointerType* byte_ptr = PointerType::getUnqual(Type::getInt8Ty(C));
+    FunctionType* entry_type = FunctionType::get(byte_ptr, {PointerType::getUnqual(hook_type)}, false);
+    FunctionCallee osr_entry = M.getOrInsertFunction("__bareflow.osr_entry", entry_type);
+
+    for (auto& F : M) {
+        if (F.isDeclaration()) continue;
+
+        // Collect every site first: splitting headers renumbers the blocks
+        struct Pending { BasicBlock* header; uint32_t index; OSRLiveIns live;
+                         SmallVector<BasicBlock*, 2> latches; };
+        std::vector<Pending> pending;
+        {
+            DominatorTree dt(F);
+            LoopInfo loops(dt);
+            std::unordered_map<BasicBlock*, uint32_t> index;
+            uint32_t n = 0;
+            for (auto& BB : F) index[&BB] = n++;
+
+            for (Loop* loop : loops.getLoopsInPreorder()) {
+                BasicBlock* header = loop->getHeader();
+                OSRLiveIns live = osrLiveIns(F, header, osrRegion(header));
+                if (osrEligible(F, live)) {
+                    pending.push_back({header, index[header], std::move(live), {}});
+                    loop->getLoopLatches(pending.back().latches);
+                }
+            }
+        }
+
+        for (auto& site : pending) {
+            uint32_t site_id = (uint32_t)ctx->osr_sites.size();
+            ctx->osr_sites.push_back({F.getName().str(), site.index, (uint32_t)site.live.values.size(),
+                                      {0, 0, ctx->osr_threshold, ctx, site_id}, nullptr, false, nullptr, 0, 0});
+            std::string symbol = (Twine("__bareflow.osr.") + F.getName() + "." + Twine(site.index)).str();
+            symbols[ctx->jit->mangleAndIntern(symbol)] = runtimeSymbol(&ctx->osr_sites.back().hook);
+
+            StructType* frame_type = osrFrameType(C, site.live);
+            FunctionType* cont_type = FunctionType::get(F.getReturnType(),
+                                                        {PointerType::getUnqual(frame_type)}, false);
+
+            // The header's terminator moves to `rest`, so a header that was
+            // its own latch now reaches itself through `rest`
+            BasicBlock* rest = SplitBlock(site.header, site.header->getFirstNonPHI());
+            std::replace(site.latches.begin(), site.latches.end(), site.header, rest);
+            BasicBlock* check = BasicBlock::Create(C, "osr.check", &F);
+            BasicBlock* transfer = BasicBlock::Create(C, "osr.transfer", &F);
+
+            site.header->getTerminator()->eraseFromParent();
+            PHINode* entering = PHINode::Create(i64, 2, "osr.entering", &site.header->front());
+            for (BasicBlock* pred : predecessors(site.header)) {
+                bool latch = std::find(site.latches.begin(), site.latches.end(), pred) != site.latches.end();
+                entering->addIncoming(ConstantInt::get(i64, latch ? 0 : 1), pred);
+            }
+
+            IRBuilder<> builder(site.header);
+            Value* addr = M.getOrInsertGlobal(symbol, hook_type);
+            Value* count = builder.CreateAdd(builder.CreateLoad(i64, addr), builder.getInt64(1));
+            builder.CreateStore(count, addr);
+            Value* entries = builder.CreateStructGEP(hook_type, addr, 1);
+            builder.CreateStore(builder.CreateAdd(builder.CreateLoad(i64, entries), entering), entries);
+            Value* threshold = builder.CreateLoad(i64, builder.CreateStructGEP(hook_type, addr, 2));
+            builder.CreateCondBr(builder.CreateICmpUGE(count, threshold), check, rest);
+
+            builder.SetInsertPoint(check);
+            Value* entry = builder.CreateCall(osr_entry, {addr});
+            builder.CreateCondBr(builder.CreateIsNotNull(entry), transfer, rest);
+
+            // Frame lives in the entry block so looping doesn't grow the stack
+            IRBuilder<> entry_builder(&*F.getEntryBlock().getFirstInsertionPt());
+            Value* frame = entry_builder.CreateAlloca(frame_type, nullptr, "osr.frame");
+
+            builder.SetInsertPoint(transfer);
+            for (size_t i = 0; i < site.live.values.size(); i++) {
+                Value* V = site.live.values[i];
+                if (site.live.by_value[i]) {
+                    V = builder.CreateLoad(frame_type->getElementType(i), V);
+                }
+                builder.CreateStore(V, builder.CreateStructGEP(frame_type, frame, (unsigned)i));
+            }
+            Value* cont = builder.CreateBitCast(entry, PointerType::getUnqual(cont_type));
+            CallInst* result = builder.CreateCall(cont_type, cont, {frame});
+            if (F.getReturnType()->isVoidTy()) {
+                builder.CreateRetVoid();
+            } else {
+                builder.CreateRet(result);
+            }
+        }
+    }
+}
+
+// Clone the region of `F` reachable from its header_index-th block into a
+// new function taking the state-transfer frame
+static Function* buildOSRContinuation(Function& F, const OSRSite& site, const std::string& name) {
+    if (site.header_index >= F.size()) return nullptr;
+    BasicBlock* header = &*std::next(F.begin(), site.header_index);
+
+    std::unordered_set<BasicBlock*> region = osrRegion(header);
+    OSRLiveIns live = osrLiveIns(F, header, region);
+    if (live.values.size() != site.num_live || !osrEligible(F, live)) {
+        return nullptr;     // IR no longer matches what was instrumented
+    }
+
+    LLVMContext& C = F.getContext();
+    StructType* frame_type = osrFrameType(C, live);
+    FunctionType* cont_type = FunctionType::get(F.getReturnType(),
+                                                {PointerType::getUnqual(frame_type)}, false);
+    Function* cont = Function::Create(cont_type, GlobalValue::ExternalLinkage, name, F.getParent());
+    for (const Attribute& attr : F.getAttributes().getFnAttrs()) {
+        if (attr.isStringAttribute()) cont->addFnAttr(attr);   // target-cpu and friends
+    }
+
+    // Reload the live state; promotable allocas get fresh slots that mem2reg
+    // can lift, everything else keeps pointing into the suspended frame
+    BasicBlock* osr_entry = BasicBlock::Create(C, "osr.entry", cont);
+    IRBuilder<> builder(osr_entry);
+    ValueToValueMapTy vmap;
+    std::vector<Value*> header_values;
+    for (size_t i = 0; i < live.values.size(); i++) {
+        Value* field = builder.CreateLoad(frame_type->getElementType(i),
+                                          builder.CreateStructGEP(frame_type, cont->getArg(0), (unsigned)i));
+        Value* V = live.values[i];
+        if (live.by_value[i]) {
+            Value* slot = builder.CreateAlloca(frame_type->getElementType(i));
+            builder.CreateStore(field, slot);
+            field = slot;
+        }
+        if (isa<PHINode>(V) && cast<PHINode>(V)->getParent() == header) {
+            header_values.push_back(field);
+        } else {
+            vmap[V] = field;
+        }
+    }
+    for (Argument& arg : F.args()) {
+        if (!vmap.count(&arg)) vmap[&arg] = PoisonValue::get(arg.getType());
+    }
+
+    // Region blocks in function order, so the clone keeps the original layout
+    SmallVector<BasicBlock*, 16> cloned;
+    for (BasicBlock& BB : F) {
+        if (!region.count(&BB)) continue;
+        BasicBlock* copy = CloneBasicBlock(&BB, vmap, "", cont);
+        vmap[&BB] = copy;
+        cloned.push_back(copy);
+
+        for (PHINode& phi : copy->phis()) {
+            for (int i = (int)phi.getNumIncomingValues() - 1; i >= 0; i--) {
+                if (!region.count(phi.getIncomingBlock(i))) {
+                    phi.removeIncomingValue(i, false);
+                }
+            }
+        }
+    }
+    builder.CreateBr(cast<BasicBlock>(vmap[header]));
+    remapInstructionsInBlocks(cloned, vmap);
+
+    BasicBlock* cloned_header = cast<BasicBlock>(vmap[header]);
+    size_t phi_index = 0;
+    for (PHINode& phi : cloned_header->phis()) {
+        phi.addIncoming(header_values[phi_index++], osr_entry);
+    }
+
+    // Locations still point at F's subprogram
+    stripDebugInfo(*cont);
+    return cont;
+}
+
+// Called from the load-time tier once a header passes the threshold.
+// Returns the continuation, or null to keep running the current code.
+static void* osrEntry(OSRHook* hook) {
+    JITContext* ctx = hook->ctx;
+    uint32_t site_id = hook->site_id;
+    OSRSite& site = ctx->osr_sites[site_id];
+    if (site.entry || site.failed) {
+        return site.entry;
+    }
+    // Until proven otherwise. Raising the threshold also stops re-entry and,
+    // if the build fails, keeps the header from calling in on every pass.
+    site.failed = true;
+    uint64_t threshold = site.hook.threshold;
+    site.hook.threshold = UINT64_MAX;
+    site.osr_iterations = site.hook.iterations;
+    site.osr_entries = site.hook.entries;
+
+    auto start = std::chrono::steady_clock::now();
+    std::string cont_name = (site.function + ".osr" + Twine(site_id)).str();
+
+    auto llvm_ctx = std::make_unique<LLVMContext>();
+    std::unique_ptr<Module> M = extractTierModule(ctx, site.function, cont_name + ".src", *llvm_ctx);
+    if (!M) {
+        return nullptr;
+    }
+
+    Function* body = M->getFunction(cont_name + ".src");
+    if (!buildOSRContinuation(*body, site, cont_name)) {
+        ctx->last_error = "OSR continuation for " + site.function + " did not build";
+        return nullptr;
+    }
+
+    // Only the continuation is new code; re-entry into the function itself
+    // (recursion, calls from inlined callees) goes through its stub
+    Function* stub = Function::Create(body->getFunctionType(), GlobalValue::ExternalLinkage,
+                                      site.function, M.get());
+    stub->setCallingConv(body->getCallingConv());
+    body->replaceAllUsesWith(stub);
+    body->eraseFromParent();
+
+    optimizeTierModule(ctx, *M, JIT_OPT_AGGRESSIVE);
+    if (verifyModule(*M, &errs())) {
+        ctx->last_error = "OSR module failed verification";
+        return nullptr;
+    }
+
+    ResourceTrackerSP tracker = ctx->jit->getMainJITDylib().createResourceTracker();
+    if (auto err = ctx->jit->addIRModule(tracker, ThreadSafeModule(std::move(M), std::move(llvm_ctx)))) {
+        ctx->last_error = toString(std::move(err));
+        return nullptr;
+    }
+    auto sym = ctx->jit->lookup(cont_name);
+    if (!sym) {
+        ctx->last_error = toString(sym.takeError());
+        consumeError(tracker->remove());
+        return nullptr;
+    }
+
+    site.entry = sym->toPtr<void*>();
+    site.tracker = tracker;
+    site.failed = false;
+    site.hook.threshold = threshold;    // Later calls transfer straight away
+
+    ctx->stats.osr_compiles++;
+    ctx->stats.total_compile_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return site.entry;
+}
+
+// Keep an uninstrumented copy for later tiers, then add the instrumented
+// module to the JIT behind per-function stubs
+static bool addInstrumentedModule(JITContext* ctx, std::unique_ptr<Module> module) {
+    size_t module_id = ctx->pristine_modules.size();
+    promoteLocalSymbols(*module, module_id);
+    ctx->pristine_modules.push_back(CloneModule(*module));
+    SymbolMap symbols;
+    instrumentCallEdges(ctx, *module, symbols);
+    instrumentOSR(ctx, *module, symbols);
+    applyTierTarget(ctx, *module, JIT_OPT_NONE);
+    setTierFlag(*module, JIT_OPT_NONE);
+
+    std::vector<std::string> names = routeThroughStubs(*module);
+    if (!defineStubs(ctx, names, std::move(symbols))) {
+        ctx->pristine_modules.pop_back();
+        return false;
+    }
+
+    auto tsm = ThreadSafeModule(std::move(module), std::make_unique<LLVMContext>());
+    auto add_err = ctx->jit->addIRModule(std::move(tsm));
+    if (add_err) {
+        ctx->pristine_modules.pop_back();
+        ctx->last_error = toString(std::move(add_err));
+        return false;
+    }
+
+    for (const auto& name : names) {
+        if (!pointStub(ctx, name, tierBodyName(name, 0))) {
+            return false;
+        }
+        ctx->defining_module[name] = module_id;
+    }
+
+    ctx->stats.functions_compiled++;
+    return true;
+}
+
 extern "C" {
 
 JITContext* jit_create(void) {
@@ -82,15 +1234,10 @@ JITModule* jit_load_bitcode(JITContext* ctx, const char* path) {
         return nullptr;
     }
     
-    auto tsm = ThreadSafeModule(std::move(module), std::make_unique<LLVMContext>());
-    auto add_err = ctx->jit->addIRModule(std::move(tsm));
-    if (add_err) {
-        ctx->last_error = toString(std::move(add_err));
+    if (!addInstrumentedModule(ctx, std::move(module))) {
         return nullptr;
     }
     
-    ctx->stats.functions_compiled++;
-    
     auto mod = new JITModule();
     mod->name = path;
     return mod;
@@ -114,15 +1261,10 @@ JITModule* jit_load_bitcode_memory(JITContext* ctx, const uint8_t* data, size_t
         return nullptr;
     }
     
-    auto tsm = ThreadSafeModule(std::move(module), std::make_unique<LLVMContext>());
-    auto add_err = ctx->jit->addIRModule(std::move(tsm));
-    if (add_err) {
-        ctx->last_error = toString(std::move(add_err));
+    if (!addInstrumentedModule(ctx, std::move(module))) {
         return nullptr;
     }
     
-    ctx->stats.functions_compiled++;
-    
     auto mod = new JITModule();
     mod->name = "<memory>";
     return mod;
@@ -158,24 +1300,156 @@ void* jit_find_function(JITContext* ctx, const char* name) {
 }
 
 int jit_recompile_function(JITContext* ctx, const char* name, JITOptLevel opt) {
+    if (!ctx || !ctx->jit || !name) {
+        if (ctx) ctx->last_error = "Invalid JIT context";
+        return -1;
+    }
+
+    // Checked before touching the profiles so a bad name leaves no entry
+    if (!ctx->defining_module.count(name)) {
+        ctx->last_error = std::string("No bitcode for function ") + name;
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    FunctionProfile& profile = ctx->function_profiles[name];
+    if (profile.name.empty()) {
+        profile.name = name;
+        profile.code_ptr = ctx->stubs->findStub(name, true).getAddress().toPtr<void*>();
+    }
+
+    uint32_t generation = profile.tier_generation + 1;
+    auto llvm_ctx = std::make_unique<LLVMContext>();
+    std::unique_ptr<Module> M = extractTierModule(ctx, name, tierBodyName(name, generation),
+                                                  *llvm_ctx);
+    if (!M) {
+        return -1;
+    }
+
+    optimizeTierModule(ctx, *M, opt);
+    if (verifyModule(*M, &errs())) {
+        ctx->last_error = "Recompiled module failed verification";
+        return -1;
+    }
+
+    // Own tracker per tier. Superseded tiers are kept: a caller may still be
+    // running the old body when the stub is repointed.
+    ResourceTrackerSP tracker = ctx->jit->getMainJITDylib().createResourceTracker();
+    if (auto err = ctx->jit->addIRModule(tracker, ThreadSafeModule(std::move(M), std::move(llvm_ctx)))) {
+        ctx->last_error = toString(std::move(err));
+        return -1;
+    }
+    if (!pointStub(ctx, name, tierBodyName(name, generation))) {
+        consumeError(tracker->remove());
+        return -1;
+    }
+
+    profile.tier_generation = generation;
+    profile.tiers.push_back(tracker);
+    profile.current_opt_level = opt;
+
+    ctx->stats.functions_compiled++;
+    ctx->stats.reoptimizations++;
+    ctx->stats.total_compile_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+int jit_set_object_cache(JITContext* ctx, const char* dir, const char* cpu_tag) {
     if (!ctx || !ctx->jit) {
         if (ctx) ctx->last_error = "Invalid JIT context";
         return -1;
     }
 
-    // Update optimization level in profile
-    auto it = ctx->function_profiles.find(name);
-    if (it != ctx->function_profiles.end()) {
-        it->second.current_opt_level = opt;
-        ctx->stats.reoptimizations++;
+    if (!dir || !*dir) {
+        ctx->object_cache->dir.clear();
+        return 0;
+    }
+
+    if (auto ec = sys::fs::create_directories(dir)) {
+        ctx->last_error = std::string("Object cache: ") + dir + ": " + ec.message();
+        return -1;
+    }
+
+    ctx->object_cache->dir = dir;
+    if (cpu_tag && *cpu_tag) {
+        ctx->object_cache->cpu_tag = cpu_tag;
+    } else if (ctx->target_machine) {
+        ctx->object_cache->cpu_tag = (ctx->target_machine->getTargetCPU() + ":" +
+                                      ctx->target_machine->getTargetFeatureString()).str();
+    } else {
+        // No host TargetMachine: the probed JIT_CPU_* bits still tell CPUs apart
+        std::string tag;
+        raw_string_ostream ts(tag);
+        ts << ctx->host_cpu << ":" << format_hex_no_prefix(ctx->cpu_features, 8);
+        ctx->object_cache->cpu_tag = ts.str();
+    }
+    return 0;
+}
+
+uint32_t jit_probe_cpu_features(void) {
+#if defined(__i386__) || defined(__x86_64__)
+    uint32_t max_leaf, ebx, ecx, edx;
+    cpu_cpuid(0, &max_leaf, nullptr, nullptr, nullptr);
+    if (max_leaf < 1) return 0;
+
+    uint32_t features = 0;
+    cpu_cpuid(1, nullptr, nullptr, &ecx, &edx);
+    if (edx & (1u << 26)) features |= JIT_CPU_SSE2;
+    if (ecx & (1u << 0))  features |= JIT_CPU_SSE3;
+    if (ecx & (1u << 9))  features |= JIT_CPU_SSSE3;
+    if (ecx & (1u << 19)) features |= JIT_CPU_SSE4_1;
+    if (ecx & (1u << 20)) features |= JIT_CPU_SSE4_2;
+    if (ecx & (1u << 23)) features |= JIT_CPU_POPCNT;
+
+    // AVX needs the OS to save YMM (XCR0 bits 1-2), AVX-512 also opmask and ZMM (bits 5-7)
+    uint64_t xcr0 = (ecx & (1u << 27)) ? cpu_xgetbv() : 0;
+    bool ymm = (ecx & (1u << 28)) && (xcr0 & 0x06) == 0x06;
+    bool zmm = ymm && (xcr0 & 0xe0) == 0xe0;
+    if (ymm) {
+        features |= JIT_CPU_AVX;
+        if (ecx & (1u << 12)) features |= JIT_CPU_FMA;
+    }
+
+    if (max_leaf >= 7) {
+        cpu_cpuid(7, nullptr, &ebx, nullptr, nullptr);
+        if (ymm && (ebx & (1u << 5))) features |= JIT_CPU_AVX2;
+        if (ebx & (1u << 8))          features |= JIT_CPU_BMI2;
+        if (zmm && (ebx & (1u << 16))) features |= JIT_CPU_AVX512F;
+    }
+    return features;
+#else
+    return 0;
+#endif
+}
+
+int jit_set_tier_target(JITContext* ctx, JITOptLevel opt, const char* cpu, uint32_t features) {
+    if (!ctx || !ctx->jit) {
+        if (ctx) ctx->last_error = "Invalid JIT context";
+        return -1;
+    }
+    if (opt < JIT_OPT_NONE || opt > JIT_OPT_AGGRESSIVE) {
+        ctx->last_error = "Invalid optimization level";
+        return -1;
+    }
+
+    std::string name = cpu && *cpu ? cpu : ctx->host_cpu;
+    if (ctx->target_machine && !ctx->target_machine->getMCSubtargetInfo()->isCPUStringValid(name)) {
+        ctx->last_error = "Unknown target CPU " + name;
+        return -1;
     }
 
-    // Note: True recompilation with different optimization levels would require
-    // reloading the module with LLVM optimization passes applied.
-    // For now, we track the optimization intent for future implementation.
+    ctx->tier_targets[opt] = {name, features};
     return 0;
 }
 
+void jit_set_osr_threshold(JITContext* ctx, uint64_t iterations) {
+    if (ctx) {
+        ctx->osr_threshold = iterations;
+    }
+}
+
 void jit_get_stats(JITContext* ctx, JITStats* stats) {
     if (ctx && stats) {
         *stats = ctx->stats;
@@ -273,11 +1547,71 @@ int jit_auto_optimize(JITContext* ctx, const char* name) {
 
         // Only recompile if optimization level changed
         if (new_level != profile.current_opt_level) {
-            return jit_recompile_function(ctx, name, new_level);
+            return jit_recompile_function(ctx, name, new_level) == 0 ? 1 : -1;
         }
     }
 
     return 0; // No reoptimization needed
 }
 
-} // extern "C"
\ No newline at end of file
+int jit_get_call_edges(JITContext* ctx, JITCallEdge* edges, int max_count) {
+    if (!ctx || !edges || max_count <= 0) {
+        return -1;
+    }
+
+    std::vector<const CallEdge*> sorted;
+    for (const auto& edge : ctx->call_edges) {
+        sorted.push_back(&edge);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const CallEdge* a, const CallEdge* b) { return a->count > b->count; });
+
+    int count = 0;
+    for (const CallEdge* edge : sorted) {
+        if (count >= max_count) break;
+
+        JITCallEdge& out = edges[count++];
+        strncpy(out.caller, edge->caller.c_str(), sizeof(out.caller) - 1);
+        out.caller[sizeof(out.caller) - 1] = '\0';
+        strncpy(out.callee, edge->callee.c_str(), sizeof(out.callee) - 1);
+        out.callee[sizeof(out.callee) - 1] = '\0';
+        out.callsite = edge->callsite;
+        out.count = edge->count;
+    }
+
+    return count;
+}
+
+int jit_export_profiled_bitcode(JITContext* ctx, const char* path) {
+    if (!ctx || !path) {
+        if (ctx) ctx->last_error = "Invalid arguments";
+        return -1;
+    }
+    if (ctx->pristine_modules.empty()) {
+        ctx->last_error = "No modules loaded";
+        return -1;
+    }
+
+    auto merged = CloneModule(*ctx->pristine_modules[0]);
+    Linker linker(*merged);
+    for (size_t i = 1; i < ctx->pristine_modules.size(); i++) {
+        if (linker.linkInModule(CloneModule(*ctx->pristine_modules[i]))) {
+            ctx->last_error = "Failed to link modules for export";
+            return -1;
+        }
+    }
+
+    annotateEdgeProfile(ctx, *merged);
+    annotateLoopProfile(ctx, *merged);
+
+    std::error_code ec;
+    raw_fd_ostream out(path, ec, sys::fs::OF_None);
+    if (ec) {
+        ctx->last_error = ec.message();
+        return -1;
+    }
+    WriteBitcodeToFile(*merged, out);
+    return 0;
+}
+
+} // extern "C"
@@ -15,15 +15,23 @@
 #include "cxx_runtime.h"
 #include "cxx_test.h"
 #include "jit_allocator_test.h"
+#include "baseline_jit_test.h"
+#include "tier_policy_test.h"
+#include "adaptive_jit_test.h"
 #include "profiling_export.h"
+#include "profile_stream.h"
 #include "fat16_test.h"
 #include "disk_module_loader.h"
 #include "micro_jit.h"
 #include "jit_allocator.h"
+#include "paging.h"
 #include "adaptive_jit.h"
 #include "jit_demo.h"
 #include "elf_test.h"
 #include "llvm_test.h"
+#include "idt.h"
+#include "pic.h"
+#include "sample_profiler.h"
 
 // Forward declarations
 extern void* malloc(size_t size);
@@ -134,9 +142,92 @@ void print_system_info(void) {
     terminal_writestring("\n");
 }
 
+// ============================================================================
+// CONTINUOUS PROFILING (build with CONTINUOUS=1)
+// ============================================================================
+#ifdef CONTINUOUS_PROFILING
+#ifndef CONTINUOUS_PERIOD_MS
+#define CONTINUOUS_PERIOD_MS PROFILE_STREAM_DEFAULT_MS
+#endif
+
+// Steady-state workload: run every loaded module forever and export one
+// delta frame per epoch, so PGO sees the workload after warm-up
+static void run_continuous_profiling(module_manager_t* mgr) {
+    if (profile_stream_start(mgr, CONTINUOUS_PERIOD_MS) != 0) {
+        vga_print_color("[STREAM] Cannot start (TSC uncalibrated or out of memory)\n",
+                        VGA_RED, VGA_BLACK);
+        return;
+    }
+
+    terminal_writestring("[STREAM] Continuous profiling, one delta every ");
+    print_int(CONTINUOUS_PERIOD_MS);
+    terminal_writestring(" ms\n");
+
+    while (1) {
+        for (uint32_t i = 0; i < mgr->num_modules; i++) {
+            if (mgr->modules[i].loaded) {
+                module_execute(mgr, mgr->modules[i].name);
+            }
+            profile_stream_poll();
+        }
+    }
+}
+#endif
+
+// ============================================================================
+// SAMPLING PROFILER
+// ============================================================================
+
+// Install the IDT with every PIC line masked, so the LAPIC timer is the
+// only interrupt source, and sample the workload that follows
+static int g_sampling = 0;
+
+static void start_sampling(void) {
+    pic_init();
+    idt_init();
+
+    if (sample_profiler_init() != 0) {
+        serial_puts("[SAMPLE] No local APIC, sampling disabled\n");
+        return;
+    }
+    if (sample_profiler_start(SAMPLE_DEFAULT_HZ) != 0) {
+        serial_puts("[SAMPLE] Cannot start LAPIC timer\n");
+        return;
+    }
+
+    g_sampling = 1;
+    asm volatile("sti");
+}
+
+static void finish_sampling(void) {
+    if (!g_sampling) return;
+
+    asm volatile("cli");
+    sample_profiler_stop();
+    sample_profiler_export_json();
+}
+
 // ============================================================================
 // CPU INFO
 // ============================================================================
+
+// Control-register setup for the features the kernel uses: SSE for the
+// float code the baseline JIT emits (FXSR + SSE2, EM off, MP on, OSFXSR,
+// OSXMMEXCPT). Left alone on CPUs without them; the JIT then rejects floats.
+static void cpu_init(void) {
+    unsigned int eax, ebx, ecx, edx;
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+    if (!(edx & (1u << 24)) || !(edx & (1u << 26))) {
+        return;
+    }
+
+    unsigned int cr0, cr4;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" : : "r"((cr0 & ~(1u << 2)) | (1u << 1)));
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    asm volatile("mov %0, %%cr4" : : "r"(cr4 | (1u << 9) | (1u << 10)));
+}
+
 void check_cpu_features(void) {
     terminal_setcolor(VGA_YELLOW, VGA_BLACK);
     terminal_writestring("CPU Features:\n");
@@ -186,6 +277,9 @@ void check_cpu_features(void) {
 // KERNEL MAIN
 // ============================================================================
 void kernel_main(void) {
+    // Enable SSE before anything can run JIT float code
+    cpu_init();
+
     // Initialize VGA terminal
     terminal_initialize();
 
@@ -231,26 +325,31 @@ void kernel_main(void) {
 
     // Execute fibonacci multiple times to trigger recompilation
     serial_puts("=== HOT-PATH DETECTION TEST ===\n");
-    serial_puts("Executing fibonacci 150 times to trigger O0->O1->O2 recompilation\n\n");
+    serial_puts("Executing fibonacci 150 times to trigger cost-model tier-ups\n\n");
+
+    // Report each tier change as it happens; the cost model picks when and
+    // may skip levels
+    opt_level_t level = adaptive_jit_get_profile(&ajit, fib_id)->opt_level;
+    int tier_ups = 0;
+    serial_puts("[Call 1] Initial execution at O");
+    serial_putchar('0' + level);
+    serial_puts("\n");
 
     for (int i = 0; i < 150; i++) {
         int result = adaptive_jit_execute(&ajit, fib_id);
-
-        // Print status at key thresholds
-        if (i == 0) {
-            serial_puts("[Call 1] Initial execution at O0\n");
-        } else if (i == 99) {
-            serial_puts("[Call 100] Threshold reached - recompiling to O1...\n");
-        } else if (i == 100) {
-            function_profile_t* profile = adaptive_jit_get_profile(&ajit, fib_id);
-            serial_puts("[Call 101] Now running at O");
-            serial_putchar('0' + profile->opt_level);
+        adaptive_jit_compile_pending(&ajit, 0);
+
+        opt_level_t now = adaptive_jit_get_profile(&ajit, fib_id)->opt_level;
+        if (now != level) {
+            serial_puts("[Call ");
+            serial_put_int(i + 1);
+            serial_puts("] O");
+            serial_putchar('0' + level);
+            serial_puts(" -> O");
+            serial_putchar('0' + now);
             serial_puts("\n");
-        } else if (i == 149) {
-            function_profile_t* profile = adaptive_jit_get_profile(&ajit, fib_id);
-            serial_puts("[Call 150] Final optimization level: O");
-            serial_putchar('0' + profile->opt_level);
-            serial_puts("\n\n");
+            level = now;
+            tier_ups++;
         }
 
         // Verify result
@@ -259,6 +358,7 @@ void kernel_main(void) {
             break;
         }
     }
+    serial_puts("\n");
 
     // Print final profiling statistics
     function_profile_t* final_profile = adaptive_jit_get_profile(&ajit, fib_id);
@@ -274,11 +374,9 @@ void kernel_main(void) {
     serial_puts("Final optimization level: O");
     serial_putchar('0' + final_profile->opt_level);
     serial_puts("\n");
-    serial_puts("Recompilations triggered: ");
-    if (final_profile->opt_level == OPT_LEVEL_O1) serial_puts("1 (O0->O1)\n");
-    else if (final_profile->opt_level == OPT_LEVEL_O2) serial_puts("2 (O0->O1->O2)\n");
-    else if (final_profile->opt_level == OPT_LEVEL_O3) serial_puts("3 (O0->O1->O2->O3)\n");
-    else serial_puts("0\n");
+    serial_puts("Tier-ups: ");
+    serial_put_int(tier_ups);
+    serial_puts("\n");
 
     serial_puts("\n=== ADAPTIVE JIT TEST COMPLETE ===\n\n");
 
@@ -729,10 +827,36 @@ skip_jit_test:
     test_llvm_modules();
 
 llvm_pgo_tests:
+    // ========================================================================
+    // JIT TEST SUITES (W^X code pool, baseline JIT, tiering)
+    // ========================================================================
+
+    // Identity-mapped PAE paging, so JIT code pages can be kept W^X
+    if (paging_init() == 0) {
+        serial_puts("[PAGING] PAE identity map enabled\n");
+    } else {
+        serial_puts("[PAGING] No PAE, JIT code pool stays flat\n");
+    }
+
+    terminal_setcolor(VGA_LIGHT_GREEN, VGA_BLACK);
+    test_jit_allocator();
+
+    // From here on JIT code is written through the pool and run through an RX alias
+    if (jit_enable_code_dual_mapping(JIT_CODE_RX_ALIAS_BASE) == 0) {
+        serial_puts("[JIT] Code pool dual-mapped (RW+NX / RX)\n");
+    }
+
+    test_baseline_jit();
+    test_tier_policy();
+    test_adaptive_jit();
+    terminal_setcolor(VGA_LIGHT_GREY, VGA_BLACK);
+
     // ========================================================================
     // LLVM PGO PERFORMANCE TEST SUITE
     // ========================================================================
 
+    start_sampling();
+
     test_llvm_pgo_suite();
 
     // ========================================================================
@@ -741,6 +865,8 @@ llvm_pgo_tests:
 
     test_llvm_pgo_extended();
 
+    finish_sampling();
+
     // ========================================================================
     // FINAL MESSAGE
     // ========================================================================
@@ -749,6 +875,10 @@ llvm_pgo_tests:
     terminal_writestring("\n=== ALL MODULE TESTS COMPLETED ===\n\n");
     terminal_setcolor(VGA_LIGHT_GREY, VGA_BLACK);
 
+#ifdef CONTINUOUS_PROFILING
+    run_continuous_profiling(&module_mgr);
+#endif
+
     terminal_writestring("System ready. CPU halted.\n");
 
     // Infinite loop
@@ -0,0 +1,103 @@
+// ============================================================================
+// BAREFLOW - Log-Linear Latency Histograms Implementation
+// ============================================================================
+
+#include "latency_histogram.h"
+#include <stddef.h>
+
+extern void* memset(void* s, int c, size_t n);
+
+// ============================================================================
+// Bucket Layout
+// ============================================================================
+
+uint32_t latency_hist_bucket(uint64_t cycles) {
+    if (cycles < LATENCY_SUB_BUCKETS) {
+        return (uint32_t)cycles;
+    }
+
+    uint32_t msb = 63 - __builtin_clzll(cycles);
+    if (msb >= LATENCY_MAX_BITS) {
+        return LATENCY_BUCKETS - 1;
+    }
+
+    // The top LATENCY_SUB_BITS bits below the leading one pick the sub-bucket
+    uint32_t shift = msb - LATENCY_SUB_BITS;
+    uint32_t sub = (uint32_t)(cycles >> shift) & (LATENCY_SUB_BUCKETS - 1);
+    return LATENCY_SUB_BUCKETS + shift * LATENCY_SUB_BUCKETS + sub;
+}
+
+uint64_t latency_hist_bucket_low(uint32_t index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+
+    uint32_t shift = (index - LATENCY_SUB_BUCKETS) >> LATENCY_SUB_BITS;
+    uint32_t sub = (index - LATENCY_SUB_BUCKETS) & (LATENCY_SUB_BUCKETS - 1);
+    return (uint64_t)(LATENCY_SUB_BUCKETS + sub) << shift;
+}
+
+uint64_t latency_hist_bucket_high(uint32_t index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+    if (index >= LATENCY_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+
+    uint32_t shift = (index - LATENCY_SUB_BUCKETS) >> LATENCY_SUB_BITS;
+    return latency_hist_bucket_low(index) + ((uint64_t)1 << shift) - 1;
+}
+
+// ============================================================================
+// Recording / Merging
+// ============================================================================
+
+void latency_hist_init(latency_histogram_t* hist) {
+    if (!hist) return;
+    memset(hist, 0, sizeof(latency_histogram_t));
+}
+
+void latency_hist_record(latency_histogram_t* hist, uint64_t cycles) {
+    if (!hist) return;
+
+    uint32_t* bucket = &hist->counts[latency_hist_bucket(cycles)];
+    if (*bucket != UINT32_MAX) {
+        (*bucket)++;
+        hist->total++;
+    }
+}
+
+void latency_hist_merge(latency_histogram_t* dst, const latency_histogram_t* src) {
+    if (!dst || !src) return;
+
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        uint32_t room = UINT32_MAX - dst->counts[i];
+        uint32_t add = src->counts[i] < room ? src->counts[i] : room;
+        dst->counts[i] += add;
+        dst->total += add;
+    }
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+uint64_t latency_hist_percentile(const latency_histogram_t* hist, uint32_t basis_points) {
+    if (!hist || hist->total == 0) return 0;
+
+    // cumulative / total >= bp / 10000, kept in multiplications (no 64-bit division)
+    uint64_t target = hist->total * basis_points;
+    uint64_t cumulative = 0;
+    uint32_t i = 0;
+
+    for (; i < LATENCY_BUCKETS - 1; i++) {
+        cumulative += hist->counts[i];
+        if (hist->counts[i] && cumulative * 10000 >= target) {
+            return latency_hist_bucket_high(i);
+        }
+    }
+
+    // Overflow bucket has no upper bound: report where it starts
+    return latency_hist_bucket_low(i);
+}
@@ -0,0 +1,74 @@
+// ============================================================================
+// BAREFLOW - Log-Linear Latency Histograms (HDR-style)
+// ============================================================================
+// File: kernel/latency_histogram.h
+// Purpose: Per-function cycle distributions with p50/p99/p999 queries
+// ============================================================================
+//
+// Values below 2^LATENCY_SUB_BITS get one bucket each; every power of two
+// above that is split into 2^LATENCY_SUB_BITS linear sub-buckets, so any
+// value lands in a bucket at most 1/8 of its magnitude wide (12.5%
+// worst-case relative error) across the whole 0 .. 2^40 cycle range.
+//
+// The layout is fixed, so histograms merge by adding counts bucket by
+// bucket, in the kernel or on the host from the exported JSON.
+// ============================================================================
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_SUB_BITS    3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS    40      // Values >= 2^40 cycles share the top bucket
+#define LATENCY_BUCKETS     (LATENCY_SUB_BUCKETS + \
+                             (LATENCY_MAX_BITS - LATENCY_SUB_BITS) * LATENCY_SUB_BUCKETS)
+
+// Percentiles in basis points (1/100 of a percent)
+#define LATENCY_P50         5000
+#define LATENCY_P99         9900
+#define LATENCY_P999        9990
+
+typedef struct {
+    uint64_t total;                     // Values recorded
+    uint32_t counts[LATENCY_BUCKETS];   // 1216 bytes
+} latency_histogram_t;
+
+/**
+ * Clear all buckets
+ */
+void latency_hist_init(latency_histogram_t* hist);
+
+/**
+ * Record one latency sample (cycles)
+ */
+void latency_hist_record(latency_histogram_t* hist, uint64_t cycles);
+
+/**
+ * Add every bucket of 'src' into 'dst'
+ */
+void latency_hist_merge(latency_histogram_t* dst, const latency_histogram_t* src);
+
+/**
+ * Smallest bucket upper bound covering 'basis_points' of the samples
+ * (e.g. LATENCY_P99). Returns 0 for an empty histogram.
+ */
+uint64_t latency_hist_percentile(const latency_histogram_t* hist, uint32_t basis_points);
+
+/**
+ * Bucket index for a value, and the value range [low, high] of a bucket
+ */
+uint32_t latency_hist_bucket(uint64_t cycles);
+uint64_t latency_hist_bucket_low(uint32_t index);
+uint64_t latency_hist_bucket_high(uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_HISTOGRAM_H
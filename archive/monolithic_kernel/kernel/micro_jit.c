@@ -3,6 +3,7 @@
 // ============================================================================
 
 #include "micro_jit.h"
+#include "baseline_jit.h"
 #include "jit_allocator.h"
 #include "stdlib.h"
 
@@ -34,6 +35,7 @@ int micro_jit_init(micro_jit_ctx_t* ctx, void* jit_allocator) {
     ctx->code_size = 0;
     ctx->code_capacity = MAX_JIT_CODE_SIZE;
     ctx->allocator = jit_allocator;
+    ctx->num_patch_sites = 0;
 
     return 0;
 }
@@ -95,9 +97,13 @@ void* micro_jit_finalize(micro_jit_ctx_t* ctx) {
         return NULL;
     }
 
-    // Code is already in executable memory (JIT allocator)
-    // Just return pointer
-    return (void*)ctx->code_buffer;
+    // W^X: code buffer leaves the writable state before anyone calls it
+    if (jit_mark_executable(ctx->code_buffer, ctx->code_size) != 0) {
+        return NULL;
+    }
+
+    // Caller must use the executable view (RX alias under dual mapping)
+    return jit_code_exec_address(ctx->code_buffer);
 }
 
 // Cleanup
@@ -117,101 +123,119 @@ void micro_jit_destroy(micro_jit_ctx_t* ctx) {
 // HIGH-LEVEL PATTERNS
 // ============================================================================
 
+// Body of fibonacci(n) for an int vreg n: returns a
+static void build_fibonacci(baseline_ir_t* ir, int n) {
+    int a = baseline_ir_const(ir, 0);
+    int b = baseline_ir_const(ir, 1);
+    int i = baseline_ir_const(ir, 0);
+    int one = baseline_ir_const(ir, 1);
+    int loop = baseline_ir_label(ir);
+    int done = baseline_ir_label(ir);
+
+    // while (i < n) { temp = a + b; a = b; b = temp; i++; }
+    baseline_ir_place(ir, loop);
+    baseline_ir_branch(ir, BASELINE_GE, i, n, done);
+    int temp = baseline_ir_binop(ir, BASELINE_OP_ADD, a, b);
+    baseline_ir_mov(ir, a, b);
+    baseline_ir_mov(ir, b, temp);
+    baseline_ir_mov(ir, i, baseline_ir_binop(ir, BASELINE_OP_ADD, i, one));
+    baseline_ir_jump(ir, loop);
+
+    baseline_ir_place(ir, done);
+    baseline_ir_ret(ir, a);
+}
+
 // Compile fibonacci(void) -> int
 void* micro_jit_compile_fibonacci(micro_jit_ctx_t* ctx, int iterations) {
-    // Reset context
-    ctx->code_size = 0;
-
-    // int a = 0, b = 1;
-    micro_jit_emit_mov_reg_imm(ctx, REG_EAX, 0);  // a = 0
-    micro_jit_emit_mov_reg_imm(ctx, REG_ECX, 1);  // b = 1
-    micro_jit_emit_mov_reg_imm(ctx, REG_EDX, 0);  // i = 0
-
-    // loop:
-    size_t loop_start = ctx->code_size;
-
-    // if (i >= iterations) goto end
-    micro_jit_emit_cmp_reg_imm(ctx, REG_EDX, iterations);
-    // JGE = jump if greater or equal (we'll patch offset later)
-    size_t jge_offset_pos = ctx->code_size;
-    emit_byte(ctx, 0x0F);  // JGE opcode part 1
-    emit_byte(ctx, 0x8D);  // JGE opcode part 2
-    emit_dword(ctx, 0);    // Placeholder for offset
-
-    // temp = a + b;
-    // mov ebx, eax (temp = a)
-    emit_byte(ctx, 0x89);
-    emit_byte(ctx, 0xC3);
-    micro_jit_emit_add(ctx, REG_EBX, REG_ECX);  // temp += b
-
-    // a = b; b = temp;
-    emit_byte(ctx, 0x89);  // mov eax, ecx (a = b)
-    emit_byte(ctx, 0xC8);
-    emit_byte(ctx, 0x89);  // mov ecx, ebx (b = temp)
-    emit_byte(ctx, 0xD9);
-
-    // i++
-    emit_byte(ctx, 0xFF);  // inc edx
-    emit_byte(ctx, 0xC2);
-
-    // jmp loop
-    int32_t jmp_offset = loop_start - (ctx->code_size + 5);
-    micro_jit_emit_jmp(ctx, jmp_offset);
-
-    // end: (patch JGE offset)
-    size_t end_pos = ctx->code_size;
-    int32_t jge_offset = end_pos - (jge_offset_pos + 6);
-    // Patch offset
-    ctx->code_buffer[jge_offset_pos + 2] = jge_offset & 0xFF;
-    ctx->code_buffer[jge_offset_pos + 3] = (jge_offset >> 8) & 0xFF;
-    ctx->code_buffer[jge_offset_pos + 4] = (jge_offset >> 16) & 0xFF;
-    ctx->code_buffer[jge_offset_pos + 5] = (jge_offset >> 24) & 0xFF;
-
-    // Return a
-    // (eax already contains result)
-    micro_jit_emit_ret(ctx);
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    build_fibonacci(&ir, baseline_ir_const(&ir, iterations));
+    return baseline_jit_compile(ctx, &ir);
+}
 
-    return micro_jit_finalize(ctx);
+// Body of sum(1..n) for an int vreg n: returns sum
+static void build_sum(baseline_ir_t* ir, int n) {
+    int sum = baseline_ir_const(ir, 0);
+    int i = baseline_ir_const(ir, 1);
+    int one = baseline_ir_const(ir, 1);
+    int loop = baseline_ir_label(ir);
+    int done = baseline_ir_label(ir);
+
+    // while (i <= n) { sum += i; i++; }
+    baseline_ir_place(ir, loop);
+    baseline_ir_branch(ir, BASELINE_GT, i, n, done);
+    baseline_ir_mov(ir, sum, baseline_ir_binop(ir, BASELINE_OP_ADD, sum, i));
+    baseline_ir_mov(ir, i, baseline_ir_binop(ir, BASELINE_OP_ADD, i, one));
+    baseline_ir_jump(ir, loop);
+
+    baseline_ir_place(ir, done);
+    baseline_ir_ret(ir, sum);
 }
 
 // Compile sum(1..n) -> int
 void* micro_jit_compile_sum(micro_jit_ctx_t* ctx, int n) {
-    ctx->code_size = 0;
-
-    // sum = 0, i = 1
-    micro_jit_emit_mov_reg_imm(ctx, REG_EAX, 0);  // sum
-    micro_jit_emit_mov_reg_imm(ctx, REG_ECX, 1);  // i
-
-    // loop:
-    size_t loop_start = ctx->code_size;
-
-    // if (i > n) goto end
-    micro_jit_emit_cmp_reg_imm(ctx, REG_ECX, n);
-    size_t jg_offset_pos = ctx->code_size;
-    emit_byte(ctx, 0x0F);  // JG
-    emit_byte(ctx, 0x8F);
-    emit_dword(ctx, 0);
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    build_sum(&ir, baseline_ir_const(&ir, n));
+    return baseline_jit_compile(ctx, &ir);
+}
 
-    // sum += i
-    micro_jit_emit_add(ctx, REG_EAX, REG_ECX);
+// ============================================================================
+// VALUE SPECIALIZATION
+// ============================================================================
 
-    // i++
-    emit_byte(ctx, 0xFF);
-    emit_byte(ctx, 0xC1);
+// Unspecialized f(int n) per pattern, built on first use: what a failed
+// guard resumes in. Static because compiled clones keep pointing at it.
+static baseline_ir_t g_generic_ir[MICRO_JIT_PATTERN_SUM + 1];
+static bool g_generic_built[MICRO_JIT_PATTERN_SUM + 1];
+
+static const baseline_ir_t* generic_ir(micro_jit_pattern_t pattern) {
+    baseline_ir_t* ir = &g_generic_ir[pattern];
+    if (!g_generic_built[pattern]) {
+        baseline_ir_init(ir);
+        int n = baseline_ir_arg(ir, BASELINE_INT, 0);
+        if (pattern == MICRO_JIT_PATTERN_FIBONACCI) {
+            build_fibonacci(ir, n);
+        } else {
+            build_sum(ir, n);
+        }
+        g_generic_built[pattern] = true;
+    }
+    return ir;
+}
 
-    // jmp loop
-    int32_t jmp_offset = loop_start - (ctx->code_size + 5);
-    micro_jit_emit_jmp(ctx, jmp_offset);
+// Compile f(int n) -> int: guard on n == value, then the constant-folded body
+void* micro_jit_compile_guarded(micro_jit_ctx_t* ctx, micro_jit_pattern_t pattern,
+                                int32_t value, void (*on_deopt)(void* arg), void* arg) {
+    if (!ctx || !ctx->code_buffer ||
+        (pattern != MICRO_JIT_PATTERN_FIBONACCI && pattern != MICRO_JIT_PATTERN_SUM)) {
+        return NULL;
+    }
 
-    // end: patch JG
-    size_t end_pos = ctx->code_size;
-    int32_t jg_offset = end_pos - (jg_offset_pos + 6);
-    ctx->code_buffer[jg_offset_pos + 2] = jg_offset & 0xFF;
-    ctx->code_buffer[jg_offset_pos + 3] = (jg_offset >> 8) & 0xFF;
-    ctx->code_buffer[jg_offset_pos + 4] = (jg_offset >> 16) & 0xFF;
-    ctx->code_buffer[jg_offset_pos + 5] = (jg_offset >> 24) & 0xFF;
+    baseline_ir_t ir;
+    baseline_ir_init(&ir);
+    baseline_ir_set_deopt_hook(&ir, on_deopt, arg);
+
+    // Nothing is computed before the guard, so the generic body restarts
+    // from its first instruction (re-reading n) and carries no values
+    int n = baseline_ir_arg(&ir, BASELINE_INT, 0);
+    int expected = baseline_ir_const(&ir, value);
+    int deopt = baseline_ir_deopt_point(&ir, generic_ir(pattern), 0);
+    baseline_ir_guard(&ir, BASELINE_EQ, n, expected, deopt);
+
+    if (pattern == MICRO_JIT_PATTERN_FIBONACCI) {
+        build_fibonacci(&ir, baseline_ir_const(&ir, value));
+    } else {
+        build_sum(&ir, baseline_ir_const(&ir, value));
+    }
 
-    micro_jit_emit_ret(ctx);
+    return baseline_jit_compile(ctx, &ir);
+}
 
-    return micro_jit_finalize(ctx);
+const char* micro_jit_pattern_name(micro_jit_pattern_t pattern) {
+    switch (pattern) {
+        case MICRO_JIT_PATTERN_FIBONACCI: return "fibonacci";
+        case MICRO_JIT_PATTERN_SUM:       return "sum";
+        default:                          return "none";
+    }
 }
@@ -3,7 +3,7 @@
 // ============================================================================
 // File: kernel/micro_jit.h
 // Purpose: ~10KB x86 code generator for hot loops (vs 500KB LLVM)
-// Strategy: Direct x86 code emission for critical patterns
+// Strategy: Direct x86 emitters, plus fixed patterns built on baseline_jit
 // ============================================================================
 
 #ifndef MICRO_JIT_H
@@ -18,11 +18,22 @@
 
 #define MAX_JIT_CODE_SIZE (8 * 1024)  // 8KB per function (sufficient for small functions)
 
+#define MICRO_JIT_MAX_PATCH_SITES 16
+
+// Patchable direct call emitted by baseline_jit: 'offset' is its rel32
+// field, 4-byte aligned so it can be rewritten with one atomic store
+typedef struct {
+    uint32_t offset;
+    int32_t tag;             // Caller-chosen ID (adaptive_jit: call site slot)
+} micro_jit_patch_site_t;
+
 typedef struct {
     uint8_t* code_buffer;    // Executable code buffer
     size_t code_size;        // Current size
     size_t code_capacity;    // Max capacity
     void* allocator;         // JIT allocator reference
+    micro_jit_patch_site_t patch_sites[MICRO_JIT_MAX_PATCH_SITES];
+    int num_patch_sites;     // Set by baseline_jit_compile
 } micro_jit_ctx_t;
 
 // ============================================================================
@@ -43,6 +54,13 @@ typedef enum {
     JIT_OP_RET            // ret
 } jit_opcode_t;
 
+// Code shapes micro_jit can regenerate for a given n (constant-folded)
+typedef enum {
+    MICRO_JIT_PATTERN_NONE = 0,     // Opaque code, cannot be specialized
+    MICRO_JIT_PATTERN_FIBONACCI,    // int fibonacci(int n)
+    MICRO_JIT_PATTERN_SUM           // int sum(int n), 1..n
+} micro_jit_pattern_t;
+
 typedef enum {
     REG_EAX = 0,
     REG_ECX = 1,
@@ -98,7 +116,7 @@ void* micro_jit_compile_loop(micro_jit_ctx_t* ctx, int n,
                               void (*body_emitter)(micro_jit_ctx_t*, int));
 
 /**
- * JIT compile fibonacci (special case)
+ * JIT compile fibonacci (baseline_jit IR, constant-folded n)
  * Returns function pointer: int fibonacci(void)
  */
 void* micro_jit_compile_fibonacci(micro_jit_ctx_t* ctx, int iterations);
@@ -109,4 +127,19 @@ void* micro_jit_compile_fibonacci(micro_jit_ctx_t* ctx, int iterations);
  */
 void* micro_jit_compile_sum(micro_jit_ctx_t* ctx, int n);
 
+/**
+ * JIT compile 'pattern' specialized for n == value, behind a guard
+ * Returns function pointer: int f(int n). When the cdecl argument isn't
+ * 'value' the guard deoptimizes: 'on_deopt' (may be NULL) runs with 'arg',
+ * then the call finishes in the pattern's unspecialized IR, interpreted.
+ * The clone is position independent.
+ */
+void* micro_jit_compile_guarded(micro_jit_ctx_t* ctx, micro_jit_pattern_t pattern,
+                                int32_t value, void (*on_deopt)(void* arg), void* arg);
+
+/**
+ * Name of a pattern ("fibonacci", "sum", "none")
+ */
+const char* micro_jit_pattern_name(micro_jit_pattern_t pattern);
+
 #endif // MICRO_JIT_H
@@ -4,6 +4,8 @@
 
 #include "module_loader.h"
 #include "vga.h"
+#include "profile_stream.h"
+#include "stdlib.h"
 
 // Forward declarations from stdlib
 extern void* memcpy(void* dest, const void* src, size_t n);
@@ -16,47 +18,6 @@ static void print_int(int num);
 static void print_u64(uint64_t num);
 static void print_hex(uint32_t num);
 
-// Simple 64-bit division (avoids __udivdi3 dependency)
-static uint64_t udiv64(uint64_t dividend, uint64_t divisor) {
-    if (divisor == 0) return 0;
-
-    uint64_t quotient = 0;
-    uint64_t remainder = 0;
-
-    for (int i = 63; i >= 0; i--) {
-        remainder <<= 1;
-        remainder |= (dividend >> i) & 1;
-
-        if (remainder >= divisor) {
-            remainder -= divisor;
-            quotient |= (1ULL << i);
-        }
-    }
-
-    return quotient;
-}
-
-// Simple integer square root using Newton's method
-static uint64_t isqrt64(uint64_t n) {
-    if (n == 0) return 0;
-    if (n < 4) return 1;
-
-    uint64_t x = n;
-    uint64_t y = (x + 1) >> 1;
-
-    // Newton's method: y = (x + n/x) / 2
-    // Limit iterations to prevent potential infinite loops
-    int iterations = 0;
-    while (y < x && iterations < 100) {
-        x = y;
-        if (x == 0) break;  // Prevent division by zero
-        y = (x + udiv64(n, x)) >> 1;
-        iterations++;
-    }
-
-    return x;
-}
-
 // ============================================================================
 // MODULE MANAGER
 // ============================================================================
@@ -65,6 +26,26 @@ void module_init(module_manager_t* mgr) {
     memset(mgr, 0, sizeof(module_manager_t));
     mgr->num_modules = 0;
     mgr->total_calls = 0;
+
+    // Counts ride along with the rdtsc profile when a PMU is present
+    if (pmu_init() > 0) {
+        terminal_writestring("[PMU] Hardware counters enabled\n");
+    } else {
+        terminal_writestring("[PMU] Not available, profiling cycles only\n");
+    }
+
+    // Frequency calibration waits until something converts cycles
+    if (timebase_init() == 0) {
+        terminal_writestring("[TSC] ");
+        terminal_writestring(timebase_invariant() ? "invariant" : "NOT invariant");
+        terminal_writestring(", fence ");
+        terminal_writestring(timebase_fence_name(timebase_fence()));
+        terminal_writestring(", overhead ");
+        print_int(timebase_overhead());
+        terminal_writestring(" cycles\n");
+    } else {
+        terminal_writestring("[TSC] Not available, reporting raw cycles\n");
+    }
 }
 
 int module_load(module_manager_t* mgr, const void* module_data, size_t size) {
@@ -175,34 +156,37 @@ int module_execute(module_manager_t* mgr, const char* name) {
     }
 
     // Profile execution
-    uint64_t start = rdtsc();
+    pmu_counts_t pmu_start, pmu_end, pmu_diff;
+    pmu_read(&pmu_start);
+    uint64_t start = timebase_begin();
 
     // Execute the module
     module_func_t func = (module_func_t)mod->code_ptr;
     int result = func();
 
-    uint64_t end = rdtsc();
-    uint64_t cycles = end - start;
+    uint64_t end = timebase_end();
+    pmu_read(&pmu_end);
+    uint64_t cycles = timebase_elapsed(start, end);
 
     // Update profiling stats
     mod->call_count++;
     mod->total_cycles += cycles;
 
-    // For variance: sum of (x^2) - but avoid overflow by scaling down if needed
-    // Only update if multiplication won't overflow (cycles < 2^32)
-    if (cycles < 0x100000000ULL) {
-        mod->sum_of_squares += cycles * cycles;
-    } else {
-        // For very large cycle counts, use scaled version
-        uint64_t scaled = cycles >> 16;  // Divide by 65536
-        mod->sum_of_squares += (scaled * scaled) << 32;  // Re-scale
+    pmu_delta(&pmu_start, &pmu_end, &pmu_diff);
+    for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+        mod->pmu_counts[e] += pmu_diff.counts[e];
     }
 
+    latency_hist_record(&mod->latency, cycles);
+
     if (cycles < mod->min_cycles) mod->min_cycles = cycles;
     if (cycles > mod->max_cycles) mod->max_cycles = cycles;
 
     mgr->total_calls++;
 
+    // Same call into the current epoch when continuous profiling is on
+    profile_stream_record((uint32_t)(mod - mgr->modules), cycles, &pmu_diff);
+
     return result;
 }
 
@@ -226,7 +210,8 @@ int module_install_override(module_manager_t* mgr, const module_header_t* header
     existing->code_size = header->code_size;
     existing->call_count = 0;
     existing->total_cycles = 0;
-    existing->sum_of_squares = 0;
+    latency_hist_init(&existing->latency);
+    memset(existing->pmu_counts, 0, sizeof(existing->pmu_counts));
     existing->min_cycles = UINT64_MAX;
     existing->max_cycles = 0;
     return 1;
@@ -266,6 +251,11 @@ void module_print_stats(module_manager_t* mgr, const char* name) {
 
         terminal_writestring("  Avg cycles:    ");
         print_u64(avg);
+        if (timebase_hz()) {
+            terminal_writestring(" (");
+            print_u64(timebase_cycles_to_ns(avg));
+            terminal_writestring(" ns)");
+        }
         terminal_writestring("\n");
 
         terminal_writestring("  Min cycles:    ");
@@ -276,19 +266,16 @@ void module_print_stats(module_manager_t* mgr, const char* name) {
         print_u64(mod->max_cycles);
         terminal_writestring("\n");
 
-        // Calculate standard deviation: sqrt(E[X^2] - E[X]^2)
-        // Variance = (sum_of_squares / n) - (mean)^2
-        uint64_t mean_of_squares = udiv64(mod->sum_of_squares, mod->call_count);
-        uint64_t variance = 0;
-
-        if (mean_of_squares >= avg * avg) {
-            variance = mean_of_squares - (avg * avg);
-        }
-
-        uint64_t std_dev = isqrt64(variance);
+        // Tail latency from the histogram (bucket upper bounds, <=12.5% error)
+        uint64_t p50 = latency_hist_percentile(&mod->latency, LATENCY_P50);
+        uint64_t p99 = latency_hist_percentile(&mod->latency, LATENCY_P99);
 
-        terminal_writestring("  Std dev:       ");
-        print_u64(std_dev);
+        terminal_writestring("  p50/p99/p999:  ");
+        print_u64(p50);
+        terminal_writestring(" / ");
+        print_u64(p99);
+        terminal_writestring(" / ");
+        print_u64(latency_hist_percentile(&mod->latency, LATENCY_P999));
         terminal_writestring(" cycles\n");
 
         // Efficiency: cycles per byte of code
@@ -299,12 +286,12 @@ void module_print_stats(module_manager_t* mgr, const char* name) {
             terminal_writestring(" cycles/byte\n");
         }
 
-        // Performance variability (coefficient of variation as percentage)
-        if (avg > 0) {
-            uint64_t cv_percent = udiv64(std_dev * 100, avg);
-            terminal_writestring("  Variability:   ");
-            print_u64(cv_percent);
-            terminal_writestring("% CV\n");
+        // Tail ratio: how far the slow calls sit from the typical one
+        if (p50 > 0) {
+            uint64_t tail_percent = udiv64(p99 * 100, p50);
+            terminal_writestring("  Tail ratio:    ");
+            print_u64(tail_percent);
+            terminal_writestring("% (p99/p50)\n");
         }
 
         // Visual performance bar (relative to max cycles across all runs)
@@ -11,6 +11,9 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "pmu.h"
+#include "latency_histogram.h"
+#include "timebase.h"
 
 // ============================================================================
 // MODULE SYSTEM
@@ -37,7 +40,8 @@ typedef struct {
     uint64_t total_cycles;
     uint64_t min_cycles;
     uint64_t max_cycles;
-    uint64_t sum_of_squares;  // For variance calculation
+    latency_histogram_t latency;  // Per-call cycle distribution (p50/p99/p999)
+    uint64_t pmu_counts[PMU_EVENT_COUNT];  // Summed PMU deltas (0 if no PMU)
     uint32_t code_size;
     int loaded;
 } module_profile_t;
@@ -77,7 +81,8 @@ void module_print_all_stats(module_manager_t* mgr);
 // PROFILING HELPERS
 // ============================================================================
 
-// Read CPU timestamp counter (for cycle counting)
+// Read CPU timestamp counter (unserialized; measured regions use the
+// timebase_begin/timebase_end brackets from timebase.h)
 static inline uint64_t rdtsc(void) {
     uint32_t lo, hi;
     asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
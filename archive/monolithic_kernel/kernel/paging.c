@@ -0,0 +1,220 @@
+// ============================================================================
+// BAREFLOW - PAE Paging Implementation
+// ============================================================================
+
+#include "paging.h"
+
+#define PTE_PRESENT         (1ull << 0)
+#define PTE_WRITABLE        (1ull << 1)
+#define PTE_LARGE           (1ull << 7)     // PDE maps a 2 MB page
+#define PTE_NO_EXEC         (1ull << 63)
+#define PTE_ADDR_MASK       0x000FFFFFFFFFF000ull
+#define PDE_LARGE_ADDR_MASK 0x000FFFFFFFE00000ull
+
+#define ENTRIES_PER_TABLE   512
+#define LARGE_PAGE_SIZE     (2u * 1024 * 1024)
+
+#define CR0_WP              (1u << 16)
+#define CR0_PG              (1u << 31)
+#define CR4_PAE             (1u << 5)
+#define IA32_EFER           0xC0000080
+#define EFER_NXE            (1u << 11)
+
+#define CPUID_1_EDX_PAE     (1u << 6)
+#define CPUID_EXT_EDX_NX    (1u << 20)
+
+// One PDPT, four page directories covering 4 GB with 2 MB pages, and the
+// pool of 4 KB tables used when a 2 MB page has to be split
+static uint64_t g_pdpt[4] __attribute__((aligned(32)));
+static uint64_t g_page_dirs[4][ENTRIES_PER_TABLE] __attribute__((aligned(PAGING_PAGE_SIZE)));
+static uint64_t g_page_tables[PAGING_MAX_TABLES][ENTRIES_PER_TABLE] __attribute__((aligned(PAGING_PAGE_SIZE)));
+static int g_tables_used = 0;
+
+static bool g_enabled = false;
+static bool g_nx = false;
+
+// ============================================================================
+// Hardware Access
+// ============================================================================
+
+static inline void cpuid(uint32_t leaf, uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d) {
+    asm volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+static inline void invlpg(uintptr_t addr) {
+    asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
+}
+
+// ============================================================================
+// Table Walk
+// ============================================================================
+
+static inline uint64_t* pde_for(uintptr_t virt) {
+    return &g_page_dirs[virt >> 30][(virt >> 21) & (ENTRIES_PER_TABLE - 1)];
+}
+
+static inline uint64_t* table_at(uint64_t entry) {
+    // Tables live in the identity-mapped kernel image (virt == phys)
+    return (uint64_t*)(uintptr_t)(entry & PTE_ADDR_MASK);
+}
+
+// PTE for 'virt', splitting its 2 MB page into 4 KB pages on first use
+static uint64_t* pte_for(uintptr_t virt) {
+    uint64_t* pde = pde_for(virt);
+
+    if (*pde & PTE_LARGE) {
+        if (g_tables_used >= PAGING_MAX_TABLES) {
+            return NULL;
+        }
+        uint64_t* table = g_page_tables[g_tables_used++];
+
+        // Same frames and permissions as the large page, 4 KB at a time
+        uint64_t frame = *pde & PDE_LARGE_ADDR_MASK;
+        uint64_t attrs = *pde & (PTE_PRESENT | PTE_WRITABLE | PTE_NO_EXEC);
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            table[i] = (frame + (uint64_t)i * PAGING_PAGE_SIZE) | attrs;
+        }
+
+        // Permissions are set per PTE; the directory entry allows everything
+        *pde = (uint64_t)(uintptr_t)table | PTE_PRESENT | PTE_WRITABLE;
+        invlpg(virt & ~(uintptr_t)(LARGE_PAGE_SIZE - 1));
+    }
+
+    return &table_at(*pde)[(virt >> 12) & (ENTRIES_PER_TABLE - 1)];
+}
+
+static inline uint64_t pte_attrs(bool writable, bool no_exec) {
+    uint64_t attrs = PTE_PRESENT;
+    if (writable) attrs |= PTE_WRITABLE;
+    if (no_exec && g_nx) attrs |= PTE_NO_EXEC;   // Reserved bit without NXE
+    return attrs;
+}
+
+// ============================================================================
+// API Functions
+// ============================================================================
+
+int paging_init(void) {
+    if (g_enabled) {
+        return 0;
+    }
+
+    uint32_t a, b, c, d;
+    cpuid(1, &a, &b, &c, &d);
+    if (!(d & CPUID_1_EDX_PAE)) {
+        return -1;
+    }
+
+    cpuid(0x80000000, &a, &b, &c, &d);
+    if (a >= 0x80000001) {
+        cpuid(0x80000001, &a, &b, &c, &d);
+        g_nx = (d & CPUID_EXT_EDX_NX) != 0;
+    }
+
+    // Identity map: every 2 MB of the 4 GB space, RW + executable
+    for (int dir = 0; dir < 4; dir++) {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            uint64_t frame = ((uint64_t)dir << 30) | ((uint64_t)i << 21);
+            g_page_dirs[dir][i] = frame | PTE_PRESENT | PTE_WRITABLE | PTE_LARGE;
+        }
+        // PDPTEs only take the present bit (RW/US are reserved in PAE mode)
+        g_pdpt[dir] = (uint64_t)(uintptr_t)g_page_dirs[dir] | PTE_PRESENT;
+    }
+    g_tables_used = 0;
+
+    if (g_nx) {
+        wrmsr(IA32_EFER, rdmsr(IA32_EFER) | EFER_NXE);
+    }
+
+    uint32_t cr0, cr4;
+    asm volatile("mov %0, %%cr3" : : "r"((uint32_t)(uintptr_t)g_pdpt) : "memory");
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    asm volatile("mov %0, %%cr4" : : "r"(cr4 | CR4_PAE) : "memory");
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" : : "r"(cr0 | CR0_PG | CR0_WP) : "memory");
+
+    g_enabled = true;
+    return 0;
+}
+
+bool paging_enabled(void) {
+    return g_enabled;
+}
+
+bool paging_nx_enabled(void) {
+    return g_enabled && g_nx;
+}
+
+int paging_protect_range(uintptr_t start, size_t len, bool writable, bool no_exec) {
+    if (!g_enabled || len == 0) {
+        return -1;
+    }
+
+    uintptr_t first = start & ~(uintptr_t)(PAGING_PAGE_SIZE - 1);
+    size_t span = (start - first) + len;
+    uint64_t attrs = pte_attrs(writable, no_exec);
+
+    for (size_t off = 0; off < span; off += PAGING_PAGE_SIZE) {
+        uint64_t* pte = pte_for(first + off);
+        if (!pte) {
+            return -1;
+        }
+        *pte = (*pte & PTE_ADDR_MASK) | attrs;
+        invlpg(first + off);
+    }
+    return 0;
+}
+
+int paging_map_alias(uintptr_t alias_start, uintptr_t phys_start, size_t len, bool writable, bool no_exec) {
+    if (!g_enabled || len == 0 ||
+        (alias_start & (PAGING_PAGE_SIZE - 1)) || (phys_start & (PAGING_PAGE_SIZE - 1))) {
+        return -1;
+    }
+
+    uint64_t attrs = pte_attrs(writable, no_exec);
+    for (size_t off = 0; off < len; off += PAGING_PAGE_SIZE) {
+        uint64_t* pte = pte_for(alias_start + off);
+        if (!pte) {
+            return -1;
+        }
+        *pte = (uint64_t)(phys_start + off) | attrs;
+        invlpg(alias_start + off);
+    }
+    return 0;
+}
+
+int paging_lookup(uintptr_t virt, uintptr_t* phys, uint32_t* flags) {
+    if (!g_enabled) {
+        return -1;
+    }
+
+    uint64_t entry = *pde_for(virt);
+    uintptr_t addr;
+    if (entry & PTE_LARGE) {
+        addr = (uintptr_t)(entry & PDE_LARGE_ADDR_MASK) | (virt & (LARGE_PAGE_SIZE - 1));
+    } else {
+        entry = table_at(entry)[(virt >> 12) & (ENTRIES_PER_TABLE - 1)];
+        addr = (uintptr_t)(entry & PTE_ADDR_MASK) | (virt & (PAGING_PAGE_SIZE - 1));
+    }
+    if (!(entry & PTE_PRESENT)) {
+        return -1;
+    }
+
+    if (phys) *phys = addr;
+    if (flags) {
+        *flags = PAGING_PRESENT;
+        if (entry & PTE_WRITABLE) *flags |= PAGING_WRITABLE;
+        if (entry & PTE_NO_EXEC) *flags |= PAGING_NO_EXEC;
+    }
+    return 0;
+}
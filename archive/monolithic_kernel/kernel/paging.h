@@ -0,0 +1,93 @@
+// ============================================================================
+// BAREFLOW - PAE Paging (identity map + JIT code permissions)
+// ============================================================================
+// File: kernel/paging.h
+// Purpose: Turn on paging with an identity map so the JIT allocator can
+//          enforce W^X on its code pool (page flips or an RX alias)
+// ============================================================================
+//
+// The kernel runs flat (virt == phys). paging_init() keeps it that way: all
+// 4 GB are identity-mapped RW+X with 2 MB PAE pages, so nothing else in the
+// kernel notices the switch. CR0.WP is set, so read-only pages fault even
+// for ring 0 writes.
+//
+// PAE is used instead of 32-bit paging because it is the only i386 mode
+// with an execute-disable bit. NX is enabled (EFER.NXE) when CPUID reports
+// it; without it 'no_exec' requests are accepted but cannot be enforced,
+// and only the write half of W^X holds.
+//
+// A 2 MB page is split into 4 KB pages the first time a range inside it is
+// changed. Page tables come from a fixed pool (PAGING_MAX_TABLES) and are
+// never returned; a change that needs one more table fails with -1.
+// ============================================================================
+
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PAGING_PAGE_SIZE    4096
+#define PAGING_MAX_TABLES   8       // 4 KB page tables, 2 MB of split range each
+
+// Flags reported by paging_lookup()
+#define PAGING_PRESENT      (1u << 0)
+#define PAGING_WRITABLE     (1u << 1)
+#define PAGING_NO_EXEC      (1u << 2)
+
+// ============================================================================
+// API Functions
+// ============================================================================
+
+/**
+ * Build the identity map and enable PAE paging (and NX if available)
+ * Safe to call more than once.
+ *
+ * Returns: 0 on success, -1 if the CPU has no PAE
+ */
+int paging_init(void);
+
+/**
+ * True once paging_init() has succeeded
+ */
+bool paging_enabled(void);
+
+/**
+ * True if no_exec requests are enforced (CPU has NX and EFER.NXE is set)
+ */
+bool paging_nx_enabled(void);
+
+/**
+ * Change the permissions of every 4 KB page overlapping [start, start+len)
+ * and invalidate their TLB entries. The mapping itself is not changed.
+ *
+ * Returns: 0 on success, -1 if paging is off or no page table is left
+ */
+int paging_protect_range(uintptr_t start, size_t len, bool writable, bool no_exec);
+
+/**
+ * Map [alias_start, alias_start+len) onto the frames at phys_start with the
+ * given permissions (both page-aligned). Mapping an alias back onto itself
+ * (phys_start == alias_start) with RW+X restores the identity map.
+ *
+ * Returns: 0 on success, -1 if paging is off, misaligned or out of tables
+ */
+int paging_map_alias(uintptr_t alias_start, uintptr_t phys_start, size_t len, bool writable, bool no_exec);
+
+/**
+ * Translate 'virt'. Writes the physical address and PAGING_* flags.
+ *
+ * Returns: 0 if mapped, -1 if paging is off or the address is not present
+ */
+int paging_lookup(uintptr_t virt, uintptr_t* phys, uint32_t* flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PAGING_H
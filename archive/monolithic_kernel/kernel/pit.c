@@ -0,0 +1,56 @@
+// ============================================================================
+// BAREFLOW - PIT Channel 2 Reference Window Implementation
+// ============================================================================
+
+#include "pit.h"
+
+#define PIT_CH2_DATA        0x42
+#define PIT_CMD             0x43
+#define PIT_CH2_GATE        0x61    // bit 0: gate, bit 1: speaker, bit 5: OUT2
+
+#define PIT_CH2_ONESHOT     0xB0    // Channel 2, lo/hi byte, mode 0, binary
+
+// ============================================================================
+// Hardware Access
+// ============================================================================
+
+static inline void outb(uint16_t port, uint8_t value) {
+    asm volatile("outb %0, %1" : : "a"(value), "Nd"(port));
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile("inb %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+// ============================================================================
+// API Functions
+// ============================================================================
+
+int pit_window(uint32_t ms, pit_window_fn on_start, pit_window_fn on_end, void* ctx) {
+    if (ms == 0 || ms > PIT_WINDOW_MAX_MS) {
+        return -1;
+    }
+
+    const uint32_t pit_count = PIT_FREQUENCY * ms / 1000;
+    uint8_t saved_gate = inb(PIT_CH2_GATE);
+
+    // Gate low, speaker off while programming channel 2
+    outb(PIT_CH2_GATE, saved_gate & ~0x03);
+    outb(PIT_CMD, PIT_CH2_ONESHOT);
+    outb(PIT_CH2_DATA, pit_count & 0xFF);
+    outb(PIT_CH2_DATA, (pit_count >> 8) & 0xFF);
+
+    // Raising the gate starts the count
+    outb(PIT_CH2_GATE, (saved_gate & ~0x02) | 0x01);
+    on_start(ctx);
+
+    while (!(inb(PIT_CH2_GATE) & 0x20)) {
+        // spin until OUT2 goes high
+    }
+
+    on_end(ctx);
+    outb(PIT_CH2_GATE, saved_gate);
+    return 0;
+}
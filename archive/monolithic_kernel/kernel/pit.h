@@ -0,0 +1,43 @@
+// ============================================================================
+// BAREFLOW - PIT Channel 2 Reference Window
+// ============================================================================
+// File: kernel/pit.h
+// Purpose: Fixed-length one-shot of PIT channel 2, the reference clock used
+//          to calibrate the TSC (timebase.c) and the LAPIC timer
+//          (sample_profiler.c)
+// ============================================================================
+//
+// Channel 2 is gated and polled through port 0x61, so a window needs no
+// interrupt and leaves channel 0 alone. The speaker stays off while the
+// window runs and port 0x61 is restored afterwards.
+// ============================================================================
+
+#ifndef PIT_H
+#define PIT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIT_FREQUENCY       1193182
+#define PIT_WINDOW_MAX_MS   54      // Longest window the 16-bit count holds
+
+// Called at the edges of the window with the caller's context
+typedef void (*pit_window_fn)(void* ctx);
+
+/**
+ * Run one 'ms' long one-shot of PIT channel 2. on_start runs as soon as the
+ * gate starts the count and on_end as soon as OUT2 goes high, so a clock
+ * read in both spans the window (to one PIT tick).
+ *
+ * Returns: 0 on success, -1 if ms is 0 or above PIT_WINDOW_MAX_MS
+ */
+int pit_window(uint32_t ms, pit_window_fn on_start, pit_window_fn on_end, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIT_H
@@ -0,0 +1,205 @@
+// ============================================================================
+// BAREFLOW - Hardware Performance Counters Implementation
+// ============================================================================
+
+#include "pmu.h"
+#include <stddef.h>
+
+#define IA32_PMC0               0xC1
+#define IA32_PERFEVTSEL0        0x186
+#define IA32_PERF_GLOBAL_CTRL   0x38F
+
+#define EVTSEL_USR              (1u << 16)
+#define EVTSEL_OS               (1u << 17)
+#define EVTSEL_EN               (1u << 22)
+
+// Architectural event bits in CPUID.0AH:EBX (set = NOT available)
+#define ARCH_INSTRUCTIONS       1
+#define ARCH_LLC_MISSES         4
+#define ARCH_BRANCH_MISSES      6
+
+typedef struct {
+    uint8_t event;
+    uint8_t umask;
+} pmu_encoding_t;
+
+static const char* const g_event_names[PMU_EVENT_COUNT] = {
+    "instructions",
+    "llc_misses",
+    "branch_misses",
+    "dtlb_misses",
+};
+
+static bool g_initialized = false;
+static int g_num_active = 0;
+static int g_counter[PMU_EVENT_COUNT];      // GP counter index, -1 if unsupported
+static uint64_t g_counter_mask = 0;
+
+// ============================================================================
+// Hardware Access
+// ============================================================================
+
+static inline void cpuid(uint32_t leaf, uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d) {
+    asm volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+static inline uint64_t rdpmc(uint32_t index) {
+    uint32_t lo, hi;
+    asm volatile("rdpmc" : "=a"(lo), "=d"(hi) : "c"(index));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static bool is_intel(void) {
+    uint32_t a, b, c, d;
+    cpuid(0, &a, &b, &c, &d);
+    // "GenuineIntel"
+    return b == 0x756E6547 && d == 0x49656E69 && c == 0x6C65746E;
+}
+
+// dTLB misses have no architectural encoding; only known cores get one
+static bool dtlb_encoding(pmu_encoding_t* enc) {
+    uint32_t a, b, c, d;
+    cpuid(1, &a, &b, &c, &d);
+
+    uint32_t family = (a >> 8) & 0xF;
+    uint32_t model = ((a >> 4) & 0xF) | (((a >> 16) & 0xF) << 4);
+    if (family != 6) return false;
+
+    switch (model) {
+        // Sandy Bridge .. Coffee Lake: DTLB_LOAD_MISSES.MISS_CAUSES_A_WALK
+        case 0x2A: case 0x2D: case 0x3A: case 0x3E:
+        case 0x3C: case 0x3F: case 0x45: case 0x46:
+        case 0x3D: case 0x47: case 0x4F: case 0x56:
+        case 0x4E: case 0x5E: case 0x55: case 0x8E: case 0x9E:
+            enc->event = 0x08;
+            enc->umask = 0x01;
+            return true;
+        // Ice Lake and later: DTLB_LOAD_MISSES.WALK_COMPLETED
+        case 0x6A: case 0x6C: case 0x7D: case 0x7E:
+        case 0x8C: case 0x8D: case 0x8F: case 0x97: case 0x9A:
+        case 0xA7: case 0xB7: case 0xBA: case 0xBF:
+            enc->event = 0x08;
+            enc->umask = 0x0E;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ============================================================================
+// Initialization
+// ============================================================================
+
+static void disable_all(int num_gp) {
+    for (int i = 0; i < num_gp; i++) {
+        wrmsr(IA32_PERFEVTSEL0 + i, 0);
+    }
+    for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+        g_counter[e] = -1;
+    }
+    g_num_active = 0;
+}
+
+int pmu_init(void) {
+    if (g_initialized) return g_num_active;
+    g_initialized = true;
+
+    for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+        g_counter[e] = -1;
+    }
+
+    uint32_t a, b, c, d;
+    cpuid(0, &a, &b, &c, &d);
+    if (a < 0xA || !is_intel()) {
+        return 0;
+    }
+
+    cpuid(0xA, &a, &b, &c, &d);
+    uint32_t version = a & 0xFF;
+    int num_gp = (a >> 8) & 0xFF;
+    uint32_t width = (a >> 16) & 0xFF;
+    uint32_t ebx_len = (a >> 24) & 0xFF;
+    uint32_t unavailable = b;
+
+    // Version 0 / no counters: PMU not virtualized
+    if (version == 0 || num_gp == 0 || width == 0) {
+        return 0;
+    }
+    g_counter_mask = (width >= 64) ? ~0ull : ((1ull << width) - 1);
+
+    // Architectural events are present only if listed in EBX and not masked
+    pmu_encoding_t enc[PMU_EVENT_COUNT];
+    bool wanted[PMU_EVENT_COUNT];
+    wanted[PMU_EVENT_INSTRUCTIONS] = ebx_len > ARCH_INSTRUCTIONS && !(unavailable & (1u << ARCH_INSTRUCTIONS));
+    wanted[PMU_EVENT_LLC_MISSES] = ebx_len > ARCH_LLC_MISSES && !(unavailable & (1u << ARCH_LLC_MISSES));
+    wanted[PMU_EVENT_BRANCH_MISSES] = ebx_len > ARCH_BRANCH_MISSES && !(unavailable & (1u << ARCH_BRANCH_MISSES));
+    wanted[PMU_EVENT_DTLB_MISSES] = dtlb_encoding(&enc[PMU_EVENT_DTLB_MISSES]);
+
+    enc[PMU_EVENT_INSTRUCTIONS] = (pmu_encoding_t){ 0xC0, 0x00 };
+    enc[PMU_EVENT_LLC_MISSES] = (pmu_encoding_t){ 0x2E, 0x41 };
+    enc[PMU_EVENT_BRANCH_MISSES] = (pmu_encoding_t){ 0xC5, 0x00 };
+
+    uint64_t global_enable = 0;
+    int next = 0;
+    for (int e = 0; e < PMU_EVENT_COUNT && next < num_gp; e++) {
+        if (!wanted[e]) continue;
+
+        wrmsr(IA32_PERFEVTSEL0 + next, 0);
+        wrmsr(IA32_PMC0 + next, 0);
+        wrmsr(IA32_PERFEVTSEL0 + next,
+              enc[e].event | ((uint32_t)enc[e].umask << 8) | EVTSEL_USR | EVTSEL_OS | EVTSEL_EN);
+
+        global_enable |= 1ull << next;
+        g_counter[e] = next++;
+    }
+    g_num_active = next;
+
+    if (g_num_active > 0 && version >= 2) {
+        wrmsr(IA32_PERF_GLOBAL_CTRL, global_enable);
+    }
+
+    // Some hypervisors advertise leaf 0xA without backing it: require the
+    // instruction counter to actually move before trusting any event
+    if (g_counter[PMU_EVENT_INSTRUCTIONS] >= 0) {
+        uint64_t before = rdpmc(g_counter[PMU_EVENT_INSTRUCTIONS]);
+        for (volatile int i = 0; i < 1000; i++) { }
+        uint64_t after = rdpmc(g_counter[PMU_EVENT_INSTRUCTIONS]);
+        if (((after - before) & g_counter_mask) == 0) {
+            disable_all(num_gp);
+        }
+    }
+
+    return g_num_active;
+}
+
+bool pmu_available(void) {
+    return g_num_active > 0;
+}
+
+bool pmu_event_supported(pmu_event_t event) {
+    return g_num_active > 0 && event < PMU_EVENT_COUNT && g_counter[event] >= 0;
+}
+
+const char* pmu_event_name(pmu_event_t event) {
+    return event < PMU_EVENT_COUNT ? g_event_names[event] : "unknown";
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+void pmu_read(pmu_counts_t* out) {
+    for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+        out->counts[e] = (g_num_active > 0 && g_counter[e] >= 0) ? rdpmc(g_counter[e]) : 0;
+    }
+}
+
+void pmu_delta(const pmu_counts_t* start, const pmu_counts_t* end, pmu_counts_t* out) {
+    for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+        out->counts[e] = (end->counts[e] - start->counts[e]) & g_counter_mask;
+    }
+}
@@ -0,0 +1,82 @@
+// ============================================================================
+// BAREFLOW - Hardware Performance Counters (Architectural PMU)
+// ============================================================================
+// File: kernel/pmu.h
+// Purpose: Count retired instructions, LLC misses, branch mispredicts and
+//          dTLB misses per profiled region via IA32_PERFEVTSELx / IA32_PMCx
+// ============================================================================
+//
+// Events are programmed once into general-purpose counters and left running;
+// a region is measured by reading all counters before and after it
+// (pmu_read + pmu_delta), the same way rdtsc brackets are used today.
+//
+// When CPUID leaf 0xA reports no PMU (QEMU TCG, KVM with pmu=off) or the
+// counters do not advance, pmu_init() leaves the PMU disabled, pmu_read()
+// returns zeros and callers keep working on cycles alone.
+// ============================================================================
+
+#ifndef PMU_H
+#define PMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PMU_EVENT_INSTRUCTIONS = 0,     // Instructions retired (architectural)
+    PMU_EVENT_LLC_MISSES,           // Last-level cache misses (architectural)
+    PMU_EVENT_BRANCH_MISSES,        // Branch mispredicts retired (architectural)
+    PMU_EVENT_DTLB_MISSES,          // dTLB load misses causing a walk (model-specific)
+    PMU_EVENT_COUNT
+} pmu_event_t;
+
+// Counter values (or deltas) for every event; unsupported events read 0
+typedef struct {
+    uint64_t counts[PMU_EVENT_COUNT];
+} pmu_counts_t;
+
+// ============================================================================
+// API Functions
+// ============================================================================
+
+/**
+ * Detect the PMU and program one counter per supported event
+ * Safe to call more than once.
+ *
+ * Returns: number of events being counted (0 = PMU unavailable)
+ */
+int pmu_init(void);
+
+/**
+ * True if at least one event is being counted
+ */
+bool pmu_available(void);
+
+/**
+ * True if 'event' is being counted
+ */
+bool pmu_event_supported(pmu_event_t event);
+
+/**
+ * Short event name used in exports (e.g. "llc_misses")
+ */
+const char* pmu_event_name(pmu_event_t event);
+
+/**
+ * Snapshot all counters (RDPMC)
+ */
+void pmu_read(pmu_counts_t* out);
+
+/**
+ * out = end - start, modulo the counter width
+ */
+void pmu_delta(const pmu_counts_t* start, const pmu_counts_t* end, pmu_counts_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PMU_H
@@ -0,0 +1,230 @@
+/**
+ * Binary Profile Export - Implementation
+ */
+
+#include "profile_binary.h"
+#include "profiling_export.h"
+#include <stddef.h>
+
+extern void* malloc(size_t size);
+extern void free(void* ptr);
+extern size_t strlen(const char* s);
+
+#define VARINT_MAX_BYTES 10     // 64-bit LEB128
+#define HEADER_MAX_BYTES (4 + 1 + 5)
+
+// ============================================================================
+// DEBUGCON PORT
+// ============================================================================
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile("inb %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+int debugcon_present(void) {
+    // QEMU and Bochs debugcon read back the port number; an unclaimed port
+    // floats to 0xFF
+    return inb(DEBUGCON_PORT) == DEBUGCON_PORT;
+}
+
+void debugcon_write(const uint8_t* data, uint32_t len) {
+    // One REP OUTSB: QEMU handles the whole burst without per-byte polling
+    asm volatile("rep outsb"
+                 : "+S"(data), "+c"(len)
+                 : "d"((uint16_t)DEBUGCON_PORT)
+                 : "memory");
+}
+
+// ============================================================================
+// CRC32
+// ============================================================================
+
+// Half-byte table: 64 bytes instead of 1 KB, two lookups per input byte
+static const uint32_t crc_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t profile_crc32(const uint8_t* data, uint32_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0xF];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0xF];
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// ENCODER
+// ============================================================================
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t len;
+    uint32_t capacity;
+    int overflow;
+} writer_t;
+
+static void put_u8(writer_t* w, uint8_t value) {
+    if (w->len >= w->capacity) {
+        w->overflow = 1;
+        return;
+    }
+    w->buf[w->len++] = value;
+}
+
+static void put_varint(writer_t* w, uint64_t value) {
+    while (value >= 0x80) {
+        put_u8(w, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_u8(w, (uint8_t)value);
+}
+
+static void put_bytes(writer_t* w, const char* data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        put_u8(w, (uint8_t)data[i]);
+    }
+}
+
+static void encode_module(writer_t* w, const module_profile_t* mod) {
+    uint32_t name_len = (uint32_t)strlen(mod->name);
+    put_varint(w, name_len);
+    put_bytes(w, mod->name, name_len);
+
+    uint64_t min_cycles = mod->call_count ? mod->min_cycles : 0;
+    uint64_t max_cycles = mod->call_count ? mod->max_cycles : 0;
+    put_varint(w, mod->call_count);
+    put_varint(w, mod->total_cycles);
+    put_varint(w, min_cycles);
+    put_varint(w, max_cycles - min_cycles);
+    put_varint(w, (uintptr_t)mod->code_ptr);
+    put_varint(w, mod->code_size);
+    put_u8(w, mod->loaded ? 1 : 0);
+
+    // Non-empty histogram buckets, indices delta-encoded
+    uint32_t nonzero = 0;
+    for (uint32_t b = 0; b < LATENCY_BUCKETS; b++) {
+        if (mod->latency.counts[b]) nonzero++;
+    }
+    put_varint(w, nonzero);
+
+    uint32_t prev = 0;
+    for (uint32_t b = 0; b < LATENCY_BUCKETS; b++) {
+        if (!mod->latency.counts[b]) continue;
+        put_varint(w, b - prev);
+        put_varint(w, mod->latency.counts[b]);
+        prev = b;
+    }
+
+    for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+        put_varint(w, mod->pmu_counts[e]);
+    }
+}
+
+uint32_t profile_binary_max_size_for(uint32_t num_modules) {
+    // Header + trailer + fixed payload fields + per module worst case
+    uint32_t per_module = (1 + MAX_MODULE_NAME) + 7 * VARINT_MAX_BYTES + 1 +
+                          VARINT_MAX_BYTES + LATENCY_BUCKETS * (2 + 5) +
+                          PMU_EVENT_COUNT * VARINT_MAX_BYTES;
+    return HEADER_MAX_BYTES + 4 + 5 + 7 * VARINT_MAX_BYTES + num_modules * per_module;
+}
+
+uint32_t profile_binary_max_size(const module_manager_t* mgr) {
+    return profile_binary_max_size_for(mgr->num_modules);
+}
+
+static int encode_frame(const module_manager_t* mgr, const profile_delta_t* delta,
+                        uint8_t* buf, uint32_t capacity) {
+    if (!mgr || !buf) return -1;
+
+    // The header ends with the payload length (a varint of unknown size),
+    // so the payload is encoded first behind a worst-case header gap
+    writer_t payload = { buf + HEADER_MAX_BYTES, 0, 0, 0 };
+    if (capacity <= HEADER_MAX_BYTES + 4) return -1;
+    payload.capacity = capacity - HEADER_MAX_BYTES - 4;
+
+    put_u8(&payload, (pmu_available() ? 1 : 0) | (timebase_invariant() ? 2 : 0) |
+                     (delta ? 4 : 0));
+    put_u8(&payload, LATENCY_SUB_BITS);
+    put_u8(&payload, LATENCY_MAX_BITS);
+    put_u8(&payload, PMU_EVENT_COUNT);
+    put_u8(&payload, (uint8_t)timebase_fence());
+    put_varint(&payload, timebase_hz());
+    put_varint(&payload, timebase_overhead());
+    if (delta) {
+        put_varint(&payload, delta->seq);
+        put_varint(&payload, delta->epoch_cycles);
+    }
+    put_varint(&payload, profiling_get_timestamp());
+    put_varint(&payload, mgr->total_calls);
+    put_varint(&payload, mgr->num_modules);
+
+    for (uint32_t i = 0; i < mgr->num_modules; i++) {
+        encode_module(&payload, &mgr->modules[i]);
+    }
+    if (payload.overflow) return -1;
+
+    // Header, right-aligned against the payload
+    uint8_t header[HEADER_MAX_BYTES];
+    writer_t hw = { header, 0, sizeof(header), 0 };
+    put_bytes(&hw, PROFILE_BINARY_MAGIC, 4);
+    put_u8(&hw, PROFILE_BINARY_VERSION);
+    put_varint(&hw, payload.len);
+
+    uint32_t start = HEADER_MAX_BYTES - hw.len;
+    for (uint32_t i = 0; i < hw.len; i++) {
+        buf[start + i] = header[i];
+    }
+
+    uint32_t body_len = hw.len + payload.len;
+    uint8_t* stream = buf + start;
+    uint32_t crc = profile_crc32(stream, body_len);
+    for (int i = 0; i < 4; i++) {
+        stream[body_len + i] = (uint8_t)(crc >> (8 * i));
+    }
+
+    // Callers expect the stream at buf[0]
+    uint32_t total = body_len + 4;
+    if (start) {
+        for (uint32_t i = 0; i < total; i++) {
+            buf[i] = stream[i];
+        }
+    }
+    return (int)total;
+}
+
+int profile_binary_encode(const module_manager_t* mgr, uint8_t* buf, uint32_t capacity) {
+    return encode_frame(mgr, NULL, buf, capacity);
+}
+
+int profile_binary_encode_delta(const module_manager_t* epoch, const profile_delta_t* delta,
+                                uint8_t* buf, uint32_t capacity) {
+    if (!delta) return -1;
+    return encode_frame(epoch, delta, buf, capacity);
+}
+
+int profile_binary_export(const module_manager_t* mgr) {
+    if (!mgr || !debugcon_present()) {
+        return -1;
+    }
+
+    uint32_t capacity = profile_binary_max_size(mgr);
+    uint8_t* buf = (uint8_t*)malloc(capacity);
+    if (!buf) {
+        return -1;
+    }
+
+    int len = profile_binary_encode(mgr, buf, capacity);
+    if (len > 0) {
+        debugcon_write(buf, (uint32_t)len);
+    }
+
+    free(buf);
+    return len;
+}
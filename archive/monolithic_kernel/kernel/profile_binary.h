@@ -0,0 +1,107 @@
+/**
+ * Binary Profile Export
+ *
+ * Compact alternative to profiling_export_json(): the module profile is
+ * encoded as LEB128 varints (deltas where values are ordered) with a
+ * CRC32 trailer and written in one burst to the QEMU/Bochs debugcon port
+ * (0xE9) with REP OUTSB, instead of byte-by-byte over the polled UART.
+ *
+ * tools/decode_profile.py turns the stream back into the same JSON that
+ * profiling_export_json() prints, for pgo_recompile.py.
+ *
+ * Stream layout (all multi-byte integers are unsigned LEB128 unless noted):
+ *
+ *   "BFPB"  u8 version  varint payload_len  payload  u32 crc32 (little endian)
+ *
+ *   payload:
+ *     u8 flags (bit 0: pmu_available, bit 1: invariant TSC, bit 2: delta frame)
+ *     u8 latency_sub_bits  u8 latency_max_bits  u8 pmu_event_count
+ *     u8 timebase_fence  tsc_hz  timebase_overhead_cycles          (version >= 2)
+ *     seq  epoch_cycles                         (version >= 3, delta frames only)
+ *     timestamp_cycles  total_calls  num_modules
+ *     per module:
+ *       name_len  name bytes
+ *       calls  total_cycles  min_cycles  (max_cycles - min_cycles)
+ *       code_address  code_size  u8 loaded
+ *       nonzero_buckets, then per bucket: (index - previous index)  count
+ *       pmu_event_count counters
+ *
+ *   The CRC (IEEE 802.3, same as zlib.crc32) covers magic through payload.
+ *
+ *   Delta frames (profile_stream.h) carry only what happened during one
+ *   epoch of continuous profiling; the host sums them in seq order.
+ */
+
+#ifndef PROFILE_BINARY_H
+#define PROFILE_BINARY_H
+
+#include <stdint.h>
+#include "module_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROFILE_BINARY_MAGIC "BFPB"
+#define PROFILE_BINARY_VERSION 3
+#define DEBUGCON_PORT 0xE9
+
+// Epoch identity for a delta frame
+typedef struct {
+    uint64_t seq;               // 1, 2, 3, ... per boot
+    uint64_t epoch_cycles;      // TSC cycles covered by the frame
+} profile_delta_t;
+
+/**
+ * True if a debugcon device answers on port 0xE9 (QEMU -debugcon, Bochs)
+ */
+int debugcon_present(void);
+
+/**
+ * Write raw bytes to the debugcon port in one burst
+ */
+void debugcon_write(const uint8_t* data, uint32_t len);
+
+/**
+ * Encode the module profile into 'buf'
+ *
+ * Returns: bytes written, or -1 if 'capacity' is too small
+ */
+int profile_binary_encode(const module_manager_t* mgr, uint8_t* buf, uint32_t capacity);
+
+/**
+ * Encode one epoch of counters (see profile_stream.h) as a delta frame
+ *
+ * Returns: bytes written, or -1 if 'capacity' is too small
+ */
+int profile_binary_encode_delta(const module_manager_t* epoch, const profile_delta_t* delta,
+                                uint8_t* buf, uint32_t capacity);
+
+/**
+ * Worst-case encoded size for 'mgr' (for sizing the buffer)
+ */
+uint32_t profile_binary_max_size(const module_manager_t* mgr);
+
+/**
+ * Worst-case encoded size for any manager holding 'num_modules' modules
+ */
+uint32_t profile_binary_max_size_for(uint32_t num_modules);
+
+/**
+ * Encode the module profile and write it to the debugcon port
+ *
+ * Returns: bytes written, or -1 if debugcon is absent or encoding failed
+ *          (callers fall back to profiling_export_json)
+ */
+int profile_binary_export(const module_manager_t* mgr);
+
+/**
+ * CRC32 (IEEE 802.3, reflected, init/xorout 0xFFFFFFFF)
+ */
+uint32_t profile_crc32(const uint8_t* data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILE_BINARY_H
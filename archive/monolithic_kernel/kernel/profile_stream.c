@@ -0,0 +1,213 @@
+// ============================================================================
+// BAREFLOW - Continuous Profiling Implementation
+// ============================================================================
+
+#include "profile_stream.h"
+#include "profile_binary.h"
+#include "profiling_export.h"
+#include <stddef.h>
+
+extern void* malloc(size_t size);
+extern void free(void* ptr);
+extern void* memset(void* s, int c, size_t n);
+extern void* memcpy(void* dest, const void* src, size_t n);
+
+typedef struct {
+    module_manager_t counters;  // Per-module deltas for this epoch
+    uint64_t start_tsc;
+    uint64_t seq;
+} profile_epoch_t;
+
+static const module_manager_t* g_mgr = NULL;
+static profile_epoch_t* g_epochs[2] = { NULL, NULL };
+static volatile uint32_t g_active = 0;
+static volatile bool g_pending = false;
+static uint64_t g_pending_cycles = 0;     // Length of the pending epoch
+
+static uint64_t g_period_cycles = 0;
+static uint64_t g_deadline = 0;
+static uint64_t g_next_seq = 1;
+
+static uint8_t* g_frame_buf = NULL;
+static uint32_t g_frame_capacity = 0;
+static bool g_binary = false;
+
+static profile_stream_stats_t g_stats;
+
+// ============================================================================
+// Epoch Buffers
+// ============================================================================
+
+static void epoch_clear(profile_epoch_t* epoch) {
+    memset(&epoch->counters, 0, sizeof(module_manager_t));
+    for (uint32_t i = 0; i < MAX_MODULES; i++) {
+        epoch->counters.modules[i].min_cycles = UINT64_MAX;
+    }
+}
+
+// Names, addresses and load state come from the live manager at export
+// time (modules may be loaded or overridden mid-epoch)
+static void epoch_sync_metadata(profile_epoch_t* epoch) {
+    epoch->counters.num_modules = g_mgr->num_modules;
+    for (uint32_t i = 0; i < g_mgr->num_modules; i++) {
+        const module_profile_t* live = &g_mgr->modules[i];
+        module_profile_t* mod = &epoch->counters.modules[i];
+        memcpy(mod->name, live->name, MAX_MODULE_NAME);
+        mod->code_ptr = live->code_ptr;
+        mod->code_size = live->code_size;
+        mod->loaded = live->loaded;
+    }
+}
+
+static void epoch_export(profile_epoch_t* epoch, uint64_t epoch_cycles) {
+    profile_delta_t delta = { epoch->seq, epoch_cycles };
+    epoch_sync_metadata(epoch);
+
+    if (g_binary) {
+        int len = profile_binary_encode_delta(&epoch->counters, &delta,
+                                              g_frame_buf, g_frame_capacity);
+        if (len > 0) {
+            debugcon_write(g_frame_buf, (uint32_t)len);
+            g_stats.bytes_exported += (uint32_t)len;
+        }
+    } else {
+        serial_puts("--- BEGIN DELTA JSON ---\n");
+        profiling_export_delta_json(&epoch->counters, &delta);
+        serial_puts("--- END DELTA JSON ---\n");
+    }
+
+    g_stats.epochs_exported++;
+    epoch_clear(epoch);
+}
+
+// ============================================================================
+// Control
+// ============================================================================
+
+int profile_stream_start(const module_manager_t* mgr, uint32_t period_ms) {
+    if (!mgr || period_ms == 0 || timebase_cycles_per_ms() == 0) {
+        return -1;
+    }
+    if (g_mgr) {
+        profile_stream_stop();
+    }
+
+    g_epochs[0] = (profile_epoch_t*)malloc(sizeof(profile_epoch_t));
+    g_epochs[1] = (profile_epoch_t*)malloc(sizeof(profile_epoch_t));
+    g_binary = debugcon_present();
+    g_frame_capacity = g_binary ? profile_binary_max_size_for(MAX_MODULES) : 0;
+    g_frame_buf = g_binary ? (uint8_t*)malloc(g_frame_capacity) : NULL;
+
+    if (!g_epochs[0] || !g_epochs[1] || (g_binary && !g_frame_buf)) {
+        free(g_epochs[0]);
+        free(g_epochs[1]);
+        free(g_frame_buf);
+        g_epochs[0] = g_epochs[1] = NULL;
+        g_frame_buf = NULL;
+        return -1;
+    }
+
+    epoch_clear(g_epochs[0]);
+    epoch_clear(g_epochs[1]);
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    uint64_t now = timebase_begin();
+    g_period_cycles = timebase_cycles_per_ms() * period_ms;
+    g_deadline = now + g_period_cycles;
+    g_next_seq = 1;
+    g_active = 0;
+    g_pending = false;
+    g_epochs[0]->start_tsc = now;
+    g_epochs[0]->seq = g_next_seq++;
+    g_mgr = mgr;
+
+    return 0;
+}
+
+void profile_stream_stop(void) {
+    if (!g_mgr) return;
+
+    if (g_pending) {
+        epoch_export(g_epochs[g_active ^ 1], g_pending_cycles);
+        g_pending = false;
+    }
+
+    profile_epoch_t* current = g_epochs[g_active];
+    if (current->counters.total_calls) {
+        epoch_export(current, timebase_begin() - current->start_tsc);
+    }
+
+    g_mgr = NULL;
+    free(g_epochs[0]);
+    free(g_epochs[1]);
+    free(g_frame_buf);
+    g_epochs[0] = g_epochs[1] = NULL;
+    g_frame_buf = NULL;
+}
+
+bool profile_stream_active(void) {
+    return g_mgr != NULL;
+}
+
+// ============================================================================
+// Recording / Swapping
+// ============================================================================
+
+void profile_stream_record(uint32_t module_index, uint64_t cycles, const pmu_counts_t* pmu) {
+    if (!g_mgr || module_index >= MAX_MODULES) return;
+
+    profile_epoch_t* epoch = g_epochs[g_active];
+    module_profile_t* mod = &epoch->counters.modules[module_index];
+
+    mod->call_count++;
+    mod->total_cycles += cycles;
+    if (cycles < mod->min_cycles) mod->min_cycles = cycles;
+    if (cycles > mod->max_cycles) mod->max_cycles = cycles;
+    latency_hist_record(&mod->latency, cycles);
+
+    if (pmu) {
+        for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+            mod->pmu_counts[e] += pmu->counts[e];
+        }
+    }
+
+    epoch->counters.total_calls++;
+}
+
+void profile_stream_tick(void) {
+    if (!g_mgr) return;
+
+    uint64_t now = timebase_begin();
+    if (now < g_deadline) return;
+
+    if (g_pending) {
+        // Exporter is behind: keep filling the active epoch
+        g_stats.epochs_extended++;
+        g_deadline = now + g_period_cycles;
+        return;
+    }
+
+    profile_epoch_t* filled = g_epochs[g_active];
+    profile_epoch_t* next = g_epochs[g_active ^ 1];
+    next->start_tsc = now;
+    next->seq = g_next_seq++;
+
+    g_pending_cycles = now - filled->start_tsc;
+    g_active ^= 1;
+    g_pending = true;
+    g_deadline = now + g_period_cycles;
+}
+
+int profile_stream_poll(void) {
+    profile_stream_tick();
+    if (!g_mgr || !g_pending) return 0;
+
+    epoch_export(g_epochs[g_active ^ 1], g_pending_cycles);
+    g_pending = false;
+    return 1;
+}
+
+void profile_stream_get_stats(profile_stream_stats_t* out) {
+    if (!out) return;
+    *out = g_stats;
+}
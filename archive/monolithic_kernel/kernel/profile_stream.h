@@ -0,0 +1,86 @@
+// ============================================================================
+// BAREFLOW - Continuous Profiling (Double-Buffered Delta Export)
+// ============================================================================
+// File: kernel/profile_stream.h
+// Purpose: Export per-epoch module counters periodically with fixed memory,
+//          for long-running workloads instead of one profiling_trigger_export
+// ============================================================================
+//
+// Two epoch buffers hold per-module counters (calls, cycles, min/max,
+// latency histogram, PMU). module_execute() records into the active one.
+// Every period, profile_stream_tick() makes the other buffer active and
+// marks the filled one pending; profile_stream_poll() exports the pending
+// buffer as a delta frame (binary over debugcon, JSON over serial
+// otherwise) and clears it.
+//
+// There is no timer interrupt behind tick: the CONTINUOUS=1 loop in
+// kernel.c calls profile_stream_poll() between module calls, so epochs end
+// at the first poll after the period, never in the middle of a record.
+// If the pending buffer has not been exported when the next period ends,
+// the active epoch is simply extended: nothing is dropped and memory stays
+// at two buffers plus one encode buffer, all allocated by
+// profile_stream_start().
+//
+// tools/pgo_cache_sync.py --deltas sums the frames in seq order.
+// ============================================================================
+
+#ifndef PROFILE_STREAM_H
+#define PROFILE_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "module_loader.h"
+
+#define PROFILE_STREAM_DEFAULT_MS 1000
+
+typedef struct {
+    uint64_t epochs_exported;
+    uint64_t epochs_extended;   // Periods that ended while an export was still pending
+    uint64_t bytes_exported;    // Binary frames only
+} profile_stream_stats_t;
+
+/**
+ * Start continuous profiling of 'mgr' with one epoch every 'period_ms'
+ *
+ * Calibrates the TSC frequency if nothing has asked for it yet.
+ *
+ * Returns: 0 on success, -1 if the TSC frequency is unknown, the period
+ *          is 0 or the buffers cannot be allocated
+ */
+int profile_stream_start(const module_manager_t* mgr, uint32_t period_ms);
+
+/**
+ * Export the epoch in progress (and any pending one), then release the buffers
+ */
+void profile_stream_stop(void);
+
+/**
+ * True between profile_stream_start and profile_stream_stop
+ */
+bool profile_stream_active(void);
+
+/**
+ * Add one call of module 'module_index' to the active epoch
+ * (no-op when streaming is off)
+ */
+void profile_stream_record(uint32_t module_index, uint64_t cycles, const pmu_counts_t* pmu);
+
+/**
+ * Swap epoch buffers if the period has elapsed
+ * Not interrupt-safe: must not run while profile_stream_record() is active
+ */
+void profile_stream_tick(void);
+
+/**
+ * Tick, then export the pending epoch if there is one
+ *
+ * Returns: 1 if a frame was exported, 0 otherwise
+ */
+int profile_stream_poll(void);
+
+/**
+ * Export counters so far
+ */
+void profile_stream_get_stats(profile_stream_stats_t* out);
+
+#endif // PROFILE_STREAM_H
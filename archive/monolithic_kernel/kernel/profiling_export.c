@@ -4,6 +4,7 @@
 
 #include "profiling_export.h"
 #include "module_loader.h"
+#include "profile_binary.h"
 
 // ============================================================================
 // SERIAL PORT (COM1) DRIVER
@@ -170,12 +171,10 @@ void serial_put_uint64(uint64_t value) {
 // ============================================================================
 
 uint64_t profiling_get_timestamp(void) {
-    uint32_t low, high;
-    asm volatile("rdtsc" : "=a"(low), "=d"(high));
-    return ((uint64_t)high << 32) | low;
+    return timebase_begin();
 }
 
-int profiling_export_json(const module_manager_t* mgr) {
+static int export_json(const module_manager_t* mgr, const profile_delta_t* delta) {
     if (!mgr) {
         return -1;
     }
@@ -189,12 +188,36 @@ int profiling_export_json(const module_manager_t* mgr) {
     serial_puts("  \"timestamp_cycles\": ");
     serial_put_uint64(timestamp);
     serial_puts(",\n");
+    if (delta) {
+        serial_puts("  \"delta\": { \"seq\": ");
+        serial_put_uint64(delta->seq);
+        serial_puts(", \"epoch_cycles\": ");
+        serial_put_uint64(delta->epoch_cycles);
+        serial_puts(" },\n");
+    }
     serial_puts("  \"total_calls\": ");
     serial_put_uint64(mgr->total_calls);
     serial_puts(",\n");
     serial_puts("  \"num_modules\": ");
     serial_put_int(mgr->num_modules);
     serial_puts(",\n");
+    serial_puts("  \"latency_layout\": { \"sub_bits\": ");
+    serial_put_int(LATENCY_SUB_BITS);
+    serial_puts(", \"max_bits\": ");
+    serial_put_int(LATENCY_MAX_BITS);
+    serial_puts(" },\n");
+    serial_puts("  \"pmu_available\": ");
+    serial_puts(pmu_available() ? "true" : "false");
+    serial_puts(",\n");
+    serial_puts("  \"timebase\": { \"tsc_hz\": ");
+    serial_put_uint64(timebase_hz());
+    serial_puts(", \"invariant\": ");
+    serial_puts(timebase_invariant() ? "true" : "false");
+    serial_puts(", \"fence\": \"");
+    serial_puts(timebase_fence_name(timebase_fence()));
+    serial_puts("\", \"overhead_cycles\": ");
+    serial_put_uint(timebase_overhead());
+    serial_puts(" },\n");
     serial_puts("  \"modules\": [\n");
 
     // Export each module
@@ -218,6 +241,11 @@ int profiling_export_json(const module_manager_t* mgr) {
         serial_put_uint64(mod->total_cycles);
         serial_puts(",\n");
 
+        // Wall time (0 when the TSC could not be calibrated)
+        serial_puts("      \"total_ns\": ");
+        serial_put_uint64(timebase_cycles_to_ns(mod->total_cycles));
+        serial_puts(",\n");
+
         // Min cycles
         uint64_t min_cycles = (mod->call_count == 0) ? 0 : mod->min_cycles;
         serial_puts("      \"min_cycles\": ");
@@ -248,6 +276,37 @@ int profiling_export_json(const module_manager_t* mgr) {
         serial_put_uint(mod->code_size);
         serial_puts(",\n");
 
+        // Latency distribution: percentiles plus the non-empty buckets as
+        // [low_cycles, count] pairs, so the host can merge runs
+        serial_puts("      \"latency\": { \"p50\": ");
+        serial_put_uint64(latency_hist_percentile(&mod->latency, LATENCY_P50));
+        serial_puts(", \"p99\": ");
+        serial_put_uint64(latency_hist_percentile(&mod->latency, LATENCY_P99));
+        serial_puts(", \"p999\": ");
+        serial_put_uint64(latency_hist_percentile(&mod->latency, LATENCY_P999));
+        serial_puts(", \"buckets\": [");
+        int first_bucket = 1;
+        for (uint32_t b = 0; b < LATENCY_BUCKETS; b++) {
+            if (mod->latency.counts[b] == 0) continue;
+            serial_puts(first_bucket ? "[" : ", [");
+            serial_put_uint64(latency_hist_bucket_low(b));
+            serial_puts(", ");
+            serial_put_uint(mod->latency.counts[b]);
+            serial_putchar(']');
+            first_bucket = 0;
+        }
+        serial_puts("] },\n");
+
+        // Hardware counters (all 0 when the PMU is unavailable)
+        serial_puts("      \"pmu\": {");
+        for (int e = 0; e < PMU_EVENT_COUNT; e++) {
+            serial_puts(e ? ", \"" : " \"");
+            serial_puts(pmu_event_name((pmu_event_t)e));
+            serial_puts("\": ");
+            serial_put_uint64(mod->pmu_counts[e]);
+        }
+        serial_puts(" },\n");
+
         // Loaded status
         serial_puts("      \"loaded\": ");
         serial_puts(mod->loaded ? "true" : "false");
@@ -266,10 +325,32 @@ int profiling_export_json(const module_manager_t* mgr) {
     return 0;
 }
 
+int profiling_export_json(const module_manager_t* mgr) {
+    return export_json(mgr, NULL);
+}
+
+int profiling_export_delta_json(const module_manager_t* epoch, const profile_delta_t* delta) {
+    if (!delta) {
+        return -1;
+    }
+    return export_json(epoch, delta);
+}
+
 int profiling_trigger_export(const module_manager_t* mgr) {
     // Print header (SERIAL ONLY - no VGA output to avoid mixing)
     serial_puts("\n\n");
     serial_puts("=== PROFILING DATA EXPORT ===\n");
+
+    // Fast path: binary profile over debugcon, only a summary on the UART
+    int binary_len = profile_binary_export(mgr);
+    if (binary_len > 0) {
+        serial_puts("Format: binary (debugcon 0xE9, ");
+        serial_put_int(binary_len);
+        serial_puts(" bytes)\n");
+        serial_puts("Decode: python3 tools/decode_profile.py <debugcon file>\n");
+        serial_puts("\n=== END EXPORT ===\n\n");
+        return 0;
+    }
     serial_puts("Format: JSON\n");
     serial_puts("Timestamp: ");
     serial_put_uint64(profiling_get_timestamp());
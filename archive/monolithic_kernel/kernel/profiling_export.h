@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include "module_loader.h"
+#include "profile_binary.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,16 +64,26 @@ void serial_put_uint64(uint64_t value);
  * {
  *   "format_version": "1.0",
  *   "timestamp_cycles": <rdtsc value>,
+ *   "latency_layout": { "sub_bits": 3, "max_bits": 40 },
+ *   "pmu_available": true|false,
+ *   "timebase": { "tsc_hz": <Hz, 0 if uncalibrated>, "invariant": true|false,
+ *                 "fence": "rdtscp"|"lfence"|"none", "overhead_cycles": <n> },
  *   "modules": [
  *     {
  *       "name": "module_name",
  *       "calls": <call_count>,
  *       "total_cycles": <total_cycles>,
+ *       "total_ns": <total_cycles converted with tsc_hz>,
  *       "min_cycles": <min>,
  *       "max_cycles": <max>,
  *       "avg_cycles": <avg>,
  *       "code_address": "0xXXXXXXXX",
- *       "code_size": <bytes>
+ *       "code_size": <bytes>,
+ *       "latency": { "p50": <cycles>, "p99": <cycles>, "p999": <cycles>,
+ *                    "buckets": [[<low_cycles>, <count>], ...] },
+ *       "pmu": { "instructions": <n>, "llc_misses": <n>,
+ *                "branch_misses": <n>, "dtlb_misses": <n> },
+ *       "loaded": true|false
  *     },
  *     ...
  *   ]
@@ -85,11 +96,21 @@ void serial_put_uint64(uint64_t value);
  */
 int profiling_export_json(const module_manager_t* mgr);
 
+/**
+ * Export one epoch of continuous profiling (profile_stream.h) in the same
+ * JSON format, plus "delta": { "seq": <n>, "epoch_cycles": <cycles> }
+ * after "timestamp_cycles"
+ *
+ * Returns: 0 on success, -1 on failure
+ */
+int profiling_export_delta_json(const module_manager_t* epoch, const profile_delta_t* delta);
+
 /**
  * Export profiling data and trigger host-side recompilation
  *
  * This is the main entry point for the profile-guided optimization workflow:
- * 1. Exports profiling data via serial port
+ * 1. Exports profiling data: binary over debugcon when QEMU provides it
+ *    (profile_binary.h), otherwise JSON via serial port
  * 2. Host receives data and identifies hot functions
  * 3. Host recompiles modules with LLVM -O2/-O3 + PGO
  * 4. Host updates module cache on disk
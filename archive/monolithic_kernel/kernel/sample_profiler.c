@@ -0,0 +1,247 @@
+// ============================================================================
+// BAREFLOW - Statistical Sampling Profiler Implementation
+// ============================================================================
+
+#include "sample_profiler.h"
+#include "profiling_export.h"
+#include "pit.h"
+#include <stddef.h>
+
+// External functions from stdlib
+extern void* memset(void* s, int c, size_t n);
+
+// Local APIC registers (byte offsets from the MMIO base)
+#define IA32_APIC_BASE_MSR  0x1B
+#define APIC_BASE_ENABLE    (1u << 11)
+#define LAPIC_ID            0x020
+#define LAPIC_EOI           0x0B0
+#define LAPIC_SVR           0x0F0
+#define LAPIC_LVT_TIMER     0x320
+#define LAPIC_TIMER_INIT    0x380
+#define LAPIC_TIMER_CUR     0x390
+#define LAPIC_TIMER_DIV     0x3E0
+
+#define SVR_APIC_ENABLE     (1u << 8)
+#define LVT_MASKED          (1u << 16)
+#define LVT_PERIODIC        (1u << 17)
+#define TIMER_DIV_16        0x3
+
+// PIT channel 2 is used as the reference clock for calibration
+#define CALIBRATE_MS        10
+
+// Top of the kernel stack (entry.asm); the frame chain ends here
+#define SAMPLE_STACK_TOP    0x90000
+
+static volatile uint32_t* g_lapic = NULL;
+static uint32_t g_ticks_per_ms = 0;
+static sample_buffer_t g_buffers[SAMPLE_MAX_CPUS];
+
+// ============================================================================
+// Hardware Access
+// ============================================================================
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return g_lapic[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    g_lapic[reg / 4] = value;
+}
+
+static int cpu_has_apic(void) {
+    uint32_t eax, ebx, ecx, edx;
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+    return (edx >> 9) & 1;
+}
+
+// Start the LAPIC count with the PIT window and read it when the window ends
+static void lapic_count_start(void* ctx) {
+    (void)ctx;
+    lapic_write(LAPIC_TIMER_INIT, 0xFFFFFFFF);
+}
+
+static void lapic_count_end(void* ctx) {
+    *(uint32_t*)ctx = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CUR);
+}
+
+// LAPIC timer ticks (at divide-by-16) per millisecond
+static uint32_t calibrate_timer(void) {
+    lapic_write(LAPIC_TIMER_DIV, TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LVT_MASKED | SAMPLE_VECTOR);
+
+    uint32_t elapsed = 0;
+    pit_window(CALIBRATE_MS, lapic_count_start, lapic_count_end, &elapsed);
+    lapic_write(LAPIC_TIMER_INIT, 0);
+
+    return elapsed / CALIBRATE_MS;
+}
+
+// ============================================================================
+// Initialization / Control
+// ============================================================================
+
+int sample_profiler_init(void) {
+    if (!cpu_has_apic()) {
+        return -1;
+    }
+
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(IA32_APIC_BASE_MSR));
+    if (!(lo & APIC_BASE_ENABLE)) {
+        lo |= APIC_BASE_ENABLE;
+        asm volatile("wrmsr" : : "c"(IA32_APIC_BASE_MSR), "a"(lo), "d"(hi));
+    }
+
+    // Flat, unpaged kernel: the physical MMIO base is directly addressable
+    g_lapic = (volatile uint32_t*)(lo & 0xFFFFF000);
+    lapic_write(LAPIC_SVR, SVR_APIC_ENABLE | SAMPLE_SPURIOUS);
+
+    g_ticks_per_ms = calibrate_timer();
+    if (g_ticks_per_ms == 0) {
+        return -1;
+    }
+
+    sample_profiler_reset();
+    return 0;
+}
+
+int sample_profiler_start(uint32_t hz) {
+    if (!g_lapic || hz == 0 || hz > 10000) {
+        return -1;
+    }
+
+    // ticks_per_ms * 1000 / hz, split so it stays in 32 bits (no __udivdi3)
+    uint32_t period = (g_ticks_per_ms / hz) * 1000 + ((g_ticks_per_ms % hz) * 1000) / hz;
+    if (period == 0) {
+        return -1;
+    }
+
+    lapic_write(LAPIC_TIMER_DIV, TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LVT_PERIODIC | SAMPLE_VECTOR);
+    lapic_write(LAPIC_TIMER_INIT, period);
+    return 0;
+}
+
+void sample_profiler_stop(void) {
+    if (!g_lapic) return;
+
+    lapic_write(LAPIC_LVT_TIMER, LVT_MASKED | SAMPLE_VECTOR);
+    lapic_write(LAPIC_TIMER_INIT, 0);
+}
+
+void sample_profiler_reset(void) {
+    memset(g_buffers, 0, sizeof(g_buffers));
+}
+
+// ============================================================================
+// Sampling (interrupt context)
+// ============================================================================
+
+// Walk the EBP chain of the interrupted code. Each frame holds the caller's
+// EBP at [ebp] and the return address at [ebp+4]; frames must sit on the
+// stack above the interrupted ESP and move strictly towards its top, which
+// also stops the walk on garbage EBPs from code without frame pointers.
+static uint32_t walk_stack(const sample_frame_t* frame, uint32_t* out) {
+    uint32_t low = frame->esp + 12;     // ESP of the interrupted code (no ring change)
+    uint32_t ebp = frame->ebp;
+    uint32_t depth = 0;
+
+    while (depth < SAMPLE_MAX_DEPTH) {
+        if (ebp < low || ebp > SAMPLE_STACK_TOP - 8 || (ebp & 3)) {
+            break;
+        }
+
+        const uint32_t* fp = (const uint32_t*)ebp;
+        uint32_t ret = fp[1];
+        if (ret == 0) {
+            break;
+        }
+        out[depth++] = ret;
+
+        low = ebp + 8;
+        ebp = fp[0];
+    }
+
+    return depth;
+}
+
+void sample_profiler_tick(const sample_frame_t* frame) {
+    uint32_t cpu = lapic_read(LAPIC_ID) >> 24;
+
+    if (cpu < SAMPLE_MAX_CPUS) {
+        sample_buffer_t* buf = &g_buffers[cpu];
+
+        if (buf->count < SAMPLE_BUFFER_SIZE) {
+            sample_t* s = &buf->samples[buf->count];
+            s->eip = frame->eip;
+            s->depth = walk_stack(frame, s->stack);
+            buf->count++;
+        } else {
+            buf->dropped++;
+        }
+    }
+
+    lapic_write(LAPIC_EOI, 0);
+}
+
+const sample_buffer_t* sample_profiler_buffer(uint32_t cpu) {
+    return cpu < SAMPLE_MAX_CPUS ? &g_buffers[cpu] : NULL;
+}
+
+// ============================================================================
+// JSON Export
+// ============================================================================
+
+static void put_hex(uint32_t value) {
+    serial_puts("\"0x");
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        int nibble = (value >> shift) & 0xF;
+        serial_putchar(nibble < 10 ? '0' + nibble : 'A' + nibble - 10);
+    }
+    serial_putchar('"');
+}
+
+int sample_profiler_export_json(void) {
+    serial_puts("\n=== SAMPLE PROFILE EXPORT ===\n");
+    serial_puts("--- BEGIN JSON ---\n");
+    serial_puts("{\n");
+    serial_puts("  \"format_version\": \"1.0\",\n");
+    serial_puts("  \"type\": \"sample_profile\",\n");
+    serial_puts("  \"timer_ticks_per_ms\": ");
+    serial_put_uint(g_ticks_per_ms);
+    serial_puts(",\n");
+    serial_puts("  \"cpus\": [\n");
+
+    for (uint32_t cpu = 0; cpu < SAMPLE_MAX_CPUS; cpu++) {
+        const sample_buffer_t* buf = &g_buffers[cpu];
+
+        serial_puts("    {\n");
+        serial_puts("      \"cpu\": ");
+        serial_put_uint(cpu);
+        serial_puts(",\n      \"dropped\": ");
+        serial_put_uint(buf->dropped);
+        serial_puts(",\n      \"samples\": [\n");
+
+        for (uint32_t i = 0; i < buf->count; i++) {
+            const sample_t* s = &buf->samples[i];
+
+            serial_puts("        { \"eip\": ");
+            put_hex(s->eip);
+            serial_puts(", \"stack\": [");
+            for (uint32_t d = 0; d < s->depth; d++) {
+                if (d) serial_puts(", ");
+                put_hex(s->stack[d]);
+            }
+            serial_puts(i + 1 < buf->count ? "] },\n" : "] }\n");
+        }
+
+        serial_puts("      ]\n");
+        serial_puts(cpu + 1 < SAMPLE_MAX_CPUS ? "    },\n" : "    }\n");
+    }
+
+    serial_puts("  ]\n");
+    serial_puts("}\n");
+    serial_puts("--- END JSON ---\n\n");
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// ============================================================================
+// BAREFLOW - Statistical Sampling Profiler (Local APIC Timer)
+// ============================================================================
+// File: kernel/sample_profiler.h
+// Purpose: Periodic EIP + call-stack sampling for whole-kernel hot spots
+// ============================================================================
+//
+// The local APIC timer fires SAMPLE_VECTOR at a fixed rate. Each interrupt
+// records the interrupted EIP and the return addresses found by walking the
+// EBP frame-pointer chain into the current core's buffer. Nothing is
+// symbolized in the kernel: the export carries raw addresses, which
+// tools/symbolize_samples.py resolves offline against build/kernel.map.
+//
+// Unlike function_profiler.c this needs no registration, so it also sees
+// time spent in LLVM, llvm-libc and JIT'd code. Stacks are only complete
+// through code built with -fno-omit-frame-pointer.
+// ============================================================================
+
+#ifndef SAMPLE_PROFILER_H
+#define SAMPLE_PROFILER_H
+
+#include <stdint.h>
+
+#define SAMPLE_VECTOR       0x40    // LAPIC timer vector (above the PIC range)
+#define SAMPLE_SPURIOUS     0xFF    // LAPIC spurious vector (default_isr)
+#define SAMPLE_MAX_CPUS     4       // Per-core buffers, indexed by LAPIC ID
+#define SAMPLE_MAX_DEPTH    16      // Return addresses kept per sample
+#define SAMPLE_BUFFER_SIZE  512     // Samples per core
+#define SAMPLE_DEFAULT_HZ   1000
+
+// Register state pushed by irq_lapic_timer (pusha) followed by the
+// CPU's interrupt frame
+typedef struct {
+    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax;
+    uint32_t eip, cs, eflags;
+} sample_frame_t;
+
+// One sample (72 bytes)
+typedef struct {
+    uint32_t eip;                       // Interrupted instruction
+    uint32_t depth;                     // Valid entries in stack[]
+    uint32_t stack[SAMPLE_MAX_DEPTH];   // Return addresses, innermost first
+} sample_t;
+
+typedef struct {
+    uint32_t count;                     // Samples stored
+    uint32_t dropped;                   // Samples lost because the buffer was full
+    sample_t samples[SAMPLE_BUFFER_SIZE];
+} sample_buffer_t;
+
+// ============================================================================
+// API Functions
+// ============================================================================
+
+/**
+ * Enable the local APIC and calibrate its timer against PIT channel 2
+ * Must be called after idt_init(); does not start sampling.
+ *
+ * Returns: 0 on success, -1 if the CPU has no local APIC
+ */
+int sample_profiler_init(void);
+
+/**
+ * Start periodic sampling at 'hz' samples per second per core
+ * Returns: 0 on success, -1 if not initialized or hz is out of range
+ */
+int sample_profiler_start(uint32_t hz);
+
+/**
+ * Stop sampling (masks the LAPIC timer, buffers are kept)
+ */
+void sample_profiler_stop(void);
+
+/**
+ * Clear all per-core buffers
+ */
+void sample_profiler_reset(void);
+
+/**
+ * LAPIC timer interrupt handler (called from idt_stub.asm)
+ */
+void sample_profiler_tick(const sample_frame_t* frame);
+
+/**
+ * Get the buffer of one core (NULL if cpu is out of range)
+ */
+const sample_buffer_t* sample_profiler_buffer(uint32_t cpu);
+
+/**
+ * Export raw samples as JSON via serial port, framed with the same
+ * "--- BEGIN JSON ---" / "--- END JSON ---" markers as profiling_export.c
+ *
+ * Returns: 0 on success
+ */
+int sample_profiler_export_json(void);
+
+#endif // SAMPLE_PROFILER_H
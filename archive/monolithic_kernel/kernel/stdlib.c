@@ -154,4 +154,22 @@ int abs(int n) {
 
 long labs(long n) {
     return n < 0 ? -n : n;
+}
+
+// Shift-subtract 64-bit division (no __udivdi3 in the kernel)
+uint64_t udiv64(uint64_t dividend, uint64_t divisor) {
+    if (divisor == 0) return 0;
+
+    uint64_t quotient = 0;
+    uint64_t remainder = 0;
+
+    for (int i = 63; i >= 0; i--) {
+        remainder = (remainder << 1) | ((dividend >> i) & 1);
+        if (remainder >= divisor) {
+            remainder -= divisor;
+            quotient |= (1ULL << i);
+        }
+    }
+
+    return quotient;
 }
\ No newline at end of file
@@ -28,5 +28,6 @@ char* strcat(char* dest, const char* src);
 // Math
 int abs(int n);
 long labs(long n);
+uint64_t udiv64(uint64_t dividend, uint64_t divisor);   // 0 if divisor is 0
 
 #endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+/**
+ * Shared helpers for the in-kernel test suites
+ */
+
+#include "test_helpers.h"
+#include "vga.h"
+
+void test_print_count(int value) {
+    char buf[16];
+    int idx = 0;
+
+    if (value == 0) {
+        buf[idx++] = '0';
+    }
+    while (value > 0) {
+        buf[idx++] = '0' + (value % 10);
+        value /= 10;
+    }
+    while (idx > 0) {
+        char c[2] = { buf[--idx], '\0' };
+        terminal_writestring(c);
+    }
+}
@@ -0,0 +1,21 @@
+/**
+ * Shared helpers for the in-kernel test suites
+ */
+
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Print a non-negative count in decimal on the terminal
+ */
+void test_print_count(int value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_HELPERS_H
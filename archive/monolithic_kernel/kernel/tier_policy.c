@@ -0,0 +1,103 @@
+// ============================================================================
+// BAREFLOW - Cost-Model Tiering Policy Implementation
+// ============================================================================
+
+#include "tier_policy.h"
+#include <stddef.h>
+
+extern void* memset(void* s, int c, size_t n);
+
+// Cycles per call relative to O0, per mille
+static const uint32_t g_speed[TIER_LEVELS] = { 1000, 550, 400, 350 };
+
+// Compile cycles per IR instruction at each level (O0 is never compiled)
+static const uint32_t g_cost_per_insn[TIER_LEVELS] = { 0, 1500, 5000, 12000 };
+
+// Caps keeping benefit = saved * projected within 64 bits
+#define MAX_PROJECTED_CALLS (1u << 28)
+
+void tier_state_init(tier_state_t* state, uint32_t ir_size) {
+    if (!state) return;
+    memset(state, 0, sizeof(tier_state_t));
+    state->ir_size = ir_size ? ir_size : TIER_DEFAULT_SIZE;
+}
+
+static uint32_t decayed(const tier_state_t* state, uint32_t epoch) {
+    uint32_t periods = epoch - state->epoch;
+    return periods >= 32 ? 0 : state->hotness >> periods;
+}
+
+void tier_record_calls(tier_state_t* state, uint64_t now, uint32_t calls) {
+    if (!state) return;
+
+    uint32_t epoch = (uint32_t)(now >> TIER_DECAY_SHIFT);
+    uint32_t hotness = decayed(state, epoch);
+    state->hotness = hotness > UINT32_MAX - calls ? UINT32_MAX : hotness + calls;
+    state->epoch = epoch;
+}
+
+void tier_record_cycles(tier_state_t* state, uint64_t cycles) {
+    if (!state) return;
+
+    uint32_t sample = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+    if (state->samples == 0) {
+        // First sample at this level replaces the estimate carried over
+        state->cycles_avg = sample;
+    } else {
+        state->cycles_avg = state->cycles_avg - (state->cycles_avg >> 3) + (sample >> 3);
+    }
+    if (state->samples != UINT32_MAX) {
+        state->samples++;
+    }
+}
+
+void tier_level_changed(tier_state_t* state, int from, int to) {
+    if (!state || from < 0 || from >= TIER_LEVELS || to < 0 || to >= TIER_LEVELS) return;
+
+    // Expected cycles at the new level until it has samples of its own
+    uint32_t ratio = g_speed[to] * 1024 / g_speed[from];
+    uint64_t estimate = ((uint64_t)state->cycles_avg * ratio) >> 10;
+    state->cycles_avg = estimate > UINT32_MAX ? UINT32_MAX : (uint32_t)estimate;
+    state->samples = 0;
+}
+
+uint32_t tier_hotness(const tier_state_t* state, uint64_t now) {
+    if (!state) return 0;
+    return decayed(state, (uint32_t)(now >> TIER_DECAY_SHIFT));
+}
+
+void tier_decide(const tier_state_t* state, uint64_t now, int current, tier_decision_t* decision) {
+    if (!decision) return;
+
+    decision->level = current;
+    decision->benefit = 0;
+    decision->cost = 0;
+
+    uint32_t hotness = tier_hotness(state, now);
+    if (!state || hotness < TIER_MIN_HOTNESS || current < 0 || current >= TIER_LEVELS - 1) {
+        return;
+    }
+
+    uint32_t per_call = state->cycles_avg ? state->cycles_avg : TIER_UNTIMED_CYCLES;
+    uint64_t projected = (uint64_t)hotness * TIER_HORIZON;
+    if (projected > MAX_PROJECTED_CALLS) {
+        projected = MAX_PROJECTED_CALLS;
+    }
+
+    uint64_t best_net = 0;
+    for (int level = current + 1; level < TIER_LEVELS; level++) {
+        // Fraction of each call saved, in 1/1024
+        uint32_t gain = (g_speed[current] - g_speed[level]) * 1024 / g_speed[current];
+        uint64_t saved = ((uint64_t)per_call * gain) >> 10;
+        uint64_t benefit = saved * projected;
+        uint64_t cost = TIER_COMPILE_BASE + (uint64_t)g_cost_per_insn[level] * state->ir_size;
+
+        if (benefit < cost * TIER_PAYBACK || benefit - cost <= best_net) {
+            continue;
+        }
+        best_net = benefit - cost;
+        decision->level = level;
+        decision->benefit = benefit;
+        decision->cost = cost;
+    }
+}
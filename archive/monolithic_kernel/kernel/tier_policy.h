@@ -0,0 +1,98 @@
+// ============================================================================
+// BAREFLOW - Cost-Model Tiering Policy
+// ============================================================================
+// File: kernel/tier_policy.h
+// Purpose: Decide whether a function is worth recompiling, and at which
+//          optimization level, instead of fixed call-count thresholds
+// ============================================================================
+//
+// Hotness is a function's call count, halved every 2^TIER_DECAY_SHIFT
+// profiled calls (of any function): it measures the function's share of
+// recent work and drains away once the function goes cold, however many
+// calls it piled up before. Tier L pays off when
+//
+//     benefit = cycles/call * (1 - speed[L] / speed[current]) * projected calls
+//     cost    = TIER_COMPILE_BASE + cost/instruction[L] * IR instructions
+//     benefit >= TIER_PAYBACK * cost
+//
+// with projected calls = hotness * TIER_HORIZON (the recent rate held for a
+// few decay periods). Of the tiers that pay off, the one with the largest
+// benefit - cost wins, so tiers get skipped when a bigger one already pays:
+// small functions, and functions whose hotness arrives in bulk (direct
+// call counts folded in, or a tier-up that waited in the compile queue),
+// go straight to O2 or O3. Large cold functions never cover their cost.
+//
+// Cycles per call are a moving average over timed calls at the current
+// level; on a tier change the average is scaled by the speed ratio until
+// the new code's own samples replace it. Speeds and compile costs are
+// estimates (cycles per call relative to O0; LLVM-like pipeline cost per
+// IR instruction). The arithmetic avoids 64-bit division (no __udivdi3).
+// ============================================================================
+
+#ifndef TIER_POLICY_H
+#define TIER_POLICY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIER_LEVELS         4       // O0..O3, as opt_level_t
+#define TIER_DECAY_SHIFT    14      // Hotness halves every 16384 profiled calls
+#define TIER_HORIZON        4       // Projected future calls = hotness * this
+#define TIER_PAYBACK        2       // Benefit must cover the compile cost twice
+#define TIER_MIN_HOTNESS    16      // Below this nothing is judged
+#define TIER_COMPILE_BASE   20000   // Fixed cycles per compile
+#define TIER_DEFAULT_SIZE   32      // IR instructions assumed for opaque code
+#define TIER_UNTIMED_CYCLES 200     // Cycles per call assumed before any timing
+
+typedef struct {
+    uint32_t hotness;           // Decayed call count
+    uint32_t epoch;             // Decay period 'hotness' is current for
+    uint32_t cycles_avg;        // Moving average of cycles per timed call
+    uint32_t samples;           // Timed calls at this level (saturating)
+    uint32_t ir_size;           // IR instructions (compile cost)
+} tier_state_t;
+
+typedef struct {
+    int level;                  // Best level; the current one if none pays off
+    uint64_t benefit;           // Projected cycles saved by it
+    uint64_t cost;              // Its estimated compile cycles
+} tier_decision_t;
+
+/**
+ * Fresh state for a function of 'ir_size' IR instructions (0: unknown)
+ */
+void tier_state_init(tier_state_t* state, uint32_t ir_size);
+
+/**
+ * Count 'calls' calls; 'now' is the profiler's total call count
+ */
+void tier_record_calls(tier_state_t* state, uint64_t now, uint32_t calls);
+
+/**
+ * Fold one timed call's cycles into the per-call average
+ */
+void tier_record_cycles(tier_state_t* state, uint64_t cycles);
+
+/**
+ * The function now runs code of level 'to' instead of 'from'
+ */
+void tier_level_changed(tier_state_t* state, int from, int to);
+
+/**
+ * Hotness decayed up to 'now'
+ */
+uint32_t tier_hotness(const tier_state_t* state, uint64_t now);
+
+/**
+ * Best level above 'current' by the cost model
+ */
+void tier_decide(const tier_state_t* state, uint64_t now, int current, tier_decision_t* decision);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIER_POLICY_H
@@ -0,0 +1,190 @@
+/**
+ * Tiering Cost Model Test Suite
+ */
+
+#include "tier_policy_test.h"
+#include "tier_policy.h"
+#include "test_helpers.h"
+#include "vga.h"
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+static int g_tests_passed = 0;
+static int g_tests_total = 0;
+
+#define TEST_START(name) \
+    terminal_writestring("\n[Test] "); \
+    terminal_writestring(name); \
+    terminal_writestring("\n"); \
+    g_tests_total++;
+
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        terminal_writestring("  FAIL: "); \
+        terminal_writestring(message); \
+        terminal_writestring("\n"); \
+        return 0; \
+    }
+
+#define TEST_PASS() \
+    terminal_writestring("  PASS\n"); \
+    g_tests_passed++; \
+    return 1;
+
+// Function of 'ir_size' instructions taking 'cycles' per call, with
+// 'calls' calls recorded at profiler time 0
+static void make_state(tier_state_t* state, uint32_t ir_size, uint32_t cycles, uint32_t calls) {
+    tier_state_init(state, ir_size);
+    tier_record_calls(state, 0, calls);
+    if (cycles) {
+        tier_record_cycles(state, cycles);
+    }
+}
+
+// ============================================================================
+// Test Cases
+// ============================================================================
+
+static int test_below_min_hotness(void) {
+    TEST_START("Nothing is judged below the minimum hotness");
+
+    tier_state_t state;
+    tier_decision_t d;
+    make_state(&state, 8, 100000, TIER_MIN_HOTNESS - 1);
+
+    tier_decide(&state, 0, 0, &d);
+    TEST_ASSERT(d.level == 0 && d.benefit == 0, "Tiered up a function nearly never called");
+
+    TEST_PASS();
+}
+
+static int test_cold_never_tiers(void) {
+    TEST_START("Cold and cheap functions stay at O0");
+
+    tier_state_t state;
+    tier_decision_t d;
+
+    // Large function called a hundred times: no tier covers its compile
+    make_state(&state, 200, 0, 100);
+    tier_decide(&state, 0, 0, &d);
+    TEST_ASSERT(d.level == 0, "Large cold function tiered up");
+
+    // Tiny body, 50 cycles per call: the saving never pays for O1
+    make_state(&state, 8, 50, 64);
+    tier_decide(&state, 0, 0, &d);
+    TEST_ASSERT(d.level == 0, "Cheap function tiered up");
+
+    TEST_PASS();
+}
+
+static int test_single_step(void) {
+    TEST_START("Moderately hot function goes to O1 only");
+
+    // 1000 cycles per call, 128 recent calls: O1 pays off twice over,
+    // O2/O3 compile costs are not yet covered
+    tier_state_t state;
+    tier_decision_t d;
+    make_state(&state, 32, 1000, 128);
+
+    tier_decide(&state, 0, 0, &d);
+    TEST_ASSERT(d.level == 1, "Expected O1");
+    TEST_ASSERT(d.benefit >= d.cost * TIER_PAYBACK, "Decision does not pay back");
+
+    // Already at O1: the same profile does not justify O2
+    tier_decide(&state, 0, 1, &d);
+    TEST_ASSERT(d.level == 1, "Tiered past O1 too early");
+
+    TEST_PASS();
+}
+
+static int test_bulk_hot_skips_tiers(void) {
+    TEST_START("Bulk-hot function skips straight to O3");
+
+    // Hotness arriving in one batch (e.g. folded-in direct call counts)
+    tier_state_t state;
+    tier_decision_t d;
+    make_state(&state, 16, 1000, 100000);
+
+    tier_decide(&state, 0, 0, &d);
+    TEST_ASSERT(d.level == 3, "Expected O0 -> O3");
+
+    // Nothing above O3
+    tier_decide(&state, 0, 3, &d);
+    TEST_ASSERT(d.level == 3 && d.benefit == 0, "Decided above O3");
+
+    TEST_PASS();
+}
+
+static int test_decay(void) {
+    TEST_START("Hotness decays once a function goes cold");
+
+    tier_state_t state;
+    tier_decision_t d;
+    make_state(&state, 16, 1000, 100000);
+
+    const uint64_t period = 1ull << TIER_DECAY_SHIFT;
+    TEST_ASSERT(tier_hotness(&state, period - 1) == 100000, "Decayed within a period");
+    TEST_ASSERT(tier_hotness(&state, period) == 50000, "Not halved after one period");
+    TEST_ASSERT(tier_hotness(&state, 3 * period) == 12500, "Not halved per period");
+
+    // Long after its burst the same function is no longer worth compiling
+    tier_decide(&state, 32 * period, 0, &d);
+    TEST_ASSERT(tier_hotness(&state, 32 * period) == 0, "Hotness never drained");
+    TEST_ASSERT(d.level == 0, "Tiered up a function that went cold");
+
+    // New calls are added to the decayed count, not the stale one
+    tier_record_calls(&state, period, 10);
+    TEST_ASSERT(tier_hotness(&state, period) == 50010, "Calls not added after decay");
+
+    TEST_PASS();
+}
+
+static int test_level_change_rescales(void) {
+    TEST_START("Tier change rescales cycles per call");
+
+    tier_state_t state;
+    make_state(&state, 16, 1000, 1000);
+
+    // O1 runs at 550/1000 of O0 until it has samples of its own
+    tier_level_changed(&state, 0, 1);
+    TEST_ASSERT(state.samples == 0, "Samples not reset");
+    TEST_ASSERT(state.cycles_avg >= 540 && state.cycles_avg <= 560, "Estimate not scaled");
+
+    tier_record_cycles(&state, 300);
+    TEST_ASSERT(state.cycles_avg == 300, "First sample did not replace the estimate");
+
+    TEST_PASS();
+}
+
+// ============================================================================
+// Main Test Entry Point
+// ============================================================================
+
+int test_tier_policy(void) {
+    terminal_writestring("\n");
+    terminal_writestring("========================================\n");
+    terminal_writestring("  Tiering Cost Model Test Suite\n");
+    terminal_writestring("========================================\n");
+
+    g_tests_passed = 0;
+    g_tests_total = 0;
+
+    test_below_min_hotness();
+    test_cold_never_tiers();
+    test_single_step();
+    test_bulk_hot_skips_tiers();
+    test_decay();
+    test_level_change_rescales();
+
+    terminal_writestring("\n========================================\n");
+    terminal_writestring("  Results: ");
+    test_print_count(g_tests_passed);
+    terminal_writestring(" / ");
+    test_print_count(g_tests_total);
+    terminal_writestring(" tests passed\n");
+    terminal_writestring("========================================\n\n");
+
+    return (g_tests_passed == g_tests_total) ? 0 : 1;
+}
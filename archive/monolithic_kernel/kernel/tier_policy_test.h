@@ -0,0 +1,19 @@
+#ifndef TIER_POLICY_TEST_H
+#define TIER_POLICY_TEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Test the tiering cost model (tier_decide and hotness decay)
+ *
+ * Returns: 0 on success, non-zero on failure
+ */
+int test_tier_policy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIER_POLICY_TEST_H
@@ -0,0 +1,195 @@
+// ============================================================================
+// BAREFLOW - Calibrated TSC Timebase Implementation
+// ============================================================================
+
+#include "timebase.h"
+#include "pit.h"
+#include "stdlib.h"
+
+// PIT channel 2 is the reference clock. 50 ms is close to the 16-bit
+// counter limit and keeps the +-1 PIT tick read-out error under 20 ppm.
+#define CALIBRATE_MS        50
+#define CALIBRATE_ROUNDS    3
+
+#define OVERHEAD_ROUNDS     64
+#define NS_PER_SECOND       1000000000ULL
+
+timebase_fence_t g_timebase_fence = TIMEBASE_FENCE_NONE;
+
+static bool g_detected = false;
+static int g_calibration = 0;       // 0 not yet, 1 done, -1 failed
+static uint64_t g_tsc_hz = 0;
+static uint64_t g_ns_mult = 0;      // (10^9 << 32) / tsc_hz
+static uint64_t g_cycles_per_ms = 0;
+static bool g_invariant = false;
+static uint32_t g_overhead = 0;
+
+// ============================================================================
+// Hardware Access
+// ============================================================================
+
+static void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx) : "a"(leaf), "c"(0));
+}
+
+// ============================================================================
+// Fixed-Point Helpers (no __udivdi3 in the kernel)
+// ============================================================================
+
+// (a * b) >> 32 from 32x32-bit partial products
+static uint64_t mul_shr32(uint64_t a, uint64_t b) {
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+
+    return ((a_hi * b_hi) << 32) + a_hi * b_lo + a_lo * b_hi + ((a_lo * b_lo) >> 32);
+}
+
+// ============================================================================
+// Calibration
+// ============================================================================
+
+static void window_start(void* ctx) {
+    ((uint64_t*)ctx)[0] = timebase_begin();
+}
+
+static void window_end(void* ctx) {
+    ((uint64_t*)ctx)[1] = timebase_end();
+}
+
+// TSC cycles elapsed during one CALIBRATE_MS window of PIT channel 2
+static uint64_t measure_pit_window(void) {
+    uint64_t stamps[2] = {0, 0};
+    pit_window(CALIBRATE_MS, window_start, window_end, stamps);
+    return stamps[1] - stamps[0];
+}
+
+static uint64_t calibrate_tsc_hz(void) {
+    // Keep the shortest window: SMIs and host preemption only add cycles
+    uint64_t best = 0;
+    for (int round = 0; round < CALIBRATE_ROUNDS; round++) {
+        uint64_t cycles = measure_pit_window();
+        if (best == 0 || cycles < best) {
+            best = cycles;
+        }
+    }
+
+    return best * (1000 / CALIBRATE_MS);
+}
+
+static uint32_t measure_overhead(void) {
+    uint64_t best = UINT64_MAX;
+    for (int round = 0; round < OVERHEAD_ROUNDS; round++) {
+        uint64_t start = timebase_begin();
+        uint64_t end = timebase_end();
+        if (end - start < best) {
+            best = end - start;
+        }
+    }
+
+    return best > UINT32_MAX ? 0 : (uint32_t)best;
+}
+
+// ============================================================================
+// Initialization
+// ============================================================================
+
+int timebase_init(void) {
+    if (g_detected) {
+        return 0;
+    }
+
+    uint32_t eax, ebx, ecx, edx;
+
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & (1u << 4))) {
+        return -1;  // No TSC
+    }
+    bool has_sse2 = (edx >> 26) & 1;
+
+    uint32_t max_ext;
+    cpuid(0x80000000, &max_ext, &ebx, &ecx, &edx);
+
+    bool has_rdtscp = false;
+    if (max_ext >= 0x80000001) {
+        cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+        has_rdtscp = (edx >> 27) & 1;
+    }
+
+    g_invariant = false;
+    if (max_ext >= 0x80000007) {
+        cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        g_invariant = (edx >> 8) & 1;
+    }
+
+    // RDTSCP alone does not keep later instructions out; it is always
+    // paired with LFENCE, so both need SSE2
+    if (!has_sse2) {
+        g_timebase_fence = TIMEBASE_FENCE_NONE;
+    } else if (has_rdtscp) {
+        g_timebase_fence = TIMEBASE_FENCE_RDTSCP;
+    } else {
+        g_timebase_fence = TIMEBASE_FENCE_LFENCE;
+    }
+
+    g_overhead = measure_overhead();
+    g_detected = true;
+
+    return 0;
+}
+
+// Measure the TSC frequency the first time it is needed (~150 ms)
+static bool calibrated(void) {
+    if (g_calibration == 0) {
+        g_tsc_hz = timebase_init() == 0 ? calibrate_tsc_hz() : 0;
+        if (g_tsc_hz == 0) {
+            g_calibration = -1;
+            return false;
+        }
+        g_ns_mult = udiv64(NS_PER_SECOND << 32, g_tsc_hz);
+        g_cycles_per_ms = udiv64(g_tsc_hz, 1000);
+        g_calibration = 1;
+    }
+
+    return g_calibration > 0;
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+uint64_t timebase_hz(void) {
+    return calibrated() ? g_tsc_hz : 0;
+}
+
+uint64_t timebase_cycles_per_ms(void) {
+    return calibrated() ? g_cycles_per_ms : 0;
+}
+
+bool timebase_invariant(void) {
+    return g_invariant;
+}
+
+timebase_fence_t timebase_fence(void) {
+    return g_timebase_fence;
+}
+
+uint32_t timebase_overhead(void) {
+    return g_overhead;
+}
+
+uint64_t timebase_elapsed(uint64_t start, uint64_t end) {
+    uint64_t cycles = end - start;
+    return cycles > g_overhead ? cycles - g_overhead : 0;
+}
+
+uint64_t timebase_cycles_to_ns(uint64_t cycles) {
+    return calibrated() ? mul_shr32(cycles, g_ns_mult) : 0;
+}
+
+const char* timebase_fence_name(timebase_fence_t fence) {
+    switch (fence) {
+        case TIMEBASE_FENCE_RDTSCP: return "rdtscp";
+        case TIMEBASE_FENCE_LFENCE: return "lfence";
+        default:                    return "none";
+    }
+}
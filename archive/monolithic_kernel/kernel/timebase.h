@@ -0,0 +1,134 @@
+// ============================================================================
+// BAREFLOW - Calibrated TSC Timebase
+// ============================================================================
+// File: kernel/timebase.h
+// Purpose: Serialized rdtsc brackets with the measurement overhead removed,
+//          and TSC frequency for converting cycles to nanoseconds
+// ============================================================================
+//
+// A bare rdtsc may execute before earlier instructions retire or after later
+// ones start, so short regions were measured with a skew of tens of cycles.
+// timebase_begin() fences with LFENCE on both sides of RDTSC; timebase_end()
+// uses RDTSCP (waits for earlier instructions) followed by LFENCE, or
+// LFENCE; RDTSC; LFENCE on CPUs without RDTSCP. CPUs without SSE2 have no
+// LFENCE and get plain rdtsc.
+//
+// timebase_init() picks the fences and measures the cost of an empty
+// begin/end pair; timebase_elapsed() subtracts that cost. The TSC frequency
+// is measured against PIT channel 2 (~150 ms) the first time one of
+// timebase_hz/timebase_cycles_per_ms/timebase_cycles_to_ns is called, so
+// boot does not pay for it; call those outside measured regions and never
+// first from an interrupt handler.
+// Cycle counts are only comparable across machines (and convertible to
+// time) when CPUID reports an invariant TSC: otherwise the TSC may follow
+// P-states and stop in deep C-states, and exports flag it as such.
+// ============================================================================
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TIMEBASE_FENCE_NONE = 0,        // No SSE2: plain rdtsc
+    TIMEBASE_FENCE_LFENCE,          // lfence; rdtsc; lfence on both ends
+    TIMEBASE_FENCE_RDTSCP           // end uses rdtscp; lfence
+} timebase_fence_t;
+
+// Read by the inline readers below; set once by timebase_init()
+extern timebase_fence_t g_timebase_fence;
+
+// ============================================================================
+// API Functions
+// ============================================================================
+
+/**
+ * Detect TSC features and measure the overhead of a begin/end pair.
+ * Does not calibrate the frequency. Safe to call more than once.
+ *
+ * Returns: 0 on success, -1 if the CPU has no TSC
+ *          (readers still work, timebase_hz() returns 0)
+ */
+int timebase_init(void);
+
+/**
+ * TSC frequency in Hz, calibrated on the first call (0 if that failed)
+ */
+uint64_t timebase_hz(void);
+
+/**
+ * TSC cycles per millisecond, calibrated on the first call (0 if that failed)
+ */
+uint64_t timebase_cycles_per_ms(void);
+
+/**
+ * True if CPUID.80000007H:EDX[8] reports a constant-rate, always-running TSC
+ */
+bool timebase_invariant(void);
+
+/**
+ * Serialization used by timebase_begin/timebase_end
+ */
+timebase_fence_t timebase_fence(void);
+
+/**
+ * Minimum cycles measured for an empty begin/end pair
+ */
+uint32_t timebase_overhead(void);
+
+/**
+ * end - start - overhead, clamped at 0
+ */
+uint64_t timebase_elapsed(uint64_t start, uint64_t end);
+
+/**
+ * Convert TSC cycles to nanoseconds (0 if uncalibrated)
+ */
+uint64_t timebase_cycles_to_ns(uint64_t cycles);
+
+/**
+ * Short name of the fence mode used in exports ("rdtscp", "lfence", "none")
+ */
+const char* timebase_fence_name(timebase_fence_t fence);
+
+// ============================================================================
+// Region Readers
+// ============================================================================
+
+// Start of a measured region: earlier instructions have completed and
+// nothing from the region starts before the TSC is read
+static inline uint64_t timebase_begin(void) {
+    uint32_t lo, hi;
+    if (g_timebase_fence != TIMEBASE_FENCE_NONE) {
+        asm volatile("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi) : : "memory");
+    } else {
+        asm volatile("rdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+    }
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// End of a measured region: the region has completed before the TSC is
+// read and nothing after it starts early
+static inline uint64_t timebase_end(void) {
+    uint32_t lo, hi, aux;
+    if (g_timebase_fence == TIMEBASE_FENCE_RDTSCP) {
+        asm volatile("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux) : : "memory");
+        (void)aux;
+    } else if (g_timebase_fence == TIMEBASE_FENCE_LFENCE) {
+        asm volatile("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi) : : "memory");
+    } else {
+        asm volatile("rdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+    }
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMEBASE_H
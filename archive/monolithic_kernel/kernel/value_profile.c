@@ -0,0 +1,92 @@
+// ============================================================================
+// BAREFLOW - Argument Value Profiling Implementation
+// ============================================================================
+
+#include "value_profile.h"
+#include <stddef.h>
+
+extern void* memset(void* s, int c, size_t n);
+
+void value_profile_init(value_profile_t* profile) {
+    if (!profile) return;
+    memset(profile, 0, sizeof(value_profile_t));
+}
+
+void value_profile_record(value_profile_t* profile, uint32_t value) {
+    if (!profile) return;
+
+    profile->total++;
+
+    uint32_t min_slot = 0;
+    for (uint32_t i = 0; i < profile->used; i++) {
+        value_slot_t* slot = &profile->slots[i];
+        if (slot->value == value) {
+            if (slot->count != UINT32_MAX) {
+                slot->count++;
+            }
+            return;
+        }
+        if (slot->count < profile->slots[min_slot].count) {
+            min_slot = i;
+        }
+    }
+
+    if (profile->used < VALUE_PROFILE_SLOTS) {
+        value_slot_t* slot = &profile->slots[profile->used++];
+        slot->value = value;
+        slot->count = 1;
+        slot->error = 0;
+        return;
+    }
+
+    // Space-Saving eviction: the newcomer may have been one of the values
+    // counted in the evicted slot, so it starts from that count
+    value_slot_t* slot = &profile->slots[min_slot];
+    slot->error = slot->count;
+    slot->value = value;
+    if (slot->count != UINT32_MAX) {
+        slot->count++;
+    }
+}
+
+bool value_profile_dominant(const value_profile_t* profile, uint32_t basis_points,
+                            uint64_t min_samples, uint32_t* value) {
+    if (!profile || profile->used == 0 || profile->total < min_samples) {
+        return false;
+    }
+
+    const value_slot_t* best = NULL;
+    for (uint32_t i = 0; i < profile->used; i++) {
+        const value_slot_t* slot = &profile->slots[i];
+        if (!best || slot->count - slot->error > best->count - best->error) {
+            best = slot;
+        }
+    }
+
+    uint64_t guaranteed = best->count - best->error;
+    if (guaranteed * 10000 < profile->total * basis_points) {
+        return false;
+    }
+
+    if (value) *value = best->value;
+    return true;
+}
+
+int value_profile_top(const value_profile_t* profile, value_slot_t* out, int max_count) {
+    if (!profile || !out || max_count <= 0) return 0;
+
+    int count = 0;
+    for (uint32_t i = 0; i < profile->used; i++) {
+        const value_slot_t* slot = &profile->slots[i];
+
+        // Insertion sort, highest count first (at most VALUE_PROFILE_SLOTS)
+        int pos = count < max_count ? count++ : max_count;
+        while (pos > 0 && out[pos - 1].count < slot->count) {
+            if (pos < max_count) out[pos] = out[pos - 1];
+            pos--;
+        }
+        if (pos < max_count) out[pos] = *slot;
+    }
+
+    return count;
+}
@@ -0,0 +1,74 @@
+// ============================================================================
+// BAREFLOW - Argument Value Profiling (Top-K)
+// ============================================================================
+// File: kernel/value_profile.h
+// Purpose: Most frequent argument values per hot function, to decide when
+//          a constant-specialized clone is worth emitting
+// ============================================================================
+//
+// Each profile tracks VALUE_PROFILE_SLOTS candidates with the Space-Saving
+// algorithm: a value already in a slot is counted there; otherwise it takes
+// a free slot, or evicts the slot with the lowest count and inherits that
+// count as its error bound. Memory is fixed and any value that occurs in
+// more than 1/VALUE_PROFILE_SLOTS of the calls is guaranteed to be kept.
+//
+// count - error is a lower bound on how often the value really occurred,
+// so value_profile_dominant() never reports a value on the strength of
+// counts it inherited from evicted ones.
+// ============================================================================
+
+#ifndef VALUE_PROFILE_H
+#define VALUE_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VALUE_PROFILE_SLOTS     4   // Top-k candidates per argument
+#define VALUE_PROFILE_MAX_ARGS  4   // Arguments profiled per function (e.g. M, N, K)
+
+typedef struct {
+    uint32_t value;
+    uint32_t count;             // Upper bound on occurrences
+    uint32_t error;             // Count inherited from the evicted value
+} value_slot_t;
+
+typedef struct {
+    uint64_t total;             // Values recorded
+    uint32_t used;              // Slots filled
+    value_slot_t slots[VALUE_PROFILE_SLOTS];
+} value_profile_t;
+
+/**
+ * Clear all slots
+ */
+void value_profile_init(value_profile_t* profile);
+
+/**
+ * Record one argument value
+ */
+void value_profile_record(value_profile_t* profile, uint32_t value);
+
+/**
+ * Most frequent value, if it accounts for at least 'basis_points' of the
+ * samples (lower bound) and at least 'min_samples' were recorded
+ *
+ * Returns: true and stores the value in *value, false otherwise
+ */
+bool value_profile_dominant(const value_profile_t* profile, uint32_t basis_points,
+                            uint64_t min_samples, uint32_t* value);
+
+/**
+ * Copy the filled slots to 'out', highest count first
+ * Returns: number of slots written
+ */
+int value_profile_top(const value_profile_t* profile, value_slot_t* out, int max_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VALUE_PROFILE_H
@@ -28,6 +28,42 @@ extract_cycles() {
     grep -A 5 "# Module: $module" "$profile" | grep "# Avg Cycles/Call:" | awk '{print $5}'
 }
 
+# Function to print a module's timing from a kernel profile JSON
+# (build/profile.json). Cycles are converted with the kernel-calibrated
+# TSC frequency so results from different machines can be compared;
+# without an invariant TSC only same-machine cycle comparisons hold.
+extract_timing() {
+    local module=$1
+    local profile=$2
+
+    python3 - "$module" "$profile" <<'PYEOF'
+import json, sys
+module, path = sys.argv[1], sys.argv[2]
+try:
+    profile = json.load(open(path))
+except (OSError, ValueError):
+    sys.exit(0)
+timebase = profile.get("timebase", {})
+hz = timebase.get("tsc_hz", 0)
+for mod in profile.get("modules", []):
+    if mod.get("name") != module or not mod.get("calls"):
+        continue
+    avg_cycles = mod["total_cycles"] / mod["calls"]
+    print(f"TSC: {hz / 1e6:.1f} MHz, "
+          f"{'invariant' if timebase.get('invariant') else 'NOT invariant'}, "
+          f"fence {timebase.get('fence', 'none')}, "
+          f"overhead {timebase.get('overhead_cycles', 0)} cycles subtracted")
+    print(f"Avg cycles/call: {avg_cycles:.0f}")
+    if hz:
+        print(f"Avg time/call:   {avg_cycles * 1e9 / hz:.1f} ns")
+        p99 = mod.get("latency", {}).get("p99")
+        if p99:
+            print(f"p99 time/call:   {p99 * 1e9 / hz:.1f} ns")
+    if not timebase.get("invariant"):
+        print("WARNING: TSC not invariant, ns values are not comparable across machines")
+PYEOF
+}
+
 # Function to compare two cycle counts and calculate speedup
 calculate_speedup() {
     local baseline=$1
@@ -157,8 +193,19 @@ benchmark_module() {
 
     echo ""
 
+    # Calibrated timing from the kernel's JSON profile (make pgo-profile)
+    if [ -f "build/profile.json" ]; then
+        echo -e "${YELLOW}[4] Runtime Performance (calibrated, build/profile.json)${NC}"
+        echo ""
+
+        timing=$(extract_timing "$module" "build/profile.json")
+        if [ -n "$timing" ]; then
+            echo "$timing"
+        else
+            echo "No calls recorded for $module"
+        fi
     # Extract cycle information from profile if available
-    if [ -f "profile_all_modules.txt" ]; then
+    elif [ -f "profile_all_modules.txt" ]; then
         echo -e "${YELLOW}[4] Runtime Performance (from profile)${NC}"
         echo ""
 
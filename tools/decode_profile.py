@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""
+Binary Profile Decoder - debugcon stream -> profiling JSON
+
+The kernel writes its module profile as a compact binary stream to the
+QEMU debugcon port (kernel/profile_binary.h). This tool finds the stream in
+the captured file, checks its CRC32 and prints the same JSON that
+profiling_export_json() would have sent over the serial port, so
+pgo_recompile.py and pgo_multi_iteration.py consume it unchanged.
+
+Usage:
+    qemu-system-i386 ... -debugcon file:build/profile.bin
+    python3 tools/decode_profile.py build/profile.bin -o build/profile.json
+"""
+
+import argparse
+import json
+import sys
+import zlib
+from pathlib import Path
+from typing import List, Optional, Tuple
+
+MAGIC = b"BFPB"
+VERSION = 3
+MIN_VERSION = 1     # Captures from before the timebase fields still decode
+
+# Order of the PMU counters in the stream (kernel/pmu.h pmu_event_t)
+PMU_EVENTS = ["instructions", "llc_misses", "branch_misses", "dtlb_misses"]
+
+# kernel/timebase.h timebase_fence_t
+FENCES = ["none", "lfence", "rdtscp"]
+
+
+class DecodeError(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data: bytes, pos: int = 0):
+        self.data = data
+        self.pos = pos
+
+    def u8(self) -> int:
+        if self.pos >= len(self.data):
+            raise DecodeError("truncated stream")
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def varint(self) -> int:
+        value = 0
+        shift = 0
+        while True:
+            byte = self.u8()
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+            if shift > 63:
+                raise DecodeError("varint too long")
+
+    def raw(self, n: int) -> bytes:
+        if self.pos + n > len(self.data):
+            raise DecodeError("truncated stream")
+        out = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return out
+
+
+# ============================================================================
+# Latency histogram layout (mirrors kernel/latency_histogram.c)
+# ============================================================================
+
+def bucket_index(value: int, sub_bits: int, max_bits: int) -> int:
+    sub_buckets = 1 << sub_bits
+    if value < sub_buckets:
+        return value
+    msb = value.bit_length() - 1
+    if msb >= max_bits:
+        return sub_buckets + (max_bits - sub_bits) * sub_buckets - 1
+    shift = msb - sub_bits
+    return sub_buckets + shift * sub_buckets + ((value >> shift) & (sub_buckets - 1))
+
+
+def bucket_low(index: int, sub_bits: int) -> int:
+    sub_buckets = 1 << sub_bits
+    if index < sub_buckets:
+        return index
+    shift = (index - sub_buckets) >> sub_bits
+    sub = (index - sub_buckets) & (sub_buckets - 1)
+    return (sub_buckets + sub) << shift
+
+
+def bucket_high(index: int, sub_bits: int) -> int:
+    sub_buckets = 1 << sub_bits
+    if index < sub_buckets:
+        return index
+    shift = (index - sub_buckets) >> sub_bits
+    return bucket_low(index, sub_bits) + (1 << shift) - 1
+
+
+def percentile(buckets: List[Tuple[int, int]], basis_points: int,
+               sub_bits: int, max_bits: int) -> int:
+    total = sum(count for _, count in buckets)
+    if total == 0:
+        return 0
+
+    last = (1 << sub_bits) + (max_bits - sub_bits) * (1 << sub_bits) - 1
+    cumulative = 0
+    for index, count in buckets:
+        if index == last:
+            # Overflow bucket has no upper bound: report where it starts
+            return bucket_low(index, sub_bits)
+        cumulative += count
+        if cumulative * 10000 >= total * basis_points:
+            return bucket_high(index, sub_bits)
+    return bucket_low(last, sub_bits)
+
+
+# ============================================================================
+# Timebase (mirrors kernel/timebase.c fixed-point conversion)
+# ============================================================================
+
+def cycles_to_ns(cycles: int, tsc_hz: int) -> int:
+    if tsc_hz == 0:
+        return 0
+    mask = (1 << 64) - 1
+    mult = ((10**9) << 32) // tsc_hz & mask
+    a_lo, a_hi = cycles & 0xFFFFFFFF, cycles >> 32
+    b_lo, b_hi = mult & 0xFFFFFFFF, mult >> 32
+    return ((((a_hi * b_hi) << 32) & mask) + a_hi * b_lo + a_lo * b_hi +
+            ((a_lo * b_lo) >> 32)) & mask
+
+
+# ============================================================================
+# Stream decoding
+# ============================================================================
+
+def find_frames(data: bytes) -> List[int]:
+    """Offsets of every magic in the capture (debugcon may carry other text)"""
+    offsets = []
+    pos = data.find(MAGIC)
+    while pos != -1:
+        offsets.append(pos)
+        pos = data.find(MAGIC, pos + 1)
+    return offsets
+
+
+def decode_frame(data: bytes, offset: int) -> dict:
+    r = Reader(data, offset + len(MAGIC))
+    version = r.u8()
+    if not MIN_VERSION <= version <= VERSION:
+        raise DecodeError(f"unsupported version {version}")
+
+    payload_len = r.varint()
+    payload_start = r.pos
+    r.raw(payload_len)
+    crc = int.from_bytes(r.raw(4), "little")
+    if zlib.crc32(data[offset:payload_start + payload_len]) != crc:
+        raise DecodeError("CRC mismatch")
+
+    p = Reader(data[payload_start:payload_start + payload_len])
+    flags = p.u8()
+    sub_bits = p.u8()
+    max_bits = p.u8()
+    num_events = p.u8()
+    fence, tsc_hz, overhead = 0, 0, 0
+    if version >= 2:
+        fence = p.u8()
+        tsc_hz = p.varint()
+        overhead = p.varint()
+    delta = None
+    if version >= 3 and flags & 4:
+        delta = {"seq": p.varint(), "epoch_cycles": p.varint()}
+    timestamp = p.varint()
+    total_calls = p.varint()
+    num_modules = p.varint()
+
+    modules = []
+    for _ in range(num_modules):
+        name = p.raw(p.varint()).decode("utf-8", errors="replace")
+        calls = p.varint()
+        total_cycles = p.varint()
+        min_cycles = p.varint()
+        max_cycles = min_cycles + p.varint()
+        code_address = p.varint()
+        code_size = p.varint()
+        loaded = p.u8() != 0
+
+        buckets = []
+        index = 0
+        for _ in range(p.varint()):
+            index += p.varint()
+            buckets.append((index, p.varint()))
+
+        counters = [p.varint() for _ in range(num_events)]
+        names = PMU_EVENTS + [f"event_{i}" for i in range(len(PMU_EVENTS), num_events)]
+
+        modules.append({
+            "name": name,
+            "calls": calls,
+            "total_cycles": total_cycles,
+            "total_ns": cycles_to_ns(total_cycles, tsc_hz),
+            "min_cycles": min_cycles,
+            "max_cycles": max_cycles,
+            "code_address": f"0x{code_address:08X}",
+            "code_size": code_size,
+            "latency": {
+                "p50": percentile(buckets, 5000, sub_bits, max_bits),
+                "p99": percentile(buckets, 9900, sub_bits, max_bits),
+                "p999": percentile(buckets, 9990, sub_bits, max_bits),
+                "buckets": [[bucket_low(i, sub_bits), c] for i, c in buckets],
+            },
+            "pmu": dict(zip(names, counters)),
+            "loaded": loaded,
+        })
+
+    profile = {
+        "format_version": "1.0",
+        "timestamp_cycles": timestamp,
+    }
+    if delta:
+        profile["delta"] = delta
+    profile.update({
+        "total_calls": total_calls,
+        "num_modules": num_modules,
+        "latency_layout": {"sub_bits": sub_bits, "max_bits": max_bits},
+        "pmu_available": bool(flags & 1),
+        "timebase": {
+            "tsc_hz": tsc_hz,
+            "invariant": bool(flags & 2),
+            "fence": FENCES[fence] if fence < len(FENCES) else "none",
+            "overhead_cycles": overhead,
+        },
+        "modules": modules,
+    })
+    return profile
+
+
+def decode_all(data: bytes) -> List[dict]:
+    """Every valid frame in capture order (continuous mode writes one per epoch)"""
+    frames = []
+    for offset in find_frames(data):
+        try:
+            frames.append(decode_frame(data, offset))
+        except DecodeError:
+            continue    # Magic inside payload bytes, or a torn final frame
+    return frames
+
+
+def decode_last(data: bytes) -> Optional[dict]:
+    """Decode the most recent valid frame (a capture may hold several boots)"""
+    last_error = None
+    for offset in reversed(find_frames(data)):
+        try:
+            return decode_frame(data, offset)
+        except DecodeError as e:
+            last_error = e
+    if last_error:
+        raise last_error
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode binary kernel profile to JSON")
+    parser.add_argument("input", help="debugcon capture (qemu -debugcon file:...)")
+    parser.add_argument("-o", "--output", help="Write JSON here instead of stdout")
+    args = parser.parse_args()
+
+    path = Path(args.input)
+    if not path.exists():
+        print(f"❌ Not found: {path}", file=sys.stderr)
+        return 1
+
+    try:
+        profile = decode_last(path.read_bytes())
+    except DecodeError as e:
+        print(f"❌ Corrupt profile stream: {e}", file=sys.stderr)
+        return 1
+
+    if profile is None:
+        print(f"❌ No binary profile found in {path}", file=sys.stderr)
+        return 1
+
+    text = json.dumps(profile, indent=2)
+    if args.output:
+        Path(args.output).write_text(text + "\n")
+        print(f"✅ {profile['num_modules']} modules decoded -> {args.output}", file=sys.stderr)
+    else:
+        print(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
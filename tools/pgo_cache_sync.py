@@ -9,6 +9,13 @@ Workflow:
 4. Write .MOD files to FAT16 disk using mtools
 5. Kernel loads from disk at next boot
 
+Continuous mode (kernel built with CONTINUOUS=1) exports one delta frame
+per epoch instead of a single profile. --deltas folds the frames of a
+capture into a running profile (--state), so classification reflects the
+steady-state workload and not only the first seconds after boot:
+    python3 tools/pgo_cache_sync.py --deltas build/profile_stream.bin \
+        --skip-warmup 2 --disk build/fat16_test.img
+
 Usage:
     python3 tools/pgo_cache_sync.py profile.json --disk build/fat16_test.img
 """
@@ -19,28 +26,198 @@ import subprocess
 import sys
 from pathlib import Path
 
+sys.path.insert(0, str(Path(__file__).parent))
+from decode_profile import (DecodeError, bucket_index, bucket_low,  # noqa: E402
+                            cycles_to_ns, decode_all, percentile)
+
+DELTA_BEGIN = "--- BEGIN DELTA JSON ---"
+DELTA_END = "--- END DELTA JSON ---"
+
+
+# ============================================================================
+# Delta accumulation (continuous profiling)
+# ============================================================================
+
+def read_deltas(path: Path) -> list:
+    """Delta frames in capture order: BFPB frames, or DELTA JSON blocks of a serial log"""
+    data = path.read_bytes()
+    frames = [f for f in decode_all(data) if "delta" in f]
+    if frames:
+        return frames
+
+    text = data.decode("utf-8", errors="replace")
+    pos = text.find(DELTA_BEGIN)
+    while pos != -1:
+        end = text.find(DELTA_END, pos)
+        if end == -1:
+            break   # Capture cut mid-export
+        try:
+            frames.append(json.loads(text[pos + len(DELTA_BEGIN):end]))
+        except json.JSONDecodeError:
+            pass
+        pos = text.find(DELTA_BEGIN, end)
+    return frames
+
+
+def empty_module(name: str) -> dict:
+    return {
+        "name": name,
+        "calls": 0,
+        "total_cycles": 0,
+        "total_ns": 0,
+        "min_cycles": 0,
+        "max_cycles": 0,
+        "code_address": "0x00000000",
+        "code_size": 0,
+        "latency": {"p50": 0, "p99": 0, "p999": 0, "buckets": []},
+        "pmu": {},
+        "loaded": False,
+    }
+
+
+def merge_module(acc: dict, mod: dict, sub_bits: int, max_bits: int):
+    if mod["calls"]:
+        acc["min_cycles"] = (mod["min_cycles"] if acc["calls"] == 0
+                             else min(acc["min_cycles"], mod["min_cycles"]))
+        acc["max_cycles"] = max(acc["max_cycles"], mod["max_cycles"])
+    acc["calls"] += mod["calls"]
+    acc["total_cycles"] += mod["total_cycles"]
+
+    for event, count in mod.get("pmu", {}).items():
+        acc["pmu"][event] = acc["pmu"].get(event, 0) + count
+
+    # Buckets are exported by lower bound; merge by index, keep them sorted
+    counts = {bucket_index(low, sub_bits, max_bits): c
+              for low, c in acc["latency"]["buckets"]}
+    for low, c in mod.get("latency", {}).get("buckets", []):
+        index = bucket_index(low, sub_bits, max_bits)
+        counts[index] = counts.get(index, 0) + c
+    buckets = sorted(counts.items())
+    acc["latency"] = {
+        "p50": percentile(buckets, 5000, sub_bits, max_bits),
+        "p99": percentile(buckets, 9900, sub_bits, max_bits),
+        "p999": percentile(buckets, 9990, sub_bits, max_bits),
+        "buckets": [[bucket_low(i, sub_bits), c] for i, c in buckets],
+    }
+
+    # Placement is whatever the latest epoch saw (modules can be reloaded)
+    acc["code_address"] = mod["code_address"]
+    acc["code_size"] = mod["code_size"]
+    acc["loaded"] = mod["loaded"]
+
+
+def accumulate(state: dict, frames: list, skip_warmup: int) -> int:
+    """Add new frames to 'state' in place; returns the number applied"""
+    info = state.setdefault("accumulated", {
+        "epochs": 0, "epoch_cycles": 0, "skipped_warmup": 0, "last": None,
+    })
+
+    # A re-run on the same capture resumes after the last frame applied;
+    # a capture without it (fresh boot, truncated file) is all new
+    start = 0
+    for i, frame in enumerate(frames):
+        key = [frame["delta"]["seq"], frame["timestamp_cycles"]]
+        if key == info["last"]:
+            start = i + 1
+
+    applied = 0
+    for frame in frames[start:]:
+        info["last"] = [frame["delta"]["seq"], frame["timestamp_cycles"]]
+        if frame["delta"]["seq"] <= skip_warmup:
+            info["skipped_warmup"] += 1
+            continue
+
+        layout = frame.get("latency_layout", {"sub_bits": 3, "max_bits": 40})
+        by_name = {m["name"]: m for m in state["modules"]}
+        for mod in frame["modules"]:
+            if mod["name"] not in by_name:
+                by_name[mod["name"]] = empty_module(mod["name"])
+                state["modules"].append(by_name[mod["name"]])
+            merge_module(by_name[mod["name"]], mod,
+                         layout["sub_bits"], layout["max_bits"])
+
+        state["timestamp_cycles"] = frame["timestamp_cycles"]
+        state["total_calls"] += frame["total_calls"]
+        state["latency_layout"] = layout
+        state["pmu_available"] = frame.get("pmu_available", False)
+        if "timebase" in frame:
+            state["timebase"] = frame["timebase"]
+        info["epochs"] += 1
+        info["epoch_cycles"] += frame["delta"]["epoch_cycles"]
+        applied += 1
+
+    tsc_hz = state.get("timebase", {}).get("tsc_hz", 0)
+    for mod in state["modules"]:
+        mod["total_ns"] = cycles_to_ns(mod["total_cycles"], tsc_hz)
+    state["num_modules"] = len(state["modules"])
+    return applied
+
+
+def load_accumulated(args) -> dict:
+    state_path = Path(args.state)
+    if state_path.exists():
+        state = json.loads(state_path.read_text())
+    else:
+        state = {"format_version": "1.0", "timestamp_cycles": 0,
+                 "total_calls": 0, "num_modules": 0, "modules": []}
+
+    for capture in args.deltas:
+        path = Path(capture)
+        if not path.exists():
+            print(f"❌ Delta capture not found: {path}")
+            return None
+        try:
+            frames = read_deltas(path)
+        except DecodeError as e:
+            print(f"❌ Corrupt delta stream in {path}: {e}")
+            return None
+        applied = accumulate(state, frames, args.skip_warmup)
+        print(f"📥 {path}: {len(frames)} epochs, {applied} new")
+
+    state_path.parent.mkdir(parents=True, exist_ok=True)
+    state_path.write_text(json.dumps(state, indent=2) + "\n")
+    info = state.get("accumulated", {})
+    print(f"📈 Accumulated {info.get('epochs', 0)} epochs "
+          f"({info.get('skipped_warmup', 0)} warm-up skipped) -> {state_path}")
+    return state
+
+
 def main():
     parser = argparse.ArgumentParser(description="Sync PGO cache to FAT16 disk")
-    parser.add_argument("profile", help="Profile JSON file")
+    parser.add_argument("profile", nargs="?", help="Profile JSON file")
     parser.add_argument("--disk", default="build/fat16_test.img", help="FAT16 disk image")
     parser.add_argument("--cache-dir", default="cache/i686/default", help="Cache directory")
     parser.add_argument("--dry-run", action="store_true", help="Don't actually write to disk")
+    parser.add_argument("--deltas", action="append", default=[], metavar="CAPTURE",
+                        help="Continuous-mode capture (debugcon or serial log) to accumulate")
+    parser.add_argument("--state", default="build/profile_accum.json",
+                        help="Accumulated profile, updated by --deltas")
+    parser.add_argument("--skip-warmup", type=int, default=0, metavar="N",
+                        help="Ignore the first N epochs of each boot")
     args = parser.parse_args()
 
+    if not args.profile and not args.deltas:
+        parser.error("a profile JSON or --deltas is required")
+
     # Check inputs
-    if not Path(args.profile).exists():
+    if args.profile and not Path(args.profile).exists():
         print(f"❌ Profile not found: {args.profile}")
         return 1
 
+    # Load profile
+    if args.deltas:
+        profile = load_accumulated(args)
+        if profile is None:
+            return 1
+    else:
+        with open(args.profile) as f:
+            profile = json.load(f)
+
     if not Path(args.disk).exists():
         print(f"❌ Disk image not found: {args.disk}")
         print(f"   Create with: python3 tools/create_fat16_disk.py")
         return 1
 
-    # Load profile
-    with open(args.profile) as f:
-        profile = json.load(f)
-
     print(f"📊 Profile: {profile['num_modules']} modules, {profile['total_calls']} calls")
     print()
 
@@ -163,12 +163,15 @@ class PGOIterator:
         try:
             # Run QEMU with serial output
             serial_file = "/tmp/pgo_serial.txt"
+            debugcon_file = Path("/tmp/pgo_debugcon.bin")
+            debugcon_file.unlink(missing_ok=True)
             result = subprocess.run(
                 [
                     'timeout', '--foreground', '10',
                     'qemu-system-i386',
                     '-drive', 'file=fluid.img,format=raw',
                     '-serial', f'file:{serial_file}',
+                    '-debugcon', f'file:{debugcon_file}',
                     '-nographic'
                 ],
                 cwd=self.project_root,
@@ -177,6 +180,18 @@ class PGOIterator:
                 timeout=15
             )
 
+            # Binary profile over debugcon (fast path, see kernel/profile_binary.h)
+            if debugcon_file.exists() and debugcon_file.stat().st_size > 0:
+                decoded = subprocess.run(
+                    ['python3', 'tools/decode_profile.py', str(debugcon_file), '-o', output_file],
+                    cwd=self.project_root,
+                    capture_output=True,
+                    text=True
+                )
+                if decoded.returncode == 0:
+                    return True
+                print("    ⚠️  Binary profile unusable, falling back to serial JSON")
+
             # Extract JSON from serial output
             with open(serial_file) as f:
                 content = f.read()
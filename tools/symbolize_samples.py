@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+Sample Profile Symbolizer - Resolve LAPIC-timer samples offline
+
+The kernel's sampling profiler (kernel/sample_profiler.c) exports raw EIPs
+and frame-pointer call stacks. This tool maps them to function names using
+the linker map (build/kernel.map) or, for static functions too, the ELF
+symbol table via nm, then prints:
+1. Flat profile (self samples per function)
+2. Inclusive profile (samples with the function anywhere on the stack)
+3. Optionally, folded stacks for flamegraph.pl
+
+Usage:
+    python3 tools/symbolize_samples.py serial.log
+    python3 tools/symbolize_samples.py serial.log --symbols build/kernel.elf
+    python3 tools/symbolize_samples.py serial.log --folded out.folded
+"""
+
+import argparse
+import bisect
+import json
+import re
+import subprocess
+import sys
+from collections import Counter
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+# "                0x00010020                kernel_main"
+MAP_SYMBOL_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$@]*)\s*$')
+# " .text          0x00010020      0x1234 build/kernel.o"
+MAP_SECTION_RE = re.compile(r'^\s*(\.\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+\S')
+# "00010020 T kernel_main"
+NM_RE = re.compile(r'^([0-9a-fA-F]+)\s+[tTwW]\s+(\S+)$')
+
+
+class SymbolTable:
+    """Sorted code symbols with address -> name lookup"""
+
+    def __init__(self, symbols: List[Tuple[int, str]], text_end: int):
+        symbols.sort()
+        self.addrs = [a for a, _ in symbols]
+        self.names = [n for _, n in symbols]
+        self.text_end = text_end
+
+    def lookup(self, addr: int) -> str:
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i < 0 or addr >= self.text_end:
+            # Outside the kernel image: JIT'd code or a corrupt frame
+            return f"[unknown 0x{addr:08X}]"
+        return self.names[i]
+
+
+def load_map(path: Path) -> SymbolTable:
+    """Parse code symbols from a GNU ld -Map file"""
+    symbols = []
+    text_end = 0
+    in_text = False
+
+    for line in path.read_text(errors='replace').splitlines():
+        # Output sections start in column 0 (".text", ".rodata", ...)
+        if line.startswith('.'):
+            in_text = line.split()[0].startswith('.text')
+        if not in_text:
+            continue
+
+        m = MAP_SYMBOL_RE.match(line)
+        if m:
+            symbols.append((int(m.group(1), 16), m.group(2)))
+            continue
+
+        m = MAP_SECTION_RE.match(line)
+        if m:
+            end = int(m.group(2), 16) + int(m.group(3), 16)
+            text_end = max(text_end, end)
+
+    return SymbolTable(symbols, text_end)
+
+
+def load_nm(path: Path) -> SymbolTable:
+    """Read code symbols (including static functions) from an ELF via nm"""
+    result = subprocess.run(['nm', '-n', '--defined-only', str(path)],
+                            capture_output=True, text=True, check=True)
+    symbols = []
+    text_end = 0
+
+    for line in result.stdout.splitlines():
+        m = NM_RE.match(line.strip())
+        if m:
+            symbols.append((int(m.group(1), 16), m.group(2)))
+            if m.group(2) == '__text_end':
+                text_end = int(m.group(1), 16)
+
+    if not text_end:
+        raise ValueError(f"{path}: no __text_end symbol (see kernel/linker.ld)")
+
+    return SymbolTable(symbols, text_end)
+
+
+def extract_profile(path: Path) -> Optional[dict]:
+    """Find the sample_profile JSON block in a serial log (or a bare JSON file)"""
+    content = path.read_text(errors='replace')
+
+    pos = 0
+    while True:
+        start = content.find('--- BEGIN JSON ---', pos)
+        if start == -1:
+            break
+        end = content.find('--- END JSON ---', start)
+        if end == -1:
+            break
+
+        block = json.loads(content[start + len('--- BEGIN JSON ---'):end].strip())
+        if block.get('type') == 'sample_profile':
+            return block
+        pos = end
+
+    try:
+        block = json.loads(content)
+        return block if block.get('type') == 'sample_profile' else None
+    except json.JSONDecodeError:
+        return None
+
+
+def symbolize(profile: dict, table: SymbolTable) -> List[List[str]]:
+    """Return one call stack per sample, outermost frame first"""
+    stacks = []
+    for cpu in profile['cpus']:
+        for sample in cpu['samples']:
+            frames = [table.lookup(int(sample['eip'], 16))]
+            # Return addresses point after the call; -1 lands inside it
+            frames += [table.lookup(int(a, 16) - 1) for a in sample['stack']]
+            stacks.append(list(reversed(frames)))
+    return stacks
+
+
+def print_report(stacks: List[List[str]], dropped: int, top: int):
+    total = len(stacks)
+    self_counts = Counter(s[-1] for s in stacks)
+    incl_counts: Dict[str, int] = Counter()
+    for s in stacks:
+        for name in set(s):
+            incl_counts[name] += 1
+
+    print("=" * 80)
+    print("BareFlow Sample Profile")
+    print("=" * 80)
+    print(f"Samples: {total:,}  (dropped: {dropped:,})")
+    print()
+
+    print(f"{'SELF':>8} {'SELF%':>7}  FUNCTION")
+    for name, count in self_counts.most_common(top):
+        print(f"{count:>8,} {100.0 * count / total:>6.2f}%  {name}")
+    print()
+
+    print(f"{'TOTAL':>8} {'TOTAL%':>7}  FUNCTION")
+    for name, count in incl_counts.most_common(top):
+        print(f"{count:>8,} {100.0 * count / total:>6.2f}%  {name}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Symbolize kernel sample profiles")
+    parser.add_argument("log", help="Serial log (or JSON) containing the sample profile")
+    parser.add_argument("--symbols", default="build/kernel.map",
+                        help="Linker map (.map) or kernel ELF (uses nm)")
+    parser.add_argument("--folded", help="Write folded stacks for flamegraph.pl")
+    parser.add_argument("--top", type=int, default=25, help="Functions to list")
+    args = parser.parse_args()
+
+    log_path = Path(args.log)
+    sym_path = Path(args.symbols)
+    for p in (log_path, sym_path):
+        if not p.exists():
+            print(f"❌ Not found: {p}")
+            return 1
+
+    profile = extract_profile(log_path)
+    if not profile:
+        print(f"❌ No sample_profile JSON block in {log_path}")
+        return 1
+
+    table = load_map(sym_path) if sym_path.suffix == '.map' else load_nm(sym_path)
+    if not table.addrs:
+        print(f"❌ No code symbols found in {sym_path}")
+        return 1
+
+    stacks = symbolize(profile, table)
+    if not stacks:
+        print("❌ Profile contains no samples")
+        return 1
+
+    dropped = sum(cpu.get('dropped', 0) for cpu in profile['cpus'])
+    print_report(stacks, dropped, args.top)
+
+    if args.folded:
+        folded = Counter(';'.join(s) for s in stacks)
+        with open(args.folded, 'w') as f:
+            for stack, count in sorted(folded.items()):
+                f.write(f"{stack} {count}\n")
+        print()
+        print(f"✅ Folded stacks written to {args.folded}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())